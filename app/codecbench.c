@@ -0,0 +1,293 @@
+/************************************************************************
+ *
+ *  Microbenchmark for the BPv7 block codec
+ *
+ *  This times the encode and decode of the common block types, with the
+ *  specialized codec path enabled and disabled, and confirms that both
+ *  produce identical encoded data.
+ *
+ *************************************************************************/
+
+/*************************************************************************
+ * Includes
+ *************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bplib.h"
+#include "v7_types.h"
+#include "v7_codec.h"
+#include "v7_mpool.h"
+#include "v7_mpool_bblocks.h"
+
+#define CODECBENCH_POOL_SIZE      (4 * 1024 * 1024)
+#define CODECBENCH_ITERATIONS     200000
+#define CODECBENCH_MAINTAIN_EVERY 256
+#define CODECBENCH_PAYLOAD_SIZE   64
+#define CODECBENCH_BUFFER_SIZE    512
+
+typedef enum
+{
+    codecbench_op_encode_pri,
+    codecbench_op_decode_pri,
+    codecbench_op_encode_pay,
+    codecbench_op_decode_pay,
+    codecbench_op_encode_hop,
+    codecbench_op_decode_hop,
+    codecbench_op_max
+} codecbench_op_t;
+
+static const char *const CODECBENCH_OP_NAMES[codecbench_op_max] = {
+    "primary encode", "primary decode",   "payload encode",
+    "payload decode", "hop count encode", "hop count decode",
+};
+
+typedef struct codecbench_state
+{
+    bplib_mpool_t                  *pool;
+    bplib_mpool_bblock_primary_t   *cpb;
+    bplib_mpool_bblock_canonical_t *pay;
+    bplib_mpool_bblock_canonical_t *hop;
+    uint8_t                         payload[CODECBENCH_PAYLOAD_SIZE];
+    uint8_t                         encoded[CODECBENCH_BUFFER_SIZE];
+    size_t                          pri_size;
+    size_t                          pay_size;
+    size_t                          hop_size;
+} codecbench_state_t;
+
+static double codecbench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+static void codecbench_set_ipn(bp_endpointid_buffer_t *eid, bp_ipn_nodenumber_t node, bp_ipn_servicenumber_t service)
+{
+    eid->scheme                 = bp_endpointid_scheme_ipn;
+    eid->ssp.ipn.node_number    = node;
+    eid->ssp.ipn.service_number = service;
+}
+
+static int codecbench_setup(codecbench_state_t *st)
+{
+    bp_primary_block_t          *pri;
+    bp_canonical_block_buffer_t *logical;
+    size_t                       i;
+
+    st->pool = bplib_mpool_create(malloc(CODECBENCH_POOL_SIZE), CODECBENCH_POOL_SIZE);
+    if (st->pool == NULL)
+    {
+        fprintf(stderr, "Failed to create memory pool\n");
+        return -1;
+    }
+
+    st->cpb = bplib_mpool_bblock_primary_cast(bplib_mpool_bblock_primary_alloc(st->pool));
+    st->pay = bplib_mpool_bblock_canonical_cast(bplib_mpool_bblock_canonical_alloc(st->pool));
+    st->hop = bplib_mpool_bblock_canonical_cast(bplib_mpool_bblock_canonical_alloc(st->pool));
+    if (st->cpb == NULL || st->pay == NULL || st->hop == NULL)
+    {
+        fprintf(stderr, "Failed to allocate blocks\n");
+        return -1;
+    }
+
+    /* a typical primary block - IPN scheme, CRC16, not a fragment */
+    pri          = bplib_mpool_bblock_primary_get_logical(st->cpb);
+    pri->version = 7;
+    pri->crctype = bp_crctype_CRC16;
+    codecbench_set_ipn(&pri->destinationEID, 101, 1);
+    codecbench_set_ipn(&pri->sourceEID, 100, 42);
+    codecbench_set_ipn(&pri->reportEID, 100, 0);
+    pri->controlFlags.mustNotFragment   = true;
+    pri->creationTimeStamp.time         = 742176000123;
+    pri->creationTimeStamp.sequence_num = 12345;
+    pri->lifetime                       = 3600000;
+
+    logical                            = bplib_mpool_bblock_canonical_get_logical(st->pay);
+    logical->canonical_block.blockType = bp_blocktype_payloadBlock;
+    logical->canonical_block.blockNum  = 1;
+    logical->canonical_block.crctype   = bp_crctype_CRC32C;
+
+    logical                                = bplib_mpool_bblock_canonical_get_logical(st->hop);
+    logical->canonical_block.blockType     = bp_blocktype_hopCount;
+    logical->canonical_block.blockNum      = 2;
+    logical->canonical_block.crctype       = bp_crctype_CRC16;
+    logical->data.hop_count_block.hopLimit = 30;
+    logical->data.hop_count_block.hopCount = 3;
+
+    for (i = 0; i < sizeof(st->payload); ++i)
+    {
+        st->payload[i] = (uint8_t)(i * 7);
+    }
+
+    return 0;
+}
+
+/*
+ * Encodes all the test blocks into the flat buffer, back to back
+ */
+static int codecbench_encode_all(codecbench_state_t *st)
+{
+    if (v7_block_encode_pri(st->cpb) != 0 ||
+        v7_block_encode_pay(st->pay, st->payload, sizeof(st->payload)) != 0 ||
+        v7_block_encode_canonical(st->hop) != 0)
+    {
+        return -1;
+    }
+
+    st->pri_size = bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_primary_get_encoded_chunks(st->cpb), st->encoded,
+                                                  sizeof(st->encoded), 0, -1);
+    st->pay_size = bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_canonical_get_encoded_chunks(st->pay),
+                                                  &st->encoded[st->pri_size], sizeof(st->encoded) - st->pri_size, 0,
+                                                  -1);
+    st->hop_size = bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_canonical_get_encoded_chunks(st->hop),
+                                                  &st->encoded[st->pri_size + st->pay_size],
+                                                  sizeof(st->encoded) - st->pri_size - st->pay_size, 0, -1);
+
+    if (st->pri_size == 0 || st->pay_size == 0 || st->hop_size == 0)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static int codecbench_run_op(codecbench_state_t *st, codecbench_op_t op)
+{
+    const uint8_t *pay_data;
+    const uint8_t *hop_data;
+
+    pay_data = &st->encoded[st->pri_size];
+    hop_data = &st->encoded[st->pri_size + st->pay_size];
+
+    switch (op)
+    {
+        case codecbench_op_encode_pri:
+            return v7_block_encode_pri(st->cpb);
+        case codecbench_op_decode_pri:
+            return v7_block_decode_pri(st->cpb, st->encoded, st->pri_size, false);
+        case codecbench_op_encode_pay:
+            return v7_block_encode_pay(st->pay, st->payload, sizeof(st->payload));
+        case codecbench_op_decode_pay:
+            return v7_block_decode_canonical(st->pay, pay_data, st->pay_size, bp_blocktype_undefined, false);
+        case codecbench_op_encode_hop:
+            return v7_block_encode_canonical(st->hop);
+        case codecbench_op_decode_hop:
+            return v7_block_decode_canonical(st->hop, hop_data, st->hop_size, bp_blocktype_undefined, false);
+        default:
+            break;
+    }
+
+    return -1;
+}
+
+static double codecbench_time_op(codecbench_state_t *st, codecbench_op_t op)
+{
+    double   start;
+    double   elapsed;
+    uint32_t i;
+
+    elapsed = 0.0;
+    start   = 0.0;
+    for (i = 0; i < CODECBENCH_ITERATIONS; ++i)
+    {
+        if ((i % CODECBENCH_MAINTAIN_EVERY) == 0)
+        {
+            /* garbage collection of the dropped encode chunks is not counted */
+            if (i > 0)
+            {
+                elapsed += codecbench_now() - start;
+            }
+            bplib_mpool_maintain(st->pool);
+            start = codecbench_now();
+        }
+
+        if (codecbench_run_op(st, op) != 0)
+        {
+            fprintf(stderr, "Failed %s at iteration %lu\n", CODECBENCH_OP_NAMES[op], (unsigned long)i);
+            return -1.0;
+        }
+    }
+
+    elapsed += codecbench_now() - start;
+
+    return (elapsed * 1e9) / CODECBENCH_ITERATIONS;
+}
+
+/******************************************************************************
+ * Main
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    static codecbench_state_t st;
+    uint8_t                   reference[CODECBENCH_BUFFER_SIZE];
+    size_t                    reference_size;
+    double                    generic_ns[codecbench_op_max];
+    double                    fast_ns[codecbench_op_max];
+    codecbench_op_t           op;
+
+    if (bplib_init() != 0)
+    {
+        fprintf(stderr, "Failed bplib_init()... exiting\n");
+        return EXIT_FAILURE;
+    }
+
+    if (codecbench_setup(&st) != 0)
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* Both paths must produce the same octets */
+    v7_codec_enable_fast_path(false);
+    if (codecbench_encode_all(&st) != 0)
+    {
+        fprintf(stderr, "Generic encode failed\n");
+        return EXIT_FAILURE;
+    }
+    reference_size = st.pri_size + st.pay_size + st.hop_size;
+    memcpy(reference, st.encoded, reference_size);
+
+    v7_codec_enable_fast_path(true);
+    if (codecbench_encode_all(&st) != 0)
+    {
+        fprintf(stderr, "Specialized encode failed\n");
+        return EXIT_FAILURE;
+    }
+    if ((st.pri_size + st.pay_size + st.hop_size) != reference_size ||
+        memcmp(reference, st.encoded, reference_size) != 0)
+    {
+        fprintf(stderr, "Encoded data does not match between generic and specialized codec\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Encoded sizes: primary=%lu payload=%lu hop count=%lu\n", (unsigned long)st.pri_size,
+           (unsigned long)st.pay_size, (unsigned long)st.hop_size);
+
+    for (op = 0; op < codecbench_op_max; ++op)
+    {
+        v7_codec_enable_fast_path(false);
+        generic_ns[op] = codecbench_time_op(&st, op);
+        v7_codec_enable_fast_path(true);
+        fast_ns[op] = codecbench_time_op(&st, op);
+
+        if (generic_ns[op] < 0 || fast_ns[op] < 0)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%-20s %12s %12s %8s\n", "operation", "generic ns", "fast ns", "speedup");
+    for (op = 0; op < codecbench_op_max; ++op)
+    {
+        printf("%-20s %12.1f %12.1f %7.2fx\n", CODECBENCH_OP_NAMES[op], generic_ns[op], fast_ns[op],
+               generic_ns[op] / fast_ns[op]);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -198,7 +198,8 @@ static bp_flash_driver_t lbplib_flash_driver = {.num_blocks      = FLASH_SIM_NUM
                                                 .write           = bplib_flash_sim_page_write,
                                                 .erase           = bplib_flash_sim_block_erase,
                                                 .isbad           = bplib_flash_sim_block_is_bad,
-                                                .phyblk          = bplib_flash_sim_physical_block};
+                                                .phyblk          = bplib_flash_sim_physical_block,
+                                                .erase_count     = bplib_flash_sim_block_erase_count};
 
 /* Lua Flash Simulation */
 static bool lbplib_flash_sim_initialized = false;
@@ -765,6 +766,26 @@ int lbplib_unittest(lua_State *L)
             {
                 failures += bplib_unittest_flash();
             }
+
+            if ((strcmp("ALL", test) == 0) || (strcmp("REASSEMBLY", test) == 0))
+            {
+                failures += bplib_unittest_reassembly();
+            }
+
+            if ((strcmp("ALL", test) == 0) || (strcmp("AGGREGATE", test) == 0))
+            {
+                failures += bplib_unittest_aggregate();
+            }
+
+            if ((strcmp("ALL", test) == 0) || (strcmp("LZC", test) == 0))
+            {
+                failures += bplib_unittest_lzc();
+            }
+
+            if ((strcmp("ALL", test) == 0) || (strcmp("FILE", test) == 0))
+            {
+                failures += bplib_unittest_file();
+            }
         }
     }
 
@@ -849,6 +870,12 @@ int lbplib_flashsim(lua_State *L)
             lua_pushstring(L, "errors");
             lua_pushnumber(L, stats.error_count);
             lua_settable(L, -3);
+            lua_pushstring(L, "min_erases");
+            lua_pushnumber(L, stats.min_erase_count);
+            lua_settable(L, -3);
+            lua_pushstring(L, "max_erases");
+            lua_pushnumber(L, stats.max_erase_count);
+            lua_settable(L, -3);
             return 1;
         }
         else if (strcmp(cmdstr, "INIT") == 0)
@@ -32,6 +32,102 @@
  TYPEDEFS
  ******************************************************************************/
 
+/*
+ * Counters describing how well custody acknowledgements are being aggregated.
+ *
+ * The fill ratio of generated DACS bundles is total_ranges / (dacs_generated * BP_DACS_MAX_SEQ_RANGES_PER_PAYLOAD)
+ * and the mean aggregation latency is total_open_time / dacs_generated.
+ */
+typedef struct bplib_cache_dacs_stats
+{
+    uint32_t dacs_generated;  /**< number of DACS bundles closed and released for transmit */
+    uint32_t closed_full;     /**< number closed because every range slot was in use */
+    uint32_t closed_size;     /**< number closed because the encoded size reached the byte budget */
+    uint32_t closed_deadline; /**< number closed because the aggregation deadline passed */
+    uint64_t total_ranges;    /**< sum of ranges used across all generated DACS */
+    uint64_t total_seqs;      /**< sum of sequence numbers acknowledged across all generated DACS */
+    uint64_t total_open_time; /**< sum of time (ms) each DACS was held open before closing */
+    uint64_t max_open_time;   /**< longest time (ms) any DACS was held open */
+    uint64_t rtt_estimate;    /**< current smoothed custody round-trip time (ms), 0 if not yet observed */
+} bplib_cache_dacs_stats_t;
+
+/*
+ * Order in which bundles that are due for [re]transmit are handed to the egress path,
+ * when there are more of them than the egress path can take at once.
+ */
+typedef enum bplib_cache_retx_order
+{
+    bplib_cache_retx_order_oldest_first,    /**< lowest creation time first */
+    bplib_cache_retx_order_newest_first,    /**< highest creation time first, for freshest data */
+    bplib_cache_retx_order_earliest_expiry, /**< bundles closest to the end of their lifetime first */
+    bplib_cache_retx_order_fair_share,      /**< round robin between destination nodes */
+    bplib_cache_retx_order_max
+} bplib_cache_retx_order_t;
+
+/*
+ * Scheduling policy of a cache instance.  All times are in milliseconds.
+ *
+ * A new policy is applied by the maintenance task on the next poll of the cache, not by the
+ * caller of bplib_cache_set_policy().
+ */
+typedef struct bplib_cache_policy
+{
+    bplib_cache_retx_order_t retx_order;
+    uint32_t                 fast_retry_time; /**< recheck interval for bundles blocked on a temporary condition */
+    uint32_t                 idle_retry_time; /**< recheck interval for bundles that are not expecting any action */
+    uint32_t                 age_out_time;    /**< holdover time for metadata of bundles no longer in custody */
+} bplib_cache_policy_t;
+
+/*
+ * What a cache instance does when storing a bundle would exceed one of its quotas.
+ *
+ * The priority of a bundle is taken from its delivery policy: best effort bundles rank below
+ * locally acknowledged bundles, which rank below custody tracked bundles.
+ */
+typedef enum bplib_cache_evict_policy
+{
+    bplib_cache_evict_none,              /**< never evict, new bundles are refused until space frees up */
+    bplib_cache_evict_nearest_expiry,    /**< drop the bundles closest to the end of their lifetime */
+    bplib_cache_evict_non_custody_first, /**< drop bundles not under custody tracking, oldest first, but never others */
+    bplib_cache_evict_lowest_priority,   /**< drop the lowest priority bundles, nearest expiry first among equals */
+    bplib_cache_evict_max
+} bplib_cache_evict_policy_t;
+
+/*
+ * Storage limits of a cache instance.  A limit of 0 means unlimited.
+ *
+ * Like the policy, new limits are applied by the maintenance task on the next poll of the cache.
+ *
+ * Byte limits apply to the encoded size of the stored bundles.  The global limits also cover
+ * the memory pool itself: the cache treats a pool that is close to running out of bundle
+ * blocks the same as reaching max_entries.
+ *
+ * As the global usage nears a limit, the cache marks its parent interface as congested, and
+ * the data service sockets under that interface stop accepting new bundles, so bplib_send()
+ * blocks until the cache has drained or the send times out.
+ */
+typedef struct bplib_cache_quota
+{
+    bplib_cache_evict_policy_t evict_policy;
+    uint32_t                   max_entries;      /**< bundles held across all destinations */
+    uint32_t                   max_dest_entries; /**< bundles held for any single destination node */
+    uint64_t                   max_bytes;        /**< bytes held across all destinations */
+    uint64_t                   max_dest_bytes;   /**< bytes held for any single destination node */
+} bplib_cache_quota_t;
+
+/*
+ * Counters describing the use of the quotas of a cache instance.
+ */
+typedef struct bplib_cache_quota_stats
+{
+    uint32_t stored_entries;    /**< bundles currently counted against the quota */
+    uint64_t stored_bytes;      /**< bytes currently counted against the quota */
+    uint32_t evicted;           /**< bundles dropped to make room for others */
+    uint32_t refused;           /**< bundles not stored because no room could be made */
+    uint32_t congestion_events; /**< number of times backpressure was applied to the parent interface */
+    bool     is_congested;      /**< whether backpressure is currently applied */
+} bplib_cache_quota_stats_t;
+
 /******************************************************************************
  PROTOTYPES
  ******************************************************************************/
@@ -40,6 +136,15 @@
 bp_handle_t bplib_cache_attach(bplib_routetbl_t *tbl, const bp_ipn_addr_t *service_addr);
 int         bplib_cache_detach(bplib_routetbl_t *tbl, const bp_ipn_addr_t *service_addr);
 
+int bplib_cache_set_policy(bplib_routetbl_t *tbl, bp_handle_t intf_id, const bplib_cache_policy_t *policy);
+int bplib_cache_get_policy(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_policy_t *policy);
+
+int bplib_cache_set_quota(bplib_routetbl_t *tbl, bp_handle_t intf_id, const bplib_cache_quota_t *quota);
+int bplib_cache_get_quota(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_quota_t *quota);
+int bplib_cache_get_quota_stats(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_quota_stats_t *stats);
+
+int bplib_cache_get_dacs_stats(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_dacs_stats_t *stats);
+
 void bplib_cache_debug_scan(bplib_routetbl_t *tbl, bp_handle_t intf_id);
 
 #endif /* v7_cache_h */
@@ -59,6 +59,7 @@ void bplib_cache_entry_make_pending(bplib_mpool_block_t *qblk, uint32_t set_flag
 int bplib_cache_handle_ref_recycle(void *arg, bplib_mpool_block_t *rblk)
 {
     bplib_cache_blockref_t *block_ref;
+    bplib_cache_entry_t    *store_entry;
 
     block_ref = bplib_mpool_generic_data_cast(rblk, BPLIB_STORE_SIGNATURE_BLOCKREF);
     if (block_ref == NULL)
@@ -68,6 +69,13 @@ int bplib_cache_handle_ref_recycle(void *arg, bplib_mpool_block_t *rblk)
 
     assert(block_ref->storage_entry_block != NULL);
 
+    store_entry = bplib_mpool_generic_data_cast(block_ref->storage_entry_block, BPLIB_STORE_SIGNATURE_ENTRY);
+    if (store_entry != NULL && store_entry->parent->queued_count > 0)
+    {
+        /* this frees up room for the release windows to send more */
+        --store_entry->parent->queued_count;
+    }
+
     /*
      * always put back into pending_list, this will re-evalute its current
      * state and reclassify it as appropriate.  This also clears the BPLIB_STORE_FLAG_LOCALLY_QUEUED
@@ -181,6 +189,8 @@ int bplib_cache_construct_entry(void *arg, bplib_mpool_block_t *sblk)
     bplib_mpool_init_secondary_link(sblk, &store_entry->hash_link, bplib_mpool_blocktype_secondary_generic);
     bplib_mpool_init_secondary_link(sblk, &store_entry->time_link, bplib_mpool_blocktype_secondary_generic);
     bplib_mpool_init_secondary_link(sblk, &store_entry->destination_link, bplib_mpool_blocktype_secondary_generic);
+    bplib_mpool_init_secondary_link(sblk, &store_entry->ready_link, bplib_mpool_blocktype_secondary_generic);
+    bplib_mpool_init_secondary_link(sblk, &store_entry->evict_link, bplib_mpool_blocktype_secondary_generic);
 
     return BP_SUCCESS;
 }
@@ -199,9 +209,12 @@ int bplib_cache_destruct_entry(void *arg, bplib_mpool_block_t *sblk)
     state = store_entry->parent;
 
     /* need to make sure this is removed from all index trees */
+    /* the quota goes first, as it refers to the queue in the dest_eid_index */
+    bplib_cache_quota_remove(state, store_entry);
     bplib_cache_remove_from_subindex(&state->hash_index, &store_entry->hash_link);
     bplib_cache_remove_from_subindex(&state->time_index, &store_entry->time_link);
     bplib_cache_remove_from_subindex(&state->dest_eid_index, &store_entry->destination_link);
+    bplib_cache_fsm_remove_ready(state, store_entry);
 
     /* release the refptr */
     bplib_mpool_ref_release(store_entry->refptr);
@@ -212,11 +225,12 @@ int bplib_cache_destruct_entry(void *arg, bplib_mpool_block_t *sblk)
 
 int bplib_cache_egress_impl(void *arg, bplib_mpool_block_t *subq_src)
 {
-    bplib_mpool_flow_t  *flow;
-    bplib_mpool_block_t *qblk;
-    bplib_mpool_block_t *intf_block;
-    bplib_cache_state_t *state;
-    int                  forward_count;
+    bplib_mpool_flow_t           *flow;
+    bplib_mpool_block_t          *qblk;
+    bplib_mpool_block_t          *intf_block;
+    bplib_cache_state_t          *state;
+    bplib_mpool_bblock_primary_t *pri_block;
+    int                           forward_count;
 
     intf_block = bplib_mpool_get_block_from_link(subq_src);
     state      = bplib_cache_get_state(intf_block);
@@ -244,8 +258,14 @@ int bplib_cache_egress_impl(void *arg, bplib_mpool_block_t *subq_src)
 
         ++forward_count;
 
+        /* Bundles received with the CRC check deferred must be checked before storing or consuming them */
+        pri_block = bplib_mpool_bblock_primary_cast(qblk);
+        if (pri_block != NULL && v7_verify_deferred_crc(pri_block) < 0)
+        {
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): dropping bundle with bad CRC\n", __func__);
+        }
         /* Is this a data bundle that needs to be stored, or is this a custody ack? */
-        if (!bplib_cache_custody_check_dacs(state, qblk))
+        else if (!bplib_cache_custody_check_dacs(state, qblk))
         {
             bplib_cache_custody_store_bundle(state, qblk);
         }
@@ -321,38 +341,164 @@ int bplib_cache_do_poll(bplib_cache_state_t *state)
     return BP_SUCCESS;
 }
 
-int bplib_cache_do_route_up(bplib_cache_state_t *state, bp_ipn_t dest, bp_ipn_t mask)
+static void bplib_cache_release_window_reset(bplib_cache_release_window_t *window, bp_ipn_t dest, bp_ipn_t mask)
+{
+    window->dest          = dest & mask;
+    window->mask          = mask;
+    window->next_key      = window->dest;
+    window->key_remaining = 0;
+}
+
+static void bplib_cache_release_window_pop(bplib_cache_ext_state_t *ext)
+{
+    --ext->num_release_windows;
+    if (ext->num_release_windows > 0)
+    {
+        memmove(&ext->release_windows[0], &ext->release_windows[1],
+                sizeof(ext->release_windows[0]) * ext->num_release_windows);
+    }
+}
+
+static uint32_t bplib_cache_count_queue_entries(bplib_cache_queue_t *store_queue)
 {
-    bplib_rbt_iter_t        rbt_it;
     bplib_mpool_list_iter_t list_it;
-    bplib_cache_queue_t    *store_queue;
-    bp_ipn_t                curr_ipn;
-    int                     rbt_status;
+    uint32_t                count;
     int                     list_status;
 
-    rbt_status = bplib_rbt_iter_goto_min(dest, &state->dest_eid_index, &rbt_it);
-    while (rbt_status == BP_SUCCESS)
+    count       = 0;
+    list_status = bplib_mpool_list_iter_goto_first(&store_queue->bundle_list, &list_it);
+    while (list_status == BP_SUCCESS)
     {
+        ++count;
+        list_status = bplib_mpool_list_iter_forward(&list_it);
+    }
+
+    return count;
+}
+
+static bool bplib_cache_entry_is_route_blocked(const bplib_cache_entry_t *store_entry)
+{
+    /* idle without any timer or queued copy means it is only waiting for a way out */
+    return (store_entry->state == bplib_cache_entry_state_idle &&
+            (store_entry->flags & BPLIB_STORE_FLAGS_ACTION_WAIT_STATE) == 0);
+}
+
+void bplib_cache_flush_route_release(bplib_cache_state_t *state)
+{
+    bplib_cache_release_window_t *window;
+    bplib_rbt_iter_t              rbt_it;
+    bplib_cache_queue_t          *store_queue;
+    bplib_cache_entry_t          *store_entry;
+    bplib_mpool_block_t          *dlink;
+    bplib_mpool_block_t          *sblk;
+    bplib_mpool_flow_t           *self_flow;
+    bp_ipn_t                      curr_ipn;
+
+    self_flow = bplib_cache_get_flow(state);
+
+    /* windows are serviced in the order that the routes came up */
+    while (state->ext->num_release_windows > 0 &&
+           (state->queued_count + state->ext->ready_count) < BP_CACHE_MAX_INFLIGHT &&
+           bplib_mpool_subq_workitem_may_push(&self_flow->ingress))
+    {
+        window = &state->ext->release_windows[0];
+
+        /* the tree position is looked up again every time, as releasing an entry may
+         * have removed it (and possibly its whole queue) from the index */
+        if (bplib_rbt_iter_goto_min(window->next_key, &state->dest_eid_index, &rbt_it) != BP_SUCCESS)
+        {
+            bplib_cache_release_window_pop(state->ext);
+            continue;
+        }
+
         curr_ipn = bplib_rbt_get_key_value(rbt_it.position);
-        if ((curr_ipn & mask) != dest)
+        if ((curr_ipn & window->mask) != window->dest)
         {
-            /* no longer a route match, all done */
-            break;
+            /* past the end of the route, this window is done */
+            bplib_cache_release_window_pop(state->ext);
+            continue;
         }
 
-        rbt_status  = bplib_rbt_iter_next(&rbt_it);
         store_queue = bplib_cache_queue_from_rbt_link(rbt_it.position);
+        if (curr_ipn != window->next_key || window->key_remaining == 0)
+        {
+            /* starting on a new destination */
+            window->next_key      = curr_ipn;
+            window->key_remaining = bplib_cache_count_queue_entries(store_queue);
+        }
 
-        /* put everything on the bundle list here onto the pending_list, but
-         * do not remove from the bundle list at this time */
-        list_status = bplib_mpool_list_iter_goto_first(&store_queue->bundle_list, &list_it);
-        while (list_status == BP_SUCCESS)
+        /*
+         * Entries are kept in each destination queue in the order they were stored.  Each one
+         * visited gets rotated to the back, so the queue is back in its original order once
+         * all of key_remaining have been visited, and the next call picks up where this one left off.
+         */
+        dlink = bplib_mpool_get_next_block(&store_queue->bundle_list);
+        bplib_mpool_extract_node(dlink);
+        bplib_mpool_insert_before(&store_queue->bundle_list, dlink);
+
+        --window->key_remaining;
+        if (window->key_remaining == 0)
         {
-            bplib_cache_entry_make_pending(list_it.position, 0, 0);
-            list_status = bplib_mpool_list_iter_forward(&list_it);
+            if (curr_ipn == (window->dest | ~window->mask))
+            {
+                /* this was the last possible destination for this route */
+                bplib_cache_release_window_pop(state->ext);
+            }
+            else
+            {
+                window->next_key = curr_ipn + 1;
+            }
+        }
+
+        sblk        = bplib_mpool_get_block_from_link(dlink);
+        store_entry = bplib_mpool_generic_data_cast(sblk, BPLIB_STORE_SIGNATURE_ENTRY);
+        if (store_entry != NULL && bplib_cache_entry_is_route_blocked(store_entry))
+        {
+            bplib_mpool_extract_node(sblk);
+            bplib_cache_fsm_execute(sblk);
+        }
+    }
+}
+
+int bplib_cache_do_route_up(bplib_cache_state_t *state, bp_ipn_t dest, bp_ipn_t mask)
+{
+    bplib_cache_ext_state_t      *ext;
+    bplib_cache_release_window_t *window;
+    uint32_t                      pos;
+
+    ext = state->ext;
+    dest &= mask;
+
+    for (pos = 0; pos < ext->num_release_windows; ++pos)
+    {
+        window = &ext->release_windows[pos];
+        if (window->dest == dest && window->mask == mask)
+        {
+            /* same route came up again, start this one over */
+            bplib_cache_release_window_reset(window, dest, mask);
+            return BP_SUCCESS;
         }
     }
 
+    if (ext->num_release_windows < BP_CACHE_RELEASE_MAX_WINDOWS)
+    {
+        window = &ext->release_windows[ext->num_release_windows];
+        ++ext->num_release_windows;
+    }
+    else
+    {
+        /* out of windows, so widen the last one until it covers this route too */
+        window = &ext->release_windows[ext->num_release_windows - 1];
+        mask &= window->mask;
+        while (((dest ^ window->dest) & mask) != 0)
+        {
+            mask <<= 1;
+        }
+        dest &= mask;
+    }
+
+    bplib_cache_release_window_reset(window, dest, mask);
+
     return BP_SUCCESS;
 }
 
@@ -374,6 +520,74 @@ int bplib_cache_do_intf_statechange(bplib_cache_state_t *state, bool is_up)
     return BP_SUCCESS;
 }
 
+void bplib_cache_apply_policy(bplib_cache_state_t *state, const bplib_cache_policy_t *policy)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_rbt_iter_t         rbt_it;
+    bplib_cache_queue_t     *store_queue;
+    bplib_mpool_block_t      rekey_list;
+    bplib_mpool_block_t     *rlink;
+    bplib_cache_retx_order_t prev_order;
+
+    ext         = state->ext;
+    prev_order  = ext->policy.retx_order;
+    ext->policy = *policy;
+
+    if (prev_order != policy->retx_order)
+    {
+        /* the keys in the ready index depend on the order, so anything in there needs to be put back in again */
+        bplib_mpool_init_list_head(NULL, &rekey_list);
+        while (bplib_rbt_iter_goto_min(0, &ext->ready_index, &rbt_it) == BP_SUCCESS)
+        {
+            store_queue = bplib_cache_queue_from_rbt_link(rbt_it.position);
+            rlink       = bplib_mpool_get_next_block(&store_queue->bundle_list);
+            bplib_cache_remove_from_subindex(&ext->ready_index, rlink);
+            bplib_mpool_insert_before(&rekey_list, rlink);
+        }
+
+        ext->ready_count = 0;
+        ext->ready_round = 0;
+
+        while (!bplib_mpool_is_empty_list_head(&rekey_list))
+        {
+            rlink = bplib_mpool_get_next_block(&rekey_list);
+            bplib_mpool_extract_node(rlink);
+            bplib_cache_fsm_make_ready(state, bplib_mpool_generic_data_cast(bplib_mpool_get_block_from_link(rlink),
+                                                                            BPLIB_STORE_SIGNATURE_ENTRY));
+        }
+    }
+}
+
+void bplib_cache_apply_pending_config(bplib_cache_state_t *state)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_cache_policy_t     policy;
+    bplib_cache_quota_t      quota;
+    bool                     policy_pending;
+    bool                     quota_pending;
+
+    ext = state->ext;
+
+    bplib_os_lock(ext->config_lock);
+    policy_pending      = ext->policy_pending;
+    policy              = ext->pending_policy;
+    ext->policy_pending = false;
+    quota_pending       = ext->quota_pending;
+    quota               = ext->pending_quota;
+    ext->quota_pending  = false;
+    bplib_os_unlock(ext->config_lock);
+
+    if (policy_pending)
+    {
+        bplib_cache_apply_policy(state, &policy);
+    }
+
+    if (quota_pending)
+    {
+        bplib_cache_quota_apply(state, &quota);
+    }
+}
+
 int bplib_cache_event_impl(void *event_arg, bplib_mpool_block_t *intf_block)
 {
     bplib_cache_state_t              *state;
@@ -389,6 +603,10 @@ int bplib_cache_event_impl(void *event_arg, bplib_mpool_block_t *intf_block)
     }
 
     state->action_time = bplib_os_get_dtntime_ms();
+
+    /* configuration changes from the API are applied here, on the same task as everything else */
+    bplib_cache_apply_pending_config(state);
+
     if (event->event_type == bplib_mpool_flow_event_poll)
     {
         bplib_cache_do_poll(state);
@@ -398,10 +616,23 @@ int bplib_cache_event_impl(void *event_arg, bplib_mpool_block_t *intf_block)
     {
         bplib_cache_do_intf_statechange(state, event->event_type == bplib_mpool_flow_event_up);
     }
+    else if (event->event_type == bplib_mpool_flow_event_route_up)
+    {
+        bplib_cache_do_route_up(state, event->route_state.dest, event->route_state.mask);
+    }
 
     /* any sort of action may have put bundles in the pending queue, so flush it now */
     bplib_cache_flush_pending(state);
 
+    /* whatever room is left goes to bundles held for routes that came up */
+    bplib_cache_flush_route_release(state);
+
+    /* now send whatever is ready, in the order chosen by the policy */
+    bplib_cache_fsm_flush_ready(state);
+
+    /* the pool may have recovered (or not) since the last check, this is not tied to any particular entry */
+    bplib_cache_quota_update_congestion(state);
+
     return BP_SUCCESS;
 }
 
@@ -445,6 +676,47 @@ int bplib_cache_destruct_state(void *arg, bplib_mpool_block_t *sblk)
     assert(bplib_mpool_is_link_unattached(&state->idle_list));
     assert(bplib_mpool_is_link_unattached(&state->pending_list));
 
+    /* the extended state goes with the last ref to the state, not with the detach, as
+     * anything still holding a ref (e.g. a bundle in the egress path) may still use it */
+    if (state->ext != NULL)
+    {
+        assert(bplib_rbt_tree_is_empty(&state->ext->ready_index));
+        assert(bplib_rbt_tree_is_empty(&state->ext->evict_index));
+
+        if (bp_handle_is_valid(state->ext->config_lock))
+        {
+            bplib_os_destroylock(state->ext->config_lock);
+        }
+
+        bplib_mpool_recycle_block(state->ext->self_block);
+        state->ext = NULL;
+    }
+
+    return BP_SUCCESS;
+}
+
+int bplib_cache_construct_ext_state(void *arg, bplib_mpool_block_t *sblk)
+{
+    bplib_cache_ext_state_t *ext;
+
+    ext = bplib_mpool_generic_data_cast(sblk, BPLIB_STORE_SIGNATURE_EXT_STATE);
+    if (ext == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    ext->self_block = sblk;
+
+    ext->policy.retx_order      = bplib_cache_retx_order_oldest_first;
+    ext->policy.fast_retry_time = BP_CACHE_FAST_RETRY_TIME;
+    ext->policy.idle_retry_time = BP_CACHE_IDLE_RETRY_TIME;
+    ext->policy.age_out_time    = BP_CACHE_AGE_OUT_TIME;
+
+    bplib_rbt_init_root(&ext->ready_index);
+
+    /* all limits are 0 (unlimited) by default, and evict_policy is none */
+    bplib_rbt_init_root(&ext->evict_index);
+
     return BP_SUCCESS;
 }
 
@@ -474,6 +746,11 @@ void bplib_cache_init(bplib_mpool_t *pool)
         .destruct  = bplib_cache_destruct_state,
     };
 
+    const bplib_mpool_blocktype_api_t ext_state_api = (bplib_mpool_blocktype_api_t) {
+        .construct = bplib_cache_construct_ext_state,
+        .destruct  = NULL,
+    };
+
     const bplib_mpool_blocktype_api_t entry_api = (bplib_mpool_blocktype_api_t) {
         .construct = bplib_cache_construct_entry,
         .destruct  = bplib_cache_destruct_entry,
@@ -490,6 +767,8 @@ void bplib_cache_init(bplib_mpool_t *pool)
     };
 
     bplib_mpool_register_blocktype(pool, BPLIB_STORE_SIGNATURE_STATE, &state_api, sizeof(bplib_cache_state_t));
+    bplib_mpool_register_blocktype(pool, BPLIB_STORE_SIGNATURE_EXT_STATE, &ext_state_api,
+                                   sizeof(bplib_cache_ext_state_t));
     bplib_mpool_register_blocktype(pool, BPLIB_STORE_SIGNATURE_ENTRY, &entry_api, sizeof(bplib_cache_entry_t));
     bplib_mpool_register_blocktype(pool, BPLIB_STORE_SIGNATURE_QUEUE, &queue_api, sizeof(bplib_cache_queue_t));
     bplib_mpool_register_blocktype(pool, BPLIB_STORE_SIGNATURE_BLOCKREF, &blockref_api, sizeof(bplib_cache_blockref_t));
@@ -519,6 +798,23 @@ bp_handle_t bplib_cache_attach(bplib_routetbl_t *tbl, const bp_ipn_addr_t *servi
     flow_block_ref = bplib_mpool_ref_create(sblk);
     state          = bplib_mpool_generic_data_cast(sblk, BPLIB_STORE_SIGNATURE_STATE);
 
+    state->ext = bplib_mpool_generic_data_cast(
+        bplib_mpool_generic_data_alloc(pool, BPLIB_STORE_SIGNATURE_EXT_STATE, state), BPLIB_STORE_SIGNATURE_EXT_STATE);
+    if (state->ext == NULL)
+    {
+        bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): Insufficient memory to create file storage\n", __func__);
+        bplib_mpool_ref_release(flow_block_ref);
+        return BP_INVALID_HANDLE;
+    }
+
+    state->ext->config_lock = bplib_os_createlock();
+    if (!bp_handle_is_valid(state->ext->config_lock))
+    {
+        bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): Cannot create cache config lock\n", __func__);
+        bplib_mpool_ref_release(flow_block_ref);
+        return BP_INVALID_HANDLE;
+    }
+
     storage_intf_id = bplib_dataservice_attach(tbl, service_addr, bplib_dataservice_type_storage, flow_block_ref);
     if (!bp_handle_is_valid(storage_intf_id))
     {
@@ -572,10 +868,242 @@ int bplib_cache_detach(bplib_routetbl_t *tbl, const bp_ipn_addr_t *service_addr)
     return status;
 }
 
-void bplib_cache_debug_scan(bplib_routetbl_t *tbl, bp_handle_t intf_id)
+int bplib_cache_set_policy(bplib_routetbl_t *tbl, bp_handle_t intf_id, const bplib_cache_policy_t *policy)
+{
+    bplib_mpool_ref_t        intf_block_ref;
+    bplib_cache_state_t     *state;
+    bplib_cache_ext_state_t *ext;
+    int                      status;
+
+    if (policy->retx_order >= bplib_cache_retx_order_max || policy->fast_retry_time == 0 ||
+        policy->idle_retry_time == 0 || policy->age_out_time == 0)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): invalid cache policy\n", __func__);
+        return BP_ERROR;
+    }
+
+    intf_block_ref = bplib_route_get_intf_controlblock(tbl, intf_id);
+    if (intf_block_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf invalid\n", __func__);
+        return BP_ERROR;
+    }
+
+    state = bplib_cache_get_state(bplib_mpool_dereference(intf_block_ref));
+    if (state == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf is not a storage cache\n", __func__);
+        status = BP_ERROR;
+    }
+    else
+    {
+        /* the ready index is owned by the maintenance task, so the re-keying happens there */
+        ext = state->ext;
+        bplib_os_lock(ext->config_lock);
+        ext->pending_policy = *policy;
+        ext->policy_pending = true;
+        bplib_os_unlock(ext->config_lock);
+
+        bplib_route_set_maintenance_request(tbl);
+
+        status = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(tbl, intf_block_ref);
+
+    return status;
+}
+
+int bplib_cache_get_policy(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_policy_t *policy)
+{
+    bplib_mpool_ref_t    intf_block_ref;
+    bplib_cache_state_t *state;
+    int                  status;
+
+    intf_block_ref = bplib_route_get_intf_controlblock(tbl, intf_id);
+    if (intf_block_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf invalid\n", __func__);
+        return BP_ERROR;
+    }
+
+    state = bplib_cache_get_state(bplib_mpool_dereference(intf_block_ref));
+    if (state == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf is not a storage cache\n", __func__);
+        status = BP_ERROR;
+    }
+    else
+    {
+        /* report a policy that is set but not applied yet as the current one */
+        bplib_os_lock(state->ext->config_lock);
+        if (state->ext->policy_pending)
+        {
+            *policy = state->ext->pending_policy;
+        }
+        else
+        {
+            *policy = state->ext->policy;
+        }
+        bplib_os_unlock(state->ext->config_lock);
+
+        status = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(tbl, intf_block_ref);
+
+    return status;
+}
+
+int bplib_cache_set_quota(bplib_routetbl_t *tbl, bp_handle_t intf_id, const bplib_cache_quota_t *quota)
+{
+    bplib_mpool_ref_t        intf_block_ref;
+    bplib_cache_state_t     *state;
+    bplib_cache_ext_state_t *ext;
+    int                      status;
+
+    if (quota->evict_policy >= bplib_cache_evict_max)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): invalid cache quota\n", __func__);
+        return BP_ERROR;
+    }
+
+    intf_block_ref = bplib_route_get_intf_controlblock(tbl, intf_id);
+    if (intf_block_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf invalid\n", __func__);
+        return BP_ERROR;
+    }
+
+    state = bplib_cache_get_state(bplib_mpool_dereference(intf_block_ref));
+    if (state == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf is not a storage cache\n", __func__);
+        status = BP_ERROR;
+    }
+    else
+    {
+        /* the evict index is owned by the maintenance task, so the re-keying happens there */
+        ext = state->ext;
+        bplib_os_lock(ext->config_lock);
+        ext->pending_quota = *quota;
+        ext->quota_pending = true;
+        bplib_os_unlock(ext->config_lock);
+
+        bplib_route_set_maintenance_request(tbl);
+
+        status = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(tbl, intf_block_ref);
+
+    return status;
+}
+
+int bplib_cache_get_quota(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_quota_t *quota)
+{
+    bplib_mpool_ref_t    intf_block_ref;
+    bplib_cache_state_t *state;
+    int                  status;
+
+    intf_block_ref = bplib_route_get_intf_controlblock(tbl, intf_id);
+    if (intf_block_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf invalid\n", __func__);
+        return BP_ERROR;
+    }
+
+    state = bplib_cache_get_state(bplib_mpool_dereference(intf_block_ref));
+    if (state == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf is not a storage cache\n", __func__);
+        status = BP_ERROR;
+    }
+    else
+    {
+        /* report a quota that is set but not applied yet as the current one */
+        bplib_os_lock(state->ext->config_lock);
+        if (state->ext->quota_pending)
+        {
+            *quota = state->ext->pending_quota;
+        }
+        else
+        {
+            *quota = state->ext->quota;
+        }
+        bplib_os_unlock(state->ext->config_lock);
+
+        status = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(tbl, intf_block_ref);
+
+    return status;
+}
+
+int bplib_cache_get_quota_stats(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_quota_stats_t *stats)
+{
+    bplib_mpool_ref_t    intf_block_ref;
+    bplib_cache_state_t *state;
+    int                  status;
+
+    intf_block_ref = bplib_route_get_intf_controlblock(tbl, intf_id);
+    if (intf_block_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf invalid\n", __func__);
+        return BP_ERROR;
+    }
+
+    state = bplib_cache_get_state(bplib_mpool_dereference(intf_block_ref));
+    if (state == NULL)
+    {
+        status = BP_ERROR;
+    }
+    else
+    {
+        *stats = state->ext->quota_stats;
+        status = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(tbl, intf_block_ref);
+
+    return status;
+}
+
+int bplib_cache_get_dacs_stats(bplib_routetbl_t *tbl, bp_handle_t intf_id, bplib_cache_dacs_stats_t *stats)
 {
     bplib_mpool_ref_t    intf_block_ref;
     bplib_cache_state_t *state;
+    int                  status;
+
+    intf_block_ref = bplib_route_get_intf_controlblock(tbl, intf_id);
+    if (intf_block_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): Parent intf invalid\n", __func__);
+        return BP_ERROR;
+    }
+
+    state = bplib_cache_get_state(bplib_mpool_dereference(intf_block_ref));
+    if (state == NULL)
+    {
+        status = BP_ERROR;
+    }
+    else
+    {
+        *stats = state->ext->dacs_stats;
+        status = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(tbl, intf_block_ref);
+
+    return status;
+}
+
+void bplib_cache_debug_scan(bplib_routetbl_t *tbl, bp_handle_t intf_id)
+{
+    bplib_mpool_ref_t               intf_block_ref;
+    bplib_cache_state_t            *state;
+    const bplib_cache_dacs_stats_t *stats;
 
     intf_block_ref = bplib_route_get_intf_controlblock(tbl, intf_id);
     if (intf_block_ref == NULL)
@@ -596,5 +1124,11 @@ void bplib_cache_debug_scan(bplib_routetbl_t *tbl, bp_handle_t intf_id)
     bplib_mpool_debug_print_list_stats(&state->pending_list, "pending_list");
     bplib_mpool_debug_print_list_stats(&state->idle_list, "idle_list");
 
+    stats = &state->ext->dacs_stats;
+    printf("DEBUG: %s() dacs generated=%lu full=%lu size=%lu deadline=%lu ranges=%lu seqs=%lu rtt=%lu\n", __func__,
+           (unsigned long)stats->dacs_generated, (unsigned long)stats->closed_full, (unsigned long)stats->closed_size,
+           (unsigned long)stats->closed_deadline, (unsigned long)stats->total_ranges, (unsigned long)stats->total_seqs,
+           (unsigned long)state->ext->custody_rtt_estimate);
+
     bplib_route_release_intf_controlblock(tbl, intf_block_ref);
 }
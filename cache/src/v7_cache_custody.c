@@ -235,6 +235,109 @@ bplib_mpool_ref_t bplib_cache_custody_create_dacs(bplib_cache_state_t
     return bplib_mpool_ref_create(pblk);
 }
 
+static uint64_t bplib_cache_custody_dacs_open_time(const bplib_cache_state_t *state)
+{
+    uint64_t open_time;
+
+    /* until a round trip has been observed there is nothing to base this on, so use the upper limit */
+    if (state->ext->custody_rtt_estimate == 0)
+    {
+        return BP_CACHE_DACS_OPEN_TIME;
+    }
+
+    open_time = state->ext->custody_rtt_estimate >> BP_CACHE_DACS_RTT_FRACTION_SHIFT;
+    if (open_time < BP_CACHE_DACS_MIN_OPEN_TIME)
+    {
+        open_time = BP_CACHE_DACS_MIN_OPEN_TIME;
+    }
+    else if (open_time > BP_CACHE_DACS_OPEN_TIME)
+    {
+        open_time = BP_CACHE_DACS_OPEN_TIME;
+    }
+
+    return open_time;
+}
+
+static size_t bplib_cache_custody_cbor_uint_size(bp_integer_t val)
+{
+    if (val < 24)
+    {
+        return 1;
+    }
+    if (val <= 0xFF)
+    {
+        return 2;
+    }
+    if (val <= 0xFFFF)
+    {
+        return 3;
+    }
+    if (val <= 0xFFFFFFFF)
+    {
+        return 5;
+    }
+    return 9;
+}
+
+/*
+ * Predicts the size of the encoded DACS payload content.  This mirrors the layout
+ * produced by the codec: [rectype, [eid, [[start, length], ...]]]
+ */
+static size_t bplib_cache_custody_dacs_encode_size(const bp_custody_accept_payload_block_t *payload)
+{
+    size_t       size;
+    bp_integer_t i;
+
+    /* outer admin record array, rectype, the acceptance block array, and the EID arrays + scheme */
+    size = 6;
+    size += bplib_cache_custody_cbor_uint_size(payload->flow_source_eid.ssp.ipn.node_number);
+    size += bplib_cache_custody_cbor_uint_size(payload->flow_source_eid.ssp.ipn.service_number);
+    size += bplib_cache_custody_cbor_uint_size(payload->num_ranges);
+
+    for (i = 0; i < payload->num_ranges; ++i)
+    {
+        size += 1 + bplib_cache_custody_cbor_uint_size(payload->seq_ranges[i].start) +
+                bplib_cache_custody_cbor_uint_size(payload->seq_ranges[i].length);
+    }
+
+    return size;
+}
+
+static void bplib_cache_custody_update_rtt(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    bplib_mpool_bblock_primary_t *pri_block;
+    bplib_cache_ext_state_t      *ext;
+    uint64_t                      sample;
+
+    /* only the first acknowledgement of a bundle is a valid sample; duplicates would skew it */
+    if ((store_entry->flags & BPLIB_STORE_FLAG_LOCAL_CUSTODY) == 0)
+    {
+        return;
+    }
+
+    pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
+    if (pri_block == NULL || pri_block->delivery_data.egress_time == 0 ||
+        pri_block->delivery_data.egress_time > state->action_time)
+    {
+        return;
+    }
+
+    ext    = state->ext;
+    sample = state->action_time - pri_block->delivery_data.egress_time;
+    if (ext->custody_rtt_estimate == 0)
+    {
+        ext->custody_rtt_estimate = sample;
+    }
+    else
+    {
+        /* exponentially weighted moving average, in the same manner as TCP SRTT */
+        ext->custody_rtt_estimate -= ext->custody_rtt_estimate >> BP_CACHE_DACS_RTT_SMOOTHING_SHIFT;
+        ext->custody_rtt_estimate += sample >> BP_CACHE_DACS_RTT_SMOOTHING_SHIFT;
+    }
+
+    ext->dacs_stats.rtt_estimate = ext->custody_rtt_estimate;
+}
+
 void bplib_cache_custody_open_dacs(bplib_cache_state_t *state, bplib_cache_custodian_info_t *custody_info)
 {
     bplib_mpool_block_t               *sblk;
@@ -264,7 +367,7 @@ void bplib_cache_custody_open_dacs(bplib_cache_state_t *state, bplib_cache_custo
 
         /* the "action_time" reflects when this bundle will be finalized and sent, until
          * then it is open for appending with additional sequence numbers. */
-        store_entry->action_time = pri_block->delivery_data.ingress_time + BP_CACHE_DACS_OPEN_TIME;
+        store_entry->action_time = pri_block->delivery_data.ingress_time + bplib_cache_custody_dacs_open_time(state);
         store_entry->refptr      = bplib_mpool_ref_duplicate(pending_bundle);
 
         /* the ack will be sent to the previous custodian of record */
@@ -297,36 +400,134 @@ void bplib_cache_custody_open_dacs(bplib_cache_state_t *state, bplib_cache_custo
     bplib_mpool_ref_release(pending_bundle);
 }
 
+/*
+ * Adds a sequence number to the ordered range set within a DACS payload.
+ *
+ * The ranges are kept sorted by starting sequence number, and adjacent ranges are always
+ * coalesced, so a contiguous run of sequence numbers only ever consumes a single entry no
+ * matter how long it gets.  The usual case is in-order arrival, which simply extends the
+ * last range.
+ *
+ * Returns false if the number required a new range but the payload had no room for it.
+ */
+static bool bplib_cache_custody_insert_dacs_seq(bp_custody_accept_payload_block_t *payload, bp_sequencenumber_t seq)
+{
+    bp_custody_seq_range_t *prev;
+    bp_custody_seq_range_t *next;
+    bp_integer_t            pos;
+    bp_integer_t            limit;
+    bp_integer_t            mid;
+
+    /* binary search for the first range that starts after seq */
+    pos   = 0;
+    limit = payload->num_ranges;
+    while (pos < limit)
+    {
+        mid = pos + ((limit - pos) / 2);
+        if (payload->seq_ranges[mid].start > seq)
+        {
+            limit = mid;
+        }
+        else
+        {
+            pos = mid + 1;
+        }
+    }
+
+    /* the range just before this position is the only one that could contain seq */
+    if (pos > 0)
+    {
+        prev = &payload->seq_ranges[pos - 1];
+    }
+    else
+    {
+        prev = NULL;
+    }
+
+    if (pos < payload->num_ranges)
+    {
+        next = &payload->seq_ranges[pos];
+    }
+    else
+    {
+        next = NULL;
+    }
+
+    if (prev != NULL && (seq - prev->start) < prev->length)
+    {
+        /* already in the set, this can happen if a duplicate is recvd */
+        return true;
+    }
+
+    if (prev != NULL && (seq - prev->start) == prev->length)
+    {
+        /* extends the previous range, which may now also close the gap to the next range */
+        ++prev->length;
+        if (next != NULL && next->start == (seq + 1))
+        {
+            prev->length += next->length;
+            --payload->num_ranges;
+            memmove(next, next + 1, (payload->num_ranges - pos) * sizeof(*next));
+        }
+        return true;
+    }
+
+    if (next != NULL && next->start == (seq + 1))
+    {
+        /* extends the next range downward */
+        next->start = seq;
+        ++next->length;
+        return true;
+    }
+
+    if (payload->num_ranges >= BP_DACS_MAX_SEQ_RANGES_PER_PAYLOAD)
+    {
+        return false;
+    }
+
+    /* needs a new range of its own, opening a slot at this position */
+    memmove(&payload->seq_ranges[pos + 1], &payload->seq_ranges[pos],
+            (payload->num_ranges - pos) * sizeof(payload->seq_ranges[0]));
+    payload->seq_ranges[pos].start  = seq;
+    payload->seq_ranges[pos].length = 1;
+    ++payload->num_ranges;
+
+    return true;
+}
+
 void bplib_cache_custody_append_dacs(bplib_cache_state_t *state, bplib_cache_custodian_info_t *custody_info)
 {
     bp_custody_accept_payload_block_t *payload;
-    bp_integer_t                       i;
 
     if (custody_info->store_entry != NULL)
     {
         payload = custody_info->store_entry->data.dacs.payload_ref;
 
-        /* check if this seq is already in the payload, this can happen if a duplicate is recvd */
-        for (i = 0; i < payload->num_entries; ++i)
+        if (!bplib_cache_custody_insert_dacs_seq(payload, custody_info->sequence_num))
         {
-            if (payload->sequence_nums[i] == custody_info->sequence_num)
-            {
-                break;
-            }
+            /* this should not happen, as the DACS is finalized as soon as all ranges are in use */
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): DACS full, seq %lu not acknowledged\n", __func__,
+                  (unsigned long)custody_info->sequence_num);
         }
 
-        if (i == payload->num_entries && i < BP_DACS_MAX_SEQ_PER_PAYLOAD)
+        /* if DACS bundle is full now, or another range might not fit in the budget, mark it as "done" */
+        if (payload->num_ranges == BP_DACS_MAX_SEQ_RANGES_PER_PAYLOAD)
         {
-            payload->sequence_nums[i] = custody_info->sequence_num;
-            ++payload->num_entries;
+            ++state->ext->dacs_stats.closed_full;
         }
-
-        /* if DACS bundle is full now, mark it as "done" */
-        if (payload->num_entries == BP_DACS_MAX_SEQ_PER_PAYLOAD)
+        else if ((bplib_cache_custody_dacs_encode_size(payload) + BP_CACHE_DACS_MAX_RANGE_ENCODE_SIZE) >
+                 BP_CACHE_DACS_MAX_CONTENT_SIZE)
         {
-            bplib_cache_custody_finalize_dacs(state, custody_info->store_entry);
-            bplib_cache_entry_make_pending(&custody_info->store_entry->hash_link, 0, BPLIB_STORE_FLAG_ACTION_TIME_WAIT);
+            ++state->ext->dacs_stats.closed_size;
         }
+        else
+        {
+            /* still open */
+            return;
+        }
+
+        bplib_cache_custody_finalize_dacs(state, custody_info->store_entry);
+        bplib_cache_entry_make_pending(&custody_info->store_entry->hash_link, 0, BPLIB_STORE_FLAG_ACTION_TIME_WAIT);
     }
 }
 
@@ -480,34 +681,160 @@ bool bplib_cache_custody_find_existing_bundle(bplib_cache_state_t *state, bplib_
     return (sblk != NULL);
 }
 
+static void bplib_cache_custody_ack_entry(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    bplib_cache_custody_update_rtt(state, store_entry);
+
+    /* confirmed that another custodian has the bundle -
+     * can clear the flag that says we are the active custodian, and reevaluate */
+    bplib_cache_entry_make_pending(&store_entry->hash_link, 0, BPLIB_STORE_FLAG_LOCAL_CUSTODY);
+}
+
+static bool bplib_cache_custody_long_range_contains(const bp_custody_accept_payload_block_t *ack_payload,
+                                                    bp_sequencenumber_t                      sequence_num)
+{
+    const bp_custody_seq_range_t *range;
+    bp_integer_t                  i;
+
+    for (i = 0; i < ack_payload->num_ranges; ++i)
+    {
+        range = &ack_payload->seq_ranges[i];
+        if (range->length > BP_CACHE_DACS_MAX_RANGE_LOOKUPS && sequence_num >= range->start &&
+            (sequence_num - range->start) < range->length)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void bplib_cache_custody_ack_long_ranges(bplib_cache_state_t                     *state,
+                                                const bplib_cache_custodian_info_t      *custody_info,
+                                                const bp_custody_accept_payload_block_t *ack_payload)
+{
+    bplib_rbt_iter_t              rbt_it;
+    bplib_mpool_list_iter_t       list_it;
+    bplib_cache_queue_t          *store_queue;
+    bplib_cache_entry_t          *store_entry;
+    bplib_mpool_bblock_primary_t *pri_block;
+    bplib_mpool_block_t          *sblk;
+    int                           rbt_status;
+    int                           list_status;
+
+    /*
+     * Walk every entry the cache holds once, rather than every sequence number in the ranges.
+     * Acknowledging an entry only moves the entry block itself to the pending_list, its
+     * hash_link stays put, so neither iterator is disturbed by this.
+     */
+    rbt_status = bplib_rbt_iter_goto_min(0, &state->hash_index, &rbt_it);
+    while (rbt_status == BP_SUCCESS)
+    {
+        store_queue = bplib_cache_queue_from_rbt_link(rbt_it.position);
+
+        list_status = bplib_mpool_list_iter_goto_first(&store_queue->bundle_list, &list_it);
+        while (list_status == BP_SUCCESS)
+        {
+            sblk        = bplib_mpool_get_block_from_link(list_it.position);
+            store_entry = bplib_mpool_generic_data_cast(sblk, BPLIB_STORE_SIGNATURE_ENTRY);
+            if (store_entry != NULL && store_entry->state != bplib_cache_entry_state_generate_dacs)
+            {
+                pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
+                if (pri_block != NULL &&
+                    bplib_cache_custody_long_range_contains(
+                        ack_payload, pri_block->pri_logical_data.creationTimeStamp.sequence_num) &&
+                    v7_compare_ipn2eid(&custody_info->flow_id, &pri_block->pri_logical_data.sourceEID) == 0)
+                {
+                    store_entry->flags |= BPLIB_STORE_FLAG_ACTIVITY;
+                    bplib_cache_custody_ack_entry(state, store_entry);
+                }
+            }
+
+            list_status = bplib_mpool_list_iter_forward(&list_it);
+        }
+
+        rbt_status = bplib_rbt_iter_next(&rbt_it);
+    }
+}
+
 void bplib_cache_custody_process_remote_dacs_bundle(bplib_cache_state_t *state, bplib_mpool_bblock_primary_t *pri_block,
                                                     const bp_custody_accept_payload_block_t *ack_payload)
 {
-    bp_integer_t                 i;
-    bplib_cache_custodian_info_t custody_info;
+    bp_integer_t                  i;
+    bp_integer_t                  n;
+    const bp_custody_seq_range_t *range;
+    bplib_cache_custodian_info_t  custody_info;
+    bool                          has_long_range;
 
     memset(&custody_info, 0, sizeof(custody_info));
 
     v7_get_eid(&custody_info.custodian_id, &pri_block->pri_logical_data.destinationEID);
     v7_get_eid(&custody_info.flow_id, &ack_payload->flow_source_eid);
 
-    for (i = 0; i < ack_payload->num_entries; ++i)
+    has_long_range = false;
+    for (i = 0; i < ack_payload->num_ranges; ++i)
     {
-        custody_info.sequence_num = ack_payload->sequence_nums[i];
-        if (bplib_cache_custody_find_existing_bundle(state, &custody_info))
+        range = &ack_payload->seq_ranges[i];
+
+        /* the length came off the wire, so it is not trusted to bound a loop */
+        if (range->length > BP_CACHE_DACS_MAX_RANGE_LOOKUPS)
         {
-            /* found it ! */
-            printf("%s(): Got custody ACK for seq %lu\n", __func__, (unsigned long)custody_info.sequence_num);
+            has_long_range = true;
+            continue;
+        }
 
-            /* confirmed that another custodian has the bundle -
-             * can clear the flag that says we are the active custodian, and reevaluate */
-            bplib_cache_entry_make_pending(&custody_info.store_entry->hash_link, 0, BPLIB_STORE_FLAG_LOCAL_CUSTODY);
+        for (n = 0; n < range->length; ++n)
+        {
+            custody_info.sequence_num = range->start + n;
+            if (bplib_cache_custody_find_existing_bundle(state, &custody_info))
+            {
+                /* found it ! */
+                bplib_cache_custody_ack_entry(state, custody_info.store_entry);
+            }
         }
     }
+
+    if (has_long_range)
+    {
+        bplib_cache_custody_ack_long_ranges(state, &custody_info, ack_payload);
+    }
 }
 
 void bplib_cache_custody_finalize_dacs(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
 {
+    bplib_mpool_bblock_primary_t            *pri_block;
+    const bp_custody_accept_payload_block_t *payload;
+    bplib_cache_dacs_stats_t                *stats;
+    uint64_t                                 open_time;
+    bp_integer_t                             i;
+
+    /* this may be invoked more than once for the same entry, only the first time counts */
+    if (bplib_mpool_is_link_unattached(&store_entry->hash_link))
+    {
+        return;
+    }
+
+    payload = store_entry->data.dacs.payload_ref;
+    stats   = &state->ext->dacs_stats;
+
+    ++stats->dacs_generated;
+    stats->total_ranges += payload->num_ranges;
+    for (i = 0; i < payload->num_ranges; ++i)
+    {
+        stats->total_seqs += payload->seq_ranges[i].length;
+    }
+
+    pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
+    if (pri_block != NULL && state->action_time > pri_block->delivery_data.ingress_time)
+    {
+        open_time = state->action_time - pri_block->delivery_data.ingress_time;
+        stats->total_open_time += open_time;
+        if (open_time > stats->max_open_time)
+        {
+            stats->max_open_time = open_time;
+        }
+    }
+
     /* after this point, the entry becomes a normal bundle, it is removed from EID hash
      * so future appends are also prevented */
     bplib_cache_remove_from_subindex(&state->hash_index, &store_entry->hash_link);
@@ -541,6 +868,7 @@ void bplib_cache_custody_store_bundle(bplib_cache_state_t *state, bplib_mpool_bl
     bplib_mpool_block_t          *sblk;
     bplib_mpool_bblock_primary_t *pri_block;
     bplib_cache_custodian_info_t  custody_info;
+    size_t                        bundle_size;
 
     memset(&custody_info, 0, sizeof(custody_info));
     sblk      = NULL;
@@ -562,6 +890,15 @@ void bplib_cache_custody_store_bundle(bplib_cache_state_t *state, bplib_mpool_bl
         return;
     }
 
+    /* make sure it fits within the quotas, this may evict other bundles to make room */
+    bundle_size = v7_compute_full_bundle_size(pri_block);
+    if (!bplib_cache_quota_admit(state, custody_info.final_dest_node, bundle_size))
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): cache quota reached, bundle for node %lu not stored\n", __func__,
+              (unsigned long)custody_info.final_dest_node);
+        return;
+    }
+
     /* Create the storage-specific data block for keeping local refs  */
     sblk = bplib_mpool_generic_data_alloc(bplib_cache_parent_pool(state), BPLIB_STORE_SIGNATURE_ENTRY, state);
 
@@ -582,6 +919,9 @@ void bplib_cache_custody_store_bundle(bplib_cache_state_t *state, bplib_mpool_bl
          * so make an entry in the hash index for it */
         bplib_cache_add_to_subindex(&state->hash_index, &custody_info.store_entry->hash_link, custody_info.eid_hash);
 
+        /* this must be done after it is in the dest_eid_index, so the per-destination usage is counted */
+        bplib_cache_quota_add(state, custody_info.store_entry, custody_info.final_dest_node, bundle_size);
+
         custody_info.store_entry->flags |= BPLIB_STORE_FLAG_LOCAL_CUSTODY | BPLIB_STORE_FLAG_ACTIVITY;
 
         pri_block->delivery_data.storage_intf_id = bplib_mpool_get_external_id(bplib_cache_state_self_block(state));
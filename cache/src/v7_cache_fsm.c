@@ -84,12 +84,162 @@ static bplib_cache_entry_state_t bplib_cache_fsm_state_queue_eval(bplib_cache_en
     return bplib_cache_entry_state_queue; /* no change */
 }
 
-static void bplib_cache_fsm_state_queue_enter(bplib_cache_entry_t *store_entry)
+static bp_val_t bplib_cache_fsm_ready_key(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    bplib_cache_ext_state_t      *ext;
+    bplib_mpool_bblock_primary_t *pri_block;
+    bp_primary_block_t           *pri;
+    bplib_cache_queue_t          *dest_queue;
+    bplib_rbt_link_t             *rbt_link;
+    bp_ipn_addr_t                 dest_addr;
+    bp_val_t                      key;
+
+    ext       = state->ext;
+    pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
+    if (pri_block == NULL)
+    {
+        return 0;
+    }
+
+    pri = bplib_mpool_bblock_primary_get_logical(pri_block);
+
+    /* the time based keys are put in buckets like the time index, to limit the number of queue blocks used */
+    switch (ext->policy.retx_order)
+    {
+        case bplib_cache_retx_order_newest_first:
+            key = ~(pri->creationTimeStamp.time >> BP_CACHE_TIME_BUCKET_SHIFT);
+            break;
+
+        case bplib_cache_retx_order_earliest_expiry:
+            key = (pri->creationTimeStamp.time + pri->lifetime) >> BP_CACHE_TIME_BUCKET_SHIFT;
+            break;
+
+        case bplib_cache_retx_order_fair_share:
+            /*
+             * Each destination gets at most one entry per round.  A destination that has not had
+             * anything ready for a while starts in the current round, rather than catching up.
+             */
+            key = ext->ready_round;
+
+            v7_get_eid(&dest_addr, &pri->destinationEID);
+            rbt_link = bplib_rbt_search(dest_addr.node_number, &state->dest_eid_index);
+            if (rbt_link != NULL)
+            {
+                dest_queue = bplib_cache_queue_from_rbt_link(rbt_link);
+                if (key <= dest_queue->fair_round)
+                {
+                    key = dest_queue->fair_round + 1;
+                }
+                dest_queue->fair_round = key;
+            }
+            break;
+
+        case bplib_cache_retx_order_oldest_first:
+        default:
+            key = pri->creationTimeStamp.time >> BP_CACHE_TIME_BUCKET_SHIFT;
+            break;
+    }
+
+    return key;
+}
+
+void bplib_cache_fsm_make_ready(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    bplib_cache_add_to_subindex(&state->ext->ready_index, &store_entry->ready_link,
+                                bplib_cache_fsm_ready_key(state, store_entry));
+    ++state->ext->ready_count;
+}
+
+void bplib_cache_fsm_remove_ready(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    if (bplib_mpool_is_link_attached(&store_entry->ready_link))
+    {
+        bplib_cache_remove_from_subindex(&state->ext->ready_index, &store_entry->ready_link);
+        --state->ext->ready_count;
+    }
+}
+
+static void bplib_cache_fsm_push_egress(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
 {
     bplib_mpool_block_t          *rblk;
     bplib_mpool_bblock_primary_t *pri_block;
     bplib_mpool_flow_t           *self_flow;
 
+    pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
+    if (pri_block != NULL && state->action_time >= (pri_block->pri_logical_data.creationTimeStamp.time +
+                                                    pri_block->pri_logical_data.lifetime))
+    {
+        /* it expired while waiting its turn, so do not bother sending it (the idle state will discard it) */
+        rblk = NULL;
+    }
+    else
+    {
+        rblk = bplib_mpool_ref_make_block(store_entry->refptr, BPLIB_STORE_SIGNATURE_BLOCKREF, store_entry);
+    }
+
+    if (rblk == NULL)
+    {
+        bplib_cache_entry_make_pending(&store_entry->hash_link, 0, BPLIB_STORE_FLAG_LOCALLY_QUEUED);
+        return;
+    }
+
+    /*
+     * If it fails to push to the queue, it is immediately recycled, and when the destructor runs
+     * the flag will be cleared and queued_count decremented as normal.
+     */
+    self_flow = bplib_cache_get_flow(state);
+    ++state->queued_count;
+    if (!bplib_mpool_flow_try_push(&self_flow->ingress, rblk, 0))
+    {
+        bplib_mpool_recycle_block(rblk);
+    }
+}
+
+void bplib_cache_fsm_flush_ready(bplib_cache_state_t *state)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_mpool_flow_t      *self_flow;
+    bplib_rbt_iter_t         rbt_it;
+    bplib_cache_queue_t     *store_queue;
+    bplib_mpool_block_t     *rlink;
+    bplib_cache_entry_t     *store_entry;
+
+    ext       = state->ext;
+    self_flow = bplib_cache_get_flow(state);
+
+    while (ext->ready_count > 0 && state->queued_count < BP_CACHE_MAX_INFLIGHT &&
+           bplib_mpool_subq_workitem_may_push(&self_flow->ingress))
+    {
+        if (bplib_rbt_iter_goto_min(0, &ext->ready_index, &rbt_it) != BP_SUCCESS)
+        {
+            break;
+        }
+
+        /* entries with the same key are taken in the order they were made ready */
+        store_queue = bplib_cache_queue_from_rbt_link(rbt_it.position);
+        rlink       = bplib_mpool_get_next_block(&store_queue->bundle_list);
+        store_entry =
+            bplib_mpool_generic_data_cast(bplib_mpool_get_block_from_link(rlink), BPLIB_STORE_SIGNATURE_ENTRY);
+
+        if (ext->policy.retx_order == bplib_cache_retx_order_fair_share)
+        {
+            ext->ready_round = bplib_rbt_get_key_value(rbt_it.position);
+        }
+
+        bplib_cache_remove_from_subindex(&ext->ready_index, rlink);
+        --ext->ready_count;
+
+        if (store_entry != NULL)
+        {
+            bplib_cache_fsm_push_egress(state, store_entry);
+        }
+    }
+}
+
+static void bplib_cache_fsm_state_queue_enter(bplib_cache_entry_t *store_entry)
+{
+    bplib_mpool_bblock_primary_t *pri_block;
+
     pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
 
     if (pri_block != NULL)
@@ -101,31 +251,24 @@ static void bplib_cache_fsm_state_queue_enter(bplib_cache_entry_t *store_entry)
         pri_block->delivery_data.egress_time    = 0;
     }
 
-    rblk = bplib_mpool_ref_make_block(store_entry->refptr, BPLIB_STORE_SIGNATURE_BLOCKREF, store_entry);
-    if (rblk != NULL)
-    {
-        self_flow = bplib_cache_get_flow(store_entry->parent);
-
-        /*
-         * note - the flag is always set here, even if it does not actually make it into the queue.
-         *
-         * If it fails to push to the queue, it is immediately recycled, and when the destructor runs
-         * the flag will be cleared as normal.  This keeps things synchronized in that it won't transition
-         * back to idle until the referring block is actually removed, even though it was never really
-         * queued.
-         */
-        store_entry->flags |= BPLIB_STORE_FLAG_LOCALLY_QUEUED;
-        if (!bplib_mpool_flow_try_push(&self_flow->ingress, rblk, 0))
-        {
-            bplib_mpool_recycle_block(rblk);
-        }
-    }
+    /*
+     * note - the flag is set here, when the entry goes into the ready index, not when it actually
+     * gets pushed to the egress path in bplib_cache_fsm_flush_ready().
+     *
+     * It will be cleared as normal when the referring block is recycled, or by bplib_cache_fsm_flush_ready()
+     * itself if it could not be sent.  This keeps things synchronized in that it won't transition
+     * back to idle until the entry has actually left the ready index and the egress path.
+     */
+    store_entry->flags |= BPLIB_STORE_FLAG_LOCALLY_QUEUED;
+    bplib_cache_fsm_make_ready(store_entry->parent, store_entry);
 }
 
 static void bplib_cache_fsm_state_queue_exit(bplib_cache_entry_t *store_entry)
 {
     bplib_mpool_bblock_primary_t *pri_block;
 
+    bplib_cache_fsm_remove_ready(store_entry->parent, store_entry);
+
     pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
 
     if (bp_handle_is_valid(pri_block->delivery_data.egress_intf_id) &&
@@ -151,7 +294,7 @@ static bplib_cache_entry_state_t bplib_cache_fsm_state_delete_eval(bplib_cache_e
         /* clear it now, it will be re-set if something uses this entry */
         store_entry->flags &= ~BPLIB_STORE_FLAG_ACTIVITY;
         store_entry->flags |= BPLIB_STORE_FLAG_ACTION_TIME_WAIT;
-        store_entry->action_time = store_entry->parent->action_time + BP_CACHE_AGE_OUT_TIME;
+        store_entry->action_time = store_entry->parent->action_time + store_entry->parent->ext->policy.age_out_time;
     }
 
     return bplib_cache_entry_state_delete;
@@ -163,6 +306,7 @@ static void bplib_cache_fsm_state_delete_enter(bplib_cache_entry_t *store_entry)
 
     /* the bundle will not be forwarded again, so content is no longer useful, but hang onto the metadata for now */
     /* this recovers the bulk of the memory associated with this bundle */
+    bplib_cache_quota_remove(store_entry->parent, store_entry);
     pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
     if (pri_block != NULL)
     {
@@ -171,7 +315,7 @@ static void bplib_cache_fsm_state_delete_enter(bplib_cache_entry_t *store_entry)
     }
 
     store_entry->flags |= BPLIB_STORE_FLAG_ACTION_TIME_WAIT;
-    store_entry->action_time = store_entry->parent->action_time + BP_CACHE_AGE_OUT_TIME;
+    store_entry->action_time = store_entry->parent->action_time + store_entry->parent->ext->policy.age_out_time;
 }
 
 static bplib_cache_entry_state_t bplib_cache_fsm_state_generate_dacs_eval(bplib_cache_entry_t *store_entry)
@@ -187,6 +331,12 @@ static bplib_cache_entry_state_t bplib_cache_fsm_state_generate_dacs_eval(bplib_
 
 static void bplib_cache_fsm_state_generate_dacs_exit(bplib_cache_entry_t *store_entry)
 {
+    /* if still open for appending at this point, it was the aggregation deadline that closed it */
+    if (bplib_mpool_is_link_attached(&store_entry->hash_link))
+    {
+        ++store_entry->parent->ext->dacs_stats.closed_deadline;
+    }
+
     bplib_cache_custody_finalize_dacs(store_entry->parent, store_entry);
 }
 
@@ -200,12 +350,12 @@ static void bplib_cache_fsm_reschedule(bplib_cache_state_t *state, bplib_cache_e
     {
         /* item is pending action but blocked for some (hopefully) temporary external reason, so retry more aggressively
          */
-        ref_time += BP_CACHE_FAST_RETRY_TIME;
+        ref_time += state->ext->policy.fast_retry_time;
     }
     else
     {
         /* item is blocked for now, but don't want to leave it in a state where it is never checked again at all */
-        ref_time += BP_CACHE_IDLE_RETRY_TIME;
+        ref_time += state->ext->policy.idle_retry_time;
     }
 
     /* calculate the time for the next action event */
@@ -39,10 +39,11 @@
  * Randomly-chosen 32-bit static values that can be put into
  * data structures to help positively identify those structs later.
  */
-#define BPLIB_STORE_SIGNATURE_STATE    0x683359a7
-#define BPLIB_STORE_SIGNATURE_ENTRY    0xf223fff9
-#define BPLIB_STORE_SIGNATURE_QUEUE    0x30241224
-#define BPLIB_STORE_SIGNATURE_BLOCKREF 0x77e96b11
+#define BPLIB_STORE_SIGNATURE_STATE     0x683359a7
+#define BPLIB_STORE_SIGNATURE_EXT_STATE 0x5c2e91d4
+#define BPLIB_STORE_SIGNATURE_ENTRY     0xf223fff9
+#define BPLIB_STORE_SIGNATURE_QUEUE     0x30241224
+#define BPLIB_STORE_SIGNATURE_BLOCKREF  0x77e96b11
 
 #define BPLIB_STORE_FLAG_ACTIVITY         0x01
 #define BPLIB_STORE_FLAG_LOCAL_CUSTODY    0x02
@@ -55,10 +56,75 @@
 #define BPLIB_STORE_FLAGS_ACTION_WAIT_STATE (BPLIB_STORE_FLAG_ACTION_TIME_WAIT | BPLIB_STORE_FLAG_LOCALLY_QUEUED)
 
 #define BP_CACHE_DACS_LIFETIME   86400000 /* 24 hrs */
-#define BP_CACHE_DACS_OPEN_TIME  10000    /* 10 sec */
-#define BP_CACHE_FAST_RETRY_TIME 3000     /* 3 sec */
-#define BP_CACHE_IDLE_RETRY_TIME 3600000  /* 1 hour */
-#define BP_CACHE_AGE_OUT_TIME    60000    /* 1 minute */
+#define BP_CACHE_DACS_OPEN_TIME  10000    /* 10 sec, upper bound on the DACS aggregation window */
+#define BP_CACHE_FAST_RETRY_TIME 3000     /* 3 sec, default, see bplib_cache_policy_t */
+#define BP_CACHE_IDLE_RETRY_TIME 3600000  /* 1 hour, default, see bplib_cache_policy_t */
+#define BP_CACHE_AGE_OUT_TIME    60000    /* 1 minute, default, see bplib_cache_policy_t */
+
+/*
+ * Adaptive DACS aggregation
+ *
+ * An open DACS is closed as soon as any of these is true:
+ *  - all range slots in the payload are in use
+ *  - the encoded payload content would exceed BP_CACHE_DACS_MAX_CONTENT_SIZE
+ *  - the aggregation deadline passes
+ *
+ * The deadline is a fraction of the smoothed custody round-trip time observed by this
+ * cache (1/2^BP_CACHE_DACS_RTT_FRACTION_SHIFT), so the acknowledgement gets back to the
+ * previous custodian before its own retransmit timer fires.  It is kept between the
+ * MIN_OPEN_TIME and the OPEN_TIME limits, and OPEN_TIME is used until an RTT is known.
+ */
+#define BP_CACHE_DACS_MIN_OPEN_TIME         250 /* 250 ms */
+#define BP_CACHE_DACS_MAX_CONTENT_SIZE      200 /* bytes, must fit in the extension block encode buffer */
+#define BP_CACHE_DACS_RTT_FRACTION_SHIFT    1   /* close after 1/2 RTT */
+#define BP_CACHE_DACS_RTT_SMOOTHING_SHIFT   3   /* new RTT samples have 1/8 weight */
+#define BP_CACHE_DACS_MAX_RANGE_ENCODE_SIZE 19  /* CBOR array(2) header + two 64-bit uints */
+
+/*
+ * Received DACS ranges up to this length are matched by looking up each sequence number in the
+ * hash index.  Longer ranges are matched with a single walk over the entries the cache actually
+ * holds, so the work done is bounded by the cache size and not by a length from the wire.
+ */
+#define BP_CACHE_DACS_MAX_RANGE_LOOKUPS 64
+
+/*
+ * Retransmit scheduling
+ *
+ * Entries that are due for [re]transmit are not pushed to the egress path right away, they go
+ * into the ready index first.  This is keyed according to the retx_order of the cache policy and
+ * is drained from the lowest key up, as long as fewer than BP_CACHE_MAX_INFLIGHT bundle refs from
+ * this cache are still outstanding in the egress path.
+ */
+#define BP_CACHE_MAX_INFLIGHT 256
+
+/*
+ * Streaming release when a route comes up
+ *
+ * Rather than moving the whole backlog for a destination to the pending_list at once, a
+ * release window walks the dest_eid_index in key order and releases entries only while the
+ * ready index and the egress path together hold fewer than BP_CACHE_MAX_INFLIGHT entries.
+ * The walk resumes where it left off on the next flow event.
+ */
+#define BP_CACHE_RELEASE_MAX_WINDOWS 4
+
+/*
+ * Quotas and backpressure
+ *
+ * Backpressure is applied to the parent interface once the global usage gets within
+ * 1/2^BP_CACHE_QUOTA_HIGH_WATER_SHIFT of a limit, and released once it falls more than
+ * 1/2^BP_CACHE_QUOTA_LOW_WATER_SHIFT below it.  The memory pool counts as being at its limit
+ * when fewer than BP_CACHE_QUOTA_MIN_POOL_HEADROOM blocks are left for bundles.
+ */
+#define BP_CACHE_QUOTA_HIGH_WATER_SHIFT  3
+#define BP_CACHE_QUOTA_LOW_WATER_SHIFT   2
+#define BP_CACHE_QUOTA_MIN_POOL_HEADROOM 64
+
+/*
+ * Looking for a bundle to evict examines at most this many candidates, so storing a bundle
+ * takes bounded time.  Only entries in the egress path (at most BP_CACHE_MAX_INFLIGHT) are
+ * passed over in the global evict order; if no candidate can be dropped, the bundle is refused.
+ */
+#define BP_CACHE_QUOTA_MAX_VICTIM_SCAN (BP_CACHE_MAX_INFLIGHT + 64)
 
 /*
  * The size of the time "buckets" stored in the time index
@@ -74,6 +140,50 @@
 
 #define BP_CACHE_TIME_INFINITE BP_DTNTIME_INFINITE
 
+typedef struct bplib_cache_release_window
+{
+    bp_ipn_t dest;
+    bp_ipn_t mask;
+    bp_ipn_t next_key;      /**< next destination node in dest_eid_index to visit */
+    uint32_t key_remaining; /**< entries not yet visited under next_key, 0 if not started */
+} bplib_cache_release_window_t;
+
+/*
+ * The cache state lives in the user area of its flow block, which has very little room
+ * left over after the flow itself.  Anything else the cache needs to keep is held in this
+ * separate block, allocated when the cache is attached.
+ */
+typedef struct bplib_cache_ext_state
+{
+    bplib_mpool_block_t *self_block;
+
+    uint64_t                 custody_rtt_estimate; /**< smoothed custody round-trip time in ms, 0 if unknown */
+    bplib_cache_dacs_stats_t dacs_stats;
+
+    uint32_t                     num_release_windows;
+    bplib_cache_release_window_t release_windows[BP_CACHE_RELEASE_MAX_WINDOWS];
+
+    /*
+     * The API only stores a new policy or quota here, under config_lock.  It is applied by the
+     * event handler on the maintenance task, which is the only one that touches the indices.
+     */
+    bp_handle_t          config_lock;
+    bool                 policy_pending;
+    bplib_cache_policy_t pending_policy;
+    bool                 quota_pending;
+    bplib_cache_quota_t  pending_quota;
+
+    bplib_cache_policy_t policy;
+    bplib_rbt_root_t     ready_index;
+    uint32_t             ready_count; /**< entries currently in ready_index */
+    bp_val_t             ready_round; /**< fair share: round of the entry most recently taken from ready_index */
+
+    bplib_cache_quota_t       quota;
+    bplib_cache_quota_stats_t quota_stats;
+    bplib_rbt_root_t          evict_index; /**< entries counted against the quota, keyed by the evict_policy */
+
+} bplib_cache_ext_state_t;
+
 typedef struct bplib_cache_state
 {
     bp_ipn_addr_t self_addr;
@@ -104,6 +214,10 @@ typedef struct bplib_cache_state
 
     uint32_t generated_dacs_seq;
 
+    uint32_t queued_count; /**< bundle refs currently outstanding in the egress path */
+
+    bplib_cache_ext_state_t *ext;
+
 } bplib_cache_state_t;
 
 /*
@@ -125,8 +239,11 @@ typedef struct bplib_cache_state
  */
 typedef struct bplib_cache_queue
 {
-    bplib_rbt_link_t    rbt_link;    /* must be first */
-    bplib_mpool_block_t bundle_list; /* jphfix - subq? */
+    bplib_rbt_link_t    rbt_link;     /* must be first */
+    bplib_mpool_block_t bundle_list;  /* jphfix - subq? */
+    bp_val_t            fair_round;   /* dest_eid_index only: fair share round of the last entry made ready */
+    uint32_t            dest_entries; /* dest_eid_index only: entries counted against the quota */
+    uint64_t            dest_bytes;   /* dest_eid_index only: bytes counted against the quota */
 
 } bplib_cache_queue_t;
 
@@ -163,6 +280,10 @@ typedef struct bplib_cache_entry
     bplib_mpool_block_t       hash_link;
     bplib_mpool_block_t       time_link;
     bplib_mpool_block_t       destination_link;
+    bplib_mpool_block_t       ready_link;
+    bplib_mpool_block_t       evict_link; /**< in evict_index while counted against the quota */
+    bp_ipn_t                  quota_dest; /**< destination node the entry is counted against */
+    size_t                    quota_size; /**< bytes the entry is counted as */
     bplib_cache_entry_data_t  data;
 } bplib_cache_entry_t;
 
@@ -231,6 +352,15 @@ void bplib_cache_custody_store_bundle(bplib_cache_state_t *state, bplib_mpool_bl
 bool bplib_cache_custody_check_dacs(bplib_cache_state_t *state, bplib_mpool_block_t *qblk);
 
 void bplib_cache_fsm_execute(bplib_mpool_block_t *sblk);
+void bplib_cache_fsm_make_ready(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry);
+void bplib_cache_fsm_remove_ready(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry);
+void bplib_cache_fsm_flush_ready(bplib_cache_state_t *state);
+
+bool bplib_cache_quota_admit(bplib_cache_state_t *state, bp_ipn_t dest, size_t size);
+void bplib_cache_quota_add(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry, bp_ipn_t dest, size_t size);
+void bplib_cache_quota_remove(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry);
+void bplib_cache_quota_apply(bplib_cache_state_t *state, const bplib_cache_quota_t *quota);
+void bplib_cache_quota_update_congestion(bplib_cache_state_t *state);
 
 void bplib_cache_remove_from_subindex(bplib_rbt_root_t *index_root, bplib_mpool_block_t *index_link);
 void bplib_cache_add_to_subindex(bplib_rbt_root_t *index_root, bplib_mpool_block_t *index_link, bp_val_t index_val);
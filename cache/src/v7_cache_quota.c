@@ -0,0 +1,477 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include "v7_cache_internal.h"
+
+/*
+ * Under the non_custody_first policy, custody tracked bundles are keyed at or above this value,
+ * so they all sort after the bundles that may be evicted.
+ */
+#define BP_CACHE_QUOTA_CUSTODY_KEY ((bp_val_t)1 << 62)
+
+/*
+ * Under the lowest_priority policy, the delivery policy of the bundle is put in the key bits above this
+ */
+#define BP_CACHE_QUOTA_PRIORITY_SHIFT 56
+
+static bp_val_t bplib_cache_quota_evict_key(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    bplib_mpool_bblock_primary_t *pri_block;
+    bp_primary_block_t           *pri;
+    bp_val_t                      expire_key;
+    bp_val_t                      key;
+
+    pri_block = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(store_entry->refptr));
+    if (pri_block == NULL)
+    {
+        return 0;
+    }
+
+    pri        = bplib_mpool_bblock_primary_get_logical(pri_block);
+    expire_key = (pri->creationTimeStamp.time + pri->lifetime) >> BP_CACHE_TIME_BUCKET_SHIFT;
+
+    switch (state->ext->quota.evict_policy)
+    {
+        case bplib_cache_evict_non_custody_first:
+            key = pri->creationTimeStamp.time >> BP_CACHE_TIME_BUCKET_SHIFT;
+            if (pri_block->delivery_data.delivery_policy == bplib_policy_delivery_custody_tracking)
+            {
+                key |= BP_CACHE_QUOTA_CUSTODY_KEY;
+            }
+            break;
+
+        case bplib_cache_evict_lowest_priority:
+            key = ((bp_val_t)pri_block->delivery_data.delivery_policy << BP_CACHE_QUOTA_PRIORITY_SHIFT) |
+                  (expire_key & (((bp_val_t)1 << BP_CACHE_QUOTA_PRIORITY_SHIFT) - 1));
+            break;
+
+        case bplib_cache_evict_nearest_expiry:
+        case bplib_cache_evict_none:
+        default:
+            key = expire_key;
+            break;
+    }
+
+    return key;
+}
+
+static bplib_cache_queue_t *bplib_cache_quota_get_dest_queue(bplib_cache_state_t *state, bp_ipn_t dest)
+{
+    bplib_rbt_link_t *rbt_link;
+
+    rbt_link = bplib_rbt_search(dest, &state->dest_eid_index);
+    if (rbt_link == NULL)
+    {
+        return NULL;
+    }
+
+    return bplib_cache_queue_from_rbt_link(rbt_link);
+}
+
+static bool bplib_cache_quota_is_evictable(bplib_cache_state_t *state, const bplib_cache_entry_t *store_entry,
+                                           bp_val_t key)
+{
+    /* under non_custody_first, custody tracked bundles are never dropped */
+    if (state->ext->quota.evict_policy == bplib_cache_evict_non_custody_first && key >= BP_CACHE_QUOTA_CUSTODY_KEY)
+    {
+        return false;
+    }
+
+    return (store_entry->state == bplib_cache_entry_state_idle &&
+            bplib_mpool_is_link_attached(&store_entry->evict_link));
+}
+
+/*
+ * Finds the entry to drop first according to the evict_policy, optionally limited to one destination.
+ *
+ * Only idle entries are considered; anything else is either on its way out already, or
+ * currently referenced from the egress path.  No more than BP_CACHE_QUOTA_MAX_VICTIM_SCAN
+ * candidates are looked at.  When limited to one destination, the candidates come from the
+ * entries of that destination, in the order they were stored, rather than from the evict index.
+ */
+static bplib_cache_entry_t *bplib_cache_quota_find_victim(bplib_cache_state_t *state, const bp_ipn_t *dest)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_rbt_iter_t         rbt_it;
+    bplib_mpool_list_iter_t  list_it;
+    bplib_cache_queue_t     *store_queue;
+    bplib_cache_entry_t     *store_entry;
+    bplib_cache_entry_t     *victim;
+    bp_val_t                 key;
+    bp_val_t                 victim_key;
+    uint32_t                 scan_count;
+    int                      rbt_status;
+    int                      list_status;
+
+    ext = state->ext;
+    if (ext->quota.evict_policy == bplib_cache_evict_none)
+    {
+        return NULL;
+    }
+
+    scan_count = 0;
+
+    if (dest != NULL)
+    {
+        store_queue = bplib_cache_quota_get_dest_queue(state, *dest);
+        if (store_queue == NULL)
+        {
+            return NULL;
+        }
+
+        victim      = NULL;
+        victim_key  = 0;
+        list_status = bplib_mpool_list_iter_goto_first(&store_queue->bundle_list, &list_it);
+        while (list_status == BP_SUCCESS && scan_count < BP_CACHE_QUOTA_MAX_VICTIM_SCAN)
+        {
+            store_entry = bplib_mpool_generic_data_cast(bplib_mpool_get_block_from_link(list_it.position),
+                                                        BPLIB_STORE_SIGNATURE_ENTRY);
+            if (store_entry != NULL)
+            {
+                key = bplib_cache_quota_evict_key(state, store_entry);
+                if (bplib_cache_quota_is_evictable(state, store_entry, key) && (victim == NULL || key < victim_key))
+                {
+                    victim     = store_entry;
+                    victim_key = key;
+                }
+            }
+
+            ++scan_count;
+            list_status = bplib_mpool_list_iter_forward(&list_it);
+        }
+
+        return victim;
+    }
+
+    rbt_status = bplib_rbt_iter_goto_min(0, &ext->evict_index, &rbt_it);
+    while (rbt_status == BP_SUCCESS)
+    {
+        key = bplib_rbt_get_key_value(rbt_it.position);
+        if (ext->quota.evict_policy == bplib_cache_evict_non_custody_first && key >= BP_CACHE_QUOTA_CUSTODY_KEY)
+        {
+            /* everything from here on is custody tracked, which this policy never drops */
+            break;
+        }
+
+        store_queue = bplib_cache_queue_from_rbt_link(rbt_it.position);
+        list_status = bplib_mpool_list_iter_goto_first(&store_queue->bundle_list, &list_it);
+        while (list_status == BP_SUCCESS)
+        {
+            if (scan_count >= BP_CACHE_QUOTA_MAX_VICTIM_SCAN)
+            {
+                return NULL;
+            }
+
+            store_entry = bplib_mpool_generic_data_cast(bplib_mpool_get_block_from_link(list_it.position),
+                                                        BPLIB_STORE_SIGNATURE_ENTRY);
+            if (store_entry != NULL && bplib_cache_quota_is_evictable(state, store_entry, key))
+            {
+                return store_entry;
+            }
+
+            ++scan_count;
+            list_status = bplib_mpool_list_iter_forward(&list_it);
+        }
+
+        rbt_status = bplib_rbt_iter_next(&rbt_it);
+    }
+
+    return NULL;
+}
+
+static void bplib_cache_quota_evict(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    bplib_mpool_block_t *sblk;
+
+    bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): evicting bundle for node %lu to make room\n", __func__,
+          (unsigned long)store_entry->quota_dest);
+
+    ++state->ext->quota_stats.evicted;
+    bplib_cache_quota_remove(state, store_entry);
+
+    /*
+     * Without local custody the entry goes to the delete state, which drops the bundle content
+     * but holds on to the metadata for a while, so a retransmit of the same bundle is still
+     * recognized as a duplicate.
+     */
+    store_entry->flags &= ~BPLIB_STORE_FLAG_LOCAL_CUSTODY;
+
+    sblk = bplib_cache_entry_self_block(store_entry);
+    bplib_mpool_extract_node(sblk);
+    bplib_cache_fsm_execute(sblk);
+}
+
+static bool bplib_cache_quota_is_full(uint32_t entry_limit, uint64_t byte_limit, uint32_t entries, uint64_t bytes,
+                                      size_t size)
+{
+    return ((entry_limit != 0 && entries >= entry_limit) || (byte_limit != 0 && (bytes + size) > byte_limit));
+}
+
+/*
+ * Checks that a bundle of the given size may be stored for the given destination, evicting
+ * other bundles per the evict_policy if necessary.  Returns false if the bundle should be refused.
+ */
+bool bplib_cache_quota_admit(bplib_cache_state_t *state, bp_ipn_t dest, size_t size)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_cache_queue_t     *dest_queue;
+    bplib_cache_entry_t     *victim;
+    bool                     dest_full;
+
+    ext = state->ext;
+
+    if ((ext->quota.max_bytes != 0 && size > ext->quota.max_bytes) ||
+        (ext->quota.max_dest_bytes != 0 && size > ext->quota.max_dest_bytes))
+    {
+        /* it will never fit, so do not evict anything for it */
+        victim = NULL;
+    }
+    else
+    {
+        if (bplib_mpool_query_bblock_headroom(bplib_cache_parent_pool(state)) < BP_CACHE_QUOTA_MIN_POOL_HEADROOM)
+        {
+            /* the pool itself is nearly full.  This does not refuse the bundle, it was already allocated, but
+             * the memory from an evicted bundle is only recovered at the next maintenance cycle, so this only
+             * takes one victim for each new bundle rather than trying to get the pool back under the limit. */
+            victim = bplib_cache_quota_find_victim(state, NULL);
+            if (victim != NULL)
+            {
+                bplib_cache_quota_evict(state, victim);
+            }
+        }
+
+        while (true)
+        {
+            /* this needs to be looked up every time, as an eviction may recycle the queue */
+            dest_queue = bplib_cache_quota_get_dest_queue(state, dest);
+            dest_full  = (dest_queue != NULL && bplib_cache_quota_is_full(ext->quota.max_dest_entries,
+                                                                         ext->quota.max_dest_bytes,
+                                                                         dest_queue->dest_entries,
+                                                                         dest_queue->dest_bytes, size));
+
+            if (dest_full)
+            {
+                victim = bplib_cache_quota_find_victim(state, &dest);
+            }
+            else if (bplib_cache_quota_is_full(ext->quota.max_entries, ext->quota.max_bytes,
+                                               ext->quota_stats.stored_entries, ext->quota_stats.stored_bytes, size))
+            {
+                victim = bplib_cache_quota_find_victim(state, NULL);
+            }
+            else
+            {
+                /* there is room */
+                return true;
+            }
+
+            if (victim == NULL)
+            {
+                break;
+            }
+
+            bplib_cache_quota_evict(state, victim);
+        }
+    }
+
+    ++ext->quota_stats.refused;
+    bplib_cache_quota_update_congestion(state);
+
+    return false;
+}
+
+void bplib_cache_quota_add(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry, bp_ipn_t dest, size_t size)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_cache_queue_t     *dest_queue;
+
+    ext = state->ext;
+
+    store_entry->quota_dest = dest;
+    store_entry->quota_size = size;
+
+    bplib_cache_add_to_subindex(&ext->evict_index, &store_entry->evict_link,
+                                bplib_cache_quota_evict_key(state, store_entry));
+    if (!bplib_mpool_is_link_attached(&store_entry->evict_link))
+    {
+        /* must be out of memory, this entry is simply not counted */
+        return;
+    }
+
+    ++ext->quota_stats.stored_entries;
+    ext->quota_stats.stored_bytes += size;
+
+    dest_queue = bplib_cache_quota_get_dest_queue(state, dest);
+    if (dest_queue != NULL)
+    {
+        ++dest_queue->dest_entries;
+        dest_queue->dest_bytes += size;
+    }
+
+    bplib_cache_quota_update_congestion(state);
+}
+
+void bplib_cache_quota_remove(bplib_cache_state_t *state, bplib_cache_entry_t *store_entry)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_cache_queue_t     *dest_queue;
+
+    if (!bplib_mpool_is_link_attached(&store_entry->evict_link))
+    {
+        /* not counted, or already removed */
+        return;
+    }
+
+    ext = state->ext;
+    bplib_cache_remove_from_subindex(&ext->evict_index, &store_entry->evict_link);
+
+    --ext->quota_stats.stored_entries;
+    ext->quota_stats.stored_bytes -= store_entry->quota_size;
+
+    dest_queue = bplib_cache_quota_get_dest_queue(state, store_entry->quota_dest);
+    if (dest_queue != NULL && dest_queue->dest_entries > 0)
+    {
+        --dest_queue->dest_entries;
+        dest_queue->dest_bytes -= store_entry->quota_size;
+    }
+
+    bplib_cache_quota_update_congestion(state);
+}
+
+static void bplib_cache_quota_rekey(bplib_cache_state_t *state)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_rbt_iter_t         rbt_it;
+    bplib_cache_queue_t     *store_queue;
+    bplib_mpool_block_t      rekey_list;
+    bplib_mpool_block_t     *elink;
+    bplib_cache_entry_t     *store_entry;
+
+    /* the keys in the evict index depend on the policy, so everything in there needs to be put back in again */
+    ext = state->ext;
+    bplib_mpool_init_list_head(NULL, &rekey_list);
+    while (bplib_rbt_iter_goto_min(0, &ext->evict_index, &rbt_it) == BP_SUCCESS)
+    {
+        store_queue = bplib_cache_queue_from_rbt_link(rbt_it.position);
+        elink       = bplib_mpool_get_next_block(&store_queue->bundle_list);
+        bplib_cache_remove_from_subindex(&ext->evict_index, elink);
+        bplib_mpool_insert_before(&rekey_list, elink);
+    }
+
+    while (!bplib_mpool_is_empty_list_head(&rekey_list))
+    {
+        elink = bplib_mpool_get_next_block(&rekey_list);
+        bplib_mpool_extract_node(elink);
+
+        store_entry =
+            bplib_mpool_generic_data_cast(bplib_mpool_get_block_from_link(elink), BPLIB_STORE_SIGNATURE_ENTRY);
+        if (store_entry != NULL)
+        {
+            bplib_cache_add_to_subindex(&ext->evict_index, elink, bplib_cache_quota_evict_key(state, store_entry));
+        }
+    }
+}
+
+/*
+ * Puts a new quota into effect.  Lowering a limit below the current usage does not evict anything
+ * right away, but it does apply backpressure right away, and nothing new is stored until it drains.
+ */
+void bplib_cache_quota_apply(bplib_cache_state_t *state, const bplib_cache_quota_t *quota)
+{
+    bplib_cache_evict_policy_t prev_policy;
+
+    prev_policy       = state->ext->quota.evict_policy;
+    state->ext->quota = *quota;
+
+    if (prev_policy != quota->evict_policy)
+    {
+        bplib_cache_quota_rekey(state);
+    }
+
+    bplib_cache_quota_update_congestion(state);
+}
+
+/* checks if usage is at or above the given fraction below the limit (0 is unlimited) */
+static bool bplib_cache_quota_is_above_mark(uint64_t limit, uint64_t usage, unsigned int shift)
+{
+    return (limit != 0 && usage >= (limit - (limit >> shift)));
+}
+
+/*
+ * Applies or releases backpressure on the parent interface, based on the current global usage
+ */
+void bplib_cache_quota_update_congestion(bplib_cache_state_t *state)
+{
+    bplib_cache_ext_state_t *ext;
+    bplib_mpool_flow_t      *self_flow;
+    bplib_mpool_block_t     *parent_block;
+    bool                     pool_low;
+    bool                     is_congested;
+
+    ext      = state->ext;
+    pool_low = bplib_mpool_query_bblock_headroom(bplib_cache_parent_pool(state)) < BP_CACHE_QUOTA_MIN_POOL_HEADROOM;
+
+    if (!ext->quota_stats.is_congested)
+    {
+        is_congested =
+            pool_low ||
+            bplib_cache_quota_is_above_mark(ext->quota.max_entries, ext->quota_stats.stored_entries,
+                                            BP_CACHE_QUOTA_HIGH_WATER_SHIFT) ||
+            bplib_cache_quota_is_above_mark(ext->quota.max_bytes, ext->quota_stats.stored_bytes,
+                                            BP_CACHE_QUOTA_HIGH_WATER_SHIFT);
+    }
+    else
+    {
+        is_congested =
+            pool_low ||
+            bplib_cache_quota_is_above_mark(ext->quota.max_entries, ext->quota_stats.stored_entries,
+                                            BP_CACHE_QUOTA_LOW_WATER_SHIFT) ||
+            bplib_cache_quota_is_above_mark(ext->quota.max_bytes, ext->quota_stats.stored_bytes,
+                                            BP_CACHE_QUOTA_LOW_WATER_SHIFT);
+    }
+
+    if (is_congested == ext->quota_stats.is_congested)
+    {
+        /* no change */
+        return;
+    }
+
+    ext->quota_stats.is_congested = is_congested;
+
+    self_flow = bplib_cache_get_flow(state);
+    if (self_flow == NULL || self_flow->parent == NULL)
+    {
+        return;
+    }
+
+    parent_block = bplib_mpool_dereference(self_flow->parent);
+    if (is_congested)
+    {
+        ++ext->quota_stats.congestion_events;
+        bplib_mpool_flow_modify_flags(parent_block, BPLIB_MPOOL_FLOW_FLAGS_CONGESTED, 0);
+    }
+    else
+    {
+        bplib_mpool_flow_modify_flags(parent_block, 0, BPLIB_MPOOL_FLOW_FLAGS_CONGESTED);
+    }
+}
@@ -27,6 +27,101 @@
 #include "bundle_types.h"
 #include "cbuf.h"
 
+/******************************************************************************
+ DEFINES
+ ******************************************************************************/
+
+#define NULL_INDEX BP_MAX_INDEX /* 0 is a valid index so max_val is used */
+
+/******************************************************************************
+ LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * heap_before - true if the bundle at array index a times out before the one at b
+ *----------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE bool heap_before(cbuf_t *cbuf, bp_index_t a, bp_index_t b)
+{
+    if (cbuf->table[a].retx != cbuf->table[b].retx)
+    {
+        return cbuf->table[a].retx < cbuf->table[b].retx;
+    }
+
+    /* Same Retransmit Time - Smallest CID First */
+    return cbuf->table[a].cid < cbuf->table[b].cid;
+}
+
+/*----------------------------------------------------------------------------
+ * heap_place - puts an array index at a position in the heap
+ *----------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void heap_place(cbuf_t *cbuf, bp_index_t pos, bp_index_t ati)
+{
+    cbuf->heap[pos]     = ati;
+    cbuf->heap_pos[ati] = pos;
+}
+
+/*----------------------------------------------------------------------------
+ * heap_sift - moves the array index at a position in the heap up or down to
+ *  where it belongs
+ *----------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void heap_sift(cbuf_t *cbuf, bp_index_t pos)
+{
+    bp_index_t ati = cbuf->heap[pos];
+
+    /* Sift Up */
+    while (pos > 0)
+    {
+        bp_index_t parent = (pos - 1) / 2;
+        if (!heap_before(cbuf, ati, cbuf->heap[parent]))
+        {
+            break;
+        }
+        heap_place(cbuf, pos, cbuf->heap[parent]);
+        pos = parent;
+    }
+
+    /* Sift Down */
+    for (;;)
+    {
+        unsigned long child = (2 * (unsigned long)pos) + 1;
+        if (child >= cbuf->num_entries)
+        {
+            break;
+        }
+        if (child + 1 < cbuf->num_entries && heap_before(cbuf, cbuf->heap[child + 1], cbuf->heap[child]))
+        {
+            child++;
+        }
+        if (!heap_before(cbuf, cbuf->heap[child], ati))
+        {
+            break;
+        }
+        heap_place(cbuf, pos, cbuf->heap[child]);
+        pos = child;
+    }
+
+    heap_place(cbuf, pos, ati);
+}
+
+/*----------------------------------------------------------------------------
+ * remove_slot - vacates an occupied slot of the array and takes it out of the heap
+ *----------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void remove_slot(cbuf_t *cbuf, bp_index_t ati)
+{
+    bp_index_t pos = cbuf->heap_pos[ati];
+
+    cbuf->table[ati].sid = BP_SID_VACANT;
+    cbuf->heap_pos[ati]  = NULL_INDEX;
+    cbuf->num_entries--;
+
+    /* Fill Hole in Heap with Last Entry */
+    if (pos != cbuf->num_entries)
+    {
+        heap_place(cbuf, pos, cbuf->heap[cbuf->num_entries]);
+        heap_sift(cbuf, pos);
+    }
+}
+
 /******************************************************************************
  EXPORTED FUNCTIONS
  ******************************************************************************/
@@ -44,18 +139,28 @@ int cbuf_create(cbuf_t **cbuf, int size)
 
     if (size > 0)
     {
+        int i;
+
         /* Allocate Structure */
         *cbuf = (cbuf_t *)bplib_os_calloc(sizeof(cbuf_t));
 
-        /* Allocate Circular Buffer */
-        (*cbuf)->table = (bp_active_bundle_t *)bplib_os_calloc(sizeof(bp_active_bundle_t) * size);
-        if ((*cbuf)->table == NULL)
+        /* Allocate Circular Buffer and Heap */
+        (*cbuf)->table    = (bp_active_bundle_t *)bplib_os_calloc(sizeof(bp_active_bundle_t) * size);
+        (*cbuf)->heap     = (bp_index_t *)bplib_os_calloc(sizeof(bp_index_t) * size);
+        (*cbuf)->heap_pos = (bp_index_t *)bplib_os_calloc(sizeof(bp_index_t) * size);
+        if ((*cbuf)->table == NULL || (*cbuf)->heap == NULL || (*cbuf)->heap_pos == NULL)
             return BP_ERROR;
+
+        /* Initialize Heap to Empty */
+        for (i = 0; i < size; i++)
+            (*cbuf)->heap_pos[i] = NULL_INDEX;
     }
     else
     {
         /* Empty Table */
-        (*cbuf)->table = NULL;
+        (*cbuf)->table    = NULL;
+        (*cbuf)->heap     = NULL;
+        (*cbuf)->heap_pos = NULL;
     }
 
     /* Initialize Circular Buffer Attributes */
@@ -77,6 +182,10 @@ int cbuf_destroy(cbuf_t *cbuf)
     {
         if (cbuf->table)
             bplib_os_free(cbuf->table);
+        if (cbuf->heap)
+            bplib_os_free(cbuf->heap);
+        if (cbuf->heap_pos)
+            bplib_os_free(cbuf->heap_pos);
         bplib_os_free(cbuf);
     }
 
@@ -97,9 +206,16 @@ int cbuf_add(cbuf_t *cbuf, bp_active_bundle_t bundle, bool overwrite)
     else
     {
         cbuf->table[ati] = bundle;
-        cbuf->num_entries++;
         if (!overwrite)
             cbuf->newest_cid = bundle.cid + 1;
+
+        /* Add to Heap, or Move if Overwriting (the retransmit time changed) */
+        if (cbuf->heap_pos[ati] == NULL_INDEX)
+        {
+            heap_place(cbuf, cbuf->num_entries, ati);
+            cbuf->num_entries++;
+        }
+        heap_sift(cbuf, cbuf->heap_pos[ati]);
     }
 
     /* Return Success */
@@ -129,6 +245,21 @@ int cbuf_next(cbuf_t *cbuf, bp_active_bundle_t *bundle)
     return BP_TIMEOUT;
 }
 
+/*----------------------------------------------------------------------------
+ * cbuf_next_retx - the bundle with the earliest retransmit time
+ *----------------------------------------------------------------------------*/
+int cbuf_next_retx(cbuf_t *cbuf, bp_active_bundle_t *bundle)
+{
+    if (cbuf->num_entries > 0)
+    {
+        if (bundle)
+            *bundle = cbuf->table[cbuf->heap[0]];
+        return BP_SUCCESS;
+    }
+
+    return BP_TIMEOUT;
+}
+
 /*----------------------------------------------------------------------------
  * Remove
  *----------------------------------------------------------------------------*/
@@ -139,14 +270,51 @@ int cbuf_remove(cbuf_t *cbuf, bp_val_t cid, bp_active_bundle_t *bundle)
     {
         if (bundle)
             *bundle = cbuf->table[ati];
-        cbuf->table[ati].sid = BP_SID_VACANT;
-        cbuf->num_entries--;
+        remove_slot(cbuf, ati);
         return BP_SUCCESS;
     }
 
     return BP_ERROR;
 }
 
+/*----------------------------------------------------------------------------
+ * Remove Range - removes the bundles with count CIDs starting at cid, outputs
+ *  them to bundles (if not NULL) and returns the number removed
+ *----------------------------------------------------------------------------*/
+int cbuf_remove_range(cbuf_t *cbuf, bp_val_t cid, bp_val_t count, bp_active_bundle_t *bundles)
+{
+    int      num_removed = 0;
+    bp_val_t i;
+
+    if (count <= cbuf->size)
+    {
+        /* Look Up Each CID in Range */
+        for (i = 0; i < count; i++)
+        {
+            if (cbuf_remove(cbuf, cid + i, bundles ? &bundles[num_removed] : NULL) == BP_SUCCESS)
+            {
+                num_removed++;
+            }
+        }
+    }
+    else
+    {
+        /* Range Covers More CIDs than the Buffer Holds, so Check Each Slot */
+        for (i = 0; i < cbuf->size; i++)
+        {
+            if ((cbuf->table[i].sid != BP_SID_VACANT) && ((cbuf->table[i].cid - cid) < count))
+            {
+                if (bundles)
+                    bundles[num_removed] = cbuf->table[i];
+                remove_slot(cbuf, i);
+                num_removed++;
+            }
+        }
+    }
+
+    return num_removed;
+}
+
 /*----------------------------------------------------------------------------
  * Available - checks if the provided CID can be added
  *----------------------------------------------------------------------------*/
@@ -32,12 +32,16 @@
  TYPEDEFS
  ******************************************************************************/
 
-/* Circular Buffer Control Structure */
+/* Circular Buffer Control Structure
+ *  the bundles in the array are also kept in a binary min-heap ordered by retransmit
+ *  time, so the next bundle to time out is found without scanning from the oldest CID */
 typedef struct
 {
     bp_active_bundle_t *table;       /* circular array of active bundkes */
+    bp_index_t         *heap;        /* indices into the array, heap ordered by retransmit time */
+    bp_index_t         *heap_pos;    /* position in the heap of each index into the array */
     bp_index_t          size;        /* maximum (allocated) size of circular array */
-    bp_index_t          num_entries; /* number of bundles in the circular array */
+    bp_index_t          num_entries; /* number of bundles in the circular array (and in the heap) */
     bp_val_t            newest_cid;  /* most recent custody id to be inserted into array */
     bp_val_t            oldest_cid;  /* oldest custody id still present in the array */
 } cbuf_t;
@@ -50,7 +54,9 @@ int cbuf_create(cbuf_t **cbuf, int size);
 int cbuf_destroy(cbuf_t *cbuf);
 int cbuf_add(cbuf_t *cbuf, bp_active_bundle_t bundle, bool overwrite);
 int cbuf_next(cbuf_t *cbuf, bp_active_bundle_t *bundle);
+int cbuf_next_retx(cbuf_t *cbuf, bp_active_bundle_t *bundle);
 int cbuf_remove(cbuf_t *cbuf, bp_val_t cid, bp_active_bundle_t *bundle);
+int cbuf_remove_range(cbuf_t *cbuf, bp_val_t cid, bp_val_t count, bp_active_bundle_t *bundles);
 int cbuf_available(cbuf_t *cbuf, bp_val_t cid);
 int cbuf_count(cbuf_t *cbuf);
 
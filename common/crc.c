@@ -22,9 +22,22 @@
  INCLUDES
  ******************************************************************************/
 
+#include <string.h>
+
 #include "bplib.h"
 #include "crc.h"
 
+/*
+ * The accelerated kernels use x86 CPU instructions, which are compiled in with per-function
+ * target attributes and only used if the CPU reports support for them at runtime.  Define
+ * BPLIB_CRC_DISABLE_ACCEL to build with the portable kernels only.
+ */
+#if !defined(BPLIB_CRC_DISABLE_ACCEL) && defined(__GNUC__) && defined(__x86_64__)
+#define BPLIB_CRC_X86_ACCEL
+#include <nmmintrin.h> /* SSE4.2 crc32 */
+#include <wmmintrin.h> /* PCLMULQDQ */
+#endif
+
 /******************************************************************************
  FILE DATA
  ******************************************************************************/
@@ -42,26 +55,74 @@ static uint8_t BPLIB_CRC_REFLECT_TABLE[256];
 static uint16_t BPLIB_CRC16_X25_TABLE[256];
 static uint32_t BPLIB_CRC32_C_TABLE[256];
 
+/*
+ * Tables for the slice-by-8 kernels.  These work on the reflected form of the CRC register,
+ * so the input bytes are used as-is and 8 of them can be consumed per step.  Table [k] gives the
+ * effect of a byte that is followed by k more bytes.
+ */
+static uint16_t BPLIB_CRC16_X25_SLICE_TABLE[8][256];
+static uint32_t BPLIB_CRC32_C_SLICE_TABLE[8][256];
+
+/*
+ * Folding constants for the PCLMULQDQ CRC16 kernel, see bplib_crc16_x25_fold_constant()
+ */
+static uint64_t BPLIB_CRC16_X25_FOLD_K1;
+static uint64_t BPLIB_CRC16_X25_FOLD_K2;
+
+/*
+ * Tables for combining CRCs, see bplib_crc_combine().  Entry [k] is x^(8 * 2^k) mod P, which is the
+ * effect on the (normalized) CRC register of appending 2^k zero bytes.
+ */
+#define BPLIB_CRC_SHIFT_TABLE_SIZE (sizeof(size_t) * 8)
+
+static bp_crcval_t BPLIB_CRC16_X25_SHIFT_TABLE[BPLIB_CRC_SHIFT_TABLE_SIZE];
+static bp_crcval_t BPLIB_CRC32_C_SHIFT_TABLE[BPLIB_CRC_SHIFT_TABLE_SIZE];
+
 /*
  * Definition of generic-ish CRC data digest function.
  * Updates the CRC based on the data in the given buffer.
  */
 typedef bp_crcval_t (*bplib_crc_digest_func_t)(bp_crcval_t crc, const void *data, size_t size);
 
+/*
+ * Definition of a combined copy and digest function.
+ * Copies the data to the destination buffer and updates the CRC based on the same data, in one pass.
+ */
+typedef bp_crcval_t (*bplib_crc_copy_func_t)(bp_crcval_t crc, void *dest, const void *src, size_t size);
+
 /*
  * Digest function/wrapper that does nothing
  */
 static bp_crcval_t bplib_crc_digest_NOOP(bp_crcval_t crc, const void *ptr, size_t size);
+static bp_crcval_t bplib_crc_copy_NOOP(bp_crcval_t crc, void *dest, const void *src, size_t size);
 
 /*
  * Digest function/wrapper specific for CRC16 X.25 algorithm
  */
 static bp_crcval_t bplib_crc_digest_CRC16_X25(bp_crcval_t crc, const void *ptr, size_t size);
+static bp_crcval_t bplib_crc_copy_CRC16_X25(bp_crcval_t crc, void *dest, const void *src, size_t size);
 
 /*
  * Digest function/wrapper specific for CRC32 Castagnoli algorithm
  */
 static bp_crcval_t bplib_crc_digest_CRC32_CASTAGNOLI(bp_crcval_t crc, const void *ptr, size_t size);
+static bp_crcval_t bplib_crc_copy_CRC32_CASTAGNOLI(bp_crcval_t crc, void *dest, const void *src, size_t size);
+
+/*
+ * Kernels currently in use by the digest functions above, selected by bplib_crc_select_impl()
+ * These take and return the CRC in the normalized (non-reflected) form.
+ */
+static bplib_crc_digest_func_t BPLIB_CRC16_X25_KERNEL;
+static bplib_crc_digest_func_t BPLIB_CRC32_C_KERNEL;
+static bplib_crc_copy_func_t   BPLIB_CRC16_X25_COPY_KERNEL;
+static bplib_crc_copy_func_t   BPLIB_CRC32_C_COPY_KERNEL;
+static bplib_crc_impl_t        BPLIB_CRC_CURRENT_IMPL;
+
+/*
+ * CPU support for the accelerated kernels, detected in bplib_crc_init()
+ */
+static bool BPLIB_CRC_HAVE_SSE42;
+static bool BPLIB_CRC_HAVE_PCLMUL;
 
 /*
  * Actual definition of CRC parameters
@@ -75,10 +136,14 @@ struct bplib_crc_parameters
     const uint8_t *input_table; /* A ptr to a table for input translation (reflect or direct) */
     const void    *xor_table;   /* A ptr to a table with the precomputed XOR values. */
 
-    bplib_crc_digest_func_t digest; /* externally-callable "digest" routine to update CRC with new data */
+    bplib_crc_digest_func_t digest;      /* externally-callable "digest" routine to update CRC with new data */
+    bplib_crc_copy_func_t   copy_digest; /* same as digest, but also copies the data to a destination buffer */
 
     bp_crcval_t initial_value; /* The value used to initialize a CRC (normalized). */
     bp_crcval_t final_xor;     /* The final value to xor with the crc before returning (normalized). */
+
+    bp_crcval_t        polynomial;  /* The generator polynomial, without the leading term (normalized). */
+    const bp_crcval_t *shift_table; /* Powers of x for combining CRCs, NULL if not applicable */
 };
 
 /*
@@ -87,8 +152,9 @@ struct bplib_crc_parameters
  * function that does nothing.  It will always generate a CRC of "0".
  */
 bplib_crc_parameters_t BPLIB_CRC_NONE = {
-    .name   = "No CRC",
-    .digest = bplib_crc_digest_NOOP
+    .name        = "No CRC",
+    .digest      = bplib_crc_digest_NOOP,
+    .copy_digest = bplib_crc_copy_NOOP
 };
 
 /*
@@ -99,8 +165,11 @@ bplib_crc_parameters_t BPLIB_CRC16_X25 = {
     .length                = 16,
     .should_reflect_output = true,
     .digest                = bplib_crc_digest_CRC16_X25,
+    .copy_digest           = bplib_crc_copy_CRC16_X25,
     .initial_value         = 0xFFFF,
-    .final_xor             = 0xFFFF};
+    .final_xor             = 0xFFFF,
+    .polynomial            = BPLIB_CRC16_X25_POLY,
+    .shift_table           = BPLIB_CRC16_X25_SHIFT_TABLE};
 
 /*
  * Global definition of CRC32 Castagnoli algorithm
@@ -110,8 +179,11 @@ bplib_crc_parameters_t BPLIB_CRC32_CASTAGNOLI = {
     .length                = 32,
     .should_reflect_output = true,
     .digest                = bplib_crc_digest_CRC32_CASTAGNOLI,
+    .copy_digest           = bplib_crc_copy_CRC32_CASTAGNOLI,
     .initial_value         = 0xFFFFFFFF,
-    .final_xor             = 0xFFFFFFFF
+    .final_xor             = 0xFFFFFFFF,
+    .polynomial            = BPLIB_CRC32_C_POLY,
+    .shift_table           = BPLIB_CRC32_C_SHIFT_TABLE
 };
 
 /******************************************************************************
@@ -149,16 +221,392 @@ bp_crcval_t bplib_crc_digest_NOOP(bp_crcval_t crc, const void *ptr, size_t size)
     return crc;
 }
 
-bp_crcval_t bplib_crc_digest_CRC16_X25(bp_crcval_t crc, const void *ptr, size_t size)
+bp_crcval_t bplib_crc_copy_NOOP(bp_crcval_t crc, void *dest, const void *src, size_t size)
+{
+    memcpy(dest, src, size);
+    return crc;
+}
+
+/*
+ * Conversion between the normalized form of the CRC register used by the table kernels and
+ * bplib_crc_update(), and the reflected form used by the other kernels
+ */
+static inline uint16_t bplib_crc_reflect16(uint16_t val)
+{
+    return ((uint16_t)BPLIB_CRC_REFLECT_TABLE[val & 0xFF] << 8) | BPLIB_CRC_REFLECT_TABLE[val >> 8];
+}
+
+static inline uint32_t bplib_crc_reflect32(uint32_t val)
+{
+    return ((uint32_t)BPLIB_CRC_REFLECT_TABLE[val & 0xFF] << 24) |
+           ((uint32_t)BPLIB_CRC_REFLECT_TABLE[(val >> 8) & 0xFF] << 16) |
+           ((uint32_t)BPLIB_CRC_REFLECT_TABLE[(val >> 16) & 0xFF] << 8) | BPLIB_CRC_REFLECT_TABLE[val >> 24];
+}
+
+static uint16_t bplib_crc_slice8_16_impl(uint16_t crc, const uint8_t *ptr, size_t size)
+{
+    uint16_t(*table)[256] = BPLIB_CRC16_X25_SLICE_TABLE;
+
+    while (size >= 8)
+    {
+        crc = table[7][(crc ^ ptr[0]) & 0xFF] ^ table[6][((crc >> 8) ^ ptr[1]) & 0xFF] ^ table[5][ptr[2]] ^
+              table[4][ptr[3]] ^ table[3][ptr[4]] ^ table[2][ptr[5]] ^ table[1][ptr[6]] ^ table[0][ptr[7]];
+        ptr += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        crc = table[0][(crc ^ *ptr) & 0xFF] ^ (crc >> 8);
+        ++ptr;
+        --size;
+    }
+
+    return crc;
+}
+
+static uint32_t bplib_crc_slice8_32_impl(uint32_t crc, const uint8_t *ptr, size_t size)
+{
+    uint32_t(*table)[256] = BPLIB_CRC32_C_SLICE_TABLE;
+    uint32_t lo;
+
+    while (size >= 8)
+    {
+        /* assembled bytewise, so this does not depend on alignment or endianness */
+        lo = crc ^ ((uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24));
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][ptr[4]] ^ table[2][ptr[5]] ^ table[1][ptr[6]] ^ table[0][ptr[7]];
+        ptr += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        crc = table[0][(crc ^ *ptr) & 0xFF] ^ (crc >> 8);
+        ++ptr;
+        --size;
+    }
+
+    return crc;
+}
+
+/*
+ * Copying variants of the slice-by-8 kernels.  Each group of 8 bytes is loaded once, stored
+ * to the destination and used for the CRC from the same local copy, so the source is only read once.
+ */
+static uint16_t bplib_crc_slice8_16_copy_impl(uint16_t crc, uint8_t *dest, const uint8_t *ptr, size_t size)
+{
+    uint16_t(*table)[256] = BPLIB_CRC16_X25_SLICE_TABLE;
+    uint8_t b[8];
+
+    while (size >= 8)
+    {
+        memcpy(b, ptr, sizeof(b));
+        memcpy(dest, b, sizeof(b));
+        crc = table[7][(crc ^ b[0]) & 0xFF] ^ table[6][((crc >> 8) ^ b[1]) & 0xFF] ^ table[5][b[2]] ^
+              table[4][b[3]] ^ table[3][b[4]] ^ table[2][b[5]] ^ table[1][b[6]] ^ table[0][b[7]];
+        ptr += 8;
+        dest += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        *dest = *ptr;
+        crc   = table[0][(crc ^ *ptr) & 0xFF] ^ (crc >> 8);
+        ++ptr;
+        ++dest;
+        --size;
+    }
+
+    return crc;
+}
+
+static uint32_t bplib_crc_slice8_32_copy_impl(uint32_t crc, uint8_t *dest, const uint8_t *ptr, size_t size)
+{
+    uint32_t(*table)[256] = BPLIB_CRC32_C_SLICE_TABLE;
+    uint32_t lo;
+    uint8_t  b[8];
+
+    while (size >= 8)
+    {
+        memcpy(b, ptr, sizeof(b));
+        memcpy(dest, b, sizeof(b));
+        lo  = crc ^ ((uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24));
+        crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+              table[3][b[4]] ^ table[2][b[5]] ^ table[1][b[6]] ^ table[0][b[7]];
+        ptr += 8;
+        dest += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        *dest = *ptr;
+        crc   = table[0][(crc ^ *ptr) & 0xFF] ^ (crc >> 8);
+        ++ptr;
+        ++dest;
+        --size;
+    }
+
+    return crc;
+}
+
+static bp_crcval_t bplib_crc16_x25_table(bp_crcval_t crc, const void *ptr, size_t size)
 {
     return bplib_crc_generic16_impl(BPLIB_CRC_REFLECT_TABLE, BPLIB_CRC16_X25_TABLE, crc, ptr, size);
 }
 
-bp_crcval_t bplib_crc_digest_CRC32_CASTAGNOLI(bp_crcval_t crc, const void *ptr, size_t size)
+static bp_crcval_t bplib_crc32_c_table(bp_crcval_t crc, const void *ptr, size_t size)
 {
     return bplib_crc_generic32_impl(BPLIB_CRC_REFLECT_TABLE, BPLIB_CRC32_C_TABLE, crc, ptr, size);
 }
 
+static bp_crcval_t bplib_crc16_x25_slice8(bp_crcval_t crc, const void *ptr, size_t size)
+{
+    return bplib_crc_reflect16(bplib_crc_slice8_16_impl(bplib_crc_reflect16(crc), ptr, size));
+}
+
+static bp_crcval_t bplib_crc32_c_slice8(bp_crcval_t crc, const void *ptr, size_t size)
+{
+    return bplib_crc_reflect32(bplib_crc_slice8_32_impl(bplib_crc_reflect32(crc), ptr, size));
+}
+
+/*
+ * The table kernels have no copying variant, the copy is done first and the CRC is computed
+ * over the destination.  This is the reference for the fused kernels below.
+ */
+static bp_crcval_t bplib_crc16_x25_table_copy(bp_crcval_t crc, void *dest, const void *src, size_t size)
+{
+    memcpy(dest, src, size);
+    return bplib_crc16_x25_table(crc, dest, size);
+}
+
+static bp_crcval_t bplib_crc32_c_table_copy(bp_crcval_t crc, void *dest, const void *src, size_t size)
+{
+    memcpy(dest, src, size);
+    return bplib_crc32_c_table(crc, dest, size);
+}
+
+static bp_crcval_t bplib_crc16_x25_slice8_copy(bp_crcval_t crc, void *dest, const void *src, size_t size)
+{
+    return bplib_crc_reflect16(bplib_crc_slice8_16_copy_impl(bplib_crc_reflect16(crc), dest, src, size));
+}
+
+static bp_crcval_t bplib_crc32_c_slice8_copy(bp_crcval_t crc, void *dest, const void *src, size_t size)
+{
+    return bplib_crc_reflect32(bplib_crc_slice8_32_copy_impl(bplib_crc_reflect32(crc), dest, src, size));
+}
+
+#ifdef BPLIB_CRC_X86_ACCEL
+
+/*
+ * CRC32-C using the SSE4.2 crc32 instruction, which implements exactly this polynomial
+ * on the reflected register, 8 bytes at a time.
+ */
+__attribute__((target("sse4.2"))) static bp_crcval_t bplib_crc32_c_sse42(bp_crcval_t crc, const void *ptr,
+                                                                          size_t size)
+{
+    const uint8_t *bytes;
+    uint64_t       crc64;
+    uint64_t       qword;
+    uint32_t       rcrc;
+
+    bytes = ptr;
+    rcrc  = bplib_crc_reflect32(crc);
+
+    /* line up for the 8 byte loads */
+    while (size > 0 && ((uintptr_t)bytes & 7) != 0)
+    {
+        rcrc = _mm_crc32_u8(rcrc, *bytes);
+        ++bytes;
+        --size;
+    }
+
+    crc64 = rcrc;
+    while (size >= 8)
+    {
+        memcpy(&qword, bytes, sizeof(qword));
+        crc64 = _mm_crc32_u64(crc64, qword);
+        bytes += 8;
+        size -= 8;
+    }
+    rcrc = (uint32_t)crc64;
+
+    while (size > 0)
+    {
+        rcrc = _mm_crc32_u8(rcrc, *bytes);
+        ++bytes;
+        --size;
+    }
+
+    return bplib_crc_reflect32(rcrc);
+}
+
+/*
+ * Copying variant of the SSE4.2 kernel, each 8 byte word is stored to the destination as it is digested
+ */
+__attribute__((target("sse4.2"))) static bp_crcval_t bplib_crc32_c_sse42_copy(bp_crcval_t crc, void *dest,
+                                                                               const void *src, size_t size)
+{
+    const uint8_t *bytes;
+    uint8_t       *out;
+    uint64_t       crc64;
+    uint64_t       qword;
+    uint32_t       rcrc;
+
+    bytes = src;
+    out   = dest;
+    rcrc  = bplib_crc_reflect32(crc);
+
+    while (size > 0 && ((uintptr_t)bytes & 7) != 0)
+    {
+        *out = *bytes;
+        rcrc = _mm_crc32_u8(rcrc, *bytes);
+        ++bytes;
+        ++out;
+        --size;
+    }
+
+    crc64 = rcrc;
+    while (size >= 8)
+    {
+        memcpy(&qword, bytes, sizeof(qword));
+        memcpy(out, &qword, sizeof(qword));
+        crc64 = _mm_crc32_u64(crc64, qword);
+        bytes += 8;
+        out += 8;
+        size -= 8;
+    }
+    rcrc = (uint32_t)crc64;
+
+    while (size > 0)
+    {
+        *out = *bytes;
+        rcrc = _mm_crc32_u8(rcrc, *bytes);
+        ++bytes;
+        ++out;
+        --size;
+    }
+
+    return bplib_crc_reflect32(rcrc);
+}
+
+/*
+ * CRC16-X25 using carry-less multiplication to fold the data down 16 bytes at a time
+ *
+ * The 128 bit accumulator holds a polynomial A that is congruent (mod P) to the data so far.
+ * Moving it over the next block means multiplying by x^128, which is done on each half with
+ * the precomputed remainders of x^192 and x^128.  Whatever is left at the end is reduced with
+ * the slice-by-8 kernel, which gives the same CRC as the original data would have.
+ */
+__attribute__((target("pclmul"))) static bp_crcval_t bplib_crc16_x25_pclmul(bp_crcval_t crc, const void *ptr,
+                                                                             size_t size)
+{
+    const uint8_t *bytes;
+    uint8_t        folded[16];
+    uint16_t       rcrc;
+    __m128i        acc;
+    __m128i        fold_k;
+
+    bytes = ptr;
+    rcrc  = bplib_crc_reflect16(crc);
+
+    if (size >= 32)
+    {
+        fold_k = _mm_set_epi64x((long long)BPLIB_CRC16_X25_FOLD_K2, (long long)BPLIB_CRC16_X25_FOLD_K1);
+
+        /* the register is applied to the first bytes of data, and the reduction starts from 0 */
+        acc = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(const void *)bytes), _mm_cvtsi32_si128(rcrc));
+        bytes += 16;
+        size -= 16;
+
+        while (size >= 16)
+        {
+            acc = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, fold_k, 0x00),
+                                              _mm_clmulepi64_si128(acc, fold_k, 0x11)),
+                                _mm_loadu_si128((const __m128i *)(const void *)bytes));
+            bytes += 16;
+            size -= 16;
+        }
+
+        _mm_storeu_si128((__m128i *)(void *)folded, acc);
+        rcrc = bplib_crc_slice8_16_impl(0, folded, sizeof(folded));
+    }
+
+    return bplib_crc_reflect16(bplib_crc_slice8_16_impl(rcrc, bytes, size));
+}
+
+/*
+ * Copying variant of the PCLMULQDQ kernel, each 16 byte block is stored to the destination as it is folded
+ */
+__attribute__((target("pclmul"))) static bp_crcval_t bplib_crc16_x25_pclmul_copy(bp_crcval_t crc, void *dest,
+                                                                                  const void *src, size_t size)
+{
+    const uint8_t *bytes;
+    uint8_t       *out;
+    uint8_t        folded[16];
+    uint16_t       rcrc;
+    __m128i        acc;
+    __m128i        data;
+    __m128i        fold_k;
+
+    bytes = src;
+    out   = dest;
+    rcrc  = bplib_crc_reflect16(crc);
+
+    if (size >= 32)
+    {
+        fold_k = _mm_set_epi64x((long long)BPLIB_CRC16_X25_FOLD_K2, (long long)BPLIB_CRC16_X25_FOLD_K1);
+
+        data = _mm_loadu_si128((const __m128i *)(const void *)bytes);
+        _mm_storeu_si128((__m128i *)(void *)out, data);
+        acc = _mm_xor_si128(data, _mm_cvtsi32_si128(rcrc));
+        bytes += 16;
+        out += 16;
+        size -= 16;
+
+        while (size >= 16)
+        {
+            data = _mm_loadu_si128((const __m128i *)(const void *)bytes);
+            _mm_storeu_si128((__m128i *)(void *)out, data);
+            acc = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, fold_k, 0x00),
+                                              _mm_clmulepi64_si128(acc, fold_k, 0x11)),
+                                data);
+            bytes += 16;
+            out += 16;
+            size -= 16;
+        }
+
+        _mm_storeu_si128((__m128i *)(void *)folded, acc);
+        rcrc = bplib_crc_slice8_16_impl(0, folded, sizeof(folded));
+    }
+
+    return bplib_crc_reflect16(bplib_crc_slice8_16_copy_impl(rcrc, out, bytes, size));
+}
+
+#endif /* BPLIB_CRC_X86_ACCEL */
+
+bp_crcval_t bplib_crc_digest_CRC16_X25(bp_crcval_t crc, const void *ptr, size_t size)
+{
+    return BPLIB_CRC16_X25_KERNEL(crc, ptr, size);
+}
+
+bp_crcval_t bplib_crc_digest_CRC32_CASTAGNOLI(bp_crcval_t crc, const void *ptr, size_t size)
+{
+    return BPLIB_CRC32_C_KERNEL(crc, ptr, size);
+}
+
+bp_crcval_t bplib_crc_copy_CRC16_X25(bp_crcval_t crc, void *dest, const void *src, size_t size)
+{
+    return BPLIB_CRC16_X25_COPY_KERNEL(crc, dest, src, size);
+}
+
+bp_crcval_t bplib_crc_copy_CRC32_CASTAGNOLI(bp_crcval_t crc, void *dest, const void *src, size_t size)
+{
+    return BPLIB_CRC32_C_COPY_KERNEL(crc, dest, src, size);
+}
+
 bp_crcval_t bplib_precompute_crc_byte(uint8_t width, uint8_t byte, bp_crcval_t polynomial)
 {
     uint8_t     mask;
@@ -220,6 +668,93 @@ uint8_t bplib_precompute_reflection(uint8_t byte)
     return result;
 }
 
+/*
+ * Computes a folding constant for the PCLMULQDQ CRC16 kernel: (x^n mod P) * x
+ *
+ * The extra factor of x accounts for the carry-less product of two 64 bit values only being 127 bits.
+ * The result is laid out so that bit i is the coefficient of x^(64-i), which matches the bit
+ * order of the reflected data the constant gets multiplied with.
+ */
+static uint64_t bplib_crc16_x25_fold_constant(unsigned int n)
+{
+    uint32_t rem;
+    uint64_t k;
+    uint8_t  d;
+
+    rem = 1;
+    while (n > 0)
+    {
+        rem <<= 1;
+        if (rem & 0x10000)
+        {
+            rem ^= 0x10000 | BPLIB_CRC16_X25_POLY;
+        }
+        --n;
+    }
+    rem <<= 1;
+
+    k = 0;
+    for (d = 1; d <= 16; ++d)
+    {
+        if ((rem >> d) & 1)
+        {
+            k |= (uint64_t)1 << (64 - d);
+        }
+    }
+
+    return k;
+}
+
+/*
+ * Multiplies two polynomials modulo the CRC polynomial.  Both are in the normalized form of the
+ * CRC register, where the most significant bit (per the width) is the coefficient of x^(width-1).
+ */
+static bp_crcval_t bplib_crc_multiply_mod(bp_crcval_t a, bp_crcval_t b, bp_crcval_t poly, uint8_t width)
+{
+    bp_crcval_t top;
+    bp_crcval_t mask;
+    bp_crcval_t result;
+    uint8_t     i;
+
+    top    = (bp_crcval_t)1 << (width - 1);
+    mask   = top | (top - 1);
+    result = 0;
+
+    /* Horner's method, starting from the highest order coefficient of b */
+    i = width;
+    while (i > 0)
+    {
+        --i;
+        if (result & top)
+        {
+            result = ((result << 1) ^ poly) & mask;
+        }
+        else
+        {
+            result = (result << 1) & mask;
+        }
+
+        if ((b >> i) & 1)
+        {
+            result ^= a;
+        }
+    }
+
+    return result;
+}
+
+static void bplib_crc_init_shift_table(bp_crcval_t *table, bp_crcval_t poly, uint8_t width)
+{
+    size_t k;
+
+    /* x^8 does not need any reduction for the CRC widths implemented here */
+    table[0] = (bp_crcval_t)1 << 8;
+    for (k = 1; k < BPLIB_CRC_SHIFT_TABLE_SIZE; ++k)
+    {
+        table[k] = bplib_crc_multiply_mod(table[k - 1], table[k - 1], poly, width);
+    }
+}
+
 /******************************************************************************
  EXPORTED FUNCTIONS
  ******************************************************************************/
@@ -230,6 +765,7 @@ uint8_t bplib_precompute_reflection(uint8_t byte)
 void bplib_crc_init(void)
 {
     uint8_t byte;
+    int     i;
 
     byte = 0;
     do
@@ -248,6 +784,133 @@ void bplib_crc_init(void)
         ++byte;
     }
     while (byte != 0);
+
+    /*
+     * The slice tables are the reflected form of the tables above - the entry for a
+     * reflected input byte is the reflection of the entry for the normal input byte
+     */
+    do
+    {
+        BPLIB_CRC16_X25_SLICE_TABLE[0][byte] =
+            bplib_crc_reflect16(BPLIB_CRC16_X25_TABLE[BPLIB_CRC_REFLECT_TABLE[byte]]);
+        BPLIB_CRC32_C_SLICE_TABLE[0][byte] = bplib_crc_reflect32(BPLIB_CRC32_C_TABLE[BPLIB_CRC_REFLECT_TABLE[byte]]);
+        ++byte;
+    }
+    while (byte != 0);
+
+    do
+    {
+        for (i = 1; i < 8; ++i)
+        {
+            BPLIB_CRC16_X25_SLICE_TABLE[i][byte] =
+                (BPLIB_CRC16_X25_SLICE_TABLE[i - 1][byte] >> 8) ^
+                BPLIB_CRC16_X25_SLICE_TABLE[0][BPLIB_CRC16_X25_SLICE_TABLE[i - 1][byte] & 0xFF];
+            BPLIB_CRC32_C_SLICE_TABLE[i][byte] =
+                (BPLIB_CRC32_C_SLICE_TABLE[i - 1][byte] >> 8) ^
+                BPLIB_CRC32_C_SLICE_TABLE[0][BPLIB_CRC32_C_SLICE_TABLE[i - 1][byte] & 0xFF];
+        }
+        ++byte;
+    }
+    while (byte != 0);
+
+    /* the accumulator is folded over 128 bits at a time, the low half is 64 bits further out */
+    BPLIB_CRC16_X25_FOLD_K1 = bplib_crc16_x25_fold_constant(191);
+    BPLIB_CRC16_X25_FOLD_K2 = bplib_crc16_x25_fold_constant(127);
+
+    bplib_crc_init_shift_table(BPLIB_CRC16_X25_SHIFT_TABLE, BPLIB_CRC16_X25_POLY, 16);
+    bplib_crc_init_shift_table(BPLIB_CRC32_C_SHIFT_TABLE, BPLIB_CRC32_C_POLY, 32);
+
+#ifdef BPLIB_CRC_X86_ACCEL
+    __builtin_cpu_init();
+    BPLIB_CRC_HAVE_SSE42  = __builtin_cpu_supports("sse4.2");
+    BPLIB_CRC_HAVE_PCLMUL = __builtin_cpu_supports("pclmul");
+#endif
+
+    bplib_crc_select_impl(bplib_crc_impl_accelerated);
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_crc_select_impl - Selects the kernels used by the CRC digest functions
+ *      bplib_crc_impl_accelerated is always accepted, and uses the portable kernels
+ *      for any algorithm the CPU does not have support for.
+ *-------------------------------------------------------------------------------------*/
+int bplib_crc_select_impl(bplib_crc_impl_t impl)
+{
+    switch (impl)
+    {
+        case bplib_crc_impl_table:
+            BPLIB_CRC16_X25_KERNEL      = bplib_crc16_x25_table;
+            BPLIB_CRC32_C_KERNEL        = bplib_crc32_c_table;
+            BPLIB_CRC16_X25_COPY_KERNEL = bplib_crc16_x25_table_copy;
+            BPLIB_CRC32_C_COPY_KERNEL   = bplib_crc32_c_table_copy;
+            break;
+
+        case bplib_crc_impl_slice8:
+            BPLIB_CRC16_X25_KERNEL      = bplib_crc16_x25_slice8;
+            BPLIB_CRC32_C_KERNEL        = bplib_crc32_c_slice8;
+            BPLIB_CRC16_X25_COPY_KERNEL = bplib_crc16_x25_slice8_copy;
+            BPLIB_CRC32_C_COPY_KERNEL   = bplib_crc32_c_slice8_copy;
+            break;
+
+        case bplib_crc_impl_accelerated:
+            BPLIB_CRC16_X25_KERNEL      = bplib_crc16_x25_slice8;
+            BPLIB_CRC32_C_KERNEL        = bplib_crc32_c_slice8;
+            BPLIB_CRC16_X25_COPY_KERNEL = bplib_crc16_x25_slice8_copy;
+            BPLIB_CRC32_C_COPY_KERNEL   = bplib_crc32_c_slice8_copy;
+#ifdef BPLIB_CRC_X86_ACCEL
+            if (BPLIB_CRC_HAVE_PCLMUL)
+            {
+                BPLIB_CRC16_X25_KERNEL      = bplib_crc16_x25_pclmul;
+                BPLIB_CRC16_X25_COPY_KERNEL = bplib_crc16_x25_pclmul_copy;
+            }
+            if (BPLIB_CRC_HAVE_SSE42)
+            {
+                BPLIB_CRC32_C_KERNEL      = bplib_crc32_c_sse42;
+                BPLIB_CRC32_C_COPY_KERNEL = bplib_crc32_c_sse42_copy;
+            }
+#endif
+            break;
+
+        default:
+            return BP_ERROR;
+    }
+
+    BPLIB_CRC_CURRENT_IMPL = impl;
+    return BP_SUCCESS;
+}
+
+bplib_crc_impl_t bplib_crc_get_impl(void)
+{
+    return BPLIB_CRC_CURRENT_IMPL;
+}
+
+const char *bplib_crc_get_impl_name(bplib_crc_impl_t impl)
+{
+    switch (impl)
+    {
+        case bplib_crc_impl_table:
+            return "table";
+        case bplib_crc_impl_slice8:
+            return "slice-by-8";
+        case bplib_crc_impl_accelerated:
+            if (BPLIB_CRC_HAVE_SSE42 && BPLIB_CRC_HAVE_PCLMUL)
+            {
+                return "accelerated (sse4.2 + pclmulqdq)";
+            }
+            if (BPLIB_CRC_HAVE_SSE42)
+            {
+                return "accelerated (sse4.2)";
+            }
+            if (BPLIB_CRC_HAVE_PCLMUL)
+            {
+                return "accelerated (pclmulqdq)";
+            }
+            return "accelerated (not available, slice-by-8)";
+        default:
+            break;
+    }
+
+    return "unknown";
 }
 
 const char *bplib_crc_get_name(bplib_crc_parameters_t *params)
@@ -270,6 +933,49 @@ bp_crcval_t bplib_crc_update(bplib_crc_parameters_t *params, bp_crcval_t crc, co
     return params->digest(crc, data, size);
 }
 
+bp_crcval_t bplib_crc_update_copy(bplib_crc_parameters_t *params, bp_crcval_t crc, void *dest, const void *src,
+                                  size_t size)
+{
+    return params->copy_digest(crc, dest, src, size);
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_crc_combine - Computes the intermediate CRC of (A || B) from that of A and of B
+ *
+ * This works because the CRC register is linear: appending B to A is the same as appending
+ * len(B) zero bytes to A, then adding in the CRC of B by itself.  The former is done with
+ * one multiplication mod P per set bit in the length, so the data of B is not needed.
+ *
+ * crc: The intermediate CRC after A, starting from any value (normally the initial value). [INPUT]
+ * data_crc: The intermediate CRC of B alone, calculated starting from 0. [INPUT]
+ * data_size: The length of B in bytes. [INPUT]
+ *
+ * returns: The intermediate CRC after (A || B), which can be updated further or finalized.
+ *-------------------------------------------------------------------------------------*/
+bp_crcval_t bplib_crc_combine(bplib_crc_parameters_t *params, bp_crcval_t crc, bp_crcval_t data_crc, size_t data_size)
+{
+    size_t k;
+
+    if (params->shift_table == NULL)
+    {
+        /* No CRC */
+        return crc;
+    }
+
+    k = 0;
+    while (data_size > 0)
+    {
+        if (data_size & 1)
+        {
+            crc = bplib_crc_multiply_mod(crc, params->shift_table[k], params->polynomial, params->length);
+        }
+        data_size >>= 1;
+        ++k;
+    }
+
+    return crc ^ data_crc;
+}
+
 bp_crcval_t bplib_crc_finalize(bplib_crc_parameters_t *params, bp_crcval_t crc)
 {
     bp_crcval_t crc_final;
@@ -39,6 +39,17 @@
 struct bplib_crc_parameters;
 typedef const struct bplib_crc_parameters bplib_crc_parameters_t;
 
+/*
+ * Implementations of the CRC algorithms.  All of them produce the same results, they only differ in speed.
+ */
+typedef enum bplib_crc_impl
+{
+    bplib_crc_impl_table,       /**< one byte per step with a lookup table, the reference implementation */
+    bplib_crc_impl_slice8,      /**< portable, eight bytes per step with a set of lookup tables */
+    bplib_crc_impl_accelerated, /**< CPU instructions where supported (SSE4.2 crc32, PCLMULQDQ), otherwise slice8 */
+    bplib_crc_impl_max
+} bplib_crc_impl_t;
+
 /*
  * CRC algorithms that are implemented in BPLIB
  * These definitions are always fixed/const
@@ -53,12 +64,24 @@ extern bplib_crc_parameters_t BPLIB_CRC32_CASTAGNOLI;
 
 void bplib_crc_init(void);
 
+int              bplib_crc_select_impl(bplib_crc_impl_t impl);
+bplib_crc_impl_t bplib_crc_get_impl(void);
+const char      *bplib_crc_get_impl_name(bplib_crc_impl_t impl);
+
 const char *bplib_crc_get_name(bplib_crc_parameters_t *params);
 uint8_t     bplib_crc_get_width(bplib_crc_parameters_t *params);
 bp_crcval_t bplib_crc_initial_value(bplib_crc_parameters_t *params);
 bp_crcval_t bplib_crc_update(bplib_crc_parameters_t *params, bp_crcval_t crc, const void *data, size_t size);
+bp_crcval_t bplib_crc_update_copy(bplib_crc_parameters_t *params, bp_crcval_t crc, void *dest, const void *src,
+                                  size_t size);
 bp_crcval_t bplib_crc_finalize(bplib_crc_parameters_t *params, bp_crcval_t crc);
 
+/*
+ * Combines the intermediate CRC of some data (A) with that of the data following it (B), without
+ * reading B again.  The CRC of B must be computed by itself starting from 0, not the initial value.
+ */
+bp_crcval_t bplib_crc_combine(bplib_crc_parameters_t *params, bp_crcval_t crc, bp_crcval_t data_crc, size_t data_size);
+
 bp_crcval_t bplib_crc_get(const uint8_t *data, const uint32_t length, bplib_crc_parameters_t *params);
 
 #endif /* CRC_H */
@@ -0,0 +1,310 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "bplib.h"
+#include "lzc.h"
+
+/******************************************************************************
+ DEFINES
+ ******************************************************************************/
+
+#define LZC_MIN_MATCH     4
+#define LZC_MAX_OFFSET    65535
+#define LZC_LAST_LITERALS 5  /* the last octets of the input are always literals */
+#define LZC_MATCH_LIMIT   12 /* no match may start within this many octets of the end */
+#define LZC_RUN_MASK      15 /* each half of the token holds a length up to this, the rest follows it */
+#define LZC_SKIP_SHIFT    6  /* while no match is found, the search steps up by one every 64 octets */
+#define LZC_HASH_BITS     11 /* the hash table is on the stack, this keeps it to 8KiB */
+#define LZC_HASH_SIZE     (1 << LZC_HASH_BITS)
+
+/******************************************************************************
+ LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * lzc_read32 - unaligned read of four input octets
+ *----------------------------------------------------------------------------*/
+static inline uint32_t lzc_read32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/*----------------------------------------------------------------------------
+ * lzc_hash - hash table index for the four octets at a position
+ *----------------------------------------------------------------------------*/
+static inline uint32_t lzc_hash(uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - LZC_HASH_BITS);
+}
+
+/*----------------------------------------------------------------------------
+ * lzc_put_length - writes the part of a length that does not fit in the token
+ *----------------------------------------------------------------------------*/
+static uint8_t *lzc_put_length(uint8_t *out, size_t len)
+{
+    if (len >= LZC_RUN_MASK)
+    {
+        len -= LZC_RUN_MASK;
+        while (len >= 255)
+        {
+            *out++ = 255;
+            len -= 255;
+        }
+        *out++ = len;
+    }
+
+    return out;
+}
+
+/*----------------------------------------------------------------------------
+ * lzc_get_length - reads the part of a length that did not fit in the token
+ *----------------------------------------------------------------------------*/
+static const uint8_t *lzc_get_length(const uint8_t *in, const uint8_t *end, size_t *len)
+{
+    uint8_t b;
+
+    if (*len == LZC_RUN_MASK)
+    {
+        do
+        {
+            if (in >= end)
+            {
+                return NULL;
+            }
+            b = *in++;
+            *len += b;
+        }
+        while (b == 255);
+    }
+
+    return in;
+}
+
+/*----------------------------------------------------------------------------
+ * lzc_put_sequence - writes a run of literals followed by a match
+ *
+ * A match_offset of 0 means there is no match, which is only the case for the
+ * last sequence.  Returns NULL if the sequence does not fit in the output.
+ *----------------------------------------------------------------------------*/
+static uint8_t *lzc_put_sequence(uint8_t *out, const uint8_t *out_end, const uint8_t *literals, size_t literal_len,
+                                 size_t match_offset, size_t match_len)
+{
+    uint8_t *token;
+    size_t   needed;
+
+    needed = 1 + literal_len + (literal_len / 255) + 1;
+    if (match_offset != 0)
+    {
+        match_len -= LZC_MIN_MATCH;
+        needed += 2 + (match_len / 255) + 1;
+    }
+
+    if (needed > (size_t)(out_end - out))
+    {
+        return NULL;
+    }
+
+    token  = out++;
+    *token = (literal_len < LZC_RUN_MASK ? literal_len : LZC_RUN_MASK) << 4;
+    out    = lzc_put_length(out, literal_len);
+    memcpy(out, literals, literal_len);
+    out += literal_len;
+
+    if (match_offset != 0)
+    {
+        *out++ = match_offset & 0xFF;
+        *out++ = match_offset >> 8;
+        *token |= (match_len < LZC_RUN_MASK ? match_len : LZC_RUN_MASK);
+        out = lzc_put_length(out, match_len);
+    }
+
+    return out;
+}
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+/*----------------------------------------------------------------------------
+ * lzc_compress
+ *----------------------------------------------------------------------------*/
+size_t lzc_compress(const void *src, size_t src_size, void *dst, size_t dst_capacity)
+{
+    uint32_t       table[LZC_HASH_SIZE];
+    const uint8_t *in;
+    const uint8_t *ip;
+    const uint8_t *anchor;
+    const uint8_t *ref;
+    const uint8_t *match_end;
+    const uint8_t *match_start_limit;
+    const uint8_t *match_end_limit;
+    uint8_t       *out;
+    uint8_t       *out_end;
+    uint32_t       seq;
+    uint32_t       h;
+
+    in      = src;
+    ip      = in;
+    anchor  = in;
+    out     = dst;
+    out_end = out + dst_capacity;
+
+    if (src_size > LZC_MATCH_LIMIT)
+    {
+        memset(table, 0, sizeof(table));
+
+        match_start_limit = in + src_size - LZC_MATCH_LIMIT;
+        match_end_limit   = in + src_size - LZC_LAST_LITERALS;
+
+        while (ip < match_start_limit)
+        {
+            seq      = lzc_read32(ip);
+            h        = lzc_hash(seq);
+            ref      = in + table[h];
+            table[h] = ip - in;
+
+            if (ref >= ip || (ip - ref) > LZC_MAX_OFFSET || lzc_read32(ref) != seq)
+            {
+                /* no match here; step faster through data that does not compress */
+                ip += 1 + ((ip - anchor) >> LZC_SKIP_SHIFT);
+                continue;
+            }
+
+            /* extend the match backwards into the pending literals, then forwards */
+            while (ip > anchor && ref > in && ip[-1] == ref[-1])
+            {
+                --ip;
+                --ref;
+            }
+
+            match_end = ip + LZC_MIN_MATCH;
+            ref += LZC_MIN_MATCH;
+            while (match_end < match_end_limit && *match_end == *ref)
+            {
+                ++match_end;
+                ++ref;
+            }
+
+            out = lzc_put_sequence(out, out_end, anchor, ip - anchor, match_end - ref, match_end - ip);
+            if (out == NULL)
+            {
+                return 0;
+            }
+
+            ip     = match_end;
+            anchor = ip;
+        }
+    }
+
+    /* the rest of the input is the final run of literals */
+    out = lzc_put_sequence(out, out_end, anchor, (in + src_size) - anchor, 0, 0);
+    if (out == NULL)
+    {
+        return 0;
+    }
+
+    return out - (uint8_t *)dst;
+}
+
+/*----------------------------------------------------------------------------
+ * lzc_decompress
+ *----------------------------------------------------------------------------*/
+size_t lzc_decompress(const void *src, size_t src_size, void *dst, size_t dst_capacity)
+{
+    const uint8_t *in;
+    const uint8_t *in_end;
+    const uint8_t *ref;
+    uint8_t       *out;
+    uint8_t       *out_end;
+    size_t         len;
+    size_t         offset;
+    uint8_t        token;
+
+    in      = src;
+    in_end  = in + src_size;
+    out     = dst;
+    out_end = out + dst_capacity;
+
+    while (in < in_end)
+    {
+        token = *in++;
+
+        len = token >> 4;
+        in  = lzc_get_length(in, in_end, &len);
+        if (in == NULL || len > (size_t)(in_end - in) || len > (size_t)(out_end - out))
+        {
+            return 0;
+        }
+
+        memcpy(out, in, len);
+        in += len;
+        out += len;
+
+        if (in == in_end)
+        {
+            /* the last sequence has no match */
+            break;
+        }
+
+        if ((in_end - in) < 2)
+        {
+            return 0;
+        }
+
+        offset = in[0] | ((size_t)in[1] << 8);
+        in += 2;
+        if (offset == 0 || offset > (size_t)(out - (uint8_t *)dst))
+        {
+            return 0;
+        }
+
+        len = token & LZC_RUN_MASK;
+        in  = lzc_get_length(in, in_end, &len);
+        if (in == NULL)
+        {
+            return 0;
+        }
+
+        len += LZC_MIN_MATCH;
+        if (len > (size_t)(out_end - out))
+        {
+            return 0;
+        }
+
+        /* the match may overlap the output it is copied to, so this goes one octet at a time */
+        ref = out - offset;
+        while (len > 0)
+        {
+            *out++ = *ref++;
+            --len;
+        }
+    }
+
+    return out - (uint8_t *)dst;
+}
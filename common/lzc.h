@@ -0,0 +1,45 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef LZC_H
+#define LZC_H
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include "bplib.h"
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * A small LZ77 codec, using the LZ4 block format (sequences of literals and matches within
+ * the previous 64KiB, no frame header or checksum).  It needs no heap memory, and favors
+ * speed over compression ratio.
+ *
+ * Both functions return the size of the output, or 0 if it does not fit in dst_capacity
+ * (or, for decompression, the input is malformed).
+ */
+size_t lzc_compress(const void *src, size_t src_size, void *dst, size_t dst_capacity);
+size_t lzc_decompress(const void *src, size_t src_size, void *dst, size_t dst_capacity);
+
+#endif /* LZC_H */
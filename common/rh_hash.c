@@ -32,7 +32,9 @@
  ******************************************************************************/
 
 #define NULL_INDEX          BP_MAX_INDEX     /* 0 is a valid index so max_val is used */
-#define HASH_CID(cid, size) ((cid) % (size)) /* module cid to size of hash */
+#define HASH_CID(cid, mask)    ((cid) & (mask))         /* home slot of cid in the probe array */
+#define NEXT_SLOT(index, mask) (((index) + 1) & (mask)) /* wraps to start */
+#define PREV_SLOT(index, mask) (((index)-1) & (mask))   /* wraps to end */
 
 /******************************************************************************
  LOCAL FUNCTIONS
@@ -85,14 +87,44 @@ BP_LOCAL_SCOPE int overwrite_node(rh_hash_t *rh_hash, bp_index_t index, bp_activ
     }
 }
 
+/*----------------------------------------------------------------------------
+ * find_slot
+ *
+ * Probes from the home slot of the custody ID.  Returns true if it is found, with the
+ * index of its slot; otherwise returns false, with the index and probe distance of the
+ * slot it would be inserted at.
+ *----------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE bool find_slot(rh_hash_t *rh_hash, bp_val_t cid, bp_val_t *index, bp_index_t *probe)
+{
+    rh_hash_slot_t *slots      = rh_hash->slots;
+    bp_val_t        curr_index = HASH_CID(cid, rh_hash->slot_mask);
+    bp_index_t      curr_probe = 0;
+
+    /* Stop at a Vacant Slot, or at the First Entry Closer to Its Home Slot */
+    while (slots[curr_index].node != NULL_INDEX && slots[curr_index].probe >= curr_probe)
+    {
+        if (slots[curr_index].cid == cid)
+        {
+            *index = curr_index;
+            *probe = curr_probe;
+            return true;
+        }
+
+        curr_index = NEXT_SLOT(curr_index, rh_hash->slot_mask);
+        curr_probe++;
+    }
+
+    *index = curr_index;
+    *probe = curr_probe;
+    return false;
+}
+
 /*----------------------------------------------------------------------------
  * write_node
  *----------------------------------------------------------------------------*/
 BP_LOCAL_SCOPE void write_node(rh_hash_t *rh_hash, bp_index_t index, bp_active_bundle_t bundle)
 {
     rh_hash->table[index].bundle = bundle;
-    rh_hash->table[index].next   = NULL_INDEX;
-    rh_hash->table[index].prev   = NULL_INDEX;
     rh_hash->table[index].after  = NULL_INDEX;
     rh_hash->table[index].before = rh_hash->newest_entry;
 
@@ -131,29 +163,49 @@ int rh_hash_create(rh_hash_t **rh_hash, int size)
 
     if (size > 0)
     {
-        int i;
+        bp_val_t num_slots;
+        bp_val_t i;
+
+        /* Size Probe Array to Keep It at Most Half Full */
+        num_slots = 2;
+        while (num_slots < (2 * (bp_val_t)size))
+        {
+            num_slots <<= 1;
+        }
 
-        /* Allocate Hash Table */
+        /* Allocate Hash Table and Probe Array */
         (*rh_hash)->table = (rh_hash_node_t *)bplib_os_calloc(size * sizeof(rh_hash_node_t));
-        if ((*rh_hash)->table == NULL)
+        (*rh_hash)->slots = (rh_hash_slot_t *)bplib_os_calloc(num_slots * sizeof(rh_hash_slot_t));
+        if ((*rh_hash)->table == NULL || (*rh_hash)->slots == NULL)
         {
             return BP_ERROR;
         }
 
         /* Initialize Hash Table to Empty */
-        for (i = 0; i < size; i++)
+        for (i = 0; i < (bp_val_t)size; i++)
         {
             (*rh_hash)->table[i].bundle.sid = BP_SID_VACANT;
-            (*rh_hash)->table[i].next       = NULL_INDEX;
-            (*rh_hash)->table[i].prev       = NULL_INDEX;
             (*rh_hash)->table[i].before     = NULL_INDEX;
-            (*rh_hash)->table[i].after      = NULL_INDEX;
+            (*rh_hash)->table[i].after      = (i + 1 < (bp_val_t)size) ? i + 1 : NULL_INDEX;
         }
+
+        /* Initialize Probe Array to Empty */
+        for (i = 0; i < num_slots; i++)
+        {
+            (*rh_hash)->slots[i].node  = NULL_INDEX;
+            (*rh_hash)->slots[i].probe = 0;
+        }
+
+        (*rh_hash)->slot_mask = num_slots - 1;
+        (*rh_hash)->free_node = 0;
     }
     else
     {
         /* Empty Table */
-        (*rh_hash)->table = NULL;
+        (*rh_hash)->table     = NULL;
+        (*rh_hash)->slots     = NULL;
+        (*rh_hash)->slot_mask = 0;
+        (*rh_hash)->free_node = NULL_INDEX;
     }
 
     /* Initialize Hash Table Attributes */
@@ -177,6 +229,10 @@ int rh_hash_destroy(rh_hash_t *rh_hash)
         {
             bplib_os_free(rh_hash->table);
         }
+        if (rh_hash->slots)
+        {
+            bplib_os_free(rh_hash->slots);
+        }
         bplib_os_free(rh_hash);
     }
 
@@ -188,105 +244,53 @@ int rh_hash_destroy(rh_hash_t *rh_hash)
  *----------------------------------------------------------------------------*/
 int rh_hash_add(rh_hash_t *rh_hash, bp_active_bundle_t bundle, bool overwrite)
 {
-    bp_index_t curr_index = HASH_CID(bundle.cid, rh_hash->size);
+    rh_hash_slot_t *slots = rh_hash->slots;
+    bp_val_t        curr_index;
+    bp_index_t      curr_probe;
 
-    /* Add Entry to Hash */
-    if (rh_hash->table[curr_index].bundle.sid == BP_SID_VACANT)
+    /* Check for Empty Table */
+    if (rh_hash->size == 0)
     {
-        write_node(rh_hash, curr_index, bundle);
+        return BP_ERROR;
     }
-    else /* collision */
-    {
-        /* Check Current Slot for Duplicate */
-        if (rh_hash->table[curr_index].bundle.cid == bundle.cid)
-        {
-            return overwrite_node(rh_hash, curr_index, bundle, overwrite);
-        }
-
-        /* Transverse to End of Chain */
-        bp_index_t end_index  = curr_index;
-        bp_index_t scan_index = rh_hash->table[curr_index].next;
-        while (scan_index != NULL_INDEX)
-        {
-            /* Check Slot for Duplicate */
-            if (rh_hash->table[scan_index].bundle.cid == bundle.cid)
-            {
-                return overwrite_node(rh_hash, scan_index, bundle, overwrite);
-            }
-
-            /* Go To Next Slot */
-            end_index  = scan_index;
-            scan_index = rh_hash->table[scan_index].next;
-        }
-
-        /* Find First Open Hash Slot */
-        bp_index_t open_index = (curr_index + 1) % rh_hash->size;
-        while ((rh_hash->table[open_index].bundle.sid != BP_SID_VACANT) && (open_index != curr_index))
-        {
-            open_index = (open_index + 1) % rh_hash->size;
-        }
 
-        /* Check for Full Hash */
-        if (open_index == curr_index)
-        {
-            return BP_ERROR;
-        }
-
-        /* Insert Node */
-        if (rh_hash->table[curr_index].prev == NULL_INDEX) /* End of Chain Insertion (chain == 1) */
-        {
-            /* Add Entry to Open Slot at End of Chain */
-            write_node(rh_hash, open_index, bundle);
-            rh_hash->table[end_index].next  = open_index;
-            rh_hash->table[open_index].prev = end_index;
-        }
-        else /* Robin Hood Insertion (chain > 1) */
-        {
-            /* Copy Current Slot to Open Slot */
-            rh_hash->table[open_index] = rh_hash->table[curr_index];
+    /* Check for Duplicate */
+    if (find_slot(rh_hash, bundle.cid, &curr_index, &curr_probe))
+    {
+        return overwrite_node(rh_hash, slots[curr_index].node, bundle, overwrite);
+    }
 
-            /* Update Hash Links */
-            bp_index_t next_index = rh_hash->table[curr_index].next;
-            bp_index_t prev_index = rh_hash->table[curr_index].prev;
-            if (next_index != NULL_INDEX)
-            {
-                rh_hash->table[next_index].prev = open_index;
-            }
-            if (prev_index != NULL_INDEX)
-            {
-                rh_hash->table[prev_index].next = open_index;
-            }
+    /* Check for Full Hash */
+    if (rh_hash->num_entries >= rh_hash->size)
+    {
+        return BP_ERROR;
+    }
 
-            /* Update Time Order (Move) */
-            bp_index_t after_index  = rh_hash->table[curr_index].after;
-            bp_index_t before_index = rh_hash->table[curr_index].before;
-            if (after_index != NULL_INDEX)
-            {
-                rh_hash->table[after_index].before = open_index;
-            }
-            if (before_index != NULL_INDEX)
-            {
-                rh_hash->table[before_index].after = open_index;
-            }
+    /* Find End of Run */
+    bp_val_t open_index = curr_index;
+    while (slots[open_index].node != NULL_INDEX)
+    {
+        open_index = NEXT_SLOT(open_index, rh_hash->slot_mask);
+    }
 
-            /* Update Oldest Entry */
-            if (rh_hash->oldest_entry == curr_index)
-            {
-                rh_hash->oldest_entry                        = open_index;
-                rh_hash->table[rh_hash->oldest_entry].before = NULL_INDEX;
-            }
+    /* Shift Rest of Run Down by One (Robin Hood Displacement) */
+    while (open_index != curr_index)
+    {
+        bp_val_t prev_index = PREV_SLOT(open_index, rh_hash->slot_mask);
+        slots[open_index]   = slots[prev_index];
+        slots[open_index].probe++;
+        open_index = prev_index;
+    }
 
-            /* Update Newest Entry */
-            if (rh_hash->newest_entry == curr_index)
-            {
-                rh_hash->newest_entry                       = open_index;
-                rh_hash->table[rh_hash->newest_entry].after = NULL_INDEX;
-            }
+    /* Add Entry to a Vacant Node */
+    bp_index_t node_index = rh_hash->free_node;
+    rh_hash->free_node    = rh_hash->table[node_index].after;
+    write_node(rh_hash, node_index, bundle);
 
-            /* Add Entry to Current Slot */
-            write_node(rh_hash, curr_index, bundle);
-        }
-    }
+    /* Add Entry to Insertion Point */
+    slots[curr_index].cid   = bundle.cid;
+    slots[curr_index].node  = node_index;
+    slots[curr_index].probe = curr_probe;
 
     /* New Entry Added */
     rh_hash->num_entries++;
@@ -317,40 +321,27 @@ int rh_hash_next(rh_hash_t *rh_hash, bp_active_bundle_t *bundle)
  *----------------------------------------------------------------------------*/
 int rh_hash_remove(rh_hash_t *rh_hash, bp_val_t cid, bp_active_bundle_t *bundle)
 {
-    bp_index_t curr_index = HASH_CID(cid, rh_hash->size);
+    rh_hash_slot_t *slots = rh_hash->slots;
+    bp_val_t        curr_index;
+    bp_index_t      curr_probe;
 
     /* Find Node to Remove */
-    while (curr_index != NULL_INDEX)
-    {
-        if (rh_hash->table[curr_index].bundle.sid == BP_SID_VACANT) /* end of chain */
-        {
-            curr_index = NULL_INDEX;
-        }
-        else if (rh_hash->table[curr_index].bundle.cid == cid) /* matched custody ID */
-        {
-            break;
-        }
-        else /* go to next */
-        {
-            curr_index = rh_hash->table[curr_index].next;
-        }
-    }
-
-    /* Check if Node Found */
-    if (curr_index == NULL_INDEX)
+    if (rh_hash->size == 0 || !find_slot(rh_hash, cid, &curr_index, &curr_probe))
     {
         return BP_ERROR;
     }
 
+    bp_index_t node_index = slots[curr_index].node;
+
     /* Return Bundle */
     if (bundle)
     {
-        *bundle = rh_hash->table[curr_index].bundle;
+        *bundle = rh_hash->table[node_index].bundle;
     }
 
     /* Update Time Order (Bridge) */
-    bp_index_t after_index  = rh_hash->table[curr_index].after;
-    bp_index_t before_index = rh_hash->table[curr_index].before;
+    bp_index_t after_index  = rh_hash->table[node_index].after;
+    bp_index_t before_index = rh_hash->table[node_index].before;
     if (after_index != NULL_INDEX)
     {
         rh_hash->table[after_index].before = before_index;
@@ -361,70 +352,80 @@ int rh_hash_remove(rh_hash_t *rh_hash, bp_val_t cid, bp_active_bundle_t *bundle)
     }
 
     /* Update Newest and Oldest Entry */
-    if (curr_index == rh_hash->newest_entry)
+    if (node_index == rh_hash->newest_entry)
     {
         rh_hash->newest_entry = before_index;
     }
-    if (curr_index == rh_hash->oldest_entry)
+    if (node_index == rh_hash->oldest_entry)
     {
         rh_hash->oldest_entry = after_index;
     }
 
-    /* Remove End of Chain */
-    bp_index_t end_index  = curr_index;
-    bp_index_t next_index = rh_hash->table[curr_index].next;
-    if (next_index != NULL_INDEX)
+    /* Return Node to Vacant List */
+    rh_hash->table[node_index].bundle.sid = BP_SID_VACANT;
+    rh_hash->table[node_index].before     = NULL_INDEX;
+    rh_hash->table[node_index].after      = rh_hash->free_node;
+    rh_hash->free_node                    = node_index;
+
+    /* Shift Rest of Run Up by One (Backward Shift Deletion) */
+    bp_val_t next_index = NEXT_SLOT(curr_index, rh_hash->slot_mask);
+    while (slots[next_index].node != NULL_INDEX && slots[next_index].probe > 0)
     {
-        /* Transverse to End of Chain */
-        end_index = next_index;
-        while (rh_hash->table[end_index].next != NULL_INDEX)
-        {
-            end_index = rh_hash->table[end_index].next;
-        }
+        slots[curr_index] = slots[next_index];
+        slots[curr_index].probe--;
+        curr_index = next_index;
+        next_index = NEXT_SLOT(next_index, rh_hash->slot_mask);
+    }
 
-        /* Copy End of Chain into Removed Slot */
-        rh_hash->table[curr_index].bundle = rh_hash->table[end_index].bundle;
-        rh_hash->table[curr_index].before = rh_hash->table[end_index].before;
-        rh_hash->table[curr_index].after  = rh_hash->table[end_index].after;
+    /* Vacate Last Slot of Run */
+    slots[curr_index].node  = NULL_INDEX;
+    slots[curr_index].probe = 0;
 
-        /* Update Time Order (Move) */
-        after_index  = rh_hash->table[end_index].after;
-        before_index = rh_hash->table[end_index].before;
-        if (after_index != NULL_INDEX)
-        {
-            rh_hash->table[after_index].before = curr_index;
-        }
-        if (before_index != NULL_INDEX)
-        {
-            rh_hash->table[before_index].after = curr_index;
-        }
+    /* Update Statistics */
+    rh_hash->num_entries--;
 
-        /* Update Newest and Oldest Entry */
-        if (end_index == rh_hash->newest_entry)
-        {
-            rh_hash->newest_entry = curr_index;
-        }
-        if (end_index == rh_hash->oldest_entry)
+    /* Return Success */
+    return BP_SUCCESS;
+}
+
+/*----------------------------------------------------------------------------
+ * Remove Range - removes the bundles with count CIDs starting at cid, outputs
+ *  them to bundles (if not NULL) and returns the number removed
+ *----------------------------------------------------------------------------*/
+int rh_hash_remove_range(rh_hash_t *rh_hash, bp_val_t cid, bp_val_t count, bp_active_bundle_t *bundles)
+{
+    int num_removed = 0;
+
+    if (count <= rh_hash->num_entries)
+    {
+        /* Look Up Each CID in Range */
+        bp_val_t i;
+        for (i = 0; i < count; i++)
         {
-            rh_hash->oldest_entry = curr_index;
+            if (rh_hash_remove(rh_hash, cid + i, bundles ? &bundles[num_removed] : NULL) == BP_SUCCESS)
+            {
+                num_removed++;
+            }
         }
     }
-
-    /* Remove End of Chain */
-    rh_hash->table[end_index].bundle.sid = BP_SID_VACANT;
-
-    /* Update Hash Order */
-    bp_index_t prev_index = rh_hash->table[end_index].prev;
-    if (prev_index != NULL_INDEX)
+    else
     {
-        rh_hash->table[prev_index].next = NULL_INDEX;
+        /* Range Covers More CIDs than the Hash Holds, so Check Each Entry (nodes do not move on removal) */
+        bp_index_t node_index = rh_hash->oldest_entry;
+        while (node_index != NULL_INDEX)
+        {
+            bp_index_t after_index = rh_hash->table[node_index].after;
+            bp_val_t   node_cid    = rh_hash->table[node_index].bundle.cid;
+            if ((node_cid - cid) < count)
+            {
+                rh_hash_remove(rh_hash, node_cid, bundles ? &bundles[num_removed] : NULL);
+                num_removed++;
+            }
+            node_index = after_index;
+        }
     }
 
-    /* Update Statistics */
-    rh_hash->num_entries--;
-
-    /* Return Success */
-    return BP_SUCCESS;
+    return num_removed;
 }
 
 /*----------------------------------------------------------------------------
@@ -32,22 +32,44 @@
  TYPEDEFS
  ******************************************************************************/
 
+/*
+ * The active bundles are kept in a table of nodes, which never move once added, and are linked
+ * in the order they were added - this is what rh_hash_next() returns the oldest entry from.
+ *
+ * They are looked up by custody ID through a separate array of slots, using open addressing with
+ * linear probing and Robin Hood ordering: an entry never sits further from its home slot than an
+ * entry it displaced, so the entries of a run are kept in order of home slot, and a lookup stops
+ * as soon as it passes the point where the custody ID would have been placed.  The slots are small
+ * and hold the custody ID, so a lookup does not touch the nodes, and displacing entries (when
+ * adding) or shifting them back (when removing) is a sequential copy of slots.  There are at least
+ * twice as many slots as nodes (rounded up to a power of two), so even with every node in use the
+ * slots are no more than half full, and runs and probe distances stay short.
+ */
+
 typedef struct
 {
     bp_active_bundle_t bundle; /* active bundle stored a this node */
-    bp_index_t         next;   /* next entry in chain */
-    bp_index_t         prev;   /* previous entry in chain */
     bp_index_t         after;  /* next entry added to hash (time ordered) */
     bp_index_t         before; /* previous entry added to hash (time ordered) */
 } rh_hash_node_t;
 
+typedef struct
+{
+    bp_val_t   cid;   /* custody ID of the entry in this slot */
+    bp_index_t node;  /* node of the entry in this slot, or BP_MAX_INDEX when vacant */
+    bp_index_t probe; /* distance of this slot from the home slot of the custody ID */
+} rh_hash_slot_t;
+
 typedef struct
 {
     rh_hash_node_t *table;        /* hash table of active bundles */
+    rh_hash_slot_t *slots;        /* probe array, indexing the table by custody ID */
+    bp_val_t        slot_mask;    /* number of slots in the probe array, minus one */
     bp_index_t      size;         /* maximum (allocated) size of hash table */
     bp_index_t      num_entries;  /* number of active bundles in the hash table */
     bp_index_t      oldest_entry; /* oldest bundle in the hash table */
     bp_index_t      newest_entry; /* most recent bundle to be added to the hash table */
+    bp_index_t      free_node;    /* first vacant node in the table, vacant nodes are linked by after */
 } rh_hash_t;
 
 /******************************************************************************
@@ -59,6 +81,7 @@ int rh_hash_destroy(rh_hash_t *rh_hash);
 int rh_hash_add(rh_hash_t *rh_hash, bp_active_bundle_t bundle, bool overwrite);
 int rh_hash_next(rh_hash_t *rh_hash, bp_active_bundle_t *bundle);
 int rh_hash_remove(rh_hash_t *rh_hash, bp_val_t cid, bp_active_bundle_t *bundle);
+int rh_hash_remove_range(rh_hash_t *rh_hash, bp_val_t cid, bp_val_t count, bp_active_bundle_t *bundles);
 int rh_hash_available(rh_hash_t *rh_hash, bp_val_t cid);
 int rh_hash_count(rh_hash_t *rh_hash);
 
@@ -98,6 +98,9 @@ extern "C" {
 #define BP_RETX_OLDEST_BUNDLE 0
 #define BP_RETX_SMALLEST_CID  1
 
+/* Payload Compression Algorithms */
+#define BP_COMPRESSION_LZ 1 /* built-in LZ4 block format codec, see bplib_compression_lz */
+
 /* Set/Get Option Modes */
 #define BP_OPT_MODE_READ  0
 #define BP_OPT_MODE_WRITE 1
@@ -215,6 +218,21 @@ typedef struct
     void *storage_service_parm; /* pass through of parameters needed by storage service */
 } bp_attr_t;
 
+/* CLA Ingress CRC Verification Policy */
+typedef enum
+{
+    bplib_cla_crc_policy_verify_on_ingress = 0, /* check every block CRC as the bundle is received (default) */
+    bplib_cla_crc_policy_deferred               /* check only when the bundle is stored, delivered or modified */
+} bplib_cla_crc_policy_t;
+
+/* Payload Compression Codec - both return the output size, or 0 if it does not fit in dst_capacity (or fails) */
+typedef struct
+{
+    bp_val_t algorithm_id; /* carried in the bundle, the receiving socket must have a codec with the same ID */
+    size_t (*compress)(const void *src, size_t src_size, void *dst, size_t dst_capacity);
+    size_t (*decompress)(const void *src, size_t src_size, void *dst, size_t dst_capacity);
+} bplib_compression_api_t;
+
 /* Channel Statistics */
 typedef struct
 {
@@ -274,6 +292,9 @@ int bplib_attrinit(bp_attr_t *attributes);
 
 /* The following calls are specific to the new (BPv7) implementation */
 
+/* Built-in payload compression codec, BP_COMPRESSION_LZ */
+extern const bplib_compression_api_t bplib_compression_lz;
+
 /**
  * @brief Creates/opens a socket-like entity for application data
  *
@@ -322,6 +343,27 @@ int bplib_bind_socket(bp_socket_t *desc, const bp_ipn_addr_t *source_ipn);
  */
 int bplib_connect_socket(bp_socket_t *desc, const bp_ipn_addr_t *destination_ipn);
 
+/**
+ * @brief Sets the codec used to compress the payloads sent on the socket
+ *
+ * Each payload is compressed before it is put into a bundle, and the bundle carries an extension
+ * block identifying the codec.  A payload that does not get smaller is sent uncompressed.  The
+ * receiving socket decompresses the payload before passing it to bplib_recv(); it can always
+ * decompress payloads from the built-in codec, and others only if it has the same codec set.
+ *
+ * The extension block is only understood by BPLib, so this should only be used when the
+ * destination is also running BPLib.
+ *
+ * The buffers for compressed payloads are allocated here, at a fixed size (64 KiB by default), so
+ * that sending and receiving do not allocate.  A payload that does not compress to within that
+ * size is sent uncompressed.
+ *
+ * @param desc Socket-like object from bplib_create_socket()
+ * @param api Codec to use, such as &bplib_compression_lz, or NULL to stop compressing.  This is copied.
+ * @retval BP_SUCCESS if successful
+ */
+int bplib_socket_set_compression(bp_socket_t *desc, const bplib_compression_api_t *api);
+
 /**
  * @brief Creates a RAM storage (cache) logical entity
  *
@@ -358,6 +400,30 @@ bp_handle_t bplib_create_ram_storage(bplib_routetbl_t *rtbl, const bp_ipn_addr_t
  */
 bp_handle_t bplib_create_cla_intf(bplib_routetbl_t *rtbl);
 
+/**
+ * @brief Creates an aggregation stage in front of a CLA interface
+ *
+ * Bundles routed to this entity are packed together into aggregate bundles, which are then sent out
+ * through the CLA.  An aggregate goes out when the next bundle would not fit within max_size, or when
+ * the oldest bundle in it has waited for max_delay.  Bundles too big to share an aggregate are passed on
+ * to the CLA as they are.  The CLA at the other end takes the bundles back out of each aggregate as it
+ * is received, so this needs a peer that is also running BPLib.
+ *
+ * Routes to the peer should refer to this entity rather than the CLA itself, and it needs to be set up
+ * like any other interface.  The aggregates are never fragmented, so max_size should not be more than
+ * the MTU of the CLA.
+ *
+ * @param rtbl Routing table instance
+ * @param cla_intf_id bp_handle_t value from bplib_create_cla_intf()
+ * @param local_node IPN node number of this node, the source of the aggregates
+ * @param peer_node IPN node number at the other end of the CLA, the destination of the aggregates
+ * @param max_size Maximum size of an aggregate bundle, in octets
+ * @param max_delay Maximum time a bundle may wait for others to share an aggregate, in milliseconds
+ * @return bp_handle_t value referring to this entity
+ */
+bp_handle_t bplib_create_cla_aggregator(bplib_routetbl_t *rtbl, bp_handle_t cla_intf_id, bp_ipn_t local_node,
+                                        bp_ipn_t peer_node, size_t max_size, uint32_t max_delay);
+
 /**
  * @brief Creates a basic data-passing logical entity
  *
@@ -444,6 +510,51 @@ int bplib_cla_ingress(bplib_routetbl_t *rtbl, bp_handle_t intf_id, const void *b
  */
 int bplib_cla_egress(bplib_routetbl_t *rtbl, bp_handle_t intf_id, void *bundle, size_t *size, uint32_t timeout);
 
+/**
+ * @brief Set the CRC verification policy for bundles received on a CLA interface
+ *
+ * By default, the CRC of every block is verified as soon as a bundle is passed to bplib_cla_ingress().
+ * With the deferred policy, blocks are saved without checking the CRC, and the check is done only if
+ * the bundle is stored, delivered to a local service, or modified.  Bundles that are only relayed to
+ * another CLA are sent out with their original encoded blocks and CRC values, without the extra pass
+ * over the data.
+ *
+ * @param rtbl Routing table instance
+ * @param intf_id bp_handle_t value from bplib_create_cla_intf()
+ * @param policy CRC verification policy for bundles received on this interface
+ * @retval BP_SUCCESS if successful
+ */
+int bplib_cla_set_crc_policy(bplib_routetbl_t *rtbl, bp_handle_t intf_id, bplib_cla_crc_policy_t policy);
+
+/**
+ * @brief Set the maximum size of a bundle sent on a CLA interface
+ *
+ * A bundle that is larger than this (or than the buffer passed to bplib_cla_egress()) is sent as a
+ * series of fragments, one per call to bplib_cla_egress(), unless it is flagged as must not fragment.
+ * The fragments are reassembled by the data service at the destination node.  The default of 0 means
+ * there is no limit other than the buffer size.
+ *
+ * @param rtbl Routing table instance
+ * @param intf_id bp_handle_t value from bplib_create_cla_intf()
+ * @param mtu Maximum size of a bundle or fragment, in octets
+ * @retval BP_SUCCESS if successful
+ */
+int bplib_cla_set_mtu(bplib_routetbl_t *rtbl, bp_handle_t intf_id, size_t mtu);
+
+/**
+ * @brief Set the local node number used when forwarding bundles on a CLA interface
+ *
+ * Bundles sent on the interface get a previous node block naming this node, which replaces the
+ * one put there by the node before.  The default of 0 means the node is not known, and the
+ * previous node block of forwarded bundles is left as it is.
+ *
+ * @param rtbl Routing table instance
+ * @param intf_id bp_handle_t value from bplib_create_cla_intf()
+ * @param local_node IPN node number of this node
+ * @retval BP_SUCCESS if successful
+ */
+int bplib_cla_set_local_node(bplib_routetbl_t *rtbl, bp_handle_t intf_id, bp_ipn_t local_node);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
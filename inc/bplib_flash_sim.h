@@ -39,19 +39,28 @@ extern "C" {
 #define FLASH_SIM_PAGES_PER_BLOCK 128
 #define FLASH_SIM_PAGE_SIZE       4096
 #define FLASH_SIM_SPARE_SIZE      128
+#define FLASH_SIM_NUM_PLANES      2 /* pages of a batch that are read or programmed at the same time */
 
 /******************************************************************************
  PROTOTYPES
  ******************************************************************************/
 
-int bplib_flash_sim_initialize(void);
-int bplib_flash_sim_uninitialize(void);
-int bplib_flash_sim_page_read(bp_flash_addr_t addr, void *page_data);
-int bplib_flash_sim_page_write(bp_flash_addr_t addr, void *page_data);
-int bplib_flash_sim_block_erase(bp_flash_index_t block);
-int bplib_flash_sim_block_is_bad(bp_flash_index_t block);
-int bplib_flash_sim_physical_block(bp_flash_index_t logblk);
-int bplib_flash_sim_block_mark_bad(bp_flash_index_t block);
+int      bplib_flash_sim_initialize(void);
+int      bplib_flash_sim_uninitialize(void);
+int      bplib_flash_sim_page_read(bp_flash_addr_t addr, void *page_data);
+int      bplib_flash_sim_page_write(bp_flash_addr_t addr, void *page_data);
+int      bplib_flash_sim_block_erase(bp_flash_index_t block);
+uint32_t bplib_flash_sim_block_erase_count(bp_flash_index_t block);
+int      bplib_flash_sim_block_is_bad(bp_flash_index_t block);
+int      bplib_flash_sim_physical_block(bp_flash_index_t logblk);
+int      bplib_flash_sim_block_mark_bad(bp_flash_index_t block);
+int      bplib_flash_sim_pages_read(bp_flash_addr_t addr, void *page_data, int count);
+int      bplib_flash_sim_pages_write(bp_flash_addr_t addr, void *page_data, int count);
+int      bplib_flash_sim_pages_start(bp_flash_addr_t addr, void *page_data, int count); /* async write_pages */
+int      bplib_flash_sim_write_wait(void);
+
+/* Latencies in microseconds (all zero by default), for measuring the cost of flash operations */
+void bplib_flash_sim_set_latency(int transfer_us, int read_us, int program_us, int erase_us);
 
 #ifdef __cplusplus
 } // extern "C"
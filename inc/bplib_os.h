@@ -54,10 +54,16 @@
 /* Macros */
 #define bplog(flags, evt, ...) bplib_os_log(__FILE__, __LINE__, flags, evt, __VA_ARGS__)
 
+/* File Mapping Advice */
+#define BP_OS_ADVISE_SEQUENTIAL 1 /* whole mapping will be read in order */
+#define BP_OS_ADVISE_DONTNEED   2 /* pages within range can be dropped */
+
 /******************************************************************************
  TYPEDEFS
  ******************************************************************************/
 
+typedef void (*bplib_os_thread_func_t)(void *arg);
+
 /******************************************************************************
  PROTOTYPES
  ******************************************************************************/
@@ -69,6 +75,7 @@ int      bplib_os_systime(unsigned long *sysnow); /* seconds */
 uint64_t bplib_os_get_dtntime_ms(
     void); /* get the OS time compatible with the "dtn time" definition (ms resolution + dtn epoch) */
 void        bplib_os_sleep(int seconds);
+uint64_t    bplib_os_get_monotonic_us(void); /* for measuring intervals, not tied to any epoch */
 uint32_t    bplib_os_random(void);
 bp_handle_t bplib_os_createlock(void);
 void        bplib_os_destroylock(bp_handle_t h);
@@ -79,6 +86,8 @@ void        bplib_os_broadcast_signal_and_unlock(bp_handle_t h);
 void        bplib_os_signal(bp_handle_t h);
 int         bplib_os_waiton(bp_handle_t h, int timeout_ms);
 int         bplib_os_wait_until_ms(bp_handle_t h, uint64_t abs_dtntime_ms);
+bp_handle_t bplib_os_createthread(bplib_os_thread_func_t func, void *arg); /* invalid handle where unsupported */
+void        bplib_os_jointhread(bp_handle_t h);
 int         bplib_os_format(char *dst, size_t len, const char *fmt, ...) VARG_CHECK(printf, 3, 4);
 int         bplib_os_strnlen(const char *str, int maxlen);
 void       *bplib_os_calloc(size_t size);
@@ -86,4 +95,9 @@ void        bplib_os_free(void *ptr);
 size_t      bplib_os_memused(void);
 size_t      bplib_os_memhigh(void);
 
+/* Read-Only File Mapping - optional, bplib_os_mapfile returns NULL where unsupported */
+void *bplib_os_mapfile(const char *filename, size_t *size);
+void  bplib_os_unmapfile(void *addr, size_t size);
+void  bplib_os_advisefile(void *addr, size_t size, int advice);
+
 #endif /* BPLIB_OS_H */
@@ -81,6 +81,9 @@ int bplib_route_push_egress_bundle(const bplib_routetbl_t *tbl, bp_handle_t intf
 
 int bplib_route_forward_baseintf_bundle(bplib_mpool_block_t *flow_block, void *forward_arg);
 
+void bplib_route_notify_route_up(bplib_routetbl_t *tbl, bp_ipn_t dest, bp_ipn_t mask);
+void bplib_route_check_route_state(bplib_routetbl_t *tbl);
+
 void bplib_route_set_maintenance_request(bplib_routetbl_t *tbl);
 void bplib_route_maintenance_request_wait(bplib_routetbl_t *tbl);
 void bplib_route_maintenance_complete_wait(bplib_routetbl_t *tbl);
@@ -36,11 +36,57 @@ extern "C" {
  TYPEDEFS
  ******************************************************************************/
 
+/*
+ * Objects are written to a data file in groups.  Each enqueue is copied into a write-behind
+ * buffer, and the buffer is committed (written to the file in one write and flushed) when any
+ * of the following happens: it holds commit_bytes of objects, the oldest object in it has been
+ * waiting commit_latency milliseconds, the data file it is written to is full, a dequeue needs
+ * an object that is still in it, or bplib_store_file_commit() is called.  The latency is only
+ * checked when the store is accessed.  With flush_on_write set, every enqueue is committed
+ * before it returns.
+ *
+ * An enqueue returning success means the object was accepted, not that it is durable.  The
+ * commit callback is called after each commit with the handle of the store and the storage ID
+ * of the last object written; it and every object enqueued before it are durable.  Storage IDs
+ * are assigned in enqueue order, starting at 1.  The callback is called with the store lock held,
+ * and must not call back into the store.  A commit that fails to write keeps its objects and is
+ * tried again, so the callback is only late, never skipped; until it succeeds, a commit, or a
+ * dequeue or retrieve of one of its objects, fails, as does an enqueue that starts a new data file.
+ *
+ * With map_on_read set (and where the OS supports it), dequeue and retrieve return objects from
+ * data files that are full (and so never written again) as pointers into a private mapping of
+ * the file, rather than reading them into a copy.  Objects in the file still being written are
+ * always copied.  The pages of an object are dropped when it is released or relinquished.
+ *
+ * With io_depth set (and where the OS supports threads), file access moves to an I/O thread per
+ * store.  A commit hands the buffer to the I/O thread and returns, and enqueue only waits once
+ * io_depth buffers are waiting to be written (or at the start of a new data file, until the
+ * previous one is written).  The I/O thread commits buffers that reach commit_latency itself, and
+ * calls the commit callback.  It also reads up to io_depth objects ahead of dequeue, except from
+ * full data files when map_on_read is set.  A dequeue of an object not yet written waits for it.
+ *
+ * A data file is only deleted once every object in it is relinquished.  With compact_live_percent
+ * set (and where the OS supports threads), the I/O thread checks full data files after objects
+ * are relinquished, and rewrites any with no more than that percent of its bytes still live,
+ * copying only the live objects.  The copy replaces the file in one rename, and keeps the storage
+ * ID of every object, so retrieve is unaffected.  Compaction reads and writes no more than
+ * compact_budget bytes per second.
+ */
+typedef void (*bp_file_commit_t)(void *parm, bp_handle_t h, bp_sid_t committed_sid);
+
 typedef struct
 {
-    const char *root_path;      /* local directory used to store bundles as files */
-    int         cache_size;     /* number of bundles to store in cache (data_cache_t) */
-    bool        flush_on_write; /* true: write-through cache */
+    const char      *root_path;      /* local directory used to store bundles as files */
+    int              cache_size;     /* number of bundles to store in cache (data_cache_t) */
+    bool             flush_on_write; /* true: write-through cache */
+    int              commit_bytes;   /* size of write-behind buffer, committed once this full */
+    int              commit_latency; /* milliseconds an object can wait in buffer before it is committed */
+    bp_file_commit_t commit_callback;
+    void            *commit_parm;
+    bool             map_on_read;          /* true: objects in full data files are mapped, not copied */
+    int              io_depth;             /* write-behind buffers queued to I/O thread, 0 for no I/O thread */
+    int              compact_live_percent; /* compact full files with this percent or less live, 0 to disable */
+    int              compact_budget;       /* bytes per second of file access for compaction */
 } bp_file_attr_t;
 
 typedef struct
@@ -70,6 +116,7 @@ int bplib_store_file_retrieve(bp_handle_t h, bp_sid_t sid, bp_object_t **object,
 int bplib_store_file_release(bp_handle_t h, bp_sid_t sid);
 int bplib_store_file_relinquish(bp_handle_t h, bp_sid_t sid);
 int bplib_store_file_getcount(bp_handle_t h);
+int bplib_store_file_commit(bp_handle_t h);
 
 #ifdef __cplusplus
 } // extern "C"
@@ -59,6 +59,23 @@ extern "C" {
 #define FLASH_MAX_STORES 24
 #endif
 
+/*
+ * Age in seconds of the oldest object held by a flash based storage
+ * service past which the blocks it writes are expected to be kept
+ * long, and so are taken from the more worn free blocks
+ */
+#ifndef FLASH_RETAINED_AGE
+#define FLASH_RETAINED_AGE 3600
+#endif
+
+/*
+ * The most erases past the least worn free block that a free block
+ * can have and still be taken for objects expected to be kept long
+ */
+#ifndef FLASH_MAX_WEAR_GAP
+#define FLASH_MAX_WEAR_GAP 16
+#endif
+
 /******************************************************************************
  TYPEDEFS
  ******************************************************************************/
@@ -76,7 +93,27 @@ typedef int (*bp_flash_page_write_t)(bp_flash_addr_t addr, void *page_data);
 typedef int (*bp_flash_block_erase_t)(bp_flash_index_t block);
 typedef int (*bp_flash_block_is_bad_t)(bp_flash_index_t block);
 typedef int (*bp_flash_physical_block_t)(bp_flash_index_t logblk);
+typedef int (*bp_flash_pages_read_t)(bp_flash_addr_t addr, void *page_data, int count);
+typedef int (*bp_flash_pages_write_t)(bp_flash_addr_t addr, void *page_data, int count);
+typedef int (*bp_flash_write_wait_t)(void);
+typedef uint32_t (*bp_flash_erase_count_t)(bp_flash_index_t block);
 
+/*
+ * The read_pages and write_pages functions are optional (NULL if not supported).  They
+ * transfer count consecutive pages of one block, packed page_size apart in page_data, in
+ * a single operation, so that a driver for a part with multiple planes or cache read and
+ * program commands can service them together.  At most batch_pages are passed at a time.
+ *
+ * If write_wait is also provided, write_pages may return once it has taken the page_data,
+ * before the pages program (as with a cache program command), and the flash storage
+ * service prepares and passes in the next pages while they do.  Any driver function
+ * called in the meantime waits on the device as needed.  write_wait waits for all the
+ * pages written, and returns an error if any of them failed.
+ *
+ * The erase_count function is also optional.  A driver for a device that keeps erase
+ * counts (for example, in the spare area) provides it so that wear leveling carries on
+ * from where it left off, rather than starting over each time the service initializes.
+ */
 typedef struct
 {
     bp_flash_index_t          num_blocks;      /* number of blocks available in flash device */
@@ -87,14 +124,21 @@ typedef struct
     bp_flash_block_erase_t    erase;           /* function pointer to erase block */
     bp_flash_block_is_bad_t   isbad;           /* functino pointer to check if block bad */
     bp_flash_physical_block_t phyblk; /* function pointer to convert between logical and physical block addresses */
+    bp_flash_pages_read_t     read_pages;  /* optional: function pointer to read consecutive pages */
+    bp_flash_pages_write_t    write_pages; /* optional: function pointer to write consecutive pages */
+    bp_flash_write_wait_t     write_wait;  /* optional: function pointer to wait on pages being written */
+    int                       batch_pages; /* max pages per read_pages or write_pages call */
+    bp_flash_erase_count_t    erase_count; /* optional: function pointer to get erase count kept by device */
 } bp_flash_driver_t;
 
 typedef struct
 {
-    int num_free_blocks; /* number of free blocks available to driver to store bundles in */
-    int num_used_blocks; /* number of blocks currently used by the driver */
-    int num_fail_blocks; /* number of blocks that have been removed from the free list due to errors */
-    int error_count;     /* number of flash operations that have returned an error */
+    int      num_free_blocks; /* number of free blocks available to driver to store bundles in */
+    int      num_used_blocks; /* number of blocks currently used by the driver */
+    int      num_fail_blocks; /* number of blocks that have been removed from the free list due to errors */
+    int      error_count;     /* number of flash operations that have returned an error */
+    uint32_t min_erase_count; /* fewest times any block has been erased */
+    uint32_t max_erase_count; /* most times any block has been erased */
 } bp_flash_stats_t;
 
 typedef struct
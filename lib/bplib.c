@@ -22,6 +22,9 @@
  INCLUDES
  ******************************************************************************/
 
+#include <limits.h>
+#include <stdlib.h>
+
 #include "bplib.h"
 #include "bplib_os.h"
 #include "v6.h"
@@ -41,20 +44,23 @@ typedef int (*bp_table_destroy_t)(void *table);
 typedef int (*bp_table_add_t)(void *table, bp_active_bundle_t bundle, bool overwrite);
 typedef int (*bp_table_next_t)(void *table, bp_active_bundle_t *bundle);
 typedef int (*bp_table_remove_t)(void *table, bp_val_t cid, bp_active_bundle_t *bundle);
+typedef int (*bp_table_remove_range_t)(void *table, bp_val_t cid, bp_val_t count, bp_active_bundle_t *bundles);
 typedef int (*bp_table_available_t)(void *table, bp_val_t cid);
 typedef int (*bp_table_count_t)(void *table);
 
 /* Active Table */
 typedef struct
 {
-    void                *table;
-    bp_table_create_t    create;
-    bp_table_destroy_t   destroy;
-    bp_table_add_t       add;
-    bp_table_next_t      next;
-    bp_table_remove_t    remove;
-    bp_table_available_t available;
-    bp_table_count_t     count;
+    void                   *table;
+    bp_table_create_t       create;
+    bp_table_destroy_t      destroy;
+    bp_table_add_t          add;
+    bp_table_next_t         next;
+    bp_table_next_t         next_retx;
+    bp_table_remove_t       remove;
+    bp_table_remove_range_t remove_range;
+    bp_table_available_t    available;
+    bp_table_count_t        count;
 } bp_active_table_t;
 
 /* Channel Control Block */
@@ -71,6 +77,9 @@ typedef struct
     bp_val_t          current_active_cid;
     bp_handle_t       active_table_signal;
     bp_active_table_t active_table;
+    /* Bundles Acknowledged by the DACS being Processed */
+    bp_active_bundle_t *acked_bundles;
+    int                 num_acked;
     /* DTN Aggregate Custody Signals */
     bp_bundle_t dacs;
     bp_handle_t dacs_handle;
@@ -155,30 +164,96 @@ BP_LOCAL_SCOPE int create_bundle(void *parm, bool is_record, const uint8_t *payl
 }
 
 /*--------------------------------------------------------------------------------------
- * delete_bundle
+ * compare_sid - orders active bundles by storage ID, for qsort
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int compare_sid(const void *a, const void *b)
+{
+    bp_sid_t sid_a = ((const bp_active_bundle_t *)a)->sid;
+    bp_sid_t sid_b = ((const bp_active_bundle_t *)b)->sid;
+
+    return (sid_a > sid_b) - (sid_a < sid_b);
+}
+
+/*--------------------------------------------------------------------------------------
+ * delete_bundles
+ *
+ *  Removes a range of acknowledged bundles from the active table; they are relinquished
+ *  from storage afterwards, all at once, by relinquish_bundles.
  *-------------------------------------------------------------------------------------*/
-BP_LOCAL_SCOPE int delete_bundle(void *parm, bp_val_t cid, uint32_t *flags)
+BP_LOCAL_SCOPE int delete_bundles(void *parm, bp_val_t cid, bp_val_t count, uint32_t *flags)
 {
     bp_channel_t *ch = (bp_channel_t *)parm;
 
-    bp_active_bundle_t bundle;
-    int                status = ch->active_table.remove(ch->active_table.table, cid, &bundle);
-    if (status == BP_SUCCESS)
+    int num_removed = ch->active_table.remove_range(ch->active_table.table, cid, count,
+                                                    &ch->acked_bundles[ch->num_acked]);
+    ch->num_acked += num_removed;
+
+    if ((bp_val_t)num_removed < count)
+    {
+        bplog(flags, BP_FLAG_UNKNOWN_CID, "Failed to remove %lu of %lu bundles with CIDs from %lu from active table\n",
+              (unsigned long)(count - num_removed), (unsigned long)count, (unsigned long)cid);
+    }
+
+    /* Return Number of Bundles Removed */
+    return num_removed;
+}
+
+/*--------------------------------------------------------------------------------------
+ * relinquish_bundles
+ *
+ *  Relinquishes the bundles removed by delete_bundles in order of storage ID, which
+ *  keeps together the bundles held in the same data file or flash block.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void relinquish_bundles(bp_channel_t *ch, uint32_t *flags)
+{
+    int i;
+
+    qsort(ch->acked_bundles, ch->num_acked, sizeof(bp_active_bundle_t), compare_sid);
+
+    for (i = 0; i < ch->num_acked; i++)
     {
-        status = ch->store.relinquish(ch->bundle_handle, bundle.sid);
+        int status = ch->store.relinquish(ch->bundle_handle, ch->acked_bundles[i].sid);
         if (status != BP_SUCCESS)
         {
             bplog(flags, BP_FLAG_STORE_FAILURE, "Failed (%d) to relinquish bundle\n", status);
         }
     }
-    else
+
+    ch->num_acked = 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * retx_wait_ms - milliseconds from sysnow until a retransmit time (both in seconds,
+ *  on the bplib_os_systime clock that the active table times are taken from)
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int retx_wait_ms(bp_val_t retx_time, unsigned long sysnow)
+{
+    uint64_t now_ms  = (uint64_t)sysnow * 1000;
+    uint64_t retx_ms = (uint64_t)retx_time * 1000;
+
+    if (retx_ms <= now_ms)
+    {
+        return 0;
+    }
+    else if ((retx_ms - now_ms) > INT_MAX)
     {
-        bplog(flags, BP_FLAG_UNKNOWN_CID, "Failed (%d) to remove bundle with CID=%lu from active table\n", status,
-              (unsigned long)cid);
+        return INT_MAX;
     }
 
-    /* Return Status */
-    return status;
+    return (int)(retx_ms - now_ms);
+}
+
+/*--------------------------------------------------------------------------------------
+ * load_wait - the shorter of a timeout and the wait until the next retransmission
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int load_wait(int timeout, int retx_wait)
+{
+    if (retx_wait == BP_PEND || (timeout != BP_PEND && timeout <= retx_wait))
+    {
+        return timeout;
+    }
+
+    return retx_wait;
 }
 
 /*--------------------------------------------------------------------------------------
@@ -440,23 +515,27 @@ bp_desc_t *bplib_open(bp_route_t route, bp_store_t store, bp_attr_t attributes)
     /* Initialize Active Table Functions */
     if (attributes.retransmit_order == BP_RETX_SMALLEST_CID)
     {
-        ch->active_table.create    = (bp_table_create_t)cbuf_create;
-        ch->active_table.destroy   = (bp_table_destroy_t)cbuf_destroy;
-        ch->active_table.add       = (bp_table_add_t)cbuf_add;
-        ch->active_table.next      = (bp_table_next_t)cbuf_next;
-        ch->active_table.remove    = (bp_table_remove_t)cbuf_remove;
-        ch->active_table.available = (bp_table_available_t)cbuf_available;
-        ch->active_table.count     = (bp_table_count_t)cbuf_count;
+        ch->active_table.create       = (bp_table_create_t)cbuf_create;
+        ch->active_table.destroy      = (bp_table_destroy_t)cbuf_destroy;
+        ch->active_table.add          = (bp_table_add_t)cbuf_add;
+        ch->active_table.next         = (bp_table_next_t)cbuf_next;
+        ch->active_table.next_retx    = (bp_table_next_t)cbuf_next_retx;
+        ch->active_table.remove       = (bp_table_remove_t)cbuf_remove;
+        ch->active_table.remove_range = (bp_table_remove_range_t)cbuf_remove_range;
+        ch->active_table.available    = (bp_table_available_t)cbuf_available;
+        ch->active_table.count        = (bp_table_count_t)cbuf_count;
     }
     else if (attributes.retransmit_order == BP_RETX_OLDEST_BUNDLE)
     {
-        ch->active_table.create    = (bp_table_create_t)rh_hash_create;
-        ch->active_table.destroy   = (bp_table_destroy_t)rh_hash_destroy;
-        ch->active_table.add       = (bp_table_add_t)rh_hash_add;
-        ch->active_table.next      = (bp_table_next_t)rh_hash_next;
-        ch->active_table.remove    = (bp_table_remove_t)rh_hash_remove;
-        ch->active_table.available = (bp_table_available_t)rh_hash_available;
-        ch->active_table.count     = (bp_table_count_t)rh_hash_count;
+        ch->active_table.create       = (bp_table_create_t)rh_hash_create;
+        ch->active_table.destroy      = (bp_table_destroy_t)rh_hash_destroy;
+        ch->active_table.add          = (bp_table_add_t)rh_hash_add;
+        ch->active_table.next         = (bp_table_next_t)rh_hash_next;
+        ch->active_table.next_retx    = (bp_table_next_t)rh_hash_next; /* added in order of retransmit time */
+        ch->active_table.remove       = (bp_table_remove_t)rh_hash_remove;
+        ch->active_table.remove_range = (bp_table_remove_range_t)rh_hash_remove_range;
+        ch->active_table.available    = (bp_table_available_t)rh_hash_available;
+        ch->active_table.count        = (bp_table_count_t)rh_hash_count;
     }
     else
     {
@@ -475,6 +554,20 @@ bp_desc_t *bplib_open(bp_route_t route, bp_store_t store, bp_attr_t attributes)
         return NULL;
     }
 
+    /* Allocate Memory for Bundles Acknowledged by a DACS (at most the whole active table) */
+    if (attributes.active_table_size > 0)
+    {
+        ch->acked_bundles =
+            (bp_active_bundle_t *)bplib_os_calloc(sizeof(bp_active_bundle_t) * attributes.active_table_size);
+        if (ch->acked_bundles == NULL)
+        {
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to allocate memory for acknowledged bundles\n");
+            bplib_close(desc);
+            return NULL;
+        }
+    }
+    ch->num_acked = 0;
+
     /* Initialize Current Custody ID */
     ch->current_active_cid = 0;
 
@@ -547,6 +640,10 @@ void bplib_close(bp_desc_t *desc)
     {
         ch->active_table.destroy(ch->active_table.table);
     }
+    if (ch->acked_bundles)
+    {
+        bplib_os_free(ch->acked_bundles);
+    }
 
     /* Free Channel */
     bplib_os_free(desc);
@@ -886,7 +983,7 @@ int bplib_store(bp_desc_t *desc, const void *payload, size_t size, int timeout,
  *-------------------------------------------------------------------------------------*/
 int bplib_load(bp_desc_t *desc, void **bundle, size_t *size, int timeout, uint32_t *flags)
 {
-    bp_active_bundle_t active_bundle = {BP_SID_VACANT, 0, 0};
+    bp_active_bundle_t active_bundle = {BP_SID_VACANT, 0, 0, 0};
     int                status        = BP_SUCCESS; /* success or error code */
 
     /* Check Parameters */
@@ -950,137 +1047,178 @@ int bplib_load(bp_desc_t *desc, void **bundle, size_t *size, int timeout, uint32
         bplog(flags, BP_FLAG_STORE_FAILURE, "Failed (%d) to dequeue dacs bundle from storage service\n", dacs_status);
     }
 
-    /*------------------------------------------------*/
-    /* Try to Send Active Bundle (if nothing to send) */
-    /*------------------------------------------------*/
-    bplib_os_lock(ch->active_table_signal);
+    /* Retransmissions and stored bundles are checked again whenever a wait below is cut short
+     * because an active bundle is due to time out; so when nothing is ready to send, this sleeps
+     * until either the caller's timeout or the next retransmission, whichever comes first */
+    bool retry = true;
+    while (retry)
     {
-        /* Get Oldest Bundle */
-        while (object == NULL && ch->active_table.next(ch->active_table.table, &active_bundle) == BP_SUCCESS)
+        int retx_wait = BP_PEND; /* time until the next active bundle times out (ms), if any */
+        int wait      = timeout; /* the shorter of the timeout and retx_wait */
+        retry         = false;
+
+        /*------------------------------------------------*/
+        /* Try to Send Active Bundle (if nothing to send) */
+        /*------------------------------------------------*/
+        bplib_os_lock(ch->active_table_signal);
         {
-            /* Check if Bundle has Timed Out */
-            if (ch->bundle.attributes.timeout != 0 && sysnow >= (active_bundle.retx + ch->bundle.attributes.timeout))
+            /* Get Bundle that Times Out First */
+            while (object == NULL && ch->active_table.next_retx(ch->active_table.table, &active_bundle) == BP_SUCCESS)
             {
-                /* Retrieve Timed Out Bundle from Storage */
-                if (ch->store.retrieve(ch->bundle_handle, active_bundle.sid, &object, BP_CHECK) == BP_SUCCESS)
+                /* Check if Bundle has Timed Out */
+                if (ch->bundle.attributes.timeout != 0 &&
+                    sysnow >= (active_bundle.retx + ch->bundle.attributes.timeout))
                 {
-                    bp_bundle_data_t *data = (bp_bundle_data_t *)object->data;
-
-                    /* Check Lifetime of Bundle */
-                    if (v6_is_expired(&ch->bundle, sysnow, data->exprtime, unrelt))
+                    /* Check Lifetime of Bundle (kept in the active table, so it is not retrieved to check) */
+                    bool expired = v6_is_expired(&ch->bundle, sysnow, active_bundle.exprtime, unrelt);
+                    if (expired)
                     {
                         /* Bundle Expired (bundle deleted below) */
-                        object = NULL;
                         ch->stats.expired++;
                     }
-                }
-                else
-                {
-                    /* Failed to Retrieve Bundle from Storage */
-                    bplog(flags, BP_FLAG_STORE_FAILURE, "Failed to retrieve timed-out bundle\n");
-                    ch->stats.lost++;
-                }
-
-                /* Check Success of Retrieving Valid Timed Out Bundle */
-                if (object)
-                {
-                    /* Bundle is a Retransmission */
-                    resend = true;
+                    /* Retrieve Timed Out Bundle from Storage */
+                    else if (ch->store.retrieve(ch->bundle_handle, active_bundle.sid, &object, BP_CHECK) != BP_SUCCESS)
+                    {
+                        /* Failed to Retrieve Bundle from Storage */
+                        bplog(flags, BP_FLAG_STORE_FAILURE, "Failed to retrieve timed-out bundle\n");
+                        ch->stats.lost++;
+                    }
 
-                    /* Handle Active Table and Custody ID */
-                    if (ch->bundle.attributes.cid_reuse)
+                    /* Check Success of Retrieving Valid Timed Out Bundle */
+                    if (object)
                     {
-                        /* Set flag to reuse custody id and active table entry,
-                         * active table entry is not cleared, since CID is being reused */
-                        newcid = false;
+                        /* Bundle is a Retransmission */
+                        resend = true;
+
+                        /* Handle Active Table and Custody ID */
+                        if (ch->bundle.attributes.cid_reuse)
+                        {
+                            /* Set flag to reuse custody id and active table entry,
+                             * active table entry is not cleared, since CID is being reused */
+                            newcid = false;
+                        }
+                        else
+                        {
+                            /* Clear Entry (it will be reinserted below at the current CID) */
+                            ch->active_table.remove(ch->active_table.table, active_bundle.cid, NULL);
+
+                            /* Move to Next Oldest */
+                            ch->active_table.next(ch->active_table.table, NULL);
+                        }
                     }
                     else
                     {
-                        /* Clear Entry (it will be reinserted below at the current CID) */
+                        /* Clear Entry in Active Table and Storage
+                         *  - when the retrieval of the bundle failed above OR
+                         *  - when the bundle has expired (in which case it was never retrieved) */
                         ch->active_table.remove(ch->active_table.table, active_bundle.cid, NULL);
-
-                        /* Move to Next Oldest */
-                        ch->active_table.next(ch->active_table.table, NULL);
+                        if (!expired)
+                        {
+                            ch->store.release(ch->bundle_handle, active_bundle.sid);
+                        }
+                        ch->store.relinquish(ch->bundle_handle, active_bundle.sid);
                     }
                 }
-                else
+                else /* next active bundle to time out still active */
                 {
-                    /* Clear Entry in Active Table and Storage
-                     *  - when the retrieval of the bundle failed above OR
-                     *  - when the retrieved bundle has expired */
-                    ch->active_table.remove(ch->active_table.table, active_bundle.cid, NULL);
-                    ch->store.release(ch->bundle_handle, active_bundle.sid);
-                    ch->store.relinquish(ch->bundle_handle, active_bundle.sid);
-                }
-            }
-            else /* oldest active bundle still active */
-            {
-                /* Check Active Table Has Room
-                 * Since next step is to dequeue from store, need to make sure that there is room
-                 * in the active table since we don't want to dequeue a bundle from store and have
-                 * no place to put it.  Note that it is possible that even if the active table was
-                 * full, if the bundle dequeued did not request custody transfer it could still go
-                 * out, but the current design requires that at least one slot in the active table
-                 * is open at all times regardless if the bundle is requesting custody. */
-                status = ch->active_table.available(ch->active_table.table, ch->current_active_cid);
-                if (status != BP_SUCCESS)
-                {
-                    bplog(flags, BP_FLAG_ACTIVE_TABLE_WRAP, "No more room in active table for bundles\n");
-                    status = bplib_os_waiton(ch->active_table_signal, timeout);
-                    if (status == BP_SUCCESS)
+                    /* Time Until Bundle Times Out */
+                    if (ch->bundle.attributes.timeout != 0)
+                    {
+                        retx_wait = retx_wait_ms(active_bundle.retx + ch->bundle.attributes.timeout, sysnow);
+                        wait      = load_wait(timeout, retx_wait);
+                    }
+
+                    /* Check Active Table Has Room
+                     * Since next step is to dequeue from store, need to make sure that there is room
+                     * in the active table since we don't want to dequeue a bundle from store and have
+                     * no place to put it.  Note that it is possible that even if the active table was
+                     * full, if the bundle dequeued did not request custody transfer it could still go
+                     * out, but the current design requires that at least one slot in the active table
+                     * is open at all times regardless if the bundle is requesting custody. */
+                    status = ch->active_table.available(ch->active_table.table, ch->current_active_cid);
+                    if (status != BP_SUCCESS)
                     {
-                        /* Recheck Table Availability
-                         * The conditional active_table_signal can notify that the table has space but
-                         * another thread could claim the space before this current context is able to proceed;
-                         * therefore the check for room in the table must be remade. Furthermore, the check
-                         * is only made once as we don't want to stay trapped inside this function; as such
-                         * any failed check is overwritten to be a TIMEOUT. */
-                        status = ch->active_table.available(ch->active_table.table, ch->current_active_cid);
-                        if (status != BP_SUCCESS)
+                        bplog(flags, BP_FLAG_ACTIVE_TABLE_WRAP, "No more room in active table for bundles\n");
+                        status = bplib_os_waiton(ch->active_table_signal, wait);
+                        if (status == BP_SUCCESS)
+                        {
+                            /* Recheck Table Availability
+                             * The conditional active_table_signal can notify that the table has space but
+                             * another thread could claim the space before this current context is able to
+                             * proceed; therefore the check for room in the table must be remade. Furthermore,
+                             * the check is only made once as we don't want to stay trapped inside this function;
+                             * as such any failed check is overwritten to be a TIMEOUT. */
+                            status = ch->active_table.available(ch->active_table.table, ch->current_active_cid);
+                            if (status != BP_SUCCESS)
+                            {
+                                status = BP_TIMEOUT;
+                            }
+                        }
+                        else if (wait != timeout)
                         {
-                            status = BP_TIMEOUT;
+                            /* Woke Up for Retransmission */
+                            retry  = true;
+                            status = BP_SUCCESS;
                         }
                     }
-                }
 
-                /* Break Out of Loop */
-                break;
+                    /* Break Out of Loop */
+                    break;
+                }
             }
         }
-    }
-    bplib_os_unlock(ch->active_table_signal);
+        bplib_os_unlock(ch->active_table_signal);
 
-    /*------------------------------------------------*/
-    /* Try to Send Stored Bundle (if nothing to send) */
-    /*------------------------------------------------*/
-    while (object == NULL && status == BP_SUCCESS)
-    {
-        /* Dequeue Bundle from Storage Service */
-        int deq_status = ch->store.dequeue(ch->bundle_handle, &object, timeout);
-        if (deq_status == BP_SUCCESS)
+        /*------------------------------------------------*/
+        /* Try to Send Stored Bundle (if nothing to send) */
+        /*------------------------------------------------*/
+        while (object == NULL && status == BP_SUCCESS && !retry)
         {
-            bp_bundle_data_t *data = (bp_bundle_data_t *)object->data;
+            /* Dequeue Bundle from Storage Service */
+            int deq_status = ch->store.dequeue(ch->bundle_handle, &object, wait);
+            if (deq_status == BP_SUCCESS)
+            {
+                bp_bundle_data_t *data = (bp_bundle_data_t *)object->data;
 
-            /* Check Expiration Time */
-            if (v6_is_expired(&ch->bundle, sysnow, data->exprtime, unrelt))
+                /* Check Expiration Time */
+                if (v6_is_expired(&ch->bundle, sysnow, data->exprtime, unrelt))
+                {
+                    /* Bundle Expired Clear Entry (and loop again) */
+                    ch->store.release(ch->bundle_handle, object->header.sid);
+                    ch->store.relinquish(ch->bundle_handle, object->header.sid);
+                    ch->stats.expired++;
+                    object = NULL;
+                }
+            }
+            else if (deq_status == BP_TIMEOUT)
             {
-                /* Bundle Expired Clear Entry (and loop again) */
-                ch->store.release(ch->bundle_handle, object->header.sid);
-                ch->store.relinquish(ch->bundle_handle, object->header.sid);
-                ch->stats.expired++;
-                object = NULL;
+                if (wait != timeout)
+                {
+                    /* Woke Up for Retransmission */
+                    retry = true;
+                }
+                else
+                {
+                    /* No Bundles in Storage to Send */
+                    status = BP_TIMEOUT;
+                }
+            }
+            else
+            {
+                /* Failed Storage Service */
+                status = bplog(flags, BP_FLAG_STORE_FAILURE, "Failed (%d) to dequeue bundle from storage service\n",
+                               deq_status);
             }
         }
-        else if (deq_status == BP_TIMEOUT)
-        {
-            /* No Bundles in Storage to Send */
-            status = BP_TIMEOUT;
-        }
-        else
+
+        /* Account for Time Waited and Get New Current Time */
+        if (retry)
         {
-            /* Failed Storage Service */
-            status =
-                bplog(flags, BP_FLAG_STORE_FAILURE, "Failed (%d) to dequeue bundle from storage service\n", deq_status);
+            if (timeout > 0)
+            {
+                timeout -= wait;
+            }
+            unrelt = (bplib_os_systime(&sysnow) == BP_ERROR);
         }
     }
 
@@ -1097,8 +1235,9 @@ int bplib_load(bp_desc_t *desc, void **bundle, size_t *size, int timeout, uint32
             /* Save/Update Storage ID */
             active_bundle.sid = object->header.sid;
 
-            /* Update Retransmit Time */
-            active_bundle.retx = sysnow;
+            /* Update Retransmit and Expiration Time */
+            active_bundle.retx     = sysnow;
+            active_bundle.exprtime = data->exprtime;
 
             /* Save Bundle as Active */
             bplib_os_lock(ch->active_table_signal);
@@ -1203,9 +1342,12 @@ int bplib_process(bp_desc_t *desc, const void *bundle, size_t size, int timeout,
         {
             int num_acks   = 0;
             int bytes_read = v6_receive_acknowledgment(payload.memptr, payload.data.payloadsize, &num_acks,
-                                                       delete_bundle, ch, flags);
+                                                       delete_bundles, ch, flags);
             ch->stats.acknowledged_bundles += num_acks;
 
+            /* Relinquish Acknowledged Bundles */
+            relinquish_bundles(ch, flags);
+
             /* Signal Active Table */
             if (num_acks > 0)
             {
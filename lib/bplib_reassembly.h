@@ -0,0 +1,69 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef BPLIB_REASSEMBLY_H
+#define BPLIB_REASSEMBLY_H
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include "bplib_api_types.h"
+#include "v7_mpool.h"
+#include "v7_rbtree.h"
+
+/*
+ * Limits on the bundles being reassembled.  The byte budget applies to the total encoded size of
+ * the fragments held; when a new fragment would go over it, the oldest incomplete bundles are
+ * dropped to make room.  A bundle that is still incomplete after the timeout is dropped.
+ */
+#ifndef BPLIB_REASSEMBLY_BYTE_BUDGET
+#define BPLIB_REASSEMBLY_BYTE_BUDGET (256 * 1024)
+#endif
+
+#ifndef BPLIB_REASSEMBLY_TIMEOUT_MS
+#define BPLIB_REASSEMBLY_TIMEOUT_MS 60000
+#endif
+
+typedef struct bplib_reassembly_table
+{
+    bplib_rbt_root_t    index;    /* bundles being reassembled, by a hash of the bundle ID */
+    bplib_mpool_block_t age_list; /* the same bundles, oldest first */
+    size_t              held_bytes;
+
+} bplib_reassembly_table_t;
+
+void bplib_reassembly_init(bplib_mpool_t *pool);
+void bplib_reassembly_table_init(bplib_mpool_block_t *base_block, bplib_reassembly_table_t *table);
+
+/*
+ * Adds a received fragment to the table, taking ownership of the block.  Once all the fragments of
+ * the bundle are there, the reassembled bundle is returned (as a new reference), and the fragments
+ * are discarded.  Otherwise this returns NULL.
+ */
+bplib_mpool_ref_t bplib_reassembly_collect(bplib_reassembly_table_t *table, bplib_mpool_block_t *pblk,
+                                           uint64_t current_time);
+
+/*
+ * Drops the bundles that have not been completed within the timeout
+ */
+void bplib_reassembly_expire(bplib_reassembly_table_t *table, uint64_t current_time);
+
+#endif /* BPLIB_REASSEMBLY_H */
@@ -46,7 +46,7 @@
 
 /* Call-Backs */
 typedef int (*bp_create_func_t)(void *parm, bool is_record, const uint8_t *payload, int size, int timeout);
-typedef int (*bp_delete_func_t)(void *parm, bp_val_t cid, uint32_t *flags);
+typedef int (*bp_delete_func_t)(void *parm, bp_val_t cid, bp_val_t count, uint32_t *flags);
 
 /* Bundle Field (fixed size) */
 typedef struct
@@ -59,9 +59,10 @@ typedef struct
 /* Active Bundle */
 typedef struct
 {
-    bp_sid_t sid;  /* storage id */
-    bp_val_t retx; /* retransmit time */
-    bp_val_t cid;  /* custody id */
+    bp_sid_t sid;      /* storage id */
+    bp_val_t retx;     /* retransmit time */
+    bp_val_t cid;      /* custody id */
+    bp_val_t exprtime; /* absolute time when bundle expires */
 } bp_active_bundle_t;
 
 /* Payload Data */
@@ -33,16 +33,55 @@
 #include "v7_cache.h"
 #include "bplib_routing.h"
 
-#define BPLIB_BLOCKTYPE_CLA_INTF          0x7b643c85
-#define BPLIB_BLOCKTYPE_CLA_INGRESS_BLOCK 0x9580be4a
+#define BPLIB_BLOCKTYPE_CLA_INTF            0x7b643c85
+#define BPLIB_BLOCKTYPE_CLA_INGRESS_BLOCK   0x9580be4a
+#define BPLIB_BLOCKTYPE_CLA_AGGREGATOR      0x3e1f95d7
+#define BPLIB_BLOCKTYPE_CLA_AGGREGATE_BLOCK 0xc4a6072b
+
+/*
+ * Settings for the aggregate bundles.  These only go one hop, and are taken apart again as soon as
+ * they are received, so the lifetime just needs to cover the time spent in the CLA.
+ */
+#define BPLIB_CLA_AGGREGATE_LIFETIME    3600000
+#define BPLIB_CLA_AGGREGATE_PRI_CRCTYPE bp_crctype_CRC16
+#define BPLIB_CLA_AGGREGATE_PAY_CRCTYPE bp_crctype_CRC32C
 
 typedef struct bplib_cla_stats
 {
     uintmax_t ingress_byte_count;
     uintmax_t egress_byte_count;
 
+    bplib_cla_crc_policy_t crc_policy;
+
+    /* largest bundle to send in one piece (0 for no limit other than the buffer), see bplib_cla_set_mtu() */
+    size_t mtu;
+
+    /* IPN node number put in the previous node block of forwarded bundles (0 if not known), see
+     * bplib_cla_set_local_node() */
+    bp_ipn_t local_node;
+
+    /* a bundle being sent as fragments is held here between calls, with the payload offset of the next one */
+    bplib_mpool_block_t *frag_pending_block;
+    size_t               frag_next_offset;
+
 } bplib_cla_stats_t;
 
+typedef struct bplib_cla_aggregator
+{
+    bp_ipn_t            local_node;
+    bp_ipn_t            peer_node;
+    size_t              max_size;
+    uint64_t            max_delay;
+    bp_sequencenumber_t last_bundle_seq;
+
+    /* bundles waiting to go out in the next aggregate, oldest first */
+    bplib_mpool_block_t pending_list;
+    size_t              pending_size; /* sum of the aggregate entry sizes */
+    uint32_t            pending_count;
+    uint64_t            pending_time; /* when the oldest one was added */
+
+} bplib_cla_aggregator_t;
+
 /******************************************************************************
  TYPEDEFS
  ******************************************************************************/
@@ -50,6 +89,11 @@ typedef struct bplib_cla_stats
 /******************************************************************************
  LOCAL FUNCTIONS
  ******************************************************************************/
+static int bplib_cla_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content, size_t size, uint64_t time_limit,
+                                    bool defer_crc, bool in_aggregate);
+static int bplib_cla_unpack_aggregate(bplib_mpool_ref_t flow_ref, bplib_mpool_bblock_primary_t *cpb,
+                                      const void *content, size_t size, uint64_t time_limit, bool defer_crc);
+
 int bplib_cla_event_impl(void *arg, bplib_mpool_block_t *intf_block)
 {
     bplib_mpool_flow_generic_event_t *event;
@@ -88,7 +132,18 @@ int bplib_cla_event_impl(void *arg, bplib_mpool_block_t *intf_block)
     return BP_SUCCESS;
 }
 
-int bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content, size_t size, uint64_t time_limit)
+int bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content, size_t size, uint64_t time_limit,
+                                 bool defer_crc)
+{
+    return bplib_cla_bundle_ingress(flow_ref, content, size, time_limit, defer_crc, false);
+}
+
+/*
+ * Receives one bundle from a CLA.  An aggregate is only accepted at the top level: in_aggregate is set for
+ * the bundles taken out of one, and an aggregate among those is dropped, so the nesting cannot go deeper.
+ */
+static int bplib_cla_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content, size_t size, uint64_t time_limit,
+                                    bool defer_crc, bool in_aggregate)
 {
     bplib_mpool_flow_t           *flow;
     bplib_mpool_block_t          *pblk;
@@ -96,6 +151,7 @@ int bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content
     bplib_mpool_ref_t             refptr;
     bplib_mpool_bblock_primary_t *pri_block;
     size_t                        imported_sz;
+    bool                          aggregate;
     int                           status;
 
     pblk = NULL;
@@ -110,7 +166,7 @@ int bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content
             bplib_mpool_bblock_primary_alloc(bplib_mpool_get_parent_pool_from_link(bplib_mpool_dereference(flow_ref)));
         if (pblk != NULL)
         {
-            imported_sz = v7_copy_full_bundle_in(bplib_mpool_bblock_primary_cast(pblk), content, size);
+            imported_sz = v7_copy_full_bundle_in(bplib_mpool_bblock_primary_cast(pblk), content, size, defer_crc);
         }
         else
         {
@@ -132,6 +188,17 @@ int bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content
          * For now considering it an error if they do not.
          */
         if (pri_block != NULL && imported_sz == size)
+        {
+            aggregate = (bplib_mpool_bblock_primary_locate_canonical(
+                             pri_block, bp_blocktype_bundleAggregatePayloadBlock) != NULL);
+        }
+        else
+        {
+            aggregate = false;
+            pri_block = NULL;
+        }
+
+        if (pri_block != NULL && !aggregate)
         {
             rblk = bplib_mpool_ref_make_block(refptr, BPLIB_BLOCKTYPE_CLA_INGRESS_BLOCK, NULL);
         }
@@ -140,7 +207,16 @@ int bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content
             rblk = NULL;
         }
 
-        if (rblk != NULL)
+        if (aggregate && in_aggregate)
+        {
+            status = bplog(NULL, BP_FLAG_INCOMPLETE, "Aggregate bundle nested in an aggregate dropped\n");
+        }
+        else if (aggregate)
+        {
+            /* the bundles in it are received as if each one was passed in separately */
+            status = bplib_cla_unpack_aggregate(flow_ref, pri_block, content, size, time_limit, defer_crc);
+        }
+        else if (rblk != NULL)
         {
             pri_block->delivery_data.ingress_intf_id = bplib_mpool_get_external_id(bplib_mpool_dereference(flow_ref));
             pri_block->delivery_data.ingress_time    = bplib_os_get_dtntime_ms();
@@ -183,12 +259,218 @@ int bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content
     return status;
 }
 
-int bplib_generic_bundle_egress(bplib_mpool_ref_t flow_ref, void *content, size_t *size, uint64_t time_limit)
+/*
+ * The aggregate is checked first if the CRC checks were deferred, so the framing of the bundles in it can be
+ * trusted.  The bundles themselves are decoded under the same CRC policy as any other.  If one of them cannot
+ * be received, including one that is itself an aggregate, the rest of the aggregate is dropped.
+ */
+static int bplib_cla_unpack_aggregate(bplib_mpool_ref_t flow_ref, bplib_mpool_bblock_primary_t *cpb,
+                                      const void *content, size_t size, uint64_t time_limit, bool defer_crc)
+{
+    const void *bundle_ptr;
+    size_t      bundle_size;
+    size_t      position;
+    int         status;
+
+    if (v7_verify_deferred_crc(cpb) != 0)
+    {
+        return bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): aggregate bundle failed CRC check\n", __func__);
+    }
+
+    status   = BP_SUCCESS;
+    position = 0;
+    while (status == BP_SUCCESS)
+    {
+        bundle_size = v7_next_aggregated_bundle(cpb, content, size, &position, &bundle_ptr);
+        if (bundle_size == 0)
+        {
+            break;
+        }
+
+        status = bplib_cla_bundle_ingress(flow_ref, bundle_ptr, bundle_size, time_limit, defer_crc, true);
+    }
+
+    return status;
+}
+
+/*
+ * Sets the previous node block of the bundle to this node, adding the block if the bundle does not
+ * have one yet.  The block number follows the block type, as for the other blocks added here.
+ */
+static int bplib_cla_update_previous_node(bplib_mpool_bblock_primary_t *cpb, bp_ipn_t local_node)
+{
+    bplib_mpool_block_t            *cblk;
+    bplib_mpool_bblock_canonical_t *ccb;
+    bp_canonical_block_buffer_t    *logical;
+    bp_ipn_addr_t                   prev_addr;
+
+    cblk = bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_previousNode);
+    if (cblk == NULL)
+    {
+        cblk = bplib_mpool_bblock_canonical_alloc(bplib_mpool_get_parent_pool_from_link(&cpb->cblock_list));
+        if (cblk == NULL)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): cannot add previous node block\n", __func__);
+            return BP_ERROR;
+        }
+
+        ccb     = bplib_mpool_bblock_canonical_cast(cblk);
+        logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+
+        logical->canonical_block.blockType = bp_blocktype_previousNode;
+        logical->canonical_block.blockNum  = bp_blocktype_previousNode;
+        logical->canonical_block.crctype   = bplib_mpool_bblock_primary_get_logical(cpb)->crctype;
+
+        bplib_mpool_bblock_primary_append(cpb, cblk);
+    }
+    else
+    {
+        ccb     = bplib_mpool_bblock_canonical_cast(cblk);
+        logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+
+        v7_get_eid(&prev_addr, &logical->data.previous_node_block.nodeId);
+        if (logical->data.previous_node_block.nodeId.scheme == bp_endpointid_scheme_ipn &&
+            prev_addr.node_number == local_node && prev_addr.service_number == 0)
+        {
+            /* already up to date, e.g. this is a retransmit */
+            return BP_SUCCESS;
+        }
+    }
+
+    prev_addr.node_number    = local_node;
+    prev_addr.service_number = 0;
+    v7_set_eid(&logical->data.previous_node_block.nodeId, &prev_addr);
+
+    if (v7_block_update_canonical(ccb) != 0)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): previous node block update failed\n", __func__);
+        return BP_ERROR;
+    }
+
+    return BP_SUCCESS;
+}
+
+/*
+ * Brings the previous node, bundle age and hop count blocks (if present) up to date as the bundle leaves
+ * this node.  These are patched in place, so the payload and primary block are never re-encoded by this.
+ * The hop count is only incremented once per visit to this node, even if the bundle is sent more than
+ * once, and the age accumulates the time spent here since the last update.  The previous node block is
+ * only handled if the local node number is known.
+ *
+ * A bundle that has taken more hops than its hop limit allows is not forwarded: this returns BP_ERROR
+ * and the caller drops the bundle.  No status report is sent for it, as bundle status reports are not
+ * generated anywhere in this implementation.
+ */
+static int bplib_cla_update_forwarded_blocks(bplib_mpool_bblock_primary_t *cpb, bp_ipn_t local_node,
+                                             uint64_t egress_time)
+{
+    bplib_mpool_bblock_tracking_t  *tracking;
+    bplib_mpool_bblock_canonical_t *ccb;
+    bp_canonical_block_buffer_t    *logical;
+
+    tracking = &cpb->delivery_data;
+
+    ccb = bplib_mpool_bblock_canonical_cast(bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_hopCount));
+    if (ccb != NULL && !tracking->hop_count_updated)
+    {
+        /* checked before the block is changed, so a dropped bundle is left as it was */
+        logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+        if (logical->data.hop_count_block.hopCount >= logical->data.hop_count_block.hopLimit)
+        {
+            bplog(NULL, BP_FLAG_DROPPED, "%s(): hop limit %lu exceeded, bundle dropped\n", __func__,
+                  (unsigned long)logical->data.hop_count_block.hopLimit);
+            return BP_ERROR;
+        }
+
+        ++logical->data.hop_count_block.hopCount;
+        tracking->hop_count_updated = true;
+
+        if (v7_block_update_canonical(ccb) != 0)
+        {
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): hop count block update failed\n", __func__);
+            return BP_ERROR;
+        }
+    }
+
+    if (local_node != 0 && bplib_cla_update_previous_node(cpb, local_node) != BP_SUCCESS)
+    {
+        return BP_ERROR;
+    }
+
+    if (tracking->age_update_time == 0)
+    {
+        tracking->age_update_time = tracking->ingress_time;
+    }
+
+    ccb = bplib_mpool_bblock_canonical_cast(bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_bundleAge));
+    if (ccb != NULL && egress_time > tracking->age_update_time)
+    {
+        logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+        logical->data.age_block.age += egress_time - tracking->age_update_time;
+        if (v7_block_update_canonical(ccb) != 0)
+        {
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): bundle age block update failed\n", __func__);
+            return BP_ERROR;
+        }
+        tracking->age_update_time = egress_time;
+    }
+
+    return BP_SUCCESS;
+}
+
+/*
+ * Copies the bundle out to the CLA buffer, in one piece if it fits within the buffer and the MTU of the
+ * interface.  Otherwise the next fragment is copied, and the offset of the one after that is kept in the
+ * stats (it goes back to 0 after the last fragment).  The fragments are written straight from the blocks
+ * of the original bundle, which is held until the last one is sent.
+ */
+static int bplib_cla_export_bundle(bplib_cla_stats_t *stats, bplib_mpool_bblock_primary_t *cpb, void *content,
+                                   size_t *size)
+{
+    size_t max_sz;
+    size_t export_sz;
+
+    max_sz = *size;
+    if (stats->mtu != 0 && stats->mtu < max_sz)
+    {
+        max_sz = stats->mtu;
+    }
+
+    if (stats->frag_next_offset == 0)
+    {
+        export_sz = v7_compute_full_bundle_size(cpb);
+        if (export_sz <= max_sz)
+        {
+            *size = v7_copy_full_bundle_out(cpb, content, max_sz);
+            if (export_sz != *size)
+            {
+                /* something went wrong during copy */
+                return BP_ERROR;
+            }
+
+            return BP_SUCCESS;
+        }
+    }
+
+    export_sz = v7_copy_fragment_out(cpb, stats->frag_next_offset, content, max_sz, &stats->frag_next_offset);
+    if (export_sz == 0)
+    {
+        stats->frag_next_offset = 0;
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): bundle does not fit, and cannot be fragmented\n", __func__);
+        return BP_ERROR;
+    }
+
+    *size = export_sz;
+    return BP_SUCCESS;
+}
+
+int bplib_generic_bundle_egress(bplib_mpool_ref_t flow_ref, bplib_cla_stats_t *stats, void *content, size_t *size,
+                                uint64_t time_limit)
 {
     bplib_mpool_flow_t           *flow;
     bplib_mpool_bblock_primary_t *cpb;
     bplib_mpool_block_t          *pblk;
-    size_t                        export_sz;
+    uint64_t                      egress_time;
     int                           status;
 
     pblk = NULL;
@@ -199,9 +481,19 @@ int bplib_generic_bundle_egress(bplib_mpool_ref_t flow_ref, void *content, size_
     }
     else
     {
-        /* this removes it from the list */
-        /* NOTE: after this point a valid bundle has to be put somewhere (either onto another queue or recycled) */
-        pblk = bplib_mpool_flow_try_pull(&flow->egress, time_limit);
+        if (stats->frag_pending_block != NULL)
+        {
+            /* continue with the bundle that is part way through being sent as fragments */
+            pblk                      = stats->frag_pending_block;
+            stats->frag_pending_block = NULL;
+        }
+        else
+        {
+            /* this removes it from the list */
+            /* NOTE: after this point a valid bundle has to be put somewhere (either onto another queue or recycled) */
+            pblk = bplib_mpool_flow_try_pull(&flow->egress, time_limit);
+        }
+
         if (pblk == NULL)
         {
             /* queue is empty */
@@ -209,54 +501,422 @@ int bplib_generic_bundle_egress(bplib_mpool_ref_t flow_ref, void *content, size_
         }
         else
         {
+            egress_time = bplib_os_get_dtntime_ms();
+
             cpb = bplib_mpool_bblock_primary_cast(pblk);
             if (cpb == NULL)
             {
                 /* entry wasn't a bundle? */
                 status = BP_ERROR;
             }
+            else if (stats->frag_next_offset == 0 &&
+                     bplib_cla_update_forwarded_blocks(cpb, stats->local_node, egress_time) != BP_SUCCESS)
+            {
+                /* extension blocks could not be updated (or the deferred CRC check failed, or the hop limit
+                 * was exceeded) */
+                status = BP_ERROR;
+            }
             else
             {
-                export_sz = v7_compute_full_bundle_size(cpb);
-
-                if (export_sz > *size)
+                status = bplib_cla_export_bundle(stats, cpb, content, size);
+                if (status == BP_SUCCESS && stats->frag_next_offset == 0)
                 {
-                    /* buffer too small */
-                    status = BP_ERROR;
-                }
-                else
-                {
-
-                    *size = v7_copy_full_bundle_out(cpb, content, *size);
-
-                    if (export_sz != *size)
-                    {
-                        /* something went wrong during copy */
-                        status = BP_ERROR;
-                    }
-                    else
-                    {
-                        /* indicate that this has been sent out the intf */
-                        cpb->delivery_data.egress_intf_id =
-                            bplib_mpool_get_external_id(bplib_mpool_dereference(flow_ref));
-                        cpb->delivery_data.egress_time = bplib_os_get_dtntime_ms();
-
-                        status = BP_SUCCESS;
-                    }
+                    /* indicate that this has been sent out the intf */
+                    cpb->delivery_data.egress_intf_id = bplib_mpool_get_external_id(bplib_mpool_dereference(flow_ref));
+                    cpb->delivery_data.egress_time    = egress_time;
                 }
             }
 
-            bplib_mpool_recycle_block(pblk);
+            if (status == BP_SUCCESS && stats->frag_next_offset != 0)
+            {
+                /* more fragments to go, hold on to it until the next call */
+                stats->frag_pending_block = pblk;
+            }
+            else
+            {
+                stats->frag_next_offset = 0;
+                bplib_mpool_recycle_block(pblk);
+            }
         }
     }
 
     return status;
 }
 
+int bplib_cla_intf_destruct(void *arg, bplib_mpool_block_t *blk)
+{
+    bplib_cla_stats_t *stats;
+
+    stats = bplib_mpool_generic_data_cast(blk, BPLIB_BLOCKTYPE_CLA_INTF);
+    if (stats == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    /* drop the rest of a bundle that was part way through being sent as fragments */
+    if (stats->frag_pending_block != NULL)
+    {
+        bplib_mpool_recycle_block(stats->frag_pending_block);
+        stats->frag_pending_block = NULL;
+    }
+
+    return BP_SUCCESS;
+}
+
+/*
+ * Makes an aggregate bundle holding all of the pending bundles.  Returns a block referring to it,
+ * or NULL if it could not be made.
+ */
+static bplib_mpool_block_t *bplib_cla_aggregator_make_bundle(bplib_mpool_t *pool, bplib_cla_aggregator_t *agg,
+                                                             uint64_t egress_time)
+{
+    bplib_mpool_block_t            *pblk;
+    bplib_mpool_block_t            *cblk;
+    bplib_mpool_block_t            *rblk;
+    bplib_mpool_ref_t               refptr;
+    bplib_mpool_bblock_primary_t   *cpb;
+    bplib_mpool_bblock_canonical_t *ccb;
+    bp_primary_block_t             *pri;
+    bp_canonical_block_buffer_t    *pay;
+    bp_ipn_addr_t                   ipn;
+    bplib_mpool_list_iter_t         iter;
+    bplib_mpool_block_t            *qblk;
+    size_t                          entry_size;
+    int                             status;
+
+    rblk = NULL;
+    cblk = NULL;
+    pblk = NULL;
+
+    do
+    {
+        pblk = bplib_mpool_bblock_primary_alloc(pool);
+        cpb  = bplib_mpool_bblock_primary_cast(pblk);
+        cblk = bplib_mpool_bblock_canonical_alloc(pool);
+        ccb  = bplib_mpool_bblock_canonical_cast(cblk);
+        if (cpb == NULL || ccb == NULL)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): cannot allocate aggregate bundle\n", __func__);
+            break;
+        }
+
+        pri = bplib_mpool_bblock_primary_get_logical(cpb);
+
+        pri->version                      = 7;
+        pri->crctype                      = BPLIB_CLA_AGGREGATE_PRI_CRCTYPE;
+        pri->controlFlags.isAdminRecord   = true;
+        pri->controlFlags.mustNotFragment = true;
+        pri->lifetime                     = BPLIB_CLA_AGGREGATE_LIFETIME;
+
+        ipn.node_number    = agg->local_node;
+        ipn.service_number = 0;
+        v7_set_eid(&pri->sourceEID, &ipn);
+        v7_set_eid(&pri->reportEID, &ipn);
+        ipn.node_number = agg->peer_node;
+        v7_set_eid(&pri->destinationEID, &ipn);
+
+        pri->creationTimeStamp.time         = v7_get_current_time();
+        pri->creationTimeStamp.sequence_num = agg->last_bundle_seq;
+        ++agg->last_bundle_seq;
+
+        pay                            = bplib_mpool_bblock_canonical_get_logical(ccb);
+        pay->canonical_block.blockNum  = 1;
+        pay->canonical_block.blockType = bp_blocktype_bundleAggregatePayloadBlock;
+        pay->canonical_block.crctype   = BPLIB_CLA_AGGREGATE_PAY_CRCTYPE;
+
+        /* the age of each bundle gets the time it spent waiting here (this is updated in place),
+         * and any bundle whose blocks cannot be updated is dropped rather than sent inconsistent */
+        status = bplib_mpool_list_iter_goto_first(&agg->pending_list, &iter);
+        while (status == BP_SUCCESS)
+        {
+            qblk   = iter.position;
+            status = bplib_mpool_list_iter_forward(&iter);
+            if (bplib_cla_update_forwarded_blocks(bplib_mpool_bblock_primary_cast(qblk), agg->local_node,
+                                                  egress_time) != BP_SUCCESS)
+            {
+                entry_size = v7_compute_aggregate_entry_size(
+                    v7_compute_full_bundle_size(bplib_mpool_bblock_primary_cast(qblk)));
+                agg->pending_size = (agg->pending_size > entry_size) ? (agg->pending_size - entry_size) : 0;
+                --agg->pending_count;
+                bplib_mpool_extract_node(qblk);
+                bplib_mpool_recycle_block(qblk);
+            }
+        }
+
+        if (agg->pending_count == 0)
+        {
+            break;
+        }
+
+        if (v7_block_encode_pri(cpb) < 0 || v7_block_encode_pay_from_bundles(ccb, &agg->pending_list) < 0)
+        {
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): cannot encode aggregate bundle\n", __func__);
+            break;
+        }
+
+        bplib_mpool_bblock_primary_append(cpb, cblk);
+        cblk = NULL; /* do not need now that it is stored */
+
+        refptr = bplib_mpool_ref_create(pblk);
+        if (refptr == NULL)
+        {
+            break;
+        }
+
+        pblk = NULL; /* do not use original anymore */
+        rblk = bplib_mpool_ref_make_block(refptr, BPLIB_BLOCKTYPE_CLA_AGGREGATE_BLOCK, NULL);
+        bplib_mpool_ref_release(refptr);
+    }
+    while (false);
+
+    /* clean up, if anything did not work, recycle the blocks now */
+    if (cblk != NULL)
+    {
+        bplib_mpool_recycle_block(cblk);
+    }
+
+    if (pblk != NULL)
+    {
+        bplib_mpool_recycle_block(pblk);
+    }
+
+    return rblk;
+}
+
+/*
+ * Sends the pending bundles on to the CLA.  If there is more than one, they go in a single aggregate,
+ * otherwise (or if the aggregate cannot be made) they are just passed on as they are.
+ */
+static void bplib_cla_aggregator_flush(bplib_mpool_block_t *intf_block, bplib_cla_aggregator_t *agg,
+                                       bplib_mpool_flow_t *parent_flow, uint64_t egress_time)
+{
+    bplib_mpool_t                *pool;
+    bplib_mpool_block_t          *qblk;
+    bplib_mpool_block_t          *rblk;
+    bplib_mpool_bblock_primary_t *cpb;
+    bplib_mpool_list_iter_t       iter;
+    int                           status;
+
+    pool = bplib_mpool_get_parent_pool_from_link(intf_block);
+    rblk = NULL;
+    if (agg->pending_count > 1)
+    {
+        rblk = bplib_cla_aggregator_make_bundle(pool, agg, egress_time);
+    }
+
+    if (rblk != NULL)
+    {
+        if (!bplib_mpool_flow_try_push(&parent_flow->egress, rblk, 0))
+        {
+            bplib_mpool_recycle_block(rblk);
+        }
+
+        /* as far as this intf is concerned, the bundles have now been sent */
+        status = bplib_mpool_list_iter_goto_first(&agg->pending_list, &iter);
+        while (status == BP_SUCCESS)
+        {
+            cpb = bplib_mpool_bblock_primary_cast(iter.position);
+            if (cpb != NULL)
+            {
+                cpb->delivery_data.egress_intf_id = bplib_mpool_get_external_id(intf_block);
+                cpb->delivery_data.egress_time    = egress_time;
+            }
+            status = bplib_mpool_list_iter_forward(&iter);
+        }
+
+        bplib_mpool_recycle_all_blocks_in_list(pool, &agg->pending_list);
+    }
+    else
+    {
+        /* send them on separately */
+        while (!bplib_mpool_is_empty_list_head(&agg->pending_list))
+        {
+            qblk = bplib_mpool_get_next_block(&agg->pending_list);
+            bplib_mpool_extract_node(qblk);
+            if (!bplib_mpool_flow_try_push(&parent_flow->egress, qblk, 0))
+            {
+                bplib_mpool_recycle_block(qblk);
+            }
+        }
+    }
+
+    agg->pending_size  = 0;
+    agg->pending_count = 0;
+}
+
+/*
+ * Collects small bundles from the aggregator egress queue, until there is enough to fill an aggregate
+ * or the oldest one has waited for the maximum delay.  Bundles too big to be worth aggregating are
+ * passed straight on to the CLA, after any that were already waiting, so the order is kept.
+ */
+int bplib_cla_aggregator_forward_egress(void *arg, bplib_mpool_block_t *subq_src)
+{
+    bplib_mpool_block_t          *intf_block;
+    bplib_mpool_block_t          *qblk;
+    bplib_mpool_flow_t           *flow;
+    bplib_mpool_flow_t           *parent_flow;
+    bplib_cla_aggregator_t       *agg;
+    bplib_mpool_bblock_primary_t *cpb;
+    uint64_t                      egress_time;
+    size_t                        entry_size;
+    int                           forward_count;
+
+    intf_block  = bplib_mpool_get_block_from_link(subq_src);
+    flow        = bplib_mpool_flow_cast(intf_block);
+    agg         = bplib_mpool_generic_data_cast(intf_block, BPLIB_BLOCKTYPE_CLA_AGGREGATOR);
+    parent_flow = NULL;
+    if (flow != NULL)
+    {
+        parent_flow = bplib_mpool_flow_cast(bplib_mpool_dereference(flow->parent));
+    }
+
+    if (agg == NULL || parent_flow == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to cast aggregator block\n");
+        return -1;
+    }
+
+    egress_time   = bplib_os_get_dtntime_ms();
+    forward_count = 0;
+    while (true)
+    {
+        qblk = bplib_mpool_flow_try_pull(&flow->egress, 0);
+        if (qblk == NULL)
+        {
+            /* no more bundles */
+            break;
+        }
+
+        ++forward_count;
+
+        /* this may change the size of the blocks, so it needs to be done before the size is known */
+        cpb = bplib_mpool_bblock_primary_cast(qblk);
+        if (cpb == NULL || bplib_cla_update_forwarded_blocks(cpb, agg->local_node, egress_time) != BP_SUCCESS)
+        {
+            bplib_mpool_recycle_block(qblk);
+            continue;
+        }
+
+        entry_size = v7_compute_aggregate_entry_size(v7_compute_full_bundle_size(cpb));
+        if ((entry_size + V7_AGGREGATE_MAX_OVERHEAD) > agg->max_size)
+        {
+            bplib_cla_aggregator_flush(intf_block, agg, parent_flow, egress_time);
+            if (!bplib_mpool_flow_try_push(&parent_flow->egress, qblk, 0))
+            {
+                bplib_mpool_recycle_block(qblk);
+            }
+            continue;
+        }
+
+        if ((agg->pending_size + entry_size + V7_AGGREGATE_MAX_OVERHEAD) > agg->max_size)
+        {
+            bplib_cla_aggregator_flush(intf_block, agg, parent_flow, egress_time);
+        }
+
+        if (agg->pending_count == 0)
+        {
+            agg->pending_time = egress_time;
+        }
+
+        bplib_mpool_insert_before(&agg->pending_list, qblk);
+        agg->pending_size += entry_size;
+        ++agg->pending_count;
+    }
+
+    if (agg->pending_count != 0 && egress_time >= (agg->pending_time + agg->max_delay))
+    {
+        bplib_cla_aggregator_flush(intf_block, agg, parent_flow, egress_time);
+    }
+
+    return forward_count;
+}
+
+int bplib_cla_aggregator_event_impl(void *arg, bplib_mpool_block_t *intf_block)
+{
+    bplib_mpool_flow_generic_event_t *event;
+    bplib_mpool_flow_t               *flow;
+    bplib_mpool_flow_t               *parent_flow;
+    bplib_cla_aggregator_t           *agg;
+    uint64_t                          current_time;
+
+    event = arg;
+
+    flow = bplib_mpool_flow_cast(intf_block);
+    agg  = bplib_mpool_generic_data_cast(intf_block, BPLIB_BLOCKTYPE_CLA_AGGREGATOR);
+    if (flow == NULL || agg == NULL)
+    {
+        return BP_SUCCESS;
+    }
+
+    if (event->event_type == bplib_mpool_flow_event_poll)
+    {
+        /* the oldest bundle may have waited long enough, even if nothing else has come in */
+        current_time = bplib_os_get_dtntime_ms();
+        parent_flow  = bplib_mpool_flow_cast(bplib_mpool_dereference(flow->parent));
+        if (parent_flow != NULL && agg->pending_count != 0 && current_time >= (agg->pending_time + agg->max_delay))
+        {
+            bplib_cla_aggregator_flush(intf_block, agg, parent_flow, current_time);
+        }
+
+        return BP_SUCCESS;
+    }
+
+    /* otherwise the state change handling is the same as the CLA itself */
+    if (event->event_type == bplib_mpool_flow_event_down &&
+        bp_handle_equal(event->intf_state.intf_id, bplib_mpool_get_external_id(intf_block)))
+    {
+        bplib_mpool_recycle_all_blocks_in_list(NULL, &agg->pending_list);
+        agg->pending_size  = 0;
+        agg->pending_count = 0;
+    }
+
+    return bplib_cla_event_impl(arg, intf_block);
+}
+
+int bplib_cla_aggregator_construct(void *arg, bplib_mpool_block_t *blk)
+{
+    bplib_cla_aggregator_t *agg;
+
+    agg = bplib_mpool_generic_data_cast(blk, BPLIB_BLOCKTYPE_CLA_AGGREGATOR);
+    if (agg == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    bplib_mpool_init_list_head(blk, &agg->pending_list);
+    return BP_SUCCESS;
+}
+
+int bplib_cla_aggregator_destruct(void *arg, bplib_mpool_block_t *blk)
+{
+    bplib_cla_aggregator_t *agg;
+
+    agg = bplib_mpool_generic_data_cast(blk, BPLIB_BLOCKTYPE_CLA_AGGREGATOR);
+    if (agg == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    bplib_mpool_recycle_all_blocks_in_list(NULL, &agg->pending_list);
+    return BP_SUCCESS;
+}
+
 void bplib_cla_init(bplib_mpool_t *pool)
 {
-    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_CLA_INTF, NULL, sizeof(bplib_cla_stats_t));
+    const bplib_mpool_blocktype_api_t cla_intf_api = (bplib_mpool_blocktype_api_t) {
+        .construct = NULL,
+        .destruct  = bplib_cla_intf_destruct,
+    };
+    const bplib_mpool_blocktype_api_t cla_aggregator_api = (bplib_mpool_blocktype_api_t) {
+        .construct = bplib_cla_aggregator_construct,
+        .destruct  = bplib_cla_aggregator_destruct,
+    };
+
+    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_CLA_INTF, &cla_intf_api, sizeof(bplib_cla_stats_t));
     bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_CLA_INGRESS_BLOCK, NULL, 0);
+    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_CLA_AGGREGATOR, &cla_aggregator_api,
+                                   sizeof(bplib_cla_aggregator_t));
+    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_CLA_AGGREGATE_BLOCK, NULL, 0);
 }
 
 /******************************************************************************
@@ -296,6 +956,60 @@ bp_handle_t bplib_create_cla_intf(bplib_routetbl_t *rtbl)
     return self_intf_id;
 }
 
+bp_handle_t bplib_create_cla_aggregator(bplib_routetbl_t *rtbl, bp_handle_t cla_intf_id, bp_ipn_t local_node,
+                                        bp_ipn_t peer_node, size_t max_size, uint32_t max_delay)
+{
+    bplib_mpool_block_t    *sblk;
+    bplib_mpool_ref_t       cla_ref;
+    bplib_cla_aggregator_t *agg;
+    bp_handle_t             self_intf_id;
+    bplib_mpool_t          *pool;
+
+    if (max_size <= V7_AGGREGATE_MAX_OVERHEAD)
+    {
+        bplog(NULL, BP_FLAG_API_ERROR, "%s(): aggregate size %lu too small\n", __func__, (unsigned long)max_size);
+        return BP_INVALID_HANDLE;
+    }
+
+    cla_ref = bplib_route_get_intf_controlblock(rtbl, cla_intf_id);
+    if (bplib_mpool_generic_data_cast(bplib_mpool_dereference(cla_ref), BPLIB_BLOCKTYPE_CLA_INTF) == NULL)
+    {
+        bplib_route_release_intf_controlblock(rtbl, cla_ref);
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Intf ID is not a CLA\n");
+        return BP_INVALID_HANDLE;
+    }
+    bplib_route_release_intf_controlblock(rtbl, cla_ref);
+
+    pool = bplib_route_get_mpool(rtbl);
+
+    /* Allocate Blocks */
+    sblk = bplib_mpool_flow_alloc(pool, BPLIB_BLOCKTYPE_CLA_AGGREGATOR, NULL);
+    agg  = bplib_mpool_generic_data_cast(sblk, BPLIB_BLOCKTYPE_CLA_AGGREGATOR);
+    if (agg == NULL)
+    {
+        bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed to allocate intf block\n");
+        return BP_INVALID_HANDLE;
+    }
+
+    agg->local_node = local_node;
+    agg->peer_node  = peer_node;
+    agg->max_size   = max_size;
+    agg->max_delay  = max_delay;
+
+    self_intf_id = bplib_route_register_generic_intf(rtbl, cla_intf_id, sblk);
+    if (bp_handle_is_valid(self_intf_id))
+    {
+        bplib_route_register_forward_egress_handler(rtbl, self_intf_id, bplib_cla_aggregator_forward_egress);
+        bplib_route_register_event_handler(rtbl, self_intf_id, bplib_cla_aggregator_event_impl);
+    }
+    else
+    {
+        bplib_mpool_recycle_block(sblk);
+    }
+
+    return self_intf_id;
+}
+
 int bplib_cla_egress(bplib_routetbl_t *rtbl, bp_handle_t intf_id, void *bundle, size_t *size, uint32_t timeout)
 {
     bplib_mpool_ref_t  flow_ref;
@@ -333,7 +1047,7 @@ int bplib_cla_egress(bplib_routetbl_t *rtbl, bp_handle_t intf_id, void *bundle,
     }
     else
     {
-        status = bplib_generic_bundle_egress(flow_ref, bundle, size, egress_time_limit);
+        status = bplib_generic_bundle_egress(flow_ref, stats, bundle, size, egress_time_limit);
         if (status == BP_SUCCESS)
         {
             stats->egress_byte_count += *size;
@@ -376,7 +1090,8 @@ int bplib_cla_ingress(bplib_routetbl_t *rtbl, bp_handle_t intf_id, const void *b
             ingress_time_limit = bplib_os_get_dtntime_ms() + timeout;
         }
 
-        status = bplib_generic_bundle_ingress(flow_ref, bundle, size, ingress_time_limit);
+        status = bplib_generic_bundle_ingress(flow_ref, bundle, size, ingress_time_limit,
+                                              stats->crc_policy == bplib_cla_crc_policy_deferred);
 
         if (status == BP_SUCCESS)
         {
@@ -391,3 +1106,99 @@ int bplib_cla_ingress(bplib_routetbl_t *rtbl, bp_handle_t intf_id, const void *b
 
     return status;
 }
+
+int bplib_cla_set_crc_policy(bplib_routetbl_t *rtbl, bp_handle_t intf_id, bplib_cla_crc_policy_t policy)
+{
+    bplib_mpool_ref_t  flow_ref;
+    int                status;
+    bplib_cla_stats_t *stats;
+
+    if (policy != bplib_cla_crc_policy_verify_on_ingress && policy != bplib_cla_crc_policy_deferred)
+    {
+        bplog(NULL, BP_FLAG_API_ERROR, "%s(): invalid CRC policy %d\n", __func__, (int)policy);
+        return BP_ERROR;
+    }
+
+    flow_ref = bplib_route_get_intf_controlblock(rtbl, intf_id);
+    if (flow_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Intf ID invalid\n");
+        return BP_ERROR;
+    }
+
+    stats = bplib_mpool_generic_data_cast(bplib_mpool_dereference(flow_ref), BPLIB_BLOCKTYPE_CLA_INTF);
+    if (stats == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Intf ID is not a CLA\n");
+        status = BP_ERROR;
+    }
+    else
+    {
+        stats->crc_policy = policy;
+        status            = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(rtbl, flow_ref);
+
+    return status;
+}
+
+int bplib_cla_set_mtu(bplib_routetbl_t *rtbl, bp_handle_t intf_id, size_t mtu)
+{
+    bplib_mpool_ref_t  flow_ref;
+    int                status;
+    bplib_cla_stats_t *stats;
+
+    flow_ref = bplib_route_get_intf_controlblock(rtbl, intf_id);
+    if (flow_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Intf ID invalid\n");
+        return BP_ERROR;
+    }
+
+    stats = bplib_mpool_generic_data_cast(bplib_mpool_dereference(flow_ref), BPLIB_BLOCKTYPE_CLA_INTF);
+    if (stats == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Intf ID is not a CLA\n");
+        status = BP_ERROR;
+    }
+    else
+    {
+        stats->mtu = mtu;
+        status     = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(rtbl, flow_ref);
+
+    return status;
+}
+
+int bplib_cla_set_local_node(bplib_routetbl_t *rtbl, bp_handle_t intf_id, bp_ipn_t local_node)
+{
+    bplib_mpool_ref_t  flow_ref;
+    int                status;
+    bplib_cla_stats_t *stats;
+
+    flow_ref = bplib_route_get_intf_controlblock(rtbl, intf_id);
+    if (flow_ref == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Intf ID invalid\n");
+        return BP_ERROR;
+    }
+
+    stats = bplib_mpool_generic_data_cast(bplib_mpool_dereference(flow_ref), BPLIB_BLOCKTYPE_CLA_INTF);
+    if (stats == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "Intf ID is not a CLA\n");
+        status = BP_ERROR;
+    }
+    else
+    {
+        stats->local_node = local_node;
+        status            = BP_SUCCESS;
+    }
+
+    bplib_route_release_intf_controlblock(rtbl, flow_ref);
+
+    return status;
+}
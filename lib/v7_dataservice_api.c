@@ -34,6 +34,8 @@
 #include "v7_rbtree.h"
 #include "bplib_routing.h"
 #include "bplib_dataservice.h"
+#include "bplib_reassembly.h"
+#include "lzc.h"
 
 /******************************************************************************
  TYPEDEFS
@@ -44,11 +46,26 @@
 #define BPLIB_BLOCKTYPE_SERVICE_SOCKET   0xc21bb332
 #define BPLIB_BLOCKTYPE_SERVICE_BLOCK    0xbd35ac62
 
+/*
+ * A compressed payload is only sent if it saves at least this much, which more than covers the
+ * compression block that has to be added to the bundle.
+ */
+#define BPLIB_SERVICEFLOW_MIN_COMPRESSION_SAVING 24
+
+/*
+ * Size of the scratch buffers for compressed payloads.  A payload is only compressed if the result
+ * fits, otherwise it is sent as it is, and a received compressed payload that does not fit is dropped.
+ */
+#ifndef BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE
+#define BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE (64 * 1024)
+#endif
+
 typedef struct bplib_route_serviceintf_info
 {
-    bp_ipn_t          node_number;
-    bplib_rbt_root_t  service_index;
-    bplib_mpool_ref_t storage_service;
+    bp_ipn_t                 node_number;
+    bplib_rbt_root_t         service_index;
+    bplib_mpool_ref_t        storage_service;
+    bplib_reassembly_table_t reassembly; /* fragments of bundles for local delivery */
 
 } bplib_route_serviceintf_info_t;
 
@@ -71,12 +88,193 @@ struct bplib_socket_info
     uintmax_t           ingress_byte_count;
     uintmax_t           egress_byte_count;
     bp_sequencenumber_t last_bundle_seq;
+
+    /*
+     * Pre-encoded primary block for bundles sent on this socket, created on first send.
+     * This is a CBOR data block holding a v7_primary_block_template_t.
+     */
+    bplib_mpool_block_t *pri_template_blk;
+
+    /*
+     * Payload compression (compress is NULL if not enabled).  The scratch buffers hold a compressed
+     * payload being sent or received.  Both are allocated when compression is enabled, the rx one
+     * otherwise on the first compressed payload received, and they are kept until the socket is closed.
+     */
+    bplib_compression_api_t compression;
+    uint8_t                *tx_scratch;
+    uint8_t                *rx_scratch;
+};
+
+/******************************************************************************
+ FILE DATA
+ ******************************************************************************/
+
+const bplib_compression_api_t bplib_compression_lz = {
+    .algorithm_id = BP_COMPRESSION_LZ,
+    .compress     = lzc_compress,
+    .decompress   = lzc_decompress,
 };
 
 /******************************************************************************
  LOCAL FUNCTIONS
  ******************************************************************************/
 
+/*
+ * Gets the primary block template for the socket, creating it if needed.  Returns NULL if
+ * the template cannot be created, in which case the primary block is fully encoded instead.
+ */
+static const v7_primary_block_template_t *bplib_serviceflow_get_pri_template(bplib_socket_info_t      *sock_inf,
+                                                                              const bp_primary_block_t *pri)
+{
+    bplib_mpool_t               *pool;
+    v7_primary_block_template_t *tmpl;
+
+    if (sock_inf->pri_template_blk == NULL)
+    {
+        pool = bplib_route_get_mpool(sock_inf->parent_rtbl);
+
+        sock_inf->pri_template_blk = bplib_mpool_bblock_cbor_alloc(pool);
+        if (sock_inf->pri_template_blk == NULL)
+        {
+            return NULL;
+        }
+
+        tmpl = bplib_mpool_bblock_cbor_cast(sock_inf->pri_template_blk);
+        if (tmpl == NULL || bplib_mpool_get_generic_data_capacity(sock_inf->pri_template_blk) < sizeof(*tmpl) ||
+            v7_block_template_init_pri(tmpl, pri) < 0)
+        {
+            /* not expected, but it can always be encoded the normal way */
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): cannot create primary block template\n", __func__);
+            bplib_mpool_recycle_block(sock_inf->pri_template_blk);
+            sock_inf->pri_template_blk = NULL;
+            return NULL;
+        }
+
+        bplib_mpool_bblock_cbor_set_size(sock_inf->pri_template_blk, sizeof(*tmpl));
+    }
+
+    return bplib_mpool_bblock_cbor_cast(sock_inf->pri_template_blk);
+}
+
+/*
+ * Gets a scratch buffer of BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE, allocating it if this is the
+ * first use.  Returns NULL if it cannot be allocated.
+ */
+static uint8_t *bplib_serviceflow_get_scratch(uint8_t **buf)
+{
+    if (*buf == NULL)
+    {
+        *buf = bplib_os_calloc(BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE);
+        if (*buf == NULL)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): cannot allocate %lu octets\n", __func__,
+                  (unsigned long)BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE);
+        }
+    }
+
+    return *buf;
+}
+
+/*
+ * Compresses the payload into the tx scratch buffer of the socket.  Returns the compressed size,
+ * or 0 if the payload is to be sent as it is (compression is not enabled, or does not save enough).
+ */
+static size_t bplib_serviceflow_compress_payload(bplib_socket_info_t *sock_inf, const void *content, size_t size)
+{
+    size_t limit;
+
+    if (sock_inf->compression.compress == NULL || sock_inf->params.is_admin_service ||
+        size <= BPLIB_SERVICEFLOW_MIN_COMPRESSION_SAVING)
+    {
+        return 0;
+    }
+
+    /* the scratch buffer was allocated when compression was enabled */
+    limit = size - BPLIB_SERVICEFLOW_MIN_COMPRESSION_SAVING;
+    if (limit > BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE)
+    {
+        limit = BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE;
+    }
+
+    if (sock_inf->tx_scratch == NULL)
+    {
+        return 0;
+    }
+
+    return sock_inf->compression.compress(content, size, sock_inf->tx_scratch, limit);
+}
+
+/*
+ * Decompresses the payload of a received bundle, as identified by its compression block.  The
+ * compressed payload is first copied out of the block into the rx scratch buffer of the socket.
+ */
+static int bplib_serviceflow_decompress_payload(bplib_socket_info_t            *sock_inf,
+                                                bplib_mpool_bblock_canonical_t *ccb_comp,
+                                                bplib_mpool_bblock_canonical_t *ccb_pay, void *content, size_t *size)
+{
+    const bp_payload_compression_block_t *comp;
+    const bplib_compression_api_t        *api;
+    size_t                                content_size;
+    size_t                                content_offset;
+    size_t                                temp_size;
+
+    comp = &bplib_mpool_bblock_canonical_get_logical(ccb_comp)->data.payload_compression_block;
+
+    if (sock_inf->compression.decompress != NULL && comp->algorithm == sock_inf->compression.algorithm_id)
+    {
+        api = &sock_inf->compression;
+    }
+    else if (comp->algorithm == BP_COMPRESSION_LZ)
+    {
+        api = &bplib_compression_lz;
+    }
+    else
+    {
+        bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): Unknown compression algorithm %lu\n", __func__,
+              (unsigned long)comp->algorithm);
+        return BP_ERROR;
+    }
+
+    content_size   = bplib_mpool_bblock_canonical_get_content_length(ccb_pay);
+    content_offset = bplib_mpool_bblock_canonical_get_content_offset(ccb_pay);
+
+    if (content_offset == 0 || content_size == 0 || comp->uncompressed_length > *size)
+    {
+        bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): Incorrectly sized bundle\n", __func__);
+        return BP_ERROR;
+    }
+
+    if (content_size > BPLIB_SERVICEFLOW_COMPRESSION_SCRATCH_SIZE)
+    {
+        bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): Compressed payload too big: %lu\n", __func__,
+              (unsigned long)content_size);
+        return BP_ERROR;
+    }
+
+    if (bplib_serviceflow_get_scratch(&sock_inf->rx_scratch) == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    temp_size = bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb_pay),
+                                               sock_inf->rx_scratch, content_size, content_offset, content_size);
+    if (temp_size != content_size)
+    {
+        bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): Failed to copy complete payload\n", __func__);
+        return BP_ERROR;
+    }
+
+    temp_size = api->decompress(sock_inf->rx_scratch, content_size, content, comp->uncompressed_length);
+    if (temp_size != comp->uncompressed_length)
+    {
+        bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): Failed to decompress payload\n", __func__);
+        return BP_ERROR;
+    }
+
+    *size = temp_size;
+    return BP_SUCCESS;
+}
+
 bplib_mpool_ref_t bplib_serviceflow_bundleize_payload(bplib_socket_info_t *sock_inf, const void *content, size_t size)
 {
     bplib_mpool_t    *pool;
@@ -89,6 +287,12 @@ bplib_mpool_ref_t bplib_serviceflow_bundleize_payload(bplib_socket_info_t *sock_
     bp_primary_block_t             *pri;
     bplib_mpool_bblock_canonical_t *ccb_pay;
     bp_canonical_block_buffer_t    *pay;
+    bplib_mpool_bblock_canonical_t *ccb_comp;
+    bp_canonical_block_buffer_t    *comp;
+
+    const v7_primary_block_template_t *pri_template;
+    int                                encode_status;
+    size_t                             compressed_size;
 
     /* Allocate Blocks */
     pool   = bplib_route_get_mpool(sock_inf->parent_rtbl);
@@ -128,13 +332,64 @@ bplib_mpool_ref_t bplib_serviceflow_bundleize_payload(bplib_socket_info_t *sock_
         pri_block->delivery_data.delivery_policy     = sock_inf->params.local_delivery_policy;
         pri_block->delivery_data.local_retx_interval = sock_inf->params.local_retx_interval;
 
-        /* Pre-Encode Primary Block */
-        if (v7_block_encode_pri(pri_block) < 0)
+        /*
+         * Pre-Encode Primary Block - everything except the creation timestamp is the same for
+         * every bundle sent on this socket, so normally this just fills in the template.
+         */
+        pri_template = bplib_serviceflow_get_pri_template(sock_inf, pri);
+        if (pri_template != NULL)
+        {
+            encode_status = v7_block_encode_pri_from_template(pri_block, pri_template);
+        }
+        else
+        {
+            encode_status = v7_block_encode_pri(pri_block);
+        }
+
+        if (encode_status < 0)
         {
             bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed encoding pri block\n");
             break;
         }
 
+        /* Compress the payload, if enabled, and add the block that says how to decompress it */
+        compressed_size = bplib_serviceflow_compress_payload(sock_inf, content, size);
+        if (compressed_size != 0)
+        {
+            cblk     = bplib_mpool_bblock_canonical_alloc(pool);
+            ccb_comp = bplib_mpool_bblock_canonical_cast(cblk);
+            if (ccb_comp == NULL)
+            {
+                bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed to allocate compression block\n");
+                break;
+            }
+
+            comp = bplib_mpool_bblock_canonical_get_logical(ccb_comp);
+
+            comp->canonical_block.blockNum  = bp_blocktype_payloadCompressionBlock;
+            comp->canonical_block.blockType = bp_blocktype_payloadCompressionBlock;
+            comp->canonical_block.crctype   = sock_inf->params.crctype;
+
+            /* the payload is useless without this block, so it goes in every fragment */
+            comp->canonical_block.processingControlFlags.must_replicate = true;
+            comp->canonical_block.processingControlFlags.must_delete    = true;
+
+            comp->data.payload_compression_block.algorithm           = sock_inf->compression.algorithm_id;
+            comp->data.payload_compression_block.uncompressed_length = size;
+
+            if (v7_block_encode_canonical(ccb_comp) < 0)
+            {
+                bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed encoding compression block\n");
+                break;
+            }
+
+            bplib_mpool_bblock_primary_append(pri_block, cblk);
+            cblk = NULL;
+
+            content = sock_inf->tx_scratch;
+            size    = compressed_size;
+        }
+
         /* Update Payload Block */
         cblk    = bplib_mpool_bblock_canonical_alloc(pool);
         ccb_pay = bplib_mpool_bblock_canonical_cast(cblk);
@@ -192,6 +447,7 @@ int bplib_serviceflow_unbundleize_payload(bplib_socket_info_t *sock_inf, bplib_m
 {
     bplib_mpool_bblock_primary_t   *pri;
     bplib_mpool_bblock_canonical_t *ccb_pay;
+    bplib_mpool_bblock_canonical_t *ccb_comp;
     bplib_mpool_block_t            *cblk;
     size_t                          content_size;
     size_t                          content_offset;
@@ -220,6 +476,15 @@ int bplib_serviceflow_unbundleize_payload(bplib_socket_info_t *sock_inf, bplib_m
             break;
         }
 
+        /* if the payload was compressed, it is decompressed directly into the output */
+        cblk     = bplib_mpool_bblock_primary_locate_canonical(pri, bp_blocktype_payloadCompressionBlock);
+        ccb_comp = bplib_mpool_bblock_canonical_cast(cblk);
+        if (ccb_comp != NULL)
+        {
+            status = bplib_serviceflow_decompress_payload(sock_inf, ccb_comp, ccb_pay, content, size);
+            break;
+        }
+
         content_size   = bplib_mpool_bblock_canonical_get_content_length(ccb_pay);
         content_offset = bplib_mpool_bblock_canonical_get_content_offset(ccb_pay);
 
@@ -335,6 +600,7 @@ int bplib_serviceflow_forward_egress(void *arg, bplib_mpool_block_t *subq_src)
     bplib_mpool_block_t            *pblk;
     bplib_mpool_block_t            *intf_block;
     bplib_mpool_bblock_primary_t   *pri_block;
+    bplib_mpool_ref_t               refptr;
     bp_ipn_addr_t                   bundle_src;
     bp_ipn_addr_t                   bundle_dest;
     int                             forward_count;
@@ -375,7 +641,23 @@ int bplib_serviceflow_forward_egress(void *arg, bplib_mpool_block_t *subq_src)
                 next_flow_ref = base_intf->storage_service;
             }
 
-            if (next_flow_ref == NULL)
+            /* Bundles received with the CRC check deferred must be checked before local delivery */
+            if (next_flow_ref == NULL && v7_verify_deferred_crc(pri_block) == 0 &&
+                pri_block->pri_logical_data.controlFlags.isFragment)
+            {
+                /* held until the rest of the fragments arrive, then the whole bundle is delivered instead */
+                refptr    = bplib_reassembly_collect(&base_intf->reassembly, pblk, bplib_os_get_dtntime_ms());
+                pblk      = NULL;
+                pri_block = NULL;
+                if (refptr != NULL)
+                {
+                    pblk      = bplib_mpool_ref_make_block(refptr, BPLIB_BLOCKTYPE_SERVICE_BLOCK, NULL);
+                    pri_block = bplib_mpool_bblock_primary_cast(pblk);
+                    bplib_mpool_ref_release(refptr);
+                }
+            }
+
+            if (next_flow_ref == NULL && pri_block != NULL && !pri_block->crc_verify_deferred)
             {
                 v7_get_eid(&bundle_src, &bplib_mpool_bblock_primary_get_logical(pri_block)->sourceEID);
                 v7_get_eid(&bundle_dest, &bplib_mpool_bblock_primary_get_logical(pri_block)->destinationEID);
@@ -495,6 +777,9 @@ bplib_mpool_ref_t bplib_serviceflow_remove_from_base(bplib_mpool_block_t *base_i
             {
                 bplib_mpool_ref_release(base_intf->storage_service);
                 base_intf->storage_service = NULL;
+
+                /* whatever backpressure the storage service applied goes away with it */
+                bplib_mpool_flow_modify_flags(base_intf_blk, 0, BPLIB_MPOOL_FLOW_FLAGS_CONGESTED);
             }
 
             bplib_mpool_recycle_block(endpoint_intf->self_ptr);
@@ -508,14 +793,101 @@ bplib_mpool_ref_t bplib_serviceflow_remove_from_base(bplib_mpool_block_t *base_i
     return endpoint_intf_ref;
 }
 
+/**
+ * @brief Checks if the base interface above a service flow is congested
+ *
+ * @param flow
+ */
+static bool bplib_serviceflow_parent_is_congested(const bplib_mpool_flow_t *flow)
+{
+    bplib_mpool_flow_t *parent_flow;
+
+    if (flow->parent == NULL)
+    {
+        return false;
+    }
+
+    parent_flow = bplib_mpool_flow_cast(bplib_mpool_dereference(flow->parent));
+
+    return (parent_flow != NULL && (parent_flow->current_state_flags & BPLIB_MPOOL_FLOW_FLAGS_CONGESTED) != 0);
+}
+
+/**
+ * @brief Applies or releases backpressure on all the data service sockets under a base interface
+ *
+ * This is triggered by the storage service, when it is running out of room.  The ingress queue
+ * of every socket that is up is closed (depth limit 0) so bplib_send() blocks, rather than the
+ * bundles being dropped later on.  The storage service itself is not affected, as it needs its
+ * own ingress path to drain.
+ *
+ * @param base_intf
+ * @param is_congested
+ */
+static void bplib_serviceflow_apply_backpressure(bplib_route_serviceintf_info_t *base_intf, bool is_congested)
+{
+    bplib_rbt_iter_t       rbt_it;
+    bplib_service_endpt_t *endpoint_intf;
+    bplib_mpool_flow_t    *subflow;
+    int                    status;
+
+    status = bplib_rbt_iter_goto_min(0, &base_intf->service_index, &rbt_it);
+    while (status == BP_SUCCESS)
+    {
+        endpoint_intf = (bplib_service_endpt_t *)rbt_it.position; /* because its the first item */
+        subflow       = bplib_mpool_flow_cast(bplib_mpool_dereference(endpoint_intf->subflow_ref));
+
+        if (subflow != NULL && endpoint_intf->subflow_ref != base_intf->storage_service &&
+            bplib_mpool_flow_is_up(subflow))
+        {
+            if (is_congested)
+            {
+                bplib_mpool_flow_enable(&subflow->ingress, 0);
+            }
+            else
+            {
+                /* this also wakes up any senders that were waiting */
+                bplib_mpool_flow_enable(&subflow->ingress, BP_MPOOL_MAX_SUBQ_DEPTH);
+            }
+        }
+
+        status = bplib_rbt_iter_next(&rbt_it);
+    }
+}
+
 int bplib_dataservice_event_impl(void *arg, bplib_mpool_block_t *intf_block)
 {
     bplib_mpool_flow_generic_event_t *event;
     bplib_mpool_flow_t               *flow;
+    bplib_route_serviceintf_info_t   *base_intf;
 
     event = arg;
 
-    /* only care about state change events for now */
+    if (event->event_type == bplib_mpool_flow_event_poll)
+    {
+        /* the base intf drops any bundles that did not get all of their fragments in time */
+        base_intf = bplib_mpool_generic_data_cast(intf_block, BPLIB_BLOCKTYPE_SERVICE_BASE);
+        if (base_intf != NULL)
+        {
+            bplib_reassembly_expire(&base_intf->reassembly, bplib_os_get_dtntime_ms());
+        }
+
+        return BP_SUCCESS;
+    }
+
+    if (event->event_type == bplib_mpool_flow_event_congested ||
+        event->event_type == bplib_mpool_flow_event_uncongested)
+    {
+        /* only the base intf does anything with these, it passes them on to the sockets under it */
+        base_intf = bplib_mpool_generic_data_cast(intf_block, BPLIB_BLOCKTYPE_SERVICE_BASE);
+        if (base_intf != NULL && bp_handle_equal(event->intf_state.intf_id, bplib_mpool_get_external_id(intf_block)))
+        {
+            bplib_serviceflow_apply_backpressure(base_intf, event->event_type == bplib_mpool_flow_event_congested);
+        }
+
+        return BP_SUCCESS;
+    }
+
+    /* otherwise only care about state change events for now */
     if (event->event_type != bplib_mpool_flow_event_up && event->event_type != bplib_mpool_flow_event_down)
     {
         return BP_SUCCESS;
@@ -530,8 +902,15 @@ int bplib_dataservice_event_impl(void *arg, bplib_mpool_block_t *intf_block)
 
     if (event->event_type == bplib_mpool_flow_event_up)
     {
-        /* Allows bundles to be pushed to flow queues */
-        bplib_mpool_flow_enable(&flow->ingress, BP_MPOOL_MAX_SUBQ_DEPTH);
+        /* Allows bundles to be pushed to flow queues - except for ingress if storage is applying backpressure */
+        if (bplib_serviceflow_parent_is_congested(flow))
+        {
+            bplib_mpool_flow_enable(&flow->ingress, 0);
+        }
+        else
+        {
+            bplib_mpool_flow_enable(&flow->ingress, BP_MPOOL_MAX_SUBQ_DEPTH);
+        }
         bplib_mpool_flow_enable(&flow->egress, BP_MPOOL_MAX_SUBQ_DEPTH);
     }
     else if (event->event_type == bplib_mpool_flow_event_down)
@@ -557,6 +936,38 @@ int bplib_dataservice_base_construct(void *arg, bplib_mpool_block_t *blk)
     }
 
     bplib_rbt_init_root(&base_intf->service_index);
+    bplib_reassembly_table_init(blk, &base_intf->reassembly);
+    return BP_SUCCESS;
+}
+
+int bplib_dataservice_socket_destruct(void *arg, bplib_mpool_block_t *sblk)
+{
+    bplib_socket_info_t *sock;
+
+    sock = bplib_mpool_generic_data_cast(sblk, BPLIB_BLOCKTYPE_SERVICE_SOCKET);
+    if (sock == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    if (sock->pri_template_blk != NULL)
+    {
+        bplib_mpool_recycle_block(sock->pri_template_blk);
+        sock->pri_template_blk = NULL;
+    }
+
+    if (sock->tx_scratch != NULL)
+    {
+        bplib_os_free(sock->tx_scratch);
+        sock->tx_scratch = NULL;
+    }
+
+    if (sock->rx_scratch != NULL)
+    {
+        bplib_os_free(sock->rx_scratch);
+        sock->rx_scratch = NULL;
+    }
+
     return BP_SUCCESS;
 }
 
@@ -575,6 +986,11 @@ void bplib_dataservice_init(bplib_mpool_t *pool)
         .destruct  = NULL,
     };
 
+    const bplib_mpool_blocktype_api_t svc_socket_api = (bplib_mpool_blocktype_api_t) {
+        .construct = NULL,
+        .destruct  = bplib_dataservice_socket_destruct,
+    };
+
     const bplib_mpool_blocktype_api_t svc_block_api = (bplib_mpool_blocktype_api_t) {
         .construct = NULL,
         .destruct  = bplib_dataservice_block_recycle,
@@ -583,8 +999,10 @@ void bplib_dataservice_init(bplib_mpool_t *pool)
     bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_SERVICE_BASE, &svc_base_api,
                                    sizeof(bplib_route_serviceintf_info_t));
     bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_SERVICE_ENDPOINT, NULL, sizeof(bplib_service_endpt_t));
-    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_SERVICE_SOCKET, NULL, sizeof(bplib_socket_info_t));
+    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_SERVICE_SOCKET, &svc_socket_api, sizeof(bplib_socket_info_t));
     bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_SERVICE_BLOCK, &svc_block_api, 0);
+
+    bplib_reassembly_init(pool);
 }
 
 bp_handle_t bplib_dataservice_add_base_intf(bplib_routetbl_t *rtbl, bp_ipn_t node_number)
@@ -846,6 +1264,43 @@ int bplib_connect_socket(bp_socket_t *desc, const bp_ipn_addr_t *destination_ipn
     return 0;
 }
 
+int bplib_socket_set_compression(bp_socket_t *desc, const bplib_compression_api_t *api)
+{
+    bplib_socket_info_t *sock;
+    bplib_mpool_ref_t    sock_ref;
+
+    sock_ref = (bplib_mpool_ref_t)desc;
+
+    sock = bplib_mpool_generic_data_cast(bplib_mpool_dereference(sock_ref), BPLIB_BLOCKTYPE_SERVICE_SOCKET);
+    if (sock == NULL)
+    {
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): bad descriptor\n", __func__);
+        return BP_ERROR;
+    }
+
+    if (api == NULL)
+    {
+        memset(&sock->compression, 0, sizeof(sock->compression));
+    }
+    else if (api->compress == NULL || api->decompress == NULL)
+    {
+        bplog(NULL, BP_FLAG_API_ERROR, "%s(): incomplete compression codec\n", __func__);
+        return BP_ERROR;
+    }
+    else if (bplib_serviceflow_get_scratch(&sock->tx_scratch) == NULL ||
+             bplib_serviceflow_get_scratch(&sock->rx_scratch) == NULL)
+    {
+        /* allocated here so that sending and receiving never have to */
+        return BP_ERROR;
+    }
+    else
+    {
+        sock->compression = *api;
+    }
+
+    return BP_SUCCESS;
+}
+
 void bplib_close_socket(bp_socket_t *desc)
 {
     bplib_socket_info_t *sock;
@@ -0,0 +1,529 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include "bplib.h"
+#include "bplib_os.h"
+#include "v7.h"
+#include "v7_mpool.h"
+#include "v7_mpool_bblocks.h"
+#include "v7_mpool_ref.h"
+#include "v7_codec.h"
+#include "v7_rbtree.h"
+#include "crc.h"
+#include "bplib_reassembly.h"
+
+/******************************************************************************
+ TYPEDEFS
+ ******************************************************************************/
+
+#define BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY    0x5a0e7c13
+#define BPLIB_BLOCKTYPE_REASSEMBLY_FRAGMENT 0x2d91f4a8
+
+typedef struct bplib_reassembly_entry
+{
+    bplib_rbt_link_t               rbt_link; /* for storage in RB tree, must be first */
+    struct bplib_reassembly_entry *next_same_key; /* other bundles whose ID hashes to the same key */
+    bplib_mpool_block_t           *self_ptr;
+    bplib_reassembly_table_t      *parent;
+    bplib_mpool_block_t            fragment_list; /* refs to the fragments, in order of offset */
+    bp_val_t                       key;
+    bp_ipn_addr_t                  source;
+    bp_creation_timestamp_t        timestamp;
+    bp_adu_length_t                total_adu_length;
+    size_t                         held_bytes;
+    uint64_t                       expire_time;
+
+} bplib_reassembly_entry_t;
+
+/******************************************************************************
+ LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/*
+ * Gets the key for the bundle ID (source, creation timestamp) in the index.  A CRC is used as the hash,
+ * so different bundles can get the same key.  The entry in the index is then the head of a chain of
+ * the entries for all of them, see bplib_reassembly_get_entry().
+ */
+static bp_val_t bplib_reassembly_get_key(const bp_ipn_addr_t *source, const bp_creation_timestamp_t *timestamp)
+{
+    bp_crcval_t hash;
+
+    hash = bplib_crc_initial_value(&BPLIB_CRC32_CASTAGNOLI);
+    hash = bplib_crc_update(&BPLIB_CRC32_CASTAGNOLI, hash, source, sizeof(*source));
+    hash = bplib_crc_update(&BPLIB_CRC32_CASTAGNOLI, hash, timestamp, sizeof(*timestamp));
+
+    return bplib_crc_finalize(&BPLIB_CRC32_CASTAGNOLI, hash);
+}
+
+static void bplib_reassembly_drop_entry(bplib_reassembly_table_t *table, bplib_reassembly_entry_t *entry)
+{
+    bplib_reassembly_entry_t *prev;
+
+    /* because rbt_link is first element */
+    prev = (bplib_reassembly_entry_t *)bplib_rbt_search(entry->key, &table->index);
+    if (prev == entry)
+    {
+        /* the next entry in the chain, if any, takes its place in the index */
+        bplib_rbt_extract_node(&table->index, &entry->rbt_link);
+        if (entry->next_same_key != NULL)
+        {
+            bplib_rbt_insert_value(entry->key, &table->index, &entry->next_same_key->rbt_link);
+        }
+    }
+    else
+    {
+        while (prev != NULL && prev->next_same_key != entry)
+        {
+            prev = prev->next_same_key;
+        }
+
+        if (prev != NULL)
+        {
+            prev->next_same_key = entry->next_same_key;
+        }
+    }
+
+    entry->next_same_key = NULL;
+    table->held_bytes -= entry->held_bytes;
+    entry->held_bytes = 0;
+
+    /* this also takes it off the age list, and the fragments are released by the destructor */
+    bplib_mpool_recycle_block(entry->self_ptr);
+}
+
+/*
+ * Drops the oldest bundles until there is room for the given number of bytes
+ */
+static void bplib_reassembly_make_room(bplib_reassembly_table_t *table, size_t needed_bytes)
+{
+    bplib_reassembly_entry_t *entry;
+
+    while ((table->held_bytes + needed_bytes) > BPLIB_REASSEMBLY_BYTE_BUDGET)
+    {
+        entry = bplib_mpool_generic_data_cast(bplib_mpool_get_next_block(&table->age_list),
+                                              BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY);
+        if (entry == NULL)
+        {
+            break;
+        }
+
+        bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): dropping incomplete bundle from ipn:%lu.%lu\n", __func__,
+              (unsigned long)entry->source.node_number, (unsigned long)entry->source.service_number);
+        bplib_reassembly_drop_entry(table, entry);
+    }
+}
+
+static bplib_reassembly_entry_t *bplib_reassembly_get_entry(bplib_reassembly_table_t *table, bplib_mpool_t *pool,
+                                                            const bp_primary_block_t *pri, uint64_t current_time)
+{
+    bplib_reassembly_entry_t *head;
+    bplib_reassembly_entry_t *entry;
+    bplib_mpool_block_t      *eblk;
+    bp_ipn_addr_t             source;
+    bp_val_t                  key;
+
+    v7_get_eid(&source, &pri->sourceEID);
+    key = bplib_reassembly_get_key(&source, &pri->creationTimeStamp);
+
+    /* because rbt_link is first element */
+    head = (bplib_reassembly_entry_t *)bplib_rbt_search(key, &table->index);
+    for (entry = head; entry != NULL; entry = entry->next_same_key)
+    {
+        if (entry->source.node_number == source.node_number &&
+            entry->source.service_number == source.service_number &&
+            entry->timestamp.time == pri->creationTimeStamp.time &&
+            entry->timestamp.sequence_num == pri->creationTimeStamp.sequence_num)
+        {
+            if (entry->total_adu_length != pri->totalADUlength)
+            {
+                bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): fragments of bundle from ipn:%lu.%lu disagree on the length\n",
+                      __func__, (unsigned long)source.node_number, (unsigned long)source.service_number);
+                return NULL;
+            }
+
+            return entry;
+        }
+    }
+
+    eblk  = bplib_mpool_generic_data_alloc(pool, BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY, table);
+    entry = bplib_mpool_generic_data_cast(eblk, BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY);
+    if (entry == NULL)
+    {
+        bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): cannot track bundle from ipn:%lu.%lu\n", __func__,
+              (unsigned long)source.node_number, (unsigned long)source.service_number);
+        return NULL;
+    }
+
+    entry->self_ptr         = eblk;
+    entry->key              = key;
+    entry->source           = source;
+    entry->timestamp        = pri->creationTimeStamp;
+    entry->total_adu_length = pri->totalADUlength;
+    entry->expire_time      = current_time + BPLIB_REASSEMBLY_TIMEOUT_MS;
+
+    if (head != NULL)
+    {
+        /* a different bundle with the same key is already in the index, so chain this one after it */
+        entry->next_same_key = head->next_same_key;
+        head->next_same_key  = entry;
+    }
+    else
+    {
+        bplib_rbt_insert_value(key, &table->index, &entry->rbt_link);
+    }
+    bplib_mpool_insert_before(&table->age_list, eblk);
+
+    return entry;
+}
+
+/*
+ * Puts the fragment in the list in order of offset, and checks if the list now covers the whole
+ * payload.  Returns true if the bundle is complete.
+ */
+static bool bplib_reassembly_add_fragment(bplib_reassembly_entry_t *entry, bplib_mpool_block_t *rblk)
+{
+    bplib_mpool_block_t          *pos;
+    bplib_mpool_bblock_primary_t *cpb;
+    size_t                        frag_offset;
+    size_t                        covered;
+
+    frag_offset = bplib_mpool_bblock_primary_cast(rblk)->pri_logical_data.fragmentOffset;
+
+    /* fragments normally arrive in order, so search from the end */
+    pos = &entry->fragment_list;
+    while (true)
+    {
+        pos = bplib_mpool_get_prev_block(pos);
+        cpb = bplib_mpool_bblock_primary_cast(pos);
+        if (cpb == NULL || cpb->pri_logical_data.fragmentOffset <= frag_offset)
+        {
+            break;
+        }
+    }
+    bplib_mpool_insert_after(pos, rblk);
+
+    /* the payload is complete if the fragments (which can overlap) leave no gap */
+    covered = 0;
+    pos     = &entry->fragment_list;
+    while (covered < entry->total_adu_length)
+    {
+        pos = bplib_mpool_get_next_block(pos);
+        cpb = bplib_mpool_bblock_primary_cast(pos);
+        if (cpb == NULL || cpb->pri_logical_data.fragmentOffset > covered)
+        {
+            break;
+        }
+
+        frag_offset = cpb->pri_logical_data.fragmentOffset +
+                      bplib_mpool_bblock_canonical_get_content_length(bplib_mpool_bblock_canonical_cast(
+                          bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_payloadBlock)));
+        if (frag_offset > covered)
+        {
+            covered = frag_offset;
+        }
+    }
+
+    return (covered >= entry->total_adu_length);
+}
+
+/*
+ * Creates the reassembled bundle.  Its primary block is that of the first fragment, without the
+ * fragment fields.  The bundle is only for local delivery, so the extension blocks are not carried
+ * over, just the payload - and the compression block, if there is one, as the payload cannot be
+ * used without it.
+ */
+static bplib_mpool_ref_t bplib_reassembly_build_bundle(bplib_reassembly_entry_t *entry)
+{
+    bplib_mpool_t                  *pool;
+    bplib_mpool_block_t            *pblk;
+    bplib_mpool_block_t            *cblk;
+    bplib_mpool_bblock_primary_t   *first;
+    bplib_mpool_bblock_primary_t   *pri_block;
+    bplib_mpool_bblock_canonical_t *first_pay;
+    bplib_mpool_bblock_canonical_t *first_comp;
+    bplib_mpool_bblock_canonical_t *ccb_pay;
+    bplib_mpool_bblock_canonical_t *ccb_comp;
+    bp_primary_block_t             *pri;
+    bplib_mpool_ref_t               refptr;
+
+    pool   = bplib_mpool_get_parent_pool_from_link(&entry->fragment_list);
+    cblk   = NULL;
+    pblk   = NULL;
+    refptr = NULL;
+
+    do
+    {
+        first      = bplib_mpool_bblock_primary_cast(bplib_mpool_get_next_block(&entry->fragment_list));
+        first_pay  = bplib_mpool_bblock_canonical_cast(
+            bplib_mpool_bblock_primary_locate_canonical(first, bp_blocktype_payloadBlock));
+        first_comp = bplib_mpool_bblock_canonical_cast(
+            bplib_mpool_bblock_primary_locate_canonical(first, bp_blocktype_payloadCompressionBlock));
+
+        pblk      = bplib_mpool_bblock_primary_alloc(pool);
+        pri_block = bplib_mpool_bblock_primary_cast(pblk);
+        if (pri_block == NULL)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed to allocate primary block\n");
+            break;
+        }
+
+        pri                               = bplib_mpool_bblock_primary_get_logical(pri_block);
+        *pri                              = first->pri_logical_data;
+        pri->controlFlags.isFragment      = false;
+        pri->controlFlags.mustNotFragment = true;
+        pri->fragmentOffset               = 0;
+        pri->totalADUlength               = 0;
+
+        pri_block->delivery_data.delivery_policy = first->delivery_data.delivery_policy;
+        pri_block->delivery_data.ingress_intf_id = first->delivery_data.ingress_intf_id;
+        pri_block->delivery_data.ingress_time    = first->delivery_data.ingress_time;
+        pri_block->delivery_data.storage_intf_id = first->delivery_data.storage_intf_id;
+
+        if (v7_block_encode_pri(pri_block) < 0)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed encoding pri block\n");
+            break;
+        }
+
+        if (first_comp != NULL)
+        {
+            cblk     = bplib_mpool_bblock_canonical_alloc(pool);
+            ccb_comp = bplib_mpool_bblock_canonical_cast(cblk);
+            if (ccb_comp == NULL)
+            {
+                bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed to allocate compression block\n");
+                break;
+            }
+
+            *bplib_mpool_bblock_canonical_get_logical(ccb_comp) = *bplib_mpool_bblock_canonical_get_logical(first_comp);
+
+            if (v7_block_encode_canonical(ccb_comp) < 0)
+            {
+                bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed encoding compression block\n");
+                break;
+            }
+
+            bplib_mpool_bblock_primary_append(pri_block, cblk);
+            cblk = NULL;
+        }
+
+        cblk    = bplib_mpool_bblock_canonical_alloc(pool);
+        ccb_pay = bplib_mpool_bblock_canonical_cast(cblk);
+        if (ccb_pay == NULL)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed to allocate payload block\n");
+            break;
+        }
+
+        bplib_mpool_bblock_canonical_get_logical(ccb_pay)->canonical_block =
+            bplib_mpool_bblock_canonical_get_logical(first_pay)->canonical_block;
+
+        if (v7_block_encode_pay_from_fragments(ccb_pay, &entry->fragment_list, entry->total_adu_length) < 0)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "Failed encoding pay block\n");
+            break;
+        }
+
+        bplib_mpool_bblock_primary_append(pri_block, cblk);
+        cblk = NULL; /* do not need now that it is stored */
+
+        refptr = bplib_mpool_ref_create(pblk);
+        if (refptr == NULL)
+        {
+            /* not expected... */
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "Cannot convert bundle to ref\n");
+            break;
+        }
+
+        pblk = NULL; /* do not use original anymore */
+    }
+    while (false);
+
+    /* clean up, if anything did not work, recycle the blocks now */
+    if (cblk != NULL)
+    {
+        bplib_mpool_recycle_block(cblk);
+    }
+
+    if (pblk != NULL)
+    {
+        bplib_mpool_recycle_block(pblk);
+    }
+
+    return refptr;
+}
+
+int bplib_reassembly_construct_entry(void *arg, bplib_mpool_block_t *eblk)
+{
+    bplib_reassembly_entry_t *entry;
+
+    entry = bplib_mpool_generic_data_cast(eblk, BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY);
+    if (entry == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    entry->parent        = arg;
+    entry->next_same_key = NULL;
+    bplib_mpool_init_list_head(eblk, &entry->fragment_list);
+
+    return BP_SUCCESS;
+}
+
+int bplib_reassembly_destruct_entry(void *arg, bplib_mpool_block_t *eblk)
+{
+    bplib_reassembly_entry_t *entry;
+
+    entry = bplib_mpool_generic_data_cast(eblk, BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY);
+    if (entry == NULL)
+    {
+        return BP_ERROR;
+    }
+
+    /* this releases the refs to the fragments */
+    if (bplib_mpool_is_nonempty_list_head(&entry->fragment_list))
+    {
+        bplib_mpool_recycle_all_blocks_in_list(NULL, &entry->fragment_list);
+    }
+
+    return BP_SUCCESS;
+}
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+void bplib_reassembly_init(bplib_mpool_t *pool)
+{
+    const bplib_mpool_blocktype_api_t entry_api = (bplib_mpool_blocktype_api_t) {
+        .construct = bplib_reassembly_construct_entry,
+        .destruct  = bplib_reassembly_destruct_entry,
+    };
+
+    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY, &entry_api,
+                                   sizeof(bplib_reassembly_entry_t));
+    bplib_mpool_register_blocktype(pool, BPLIB_BLOCKTYPE_REASSEMBLY_FRAGMENT, NULL, 0);
+}
+
+void bplib_reassembly_table_init(bplib_mpool_block_t *base_block, bplib_reassembly_table_t *table)
+{
+    bplib_rbt_init_root(&table->index);
+    bplib_mpool_init_list_head(base_block, &table->age_list);
+    table->held_bytes = 0;
+}
+
+bplib_mpool_ref_t bplib_reassembly_collect(bplib_reassembly_table_t *table, bplib_mpool_block_t *pblk,
+                                           uint64_t current_time)
+{
+    bplib_mpool_bblock_primary_t   *cpb;
+    bplib_mpool_bblock_canonical_t *pay;
+    bplib_reassembly_entry_t       *entry;
+    bplib_mpool_block_t            *rblk;
+    bplib_mpool_ref_t               refptr;
+    const bp_primary_block_t       *pri;
+    size_t                          frag_size;
+
+    rblk   = NULL;
+    entry  = NULL;
+    refptr = bplib_mpool_ref_from_block(pblk);
+    cpb    = bplib_mpool_bblock_primary_cast(pblk);
+    if (refptr == NULL || cpb == NULL)
+    {
+        /* fragments are held by reference, anything else is not expected here */
+        bplog(NULL, BP_FLAG_DIAGNOSTIC, "%s(): fragment is not a bundle reference\n", __func__);
+    }
+    else
+    {
+        pri       = bplib_mpool_bblock_primary_get_logical(cpb);
+        pay       = bplib_mpool_bblock_canonical_cast(
+            bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_payloadBlock));
+        frag_size = v7_compute_full_bundle_size(cpb);
+
+        if (pay == NULL || pri->sourceEID.scheme != bp_endpointid_scheme_ipn ||
+            (pri->fragmentOffset + bplib_mpool_bblock_canonical_get_content_length(pay)) > pri->totalADUlength)
+        {
+            bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): fragment is not consistent\n", __func__);
+        }
+        else if (frag_size > BPLIB_REASSEMBLY_BYTE_BUDGET)
+        {
+            bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): fragment exceeds the reassembly budget\n", __func__);
+        }
+        else
+        {
+            bplib_reassembly_make_room(table, frag_size);
+
+            entry = bplib_reassembly_get_entry(table, bplib_mpool_get_parent_pool_from_link(pblk), pri, current_time);
+            if (entry != NULL)
+            {
+                rblk = bplib_mpool_ref_make_block(refptr, BPLIB_BLOCKTYPE_REASSEMBLY_FRAGMENT, NULL);
+            }
+
+            if (entry != NULL && rblk == NULL)
+            {
+                bplog(NULL, BP_FLAG_OUT_OF_MEMORY, "%s(): cannot hold fragment\n", __func__);
+            }
+            else if (entry != NULL)
+            {
+                entry->held_bytes += frag_size;
+                table->held_bytes += frag_size;
+
+                if (bplib_reassembly_add_fragment(entry, rblk))
+                {
+                    /* The bundle is complete, the fragments are no longer needed after this */
+                    bplib_mpool_ref_release(refptr);
+                    refptr = bplib_reassembly_build_bundle(entry);
+                    bplib_reassembly_drop_entry(table, entry);
+                    bplib_mpool_recycle_block(pblk);
+                    return refptr;
+                }
+            }
+        }
+    }
+
+    /* the fragment is either held by the entry now, or dropped */
+    bplib_mpool_ref_release(refptr);
+    bplib_mpool_recycle_block(pblk);
+
+    return NULL;
+}
+
+void bplib_reassembly_expire(bplib_reassembly_table_t *table, uint64_t current_time)
+{
+    bplib_reassembly_entry_t *entry;
+
+    /* the entries are in the order they were created, so all those that expired are at the front */
+    while (true)
+    {
+        entry = bplib_mpool_generic_data_cast(bplib_mpool_get_next_block(&table->age_list),
+                                              BPLIB_BLOCKTYPE_REASSEMBLY_ENTRY);
+        if (entry == NULL || entry->expire_time > current_time)
+        {
+            break;
+        }
+
+        bplog(NULL, BP_FLAG_INCOMPLETE, "%s(): reassembly of bundle from ipn:%lu.%lu timed out\n", __func__,
+              (unsigned long)entry->source.node_number, (unsigned long)entry->source.service_number);
+        bplib_reassembly_drop_entry(table, entry);
+    }
+}
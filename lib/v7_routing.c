@@ -46,6 +46,7 @@ typedef struct bplib_routeentry
     bp_ipn_t    dest;
     bp_ipn_t    mask;
     bp_handle_t intf_id;
+    bool        is_avail; /**< whether intf_id was available when last checked */
 } bplib_routeentry_t;
 
 struct bplib_routetbl
@@ -567,9 +568,10 @@ int bplib_route_add(bplib_routetbl_t *tbl, bp_ipn_t dest, bp_ipn_t mask, bp_hand
         memmove(&rp[1], &rp[0], sizeof(*rp) * (tbl->registered_routes - insert_pos));
     }
 
-    rp->dest    = dest;
-    rp->mask    = mask;
-    rp->intf_id = intf_id;
+    rp->dest     = dest;
+    rp->mask     = mask;
+    rp->intf_id  = intf_id;
+    rp->is_avail = false;
 
     ++tbl->registered_routes;
 
@@ -698,6 +700,56 @@ void bplib_route_do_timed_poll(bplib_routetbl_t *tbl)
     bplib_os_unlock(tbl->activity_lock);
 }
 
+void bplib_route_notify_route_up(bplib_routetbl_t *tbl, bp_ipn_t dest, bp_ipn_t mask)
+{
+    bplib_mpool_flow_generic_event_t event;
+    bplib_mpool_list_iter_t          iter;
+    bplib_mpool_flow_t              *flow;
+    int                              status;
+
+    event.route_state.event_type = bplib_mpool_flow_event_route_up;
+    event.route_state.dest       = dest;
+    event.route_state.mask       = mask;
+
+    /* the same lock ordering applies here as in bplib_route_do_timed_poll() - the handlers
+     * may take the pool lock while the tbl activity lock is held, never the other way around */
+    bplib_os_lock(tbl->activity_lock);
+    status = bplib_mpool_list_iter_goto_first(&tbl->flow_list, &iter);
+    while (status == BP_SUCCESS)
+    {
+        flow = bplib_mpool_flow_cast(iter.position);
+        if (flow != NULL && flow->statechange_job.event_handler != NULL)
+        {
+            flow->statechange_job.event_handler(&event, iter.position);
+        }
+        status = bplib_mpool_list_iter_forward(&iter);
+    }
+    bplib_os_unlock(tbl->activity_lock);
+}
+
+void bplib_route_check_route_state(bplib_routetbl_t *tbl)
+{
+    uint32_t                  pos;
+    bplib_routeentry_t       *rp;
+    const bplib_mpool_flow_t *ifp;
+    bool                      is_avail;
+
+    for (pos = 0; pos < tbl->registered_routes; ++pos)
+    {
+        rp  = &tbl->route_tbl[pos];
+        ifp = bplip_route_lookup_intf_const(tbl, rp->intf_id);
+
+        is_avail =
+            (ifp != NULL && (ifp->current_state_flags & BPLIB_INTF_AVAILABLE_FLAGS) == BPLIB_INTF_AVAILABLE_FLAGS);
+        if (is_avail && !rp->is_avail)
+        {
+            /* this route just became usable, so anything held for it can now be released */
+            bplib_route_notify_route_up(tbl, rp->dest, rp->mask);
+        }
+        rp->is_avail = is_avail;
+    }
+}
+
 void bplib_route_set_maintenance_request(bplib_routetbl_t *tbl)
 {
     tbl->maint_request_flag = true;
@@ -751,6 +803,9 @@ void bplib_route_periodic_maintenance(bplib_routetbl_t *tbl)
     /* now forward any bundles between interfaces, based on active flows */
     bplib_route_process_active_flows(tbl);
 
+    /* let storage intfs know about any routes that came up as a result of the above */
+    bplib_route_check_route_state(tbl);
+
     /* do general pool garbage collection to make sure it was done at least once */
     bplib_mpool_maintain(tbl->pool);
 
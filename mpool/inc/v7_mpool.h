@@ -546,6 +546,20 @@ bplib_mpool_block_t *bplib_mpool_search_list(const bplib_mpool_block_t *list, bp
  */
 void bplib_mpool_maintain(bplib_mpool_t *pool);
 
+/**
+ * @brief Gets the number of blocks that can still be allocated for bundles
+ *
+ * This is the number of free blocks above the threshold where bundle block allocations start
+ * to fail, including blocks that are recycled but not yet garbage-collected.  It allows services
+ * that hold bundles for a long time (e.g. storage) to back off before allocations actually fail.
+ *
+ * @note This is not synchronized with other threads, so the result is only an estimate.
+ *
+ * @param pool
+ * @return uint32_t number of blocks, 0 if bundle allocations would fail now
+ */
+uint32_t bplib_mpool_query_bblock_headroom(bplib_mpool_t *pool);
+
 /**
  * @brief Registers a given block type signature
  *
@@ -38,6 +38,10 @@ typedef struct bplib_mpool_bblock_tracking
 
     /* JPHFIX: this is here for now, but really it belongs on the egress CLA intf based on its RTT */
     uint64_t local_retx_interval;
+
+    /* forwarding updates: time up to which the bundle age block is current, and whether the hop count was bumped */
+    uint64_t age_update_time;
+    bool     hop_count_updated;
 } bplib_mpool_bblock_tracking_t;
 
 struct bplib_mpool_bblock_primary
@@ -46,6 +50,7 @@ struct bplib_mpool_bblock_primary
     bplib_mpool_block_t           chunk_list;
     size_t                        block_encode_size_cache;
     size_t                        bundle_encode_size_cache;
+    bool                          crc_verify_deferred;
     bp_primary_block_t            pri_logical_data;
     bplib_mpool_bblock_tracking_t delivery_data;
 };
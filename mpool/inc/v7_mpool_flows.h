@@ -26,10 +26,11 @@
 #include "v7_mpool.h"
 #include "v7_mpool_job.h"
 
-#define BPLIB_MPOOL_FLOW_FLAGS_ADMIN_UP 0x01
-#define BPLIB_MPOOL_FLOW_FLAGS_OPER_UP  0x02
-#define BPLIB_MPOOL_FLOW_FLAGS_STORAGE  0x04
-#define BPLIB_MPOOL_FLOW_FLAGS_POLL     0x10
+#define BPLIB_MPOOL_FLOW_FLAGS_ADMIN_UP  0x01
+#define BPLIB_MPOOL_FLOW_FLAGS_OPER_UP   0x02
+#define BPLIB_MPOOL_FLOW_FLAGS_STORAGE   0x04
+#define BPLIB_MPOOL_FLOW_FLAGS_CONGESTED 0x08
+#define BPLIB_MPOOL_FLOW_FLAGS_POLL      0x10
 
 /**
  * @brief Upper limit to how deep a single queue may ever be
@@ -55,6 +56,9 @@ typedef enum
     bplib_mpool_flow_event_poll,
     bplib_mpool_flow_event_up,
     bplib_mpool_flow_event_down,
+    bplib_mpool_flow_event_route_up,
+    bplib_mpool_flow_event_congested,
+    bplib_mpool_flow_event_uncongested,
     bplib_mpool_flow_event_max
 
 } bplib_mpool_flow_event_t;
@@ -76,6 +80,7 @@ typedef union bplib_mpool_flow_generic_event
 {
     bplib_mpool_flow_event_t             event_type;
     bplib_mpool_flow_statechange_event_t intf_state;
+    bplib_route_state_event_t            route_state;
 } bplib_mpool_flow_generic_event_t;
 
 struct bplib_mpool_subq_base
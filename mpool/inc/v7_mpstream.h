@@ -51,6 +51,13 @@ typedef struct bplib_mpool_stream
 void   bplib_mpool_start_stream_init(bplib_mpool_stream_t *mps, bplib_mpool_t *pool, bplib_mpool_stream_dir_t dir,
                                      bp_crctype_t crctype);
 size_t bplib_mpool_stream_write(bplib_mpool_stream_t *mps, const void *data, size_t size);
+
+/*
+ * Writes data without digesting it into the stream CRC.  This is for data with a known CRC (e.g. cached
+ * from when it was first written); the caller combines that into the intermediate CRC, via
+ * bplib_crc_combine() and bplib_mpool_stream_set_intermediate_crc().
+ */
+size_t bplib_mpool_stream_write_undigested(bplib_mpool_stream_t *mps, const void *data, size_t size);
 size_t bplib_mpool_stream_read(bplib_mpool_stream_t *mps, void *data, size_t size);
 size_t bplib_mpool_stream_seek(bplib_mpool_stream_t *mps, size_t position);
 void   bplib_mpool_stream_attach(bplib_mpool_stream_t *mps, bplib_mpool_block_t *head);
@@ -62,6 +69,10 @@ static inline bp_crcval_t bplib_mpool_stream_get_intermediate_crc(const bplib_mp
 {
     return mps->crcval;
 }
+static inline void bplib_mpool_stream_set_intermediate_crc(bplib_mpool_stream_t *mps, bp_crcval_t crcval)
+{
+    mps->crcval = crcval;
+}
 static inline size_t bplib_mpool_stream_tell(const bplib_mpool_stream_t *mps)
 {
     return mps->stream_position;
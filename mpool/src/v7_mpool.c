@@ -1001,6 +1001,29 @@ void bplib_mpool_maintain(bplib_mpool_t *pool)
     }
 }
 
+/*----------------------------------------------------------------
+ *
+ * Function: bplib_mpool_query_bblock_headroom
+ *
+ *-----------------------------------------------------------------*/
+uint32_t bplib_mpool_query_bblock_headroom(bplib_mpool_t *pool)
+{
+    bplib_mpool_block_admin_content_t *admin;
+    uint32_t                           avail_count;
+
+    /* as with bplib_mpool_maintain(), this is done unlocked - the result is only an estimate anyway */
+    admin = bplib_mpool_get_admin(pool);
+
+    /* blocks awaiting garbage collection will be free again after the next maintenance cycle */
+    avail_count = bplib_mpool_subq_get_depth(&admin->free_blocks) + bplib_mpool_subq_get_depth(&admin->recycle_blocks);
+    if (avail_count <= admin->bblock_alloc_threshold)
+    {
+        return 0;
+    }
+
+    return avail_count - admin->bblock_alloc_threshold;
+}
+
 /*----------------------------------------------------------------
  *
  * Function: bplib_mpool_debug_print_list_stats
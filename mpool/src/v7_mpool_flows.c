@@ -91,6 +91,21 @@ static int bplib_mpool_flow_event_handler(void *arg, bplib_mpool_block_t *jblk)
         flow->statechange_job.event_handler(&event, fblk);
     }
 
+    if (changed_flags & BPLIB_MPOOL_FLOW_FLAGS_CONGESTED)
+    {
+        if (flow->current_state_flags & BPLIB_MPOOL_FLOW_FLAGS_CONGESTED)
+        {
+            event.intf_state.event_type = bplib_mpool_flow_event_congested;
+        }
+        else
+        {
+            event.intf_state.event_type = bplib_mpool_flow_event_uncongested;
+        }
+
+        event.intf_state.intf_id = bplib_mpool_get_external_id(fblk);
+        flow->statechange_job.event_handler(&event, fblk);
+    }
+
     if (changed_flags & BPLIB_MPOOL_FLOW_FLAGS_POLL)
     {
         event.event_type = bplib_mpool_flow_event_poll;
@@ -444,6 +459,9 @@ void bplib_mpool_flow_enable(bplib_mpool_subq_workitem_t *subq, uint32_t depth_l
     /* prevents any additional entries in flow queues */
     subq->current_depth_limit = depth_limit;
 
+    /* in case any threads were waiting for the limit to be raised */
+    bplib_mpool_lock_broadcast_signal(lock);
+
     bplib_mpool_lock_release(lock);
 }
 
@@ -58,7 +58,11 @@ void bplib_mpool_start_stream_init(bplib_mpool_stream_t *mps, bplib_mpool_t *poo
     mps->crcval = bplib_crc_initial_value(mps->crc_params);
 }
 
-size_t bplib_mpool_stream_write(bplib_mpool_stream_t *mps, const void *data, size_t size)
+/*
+ * Common implementation of the stream write functions.  The data is digested into the
+ * stream CRC, unless it is already accounted for by the caller (digest is false).
+ */
+static size_t bplib_mpool_stream_write_impl(bplib_mpool_stream_t *mps, const void *data, size_t size, bool digest)
 {
     bplib_mpool_block_t *next_block;
     const uint8_t       *chunk_p;
@@ -99,8 +103,15 @@ size_t bplib_mpool_stream_write(bplib_mpool_stream_t *mps, const void *data, siz
 
         out_p = bplib_mpool_bblock_cbor_cast(mps->last_eblk);
         out_p += mps->curr_pos;
-        memcpy(out_p, chunk_p, chunk_sz);
-        mps->crcval = bplib_crc_update(mps->crc_params, mps->crcval, out_p, chunk_sz);
+        if (digest)
+        {
+            /* copy and digest in one pass, so the data is only read once */
+            mps->crcval = bplib_crc_update_copy(mps->crc_params, mps->crcval, out_p, chunk_p, chunk_sz);
+        }
+        else
+        {
+            memcpy(out_p, chunk_p, chunk_sz);
+        }
 
         mps->curr_pos += chunk_sz;
         bplib_mpool_bblock_cbor_set_size(mps->last_eblk, mps->curr_pos);
@@ -112,6 +123,16 @@ size_t bplib_mpool_stream_write(bplib_mpool_stream_t *mps, const void *data, siz
     return (size - remain_sz);
 }
 
+size_t bplib_mpool_stream_write(bplib_mpool_stream_t *mps, const void *data, size_t size)
+{
+    return bplib_mpool_stream_write_impl(mps, data, size, true);
+}
+
+size_t bplib_mpool_stream_write_undigested(bplib_mpool_stream_t *mps, const void *data, size_t size)
+{
+    return bplib_mpool_stream_write_impl(mps, data, size, false);
+}
+
 size_t bplib_mpool_stream_seek(bplib_mpool_stream_t *mps, size_t target_position)
 {
     bplib_mpool_block_t *next_block;
@@ -276,8 +297,7 @@ size_t bplib_mpool_stream_read(bplib_mpool_stream_t *mps, void *data, size_t siz
         }
 
         in_p += mps->curr_pos;
-        memcpy(chunk_p, in_p, chunk_sz);
-        mps->crcval = bplib_crc_update(mps->crc_params, mps->crcval, in_p, chunk_sz);
+        mps->crcval = bplib_crc_update_copy(mps->crc_params, mps->crcval, chunk_p, in_p, chunk_sz);
 
         mps->curr_pos += chunk_sz;
         mps->stream_position += chunk_sz;
@@ -150,6 +150,21 @@ int bplib_os_log(const char *file, unsigned int line, uint32_t *flags, uint32_t
     }
 }
 
+/*--------------------------------------------------------------------------------------
+ * bplib_os_get_dtntime_ms - returns milliseconds since DTN epoch
+ *-------------------------------------------------------------------------------------*/
+uint64_t bplib_os_get_dtntime_ms(void)
+{
+    CFE_TIME_SysTime_t sys_time = CFE_TIME_GetTime();
+    if (sys_time.Seconds < BP_CFE_SECS_AT_2000)
+    {
+        return 0; /* This is BP-speak for unknown time */
+    }
+
+    return ((uint64_t)(sys_time.Seconds - BP_CFE_SECS_AT_2000) * 1000) +
+           (CFE_TIME_Sub2MicroSecs(sys_time.Subseconds) / 1000);
+}
+
 /*--------------------------------------------------------------------------------------
  * bplib_os_systime - returns seconds
  *-------------------------------------------------------------------------------------*/
@@ -178,6 +193,15 @@ void bplib_os_sleep(int seconds)
     OS_TaskDelay(seconds * 1000);
 }
 
+/*--------------------------------------------------------------------------------------
+ * bplib_os_get_monotonic_us - returns microseconds from an arbitrary start, never steps
+ *-------------------------------------------------------------------------------------*/
+uint64_t bplib_os_get_monotonic_us(void)
+{
+    CFE_TIME_SysTime_t sys_time = CFE_TIME_GetMET();
+    return ((uint64_t)sys_time.Seconds * 1000000) + CFE_TIME_Sub2MicroSecs(sys_time.Subseconds);
+}
+
 /*--------------------------------------------------------------------------------------
  * bplib_os_random -
  *-------------------------------------------------------------------------------------*/
@@ -220,6 +244,22 @@ void bplib_os_unlock(bp_handle_t h)
     (void)h;
 }
 
+/*--------------------------------------------------------------------------------------
+ * bplib_os_broadcast_signal_and_unlock -
+ *-------------------------------------------------------------------------------------*/
+void bplib_os_broadcast_signal_and_unlock(bp_handle_t h)
+{
+    (void)h;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_os_broadcast_signal -
+ *-------------------------------------------------------------------------------------*/
+void bplib_os_broadcast_signal(bp_handle_t h)
+{
+    (void)h;
+}
+
 /*--------------------------------------------------------------------------------------
  * bplib_os_signal -
  *-------------------------------------------------------------------------------------*/
@@ -238,6 +278,53 @@ int bplib_os_waiton(bp_handle_t h, int timeout_ms)
     return BP_TIMEOUT;
 }
 
+/*--------------------------------------------------------------------------------------
+ * bplib_os_wait_until_ms - nothing else can signal without threads, so this only
+ *  delays until the given time (if not infinite) and then times out
+ *-------------------------------------------------------------------------------------*/
+int bplib_os_wait_until_ms(bp_handle_t h, uint64_t abs_dtntime_ms)
+{
+    uint64_t now_ms;
+    uint64_t delay_ms;
+
+    (void)h;
+
+    if (abs_dtntime_ms != BP_DTNTIME_INFINITE)
+    {
+        now_ms = bplib_os_get_dtntime_ms();
+        if (abs_dtntime_ms > now_ms)
+        {
+            delay_ms = abs_dtntime_ms - now_ms;
+            if (delay_ms > UINT32_MAX)
+            {
+                delay_ms = UINT32_MAX;
+            }
+            OS_TaskDelay((uint32_t)delay_ms);
+        }
+    }
+
+    return BP_TIMEOUT;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_os_createthread - threads not supported, callers run synchronously
+ *-------------------------------------------------------------------------------------*/
+bp_handle_t bplib_os_createthread(bplib_os_thread_func_t func, void *arg)
+{
+    (void)func;
+    (void)arg;
+
+    return BP_INVALID_HANDLE;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_os_jointhread -
+ *-------------------------------------------------------------------------------------*/
+void bplib_os_jointhread(bp_handle_t h)
+{
+    (void)h;
+}
+
 /*--------------------------------------------------------------------------------------
  * bplib_os_format -
  *-------------------------------------------------------------------------------------*/
@@ -337,3 +424,33 @@ size_t bplib_os_memhigh(void)
 {
     return highest_memory_allocated;
 }
+
+/*----------------------------------------------------------------------------
+ * bplib_os_mapfile - file mapping not supported
+ *----------------------------------------------------------------------------*/
+void *bplib_os_mapfile(const char *filename, size_t *size)
+{
+    (void)filename;
+    (void)size;
+
+    return NULL;
+}
+
+/*----------------------------------------------------------------------------
+ * bplib_os_unmapfile
+ *----------------------------------------------------------------------------*/
+void bplib_os_unmapfile(void *addr, size_t size)
+{
+    (void)addr;
+    (void)size;
+}
+
+/*----------------------------------------------------------------------------
+ * bplib_os_advisefile
+ *----------------------------------------------------------------------------*/
+void bplib_os_advisefile(void *addr, size_t size, int advice)
+{
+    (void)addr;
+    (void)size;
+    (void)advice;
+}
@@ -30,6 +30,9 @@
 #include <pthread.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "bplib.h"
 #include "bplib_os.h"
@@ -41,6 +44,7 @@
 #define UNIX_SECS_AT_2000     946684800
 #define BP_MAX_LOG_ENTRY_SIZE 256
 #define BP_MAX_LOCKS          128
+#define BP_MAX_THREADS        64 /* thread handles follow the lock handles */
 
 /******************************************************************************
  TYPEDEFS
@@ -52,12 +56,20 @@ typedef struct
     pthread_mutex_t mutex;
 } bplib_os_lock_t;
 
+typedef struct
+{
+    pthread_t              thread;
+    bplib_os_thread_func_t func;
+    void                  *arg;
+} bplib_os_thread_t;
+
 /******************************************************************************
  FILE DATA
  ******************************************************************************/
 
-static bplib_os_lock_t *locks[BP_MAX_LOCKS] = {0};
-static pthread_mutex_t  lock_of_locks;
+static bplib_os_lock_t   *locks[BP_MAX_LOCKS]     = {0};
+static bplib_os_thread_t *threads[BP_MAX_THREADS] = {0};
+static pthread_mutex_t    lock_of_locks;
 
 static struct timespec prevnow;
 
@@ -259,6 +271,17 @@ void bplib_os_sleep(int seconds)
     sleep(seconds);
 }
 
+/*--------------------------------------------------------------------------------------
+ * bplib_os_get_monotonic_us - returns microseconds from an arbitrary start, never steps
+ *-------------------------------------------------------------------------------------*/
+uint64_t bplib_os_get_monotonic_us(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000) + ((uint64_t)now.tv_nsec / 1000);
+}
+
 /*--------------------------------------------------------------------------------------
  * bplib_os_random -
  *-------------------------------------------------------------------------------------*/
@@ -461,6 +484,82 @@ int bplib_os_wait_until_ms(bp_handle_t h, uint64_t abs_dtntime_ms)
     return BP_SUCCESS;
 }
 
+/*--------------------------------------------------------------------------------------
+ * bplib_os_thread_entry - adapts pthread entry point to bplib thread function
+ *-------------------------------------------------------------------------------------*/
+static void *bplib_os_thread_entry(void *arg)
+{
+    bplib_os_thread_t *thread = (bplib_os_thread_t *)arg;
+
+    thread->func(thread->arg);
+
+    return NULL;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_os_createthread -
+ *-------------------------------------------------------------------------------------*/
+bp_handle_t bplib_os_createthread(bplib_os_thread_func_t func, void *arg)
+{
+    bp_handle_t handle = BP_INVALID_HANDLE;
+
+    pthread_mutex_lock(&lock_of_locks);
+    {
+        int i;
+        for (i = 0; i < BP_MAX_THREADS; i++)
+        {
+            if (threads[i] == NULL)
+            {
+                threads[i] = (bplib_os_thread_t *)bplib_os_calloc(sizeof(bplib_os_thread_t));
+                if (threads[i])
+                {
+                    threads[i]->func = func;
+                    threads[i]->arg  = arg;
+                    if (pthread_create(&threads[i]->thread, NULL, bplib_os_thread_entry, threads[i]) == 0)
+                    {
+                        handle = bp_handle_from_serial(BP_MAX_LOCKS + i, BPLIB_HANDLE_OS_BASE);
+                    }
+                    else
+                    {
+                        bplib_os_free(threads[i]);
+                        threads[i] = NULL;
+                    }
+                }
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&lock_of_locks);
+
+    return handle;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_os_jointhread - waits for thread function to return
+ *-------------------------------------------------------------------------------------*/
+void bplib_os_jointhread(bp_handle_t h)
+{
+    int                handle = bp_handle_to_serial(h, BPLIB_HANDLE_OS_BASE) - BP_MAX_LOCKS;
+    bplib_os_thread_t *thread;
+
+    /* Check Handle (a lock handle, or one that was never valid, falls outside of the thread range) */
+    if (handle < 0 || handle >= BP_MAX_THREADS)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&lock_of_locks);
+    thread          = threads[handle];
+    threads[handle] = NULL;
+    pthread_mutex_unlock(&lock_of_locks);
+
+    if (thread)
+    {
+        pthread_join(thread->thread, NULL);
+        bplib_os_free(thread);
+    }
+}
+
 /*--------------------------------------------------------------------------------------
  * bplib_os_format -
  *-------------------------------------------------------------------------------------*/
@@ -560,3 +659,72 @@ size_t bplib_os_memhigh(void)
 {
     return highest_memory_allocated;
 }
+
+/*----------------------------------------------------------------------------
+ * bplib_os_mapfile - maps a whole file, private copy on write
+ *----------------------------------------------------------------------------*/
+void *bplib_os_mapfile(const char *filename, size_t *size)
+{
+    struct stat st;
+    void       *addr = NULL;
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        addr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to map %s: %s\n", filename, strerror(errno));
+            addr = NULL;
+        }
+        else
+        {
+            *size = st.st_size;
+        }
+    }
+
+    /* Mapping Stays Valid After Close */
+    close(fd);
+
+    return addr;
+}
+
+/*----------------------------------------------------------------------------
+ * bplib_os_unmapfile
+ *----------------------------------------------------------------------------*/
+void bplib_os_unmapfile(void *addr, size_t size)
+{
+    munmap(addr, size);
+}
+
+/*----------------------------------------------------------------------------
+ * bplib_os_advisefile - passes access pattern of a mapped range on to the kernel
+ *
+ *  Dropped pages are only those entirely within the range, since the pages at either
+ *  end may hold the neighboring data.
+ *----------------------------------------------------------------------------*/
+void bplib_os_advisefile(void *addr, size_t size, int advice)
+{
+    uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    uintptr_t start     = (uintptr_t)addr;
+    uintptr_t end       = start + size;
+
+    if (advice == BP_OS_ADVISE_SEQUENTIAL)
+    {
+        madvise((void *)(start & ~(page_size - 1)), end - (start & ~(page_size - 1)), MADV_SEQUENTIAL);
+    }
+    else if (advice == BP_OS_ADVISE_DONTNEED)
+    {
+        start = (start + page_size - 1) & ~(page_size - 1);
+        end   = end & ~(page_size - 1);
+        if (end > start)
+        {
+            madvise((void *)start, end - start, MADV_DONTNEED);
+        }
+    }
+}
@@ -32,13 +32,21 @@
 #define FILE_FLUSH_DEFAULT true
 #define FILE_MAX_FILENAME  256
 #define FILE_DATA_COUNT    256 /* Cannot be changed without changing macros */
+#define FILE_INDEX_SIZE    ((FILE_DATA_COUNT + 1) * sizeof(unsigned long))
+#define FILE_OBJECT_ALIGN  8 /* objects are padded so that a mapped object header is aligned */
 #define FILE_MEM_LOCKED    1
 #define FILE_MEM_AVAIABLE  0
+#define FILE_ID_RETIRED    ULONG_MAX /* mapping of a file replaced by compaction */
 
 /* Dynamically Set Attributes */
 
-#define FILE_DEFAULT_CACHE_SIZE 16384
-#define FILE_DEFAULT_ROOT       ".pfile"
+#define FILE_DEFAULT_CACHE_SIZE     16384
+#define FILE_DEFAULT_ROOT           ".pfile"
+#define FILE_DEFAULT_COMMIT_BYTES   65536
+#define FILE_DEFAULT_COMMIT_LATENCY 100     /* milliseconds */
+#define FILE_DEFAULT_COMPACT_BUDGET 1048576 /* bytes per second */
+#define FILE_COMPACT_PASS_INTERVAL  1000    /* milliseconds from start of one pass over files to the next */
+#define FILE_WRITE_RETRY_INTERVAL   1000    /* milliseconds before a batch that failed to write is tried again */
 
 /* Configurable Options */
 
@@ -46,6 +54,10 @@
 #define FILE_MAX_STORES 60
 #endif
 
+#ifndef FILE_MAX_MAPS
+#define FILE_MAX_MAPS 4 /* per store */
+#endif
+
 /******************************************************************************
  MACROS
  ******************************************************************************/
@@ -53,16 +65,47 @@
 #define GET_DATAID(sid)     (sid - 1)
 #define GET_FILEID(did)     ((did) >> 8)
 #define GET_DATAOFFSET(did) ((uint8_t)((did)&0xFF))
+#define ALIGN_OBJECT(size)  (((size) + FILE_OBJECT_ALIGN - 1) & ~((unsigned long)FILE_OBJECT_ALIGN - 1))
 
 /******************************************************************************
  TYPEDEFS
  ******************************************************************************/
 
+typedef struct
+{
+    uint8_t      *addr;
+    size_t        size;
+    unsigned long file_id;
+    int           refs; /* objects handed out from this mapping */
+} file_map_t;
+
+typedef struct
+{
+    uint8_t      *buffer;
+    unsigned long capacity; /* grows to fit the largest object */
+    unsigned long size;
+    unsigned long end_data_id; /* id after last object in batch, set when batch is committed */
+} file_batch_t;
+
+typedef struct
+{
+    unsigned long *offsets;
+    unsigned long  file_id;
+    bool           valid;
+} file_index_t;
+
+typedef struct
+{
+    unsigned char *object;
+    unsigned long  data_id;
+} file_prefetch_t;
+
 typedef struct
 {
     void         *mem_ptr;
     bool          mem_locked;
     unsigned long mem_data_id;
+    file_map_t   *mem_map; /* NULL when mem_ptr is an allocated copy */
 } data_cache_t;
 
 typedef struct
@@ -71,6 +114,21 @@ typedef struct
     int  free_cnt;
 } free_table_t;
 
+typedef struct
+{
+    bool           active;
+    bool           aborted; /* file was deleted, or failed to copy */
+    unsigned long  file_id;
+    int            next_offset;
+    free_table_t   freed; /* objects relinquished when compaction started */
+    FILE          *src_fd;
+    FILE          *dst_fd;
+    file_index_t   src_index;
+    unsigned long *dst_index;
+    uint8_t       *buffer;
+    unsigned long  capacity;
+} file_compact_t;
+
 typedef struct
 {
     bool        in_use;
@@ -79,17 +137,32 @@ typedef struct
     char       *file_root;
     int         data_count;
 
-    FILE         *write_fd;
-    unsigned long write_data_id;
-    bool          write_error;
+    FILE          *write_fd;
+    unsigned long  write_data_id;
+    bool           write_error;    /* oldest batch not yet written failed, and is retried */
+    unsigned long  write_failures; /* number of failed batch writes, so waiters can see a new one */
+    uint64_t       write_retry;    /* time at which a failed batch is tried again */
+    unsigned long *write_index;    /* offsets of objects in file being written */
+
+    file_batch_t    *commit_batches; /* write-behind buffers, ring of io_depth + 1 */
+    int              commit_fill;    /* batch that enqueue copies objects into */
+    int              commit_pending; /* batches handed to I/O thread, not yet written */
+    unsigned long    commit_data_id; /* id of first object not yet written to file */
+    uint64_t         commit_deadline;
+    unsigned long    commit_bytes;
+    uint64_t         commit_latency;
+    bp_file_commit_t commit_callback;
+    void            *commit_parm;
 
     FILE         *read_fd;
     unsigned long read_data_id;
-    bool          read_error;
+    unsigned long read_fd_data_id; /* id of object read_fd is positioned at */
 
     FILE         *retrieve_fd;
     unsigned long retrieve_data_id;
 
+    file_index_t read_index; /* offsets of objects in a full file, read from its footer */
+
     FILE         *relinquish_fd;
     unsigned long relinquish_data_id;
     free_table_t  relinquish_table;
@@ -97,6 +170,30 @@ typedef struct
     data_cache_t *data_cache;
     int           cache_size;
     bool          flush_on_write;
+
+    bool       map_on_read;
+    file_map_t file_maps[FILE_MAX_MAPS];
+
+    int              io_depth; /* 0 when all file access is on caller's thread */
+    bp_handle_t      io_thread;
+    bool             io_stop;
+    FILE            *prefetch_fd;
+    unsigned long    prefetch_fd_data_id;
+    unsigned long    prefetch_data_id; /* next object to read ahead */
+    file_index_t     prefetch_index;
+    file_prefetch_t *prefetch; /* objects read ahead of dequeue, io_depth of them */
+
+    int            compact_live_percent; /* 0 when compaction is disabled */
+    unsigned long  compact_budget;       /* bytes per second */
+    int64_t        compact_tokens;       /* budget available, negative once overspent */
+    uint64_t       compact_refill_time;
+    uint64_t       compact_resume; /* time budget allows next step */
+    uint64_t       compact_pass_time;
+    bool           compact_wanted; /* objects relinquished since last pass started */
+    bool           compact_scanning;
+    unsigned long  compact_scan_id;
+    unsigned long  compact_first_id; /* files before this are deleted */
+    file_compact_t compact;
 } file_store_t;
 
 /******************************************************************************
@@ -117,25 +214,18 @@ static bp_file_driver_t file_driver = {
 /*--------------------------------------------------------------------------------------
  * open_dat_file -
  *-------------------------------------------------------------------------------------*/
-BP_LOCAL_SCOPE FILE *open_dat_file(int service_id, char *file_root, uint32_t file_id, bool read_only)
+BP_LOCAL_SCOPE FILE *open_dat_file(int service_id, char *file_root, uint32_t file_id, const char *modes)
 {
     FILE *fd;
 
     char filename[FILE_MAX_FILENAME];
     bplib_os_format(filename, FILE_MAX_FILENAME, "%s/%d_%u.dat", file_root, service_id, file_id);
 
-    if (read_only)
-    {
-        fd = file_driver.open(filename, "rb");
-    }
-    else
+    fd = file_driver.open(filename, modes);
+    if (fd == NULL && strcmp(modes, "rb") != 0)
     {
-        fd = file_driver.open(filename, "ab");
-        if (fd == NULL)
-        {
-            bplog(NULL, BP_FLAG_STORE_FAILURE, "failed to open %s data file %s: %s\n",
-                  read_only ? "read only" : "appended", filename, strerror(errno));
-        }
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "failed to open data file %s (%s): %s\n", filename, modes,
+              strerror(errno));
     }
 
     return fd;
@@ -207,117 +297,1221 @@ BP_LOCAL_SCOPE int delete_tbl_file(int service_id, char *file_root, uint32_t fil
     }
 }
 
-/******************************************************************************
- EXPORTED FUNCTIONS
- ******************************************************************************/
-
 /*--------------------------------------------------------------------------------------
- * bplib_store_file_init -
+ * get_deadline - converts a timeout in milliseconds to the time at which a wait gives up
  *-------------------------------------------------------------------------------------*/
-void bplib_store_file_init(bp_file_driver_t *driver)
+BP_LOCAL_SCOPE uint64_t get_deadline(int timeout)
 {
-    if (driver)
-        file_driver = *driver;
+    if (timeout == BP_PEND)
+    {
+        return BP_DTNTIME_INFINITE;
+    }
 
-    memset(file_stores, 0, sizeof(file_stores));
+    return bplib_os_get_dtntime_ms() + (uint64_t)(timeout > 0 ? timeout : 0);
 }
 
 /*--------------------------------------------------------------------------------------
- * bplib_store_file_create -
+ * write_batch - writes a batch of objects to the data file and flushes it
+ *
+ *  The batch starts with object data_id and never holds objects from more than one
+ *  data file.  With an I/O thread, this is called by it without the store lock held;
+ *  nothing else touches the write file, or a batch once it has been handed off.
  *-------------------------------------------------------------------------------------*/
-bp_handle_t bplib_store_file_create(int type, bp_ipn_t node, bp_ipn_t service, bool recover, void *parm)
+BP_LOCAL_SCOPE int write_batch(file_store_t *fs, file_batch_t *batch, unsigned long first_data_id)
 {
-    (void)type;
-    (void)node;
-    (void)service;
-    (void)recover;
+    unsigned long bytes_written = 0;
+    bool          commit_error  = false;
 
-    bp_file_attr_t *attr = (bp_file_attr_t *)parm;
-    bp_handle_t     pending_h;
+    /* Get IDs */
+    unsigned long data_id     = GET_DATAID(first_data_id);
+    unsigned long file_id     = GET_FILEID(data_id);
+    unsigned long data_offset = GET_DATAOFFSET(data_id);
 
-    int s;
-    for (s = 0; s < FILE_MAX_STORES; s++)
+    /* Check Need to Open Write File */
+    if (fs->write_fd == NULL)
     {
-        if (file_stores[s].in_use == false)
+        if (data_offset == 0)
         {
-            pending_h = bp_handle_from_serial(s, BPLIB_HANDLE_FILE_STORE_BASE);
-
-            /* Clear File Store (pointers set to NULL) */
-            memset(&file_stores[s], 0, sizeof(file_stores[s]));
-            file_stores[s].write_fd      = NULL;
-            file_stores[s].read_fd       = NULL;
-            file_stores[s].retrieve_fd   = NULL;
-            file_stores[s].relinquish_fd = NULL;
-
-            /* Set In Use (necessary to be able to destroy later) */
-            file_stores[s].in_use = true;
-
-            /* Initialize Parameters */
-            file_stores[s].service_id         = file_service_id++;
-            file_stores[s].lock               = BP_INVALID_HANDLE;
-            file_stores[s].write_data_id      = 1;
-            file_stores[s].read_data_id       = 1;
-            file_stores[s].retrieve_data_id   = 1;
-            file_stores[s].relinquish_data_id = 1;
+            /* Open New Write File */
+            fs->write_fd = open_dat_file(fs->service_id, fs->file_root, file_id, "wb");
+        }
+        else
+        {
+            /* Reopen Write File After Error
+             *  the index gives where the first object in the batch goes, and
+             *  anything left after it by a failed write is overwritten */
+            fs->write_fd = open_dat_file(fs->service_id, fs->file_root, file_id, "r+b");
+            if (fs->write_fd != NULL)
+            {
+                int seek_status = file_driver.seek(fs->write_fd, fs->write_index[data_offset], SEEK_SET);
+                if (seek_status < 0)
+                {
+                    bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to set write position after error\n",
+                          seek_status);
+                    commit_error = true;
+                }
+            }
+        }
+    }
 
-            /* Setup and Check Lock */
-            file_stores[s].lock = bplib_os_createlock();
-            if (!bp_handle_is_valid(file_stores[s].lock))
+    /* Write and Flush Batch */
+    if (fs->write_fd == NULL)
+    {
+        commit_error = true;
+    }
+    else if (!commit_error)
+    {
+        bytes_written = file_driver.write(batch->buffer, 1, batch->size, fs->write_fd);
+        if (bytes_written != batch->size)
+        {
+            bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to write data to file (%lu ?= %lu)\n", bytes_written,
+                  (unsigned long)batch->size);
+            commit_error = true;
+        }
+        else if ((batch->end_data_id - 1) % FILE_DATA_COUNT == 0)
+        {
+            /* Write Index Footer After Last Object in File */
+            bytes_written = file_driver.write(fs->write_index, 1, FILE_INDEX_SIZE, fs->write_fd);
+            if (bytes_written != FILE_INDEX_SIZE)
             {
-                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed (%d) to create FSS lock\n", file_stores[s].lock);
-                bplib_store_file_destroy(pending_h);
-                break;
+                bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to write index to file (%lu ?= %lu)\n", bytes_written,
+                      (unsigned long)FILE_INDEX_SIZE);
+                commit_error = true;
             }
+        }
 
-            /* Setup Root Path */
-            const char *root_path = FILE_DEFAULT_ROOT;
-            if (attr && attr->root_path)
+        if (!commit_error)
+        {
+            int flush_status = file_driver.flush(fs->write_fd);
+            if (flush_status < 0)
             {
-                root_path = attr->root_path;
+                bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to flush data write\n", flush_status);
+                commit_error = true;
             }
-            int root_path_len = bplib_os_strnlen(root_path, FILE_MAX_FILENAME) + 1;
-            if (root_path_len <= FILE_MAX_FILENAME)
+        }
+    }
+
+    /* Close Write File
+     *  after an error, or when the last object written is the last one in the
+     *  file, which is when its (one based) id is a multiple of the number of
+     *  objects per file */
+    if (fs->write_fd != NULL && (commit_error || (batch->end_data_id - 1) % FILE_DATA_COUNT == 0))
+    {
+        file_driver.close(fs->write_fd);
+        fs->write_fd = NULL;
+    }
+
+    return commit_error ? BP_ERROR : BP_SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------
+ * complete_batch - updates the commit state once a batch has been written
+ *
+ *  If the write failed, the batch is kept and written again later; its objects were
+ *  already accepted by enqueue, and are only reported durable once written.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int complete_batch(bp_handle_t h, file_store_t *fs, file_batch_t *batch, int write_status)
+{
+    /* Check Errors */
+    if (write_status != BP_SUCCESS)
+    {
+        /* Keep Batch to Retry */
+        fs->write_error = true;
+        fs->write_failures++;
+        fs->write_retry = bplib_os_get_dtntime_ms() + FILE_WRITE_RETRY_INTERVAL;
+        bplib_os_broadcast_signal(fs->lock);
+
+        /* Return Failure */
+        return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to commit data\n");
+    }
+
+    /* Set Commit State */
+    fs->write_error    = false;
+    fs->commit_data_id = batch->end_data_id;
+    batch->size        = 0;
+    if (fs->io_depth > 0)
+    {
+        fs->commit_pending--;
+    }
+
+    /* Report Durable Objects */
+    if (fs->commit_callback)
+    {
+        fs->commit_callback(fs->commit_parm, h, (bp_sid_t)(batch->end_data_id - 1));
+    }
+
+    bplib_os_broadcast_signal(fs->lock);
+
+    return BP_SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------
+ * commit_objects - commits the write-behind buffer being filled
+ *
+ *  Without an I/O thread the buffer is written before this returns.  Otherwise it is
+ *  handed to the I/O thread, once fewer than io_depth buffers are waiting on it.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int commit_objects(bp_handle_t h, file_store_t *fs, uint64_t deadline)
+{
+    unsigned long write_failures = fs->write_failures;
+
+    /* Wait for I/O Thread to Take a Buffer */
+    while (fs->io_depth > 0 && fs->commit_pending == fs->io_depth)
+    {
+        int wait_status = bplib_os_wait_until_ms(fs->lock, deadline);
+        if (wait_status == BP_ERROR)
+        {
+            return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to wait for FSS I/O\n", wait_status);
+        }
+        else if ((wait_status == BP_TIMEOUT) && (fs->commit_pending == fs->io_depth))
+        {
+            return BP_TIMEOUT;
+        }
+        else if ((fs->write_failures != write_failures) && (fs->commit_pending == fs->io_depth))
+        {
+            return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to commit data, write will be retried\n");
+        }
+    }
+
+    /* Check Anything to Commit */
+    file_batch_t *batch = &fs->commit_batches[fs->commit_fill];
+    if (batch->size == 0)
+    {
+        return BP_SUCCESS;
+    }
+
+    batch->end_data_id = fs->write_data_id;
+
+    /* Write Batch */
+    if (fs->io_depth == 0)
+    {
+        int write_status = write_batch(fs, batch, fs->commit_data_id);
+        return complete_batch(h, fs, batch, write_status);
+    }
+
+    /* Hand Batch to I/O Thread */
+    fs->commit_pending++;
+    fs->commit_fill = (fs->commit_fill + 1) % (fs->io_depth + 1);
+    bplib_os_broadcast_signal(fs->lock);
+
+    return BP_SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------
+ * commit_if_late - commits the write-behind buffer if its oldest object has waited too long
+ *
+ *  An I/O thread checks this itself.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int commit_if_late(bp_handle_t h, file_store_t *fs)
+{
+    uint64_t now = bplib_os_get_dtntime_ms();
+
+    if (fs->io_depth == 0 && fs->commit_batches[fs->commit_fill].size > 0 && now >= fs->commit_deadline &&
+        (!fs->write_error || now >= fs->write_retry))
+    {
+        return commit_objects(h, fs, BP_DTNTIME_INFINITE);
+    }
+
+    return BP_SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------
+ * sync_objects - commits objects up to (not including) end_data_id and waits for them
+ *
+ *  Fails if a write fails while waiting; the objects stay buffered and the write is
+ *  retried, so the caller can try again.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int sync_objects(bp_handle_t h, file_store_t *fs, unsigned long end_data_id, uint64_t deadline)
+{
+    unsigned long write_failures = fs->write_failures;
+    int           status         = commit_objects(h, fs, deadline);
+
+    while (status == BP_SUCCESS && fs->commit_data_id < end_data_id && fs->commit_data_id < fs->write_data_id)
+    {
+        status = bplib_os_wait_until_ms(fs->lock, deadline);
+        if (status == BP_ERROR)
+        {
+            status = bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to wait for FSS commit\n", status);
+        }
+        else if ((fs->write_failures != write_failures) && (fs->commit_data_id < end_data_id))
+        {
+            status = bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to commit data, write will be retried\n");
+        }
+    }
+
+    return status;
+}
+
+/*--------------------------------------------------------------------------------------
+ * read_file_index - returns the offsets of the objects in a full data file
+ *
+ *  Each entry is the offset of an object's size prefix, with one more entry for
+ *  the end of the last object.  They are read from the footer of the file via the
+ *  file descriptor, and kept in the index until a different file is asked for.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE unsigned long *read_file_index(FILE *fd, file_index_t *index, unsigned long file_id)
+{
+    /* Check Last Index Read */
+    if (index->valid && index->file_id == file_id)
+    {
+        return index->offsets;
+    }
+
+    /* Read Index Footer */
+    index->valid    = false;
+    int seek_status = file_driver.seek(fd, -(long)FILE_INDEX_SIZE, SEEK_END);
+    if (seek_status < 0)
+    {
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to seek to index of file %lu\n", seek_status, file_id);
+        return NULL;
+    }
+
+    unsigned long bytes_read = file_driver.read(index->offsets, 1, FILE_INDEX_SIZE, fd);
+    if (bytes_read != FILE_INDEX_SIZE || index->offsets[0] != 0)
+    {
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to read index of file %lu (%lu ?= %lu)\n", file_id, bytes_read,
+              (unsigned long)FILE_INDEX_SIZE);
+        return NULL;
+    }
+
+    index->file_id = file_id;
+    index->valid   = true;
+
+    return index->offsets;
+}
+
+/*--------------------------------------------------------------------------------------
+ * get_file_index - returns the offsets of the objects in a data file
+ *
+ *  For the file being written these are kept in memory, for a full file they are
+ *  read from its footer.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE unsigned long *get_file_index(file_store_t *fs, FILE *fd, unsigned long file_id)
+{
+    /* Check File Being Written */
+    if (file_id == GET_FILEID(GET_DATAID(fs->commit_data_id)))
+    {
+        return fs->write_index;
+    }
+
+    return read_file_index(fd, &fs->read_index, file_id);
+}
+
+/*--------------------------------------------------------------------------------------
+ * map_object - returns a pointer to an object within a mapping of its data file
+ *
+ *  Only full data files are mapped, as their contents (and index footer) no longer
+ *  change.  The caller holds a reference to the mapping until it calls free_object.
+ *  Returns NULL if the object cannot be mapped, in which case it should be read.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE unsigned char *map_object(file_store_t *fs, unsigned long data_id, bool sequential, file_map_t **map)
+{
+    unsigned long  file_id     = GET_FILEID(data_id);
+    unsigned long  data_offset = GET_DATAOFFSET(data_id);
+    unsigned long *file_index  = NULL;
+    file_map_t    *file_map    = NULL;
+    int            m;
+
+    /* Check Object can be Mapped */
+    if (!fs->map_on_read || file_id >= GET_FILEID(GET_DATAID(fs->commit_data_id)))
+    {
+        return NULL;
+    }
+
+    /* Find Existing Mapping */
+    for (m = 0; m < FILE_MAX_MAPS && file_map == NULL; m++)
+    {
+        if (fs->file_maps[m].addr != NULL && fs->file_maps[m].file_id == file_id)
+        {
+            file_map = &fs->file_maps[m];
+        }
+    }
+
+    /* Map Data File */
+    if (file_map == NULL)
+    {
+        /* Find Mapping Not in Use - Preferring an Empty One */
+        for (m = 0; m < FILE_MAX_MAPS; m++)
+        {
+            if (fs->file_maps[m].refs == 0 && (file_map == NULL || file_map->addr != NULL))
             {
-                file_stores[s].file_root = (char *)bplib_os_calloc(root_path_len);
-                if (file_stores[s].file_root)
-                {
-                    memcpy(file_stores[s].file_root, root_path, root_path_len);
-                }
+                file_map = &fs->file_maps[m];
             }
+        }
 
-            /* Check File Root Setup */
-            if (file_stores[s].file_root == NULL)
+        if (file_map == NULL)
+        {
+            return NULL;
+        }
+
+        if (file_map->addr != NULL)
+        {
+            bplib_os_unmapfile(file_map->addr, file_map->size);
+        }
+
+        char filename[FILE_MAX_FILENAME];
+        bplib_os_format(filename, FILE_MAX_FILENAME, "%s/%d_%lu.dat", fs->file_root, (int)fs->service_id, file_id);
+        file_map->addr    = bplib_os_mapfile(filename, &file_map->size);
+        file_map->file_id = file_id;
+        if (file_map->addr == NULL)
+        {
+            return NULL;
+        }
+
+        /* Check Index Footer */
+        if (file_map->size >= FILE_INDEX_SIZE)
+        {
+            file_index = (unsigned long *)&file_map->addr[file_map->size - FILE_INDEX_SIZE];
+        }
+        if ((file_index == NULL) || (file_index[0] != 0) ||
+            (file_index[FILE_DATA_COUNT] != file_map->size - FILE_INDEX_SIZE))
+        {
+            bplog(NULL, BP_FLAG_STORE_FAILURE, "Invalid index in mapped file %s\n", filename);
+            bplib_os_unmapfile(file_map->addr, file_map->size);
+            file_map->addr = NULL;
+            return NULL;
+        }
+
+        if (sequential)
+        {
+            bplib_os_advisefile(file_map->addr, file_map->size, BP_OS_ADVISE_SEQUENTIAL);
+        }
+    }
+
+    /* Check Object Not Left Out by Compaction */
+    file_index = (unsigned long *)&file_map->addr[file_map->size - FILE_INDEX_SIZE];
+    if (file_index[data_offset + 1] - file_index[data_offset] < sizeof(unsigned long) + sizeof(bp_object_hdr_t))
+    {
+        return NULL;
+    }
+
+    /* Return Object in Mapping */
+    file_map->refs++;
+    *map = file_map;
+
+    return &file_map->addr[file_index[data_offset] + sizeof(unsigned long)];
+}
+
+/*--------------------------------------------------------------------------------------
+ * drop_object_pages - lets the pages of a mapped object go until it is next accessed
+ *
+ *  The header is kept, as the sid set in it is still read after a release.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void drop_object_pages(void *object_ptr)
+{
+    bp_object_hdr_t *object_header = (bp_object_hdr_t *)object_ptr;
+
+    bplib_os_advisefile(&object_header[1], object_header->size, BP_OS_ADVISE_DONTNEED);
+}
+
+/*--------------------------------------------------------------------------------------
+ * free_object - frees an object copy, or drops the reference to its mapping
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void free_object(void *object_ptr, file_map_t *map)
+{
+    if (map != NULL)
+    {
+        drop_object_pages(object_ptr);
+        map->refs--;
+    }
+    else if (object_ptr != NULL)
+    {
+        bplib_os_free(object_ptr);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * prefetch_object - reads the next object dequeue will need before it is asked for
+ *
+ *  Called by the I/O thread with the store lock held, which is released while the
+ *  object is read.  Only objects already written are read ahead, and no more than
+ *  io_depth past the next one to be dequeued.  Returns true if an object was read.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE bool prefetch_object(file_store_t *fs)
+{
+    unsigned long  object_size = 0;
+    unsigned char *object_ptr  = NULL;
+    bool           read_ahead  = false;
+
+    /* Check Read-Ahead Enabled */
+    if (fs->prefetch == NULL)
+    {
+        return false;
+    }
+
+    /* Get Next Object to Read Ahead */
+    unsigned long read_data_id = GET_DATAID(fs->read_data_id);
+    if (fs->prefetch_data_id < read_data_id)
+    {
+        fs->prefetch_data_id = read_data_id;
+    }
+
+    unsigned long data_id     = fs->prefetch_data_id;
+    unsigned long file_id     = GET_FILEID(data_id);
+    unsigned long data_offset = GET_DATAOFFSET(data_id);
+    if (data_id >= GET_DATAID(fs->commit_data_id) || data_id >= read_data_id + fs->io_depth)
+    {
+        return false;
+    }
+
+    /* Free Object Dequeue Went Past */
+    file_prefetch_t *prefetch = &fs->prefetch[data_id % fs->io_depth];
+    if (prefetch->object != NULL)
+    {
+        bplib_os_free(prefetch->object);
+        prefetch->object = NULL;
+    }
+
+    /* Get Position in File Being Written
+     *  index entries of objects already written do not change */
+    bool          write_file = (file_id == GET_FILEID(GET_DATAID(fs->commit_data_id)));
+    unsigned long object_pos = write_file ? fs->write_index[data_offset] : 0;
+    fs->prefetch_data_id++;
+
+    bplib_os_unlock(fs->lock);
+    {
+        /* Close Previous File */
+        if (fs->prefetch_fd != NULL && GET_FILEID(fs->prefetch_fd_data_id) != file_id)
+        {
+            file_driver.close(fs->prefetch_fd);
+            fs->prefetch_fd = NULL;
+        }
+
+        /* Open File */
+        if (fs->prefetch_fd == NULL)
+        {
+            fs->prefetch_fd         = open_dat_file(fs->service_id, fs->file_root, file_id, "rb");
+            fs->prefetch_fd_data_id = data_id - data_offset;
+        }
+
+        /* Seek to Object
+         *  needed when dequeue got ahead of read-ahead */
+        bool position_valid = (fs->prefetch_fd != NULL);
+        if (position_valid && fs->prefetch_fd_data_id != data_id)
+        {
+            if (!write_file)
+            {
+                unsigned long *file_index = read_file_index(fs->prefetch_fd, &fs->prefetch_index, file_id);
+                position_valid            = (file_index != NULL);
+                object_pos                = position_valid ? file_index[data_offset] : 0;
+            }
+            position_valid = position_valid && (file_driver.seek(fs->prefetch_fd, object_pos, SEEK_SET) >= 0);
+        }
+
+        /* Read Object */
+        if (position_valid &&
+            file_driver.read(&object_size, 1, sizeof(object_size), fs->prefetch_fd) == sizeof(object_size) &&
+            object_size >= sizeof(bp_object_hdr_t))
+        {
+            object_ptr = (unsigned char *)bplib_os_calloc(object_size);
+            if (object_ptr != NULL && file_driver.read(object_ptr, 1, object_size, fs->prefetch_fd) == object_size)
+            {
+                fs->prefetch_fd_data_id = data_id + 1;
+                read_ahead              = true;
+            }
+        }
+
+        /* Close File After Last Object */
+        if (read_ahead && GET_DATAOFFSET(data_id + 1) == 0)
+        {
+            file_driver.close(fs->prefetch_fd);
+            fs->prefetch_fd = NULL;
+        }
+
+        /* Check Errors
+         *  dequeue reads the object itself, and reports any failure */
+        if (!read_ahead)
+        {
+            if (fs->prefetch_fd != NULL)
+            {
+                file_driver.close(fs->prefetch_fd);
+                fs->prefetch_fd = NULL;
+            }
+            if (object_ptr != NULL)
+            {
+                bplib_os_free(object_ptr);
+                object_ptr = NULL;
+            }
+        }
+    }
+    bplib_os_lock(fs->lock);
+
+    /* Keep Object Unless Already Dequeued */
+    if (object_ptr != NULL && data_id >= GET_DATAID(fs->read_data_id))
+    {
+        prefetch->object  = object_ptr;
+        prefetch->data_id = data_id;
+    }
+    else if (object_ptr != NULL)
+    {
+        bplib_os_free(object_ptr);
+    }
+
+    return read_ahead;
+}
+
+/*--------------------------------------------------------------------------------------
+ * take_prefetched - returns the object read ahead for dequeue, if there is one
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE unsigned char *take_prefetched(file_store_t *fs, unsigned long data_id)
+{
+    unsigned char *object_ptr = NULL;
+
+    if (fs->prefetch != NULL)
+    {
+        file_prefetch_t *prefetch = &fs->prefetch[data_id % fs->io_depth];
+        if (prefetch->object != NULL && prefetch->data_id == data_id)
+        {
+            object_ptr       = prefetch->object;
+            prefetch->object = NULL;
+        }
+    }
+
+    return object_ptr;
+}
+
+/*--------------------------------------------------------------------------------------
+ * compact_finish - replaces the data file being compacted with its compacted copy
+ *
+ *  Called with the store lock held.  The rename is atomic, so every storage ID maps
+ *  to the same object in whichever file a reader opens.  Readers of the old file
+ *  are closed so that they next open the new one along with its index.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void compact_finish(file_store_t *fs)
+{
+    file_compact_t *compact = &fs->compact;
+    unsigned long   file_id = compact->file_id;
+
+    char filename[FILE_MAX_FILENAME];
+    char tmpname[FILE_MAX_FILENAME];
+    bplib_os_format(filename, FILE_MAX_FILENAME, "%s/%d_%lu.dat", fs->file_root, (int)fs->service_id, file_id);
+    bplib_os_format(tmpname, FILE_MAX_FILENAME, "%s/%d_%lu.tmp", fs->file_root, (int)fs->service_id, file_id);
+
+    /* Close Files Left Open by an Error */
+    if (compact->src_fd != NULL)
+    {
+        file_driver.close(compact->src_fd);
+        compact->src_fd = NULL;
+    }
+    if (compact->dst_fd != NULL)
+    {
+        file_driver.close(compact->dst_fd);
+        compact->dst_fd = NULL;
+    }
+    compact->active = false;
+
+    /* Drop Copy of Deleted File, or Copy that Failed */
+    if (compact->aborted)
+    {
+        remove(tmpname);
+        return;
+    }
+
+    /* Replace Data File */
+    if (rename(tmpname, filename) < 0)
+    {
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to replace %s with compacted file: %s\n", filename,
+              strerror(errno));
+        remove(tmpname);
+        return;
+    }
+
+    /* Close Readers of Old File */
+    if (fs->read_fd != NULL && GET_FILEID(GET_DATAID(fs->read_data_id)) == file_id)
+    {
+        file_driver.close(fs->read_fd);
+        fs->read_fd = NULL;
+    }
+    if (fs->retrieve_fd != NULL && GET_FILEID(GET_DATAID(fs->retrieve_data_id)) == file_id)
+    {
+        file_driver.close(fs->retrieve_fd);
+        fs->retrieve_fd = NULL;
+    }
+    if (fs->prefetch_fd != NULL && GET_FILEID(fs->prefetch_fd_data_id) == file_id)
+    {
+        file_driver.close(fs->prefetch_fd);
+        fs->prefetch_fd = NULL;
+    }
+    if (fs->read_index.file_id == file_id)
+    {
+        fs->read_index.valid = false;
+    }
+    if (fs->prefetch_index.file_id == file_id)
+    {
+        fs->prefetch_index.valid = false;
+    }
+
+    /* Retire Mappings of Old File
+     *  objects handed out from a mapping stay valid until they are freed */
+    int m;
+    for (m = 0; m < FILE_MAX_MAPS; m++)
+    {
+        if (fs->file_maps[m].addr != NULL && fs->file_maps[m].file_id == file_id)
+        {
+            if (fs->file_maps[m].refs == 0)
+            {
+                bplib_os_unmapfile(fs->file_maps[m].addr, fs->file_maps[m].size);
+                fs->file_maps[m].addr = NULL;
+            }
+            else
+            {
+                fs->file_maps[m].file_id = FILE_ID_RETIRED;
+            }
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * compact_check_file - starts compacting a data file if little of it is still live
+ *
+ *  Called with the store lock held, which is released while the relinquish table
+ *  and index of the file are read.  The file is claimed before the lock is released,
+ *  so that relinquishing its last object while it is checked aborts the compaction
+ *  instead of leaving the copy behind.  Returns the number of bytes read.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE unsigned long compact_check_file(file_store_t *fs, unsigned long file_id)
+{
+    file_compact_t *compact    = &fs->compact;
+    bool            table_read = true;
+    unsigned long   live_size  = 0;
+
+    /* Claim File */
+    compact->active  = true;
+    compact->aborted = false;
+    compact->file_id = file_id;
+
+    /* Get Relinquished Objects
+     *  the table of the file last relinquished from is only kept in memory */
+    if (file_id == GET_FILEID(GET_DATAID(fs->relinquish_data_id)))
+    {
+        compact->freed = fs->relinquish_table;
+        bplib_os_unlock(fs->lock);
+    }
+    else
+    {
+        bplib_os_unlock(fs->lock);
+        memset(&compact->freed, 0, sizeof(compact->freed));
+        FILE *tbl_fd = open_tbl_file(fs->service_id, fs->file_root, file_id, true);
+        if (tbl_fd != NULL)
+        {
+            table_read = (file_driver.read(&compact->freed, 1, sizeof(compact->freed), tbl_fd) ==
+                          sizeof(compact->freed));
+            file_driver.close(tbl_fd);
+        }
+    }
+
+    /* Read Index of File */
+    unsigned long *src_index = NULL;
+    if (table_read && compact->freed.free_cnt > 0)
+    {
+        compact->src_fd = open_dat_file(fs->service_id, fs->file_root, file_id, "rb");
+        if (compact->src_fd != NULL)
+        {
+            src_index = read_file_index(compact->src_fd, &compact->src_index, file_id);
+        }
+    }
+
+    /* Check Enough of File is Relinquished */
+    if (src_index != NULL)
+    {
+        int d;
+        for (d = 0; d < FILE_DATA_COUNT; d++)
+        {
+            if (!compact->freed.freed[d])
+            {
+                live_size += src_index[d + 1] - src_index[d];
+            }
+        }
+
+        if (live_size < src_index[FILE_DATA_COUNT] &&
+            live_size * 100 <= src_index[FILE_DATA_COUNT] * (unsigned long)fs->compact_live_percent)
+        {
+            char tmpname[FILE_MAX_FILENAME];
+            bplib_os_format(tmpname, FILE_MAX_FILENAME, "%s/%d_%lu.tmp", fs->file_root, (int)fs->service_id,
+                            file_id);
+            compact->dst_fd = file_driver.open(tmpname, "wb");
+            if (compact->dst_fd == NULL)
+            {
+                bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to open compacted file %s: %s\n", tmpname,
+                      strerror(errno));
+            }
+        }
+    }
+
+    /* Close File Unless Compacting It */
+    if (compact->src_fd != NULL && compact->dst_fd == NULL)
+    {
+        file_driver.close(compact->src_fd);
+        compact->src_fd = NULL;
+    }
+
+    bplib_os_lock(fs->lock);
+
+    /* Start Compaction
+     *  unless the file was deleted while it was checked */
+    if (compact->dst_fd != NULL && !compact->aborted)
+    {
+        compact->next_offset  = 0;
+        compact->dst_index[0] = 0;
+    }
+    else if (compact->dst_fd != NULL)
+    {
+        compact_finish(fs);
+    }
+    else
+    {
+        compact->active = false;
+    }
+
+    return sizeof(compact->freed) + (src_index != NULL ? FILE_INDEX_SIZE : 0);
+}
+
+/*--------------------------------------------------------------------------------------
+ * compact_copy_object - copies the next live object into the compacted file
+ *
+ *  Called with the store lock held, which is released while the object is copied.
+ *  Relinquished objects are left out, and get an empty entry in the index.  Returns
+ *  the number of bytes read and written.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE unsigned long compact_copy_object(file_store_t *fs)
+{
+    file_compact_t *compact     = &fs->compact;
+    unsigned long  *src_index   = compact->src_index.offsets;
+    unsigned long  *dst_index   = compact->dst_index;
+    unsigned long   object_size = 0;
+    int             d           = compact->next_offset;
+
+    bplib_os_unlock(fs->lock);
+    {
+        /* Skip Relinquished Objects */
+        while (d < FILE_DATA_COUNT && compact->freed.freed[d])
+        {
+            dst_index[d + 1] = dst_index[d];
+            d++;
+        }
+
+        /* Copy Object */
+        if (d < FILE_DATA_COUNT)
+        {
+            object_size = src_index[d + 1] - src_index[d];
+            if (object_size > compact->capacity)
+            {
+                bplib_os_free(compact->buffer);
+                compact->buffer   = (uint8_t *)bplib_os_calloc(object_size);
+                compact->capacity = (compact->buffer != NULL) ? object_size : 0;
+            }
+
+            if (compact->buffer == NULL || file_driver.seek(compact->src_fd, src_index[d], SEEK_SET) < 0 ||
+                file_driver.read(compact->buffer, 1, object_size, compact->src_fd) != object_size ||
+                file_driver.write(compact->buffer, 1, object_size, compact->dst_fd) != object_size)
+            {
+                bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to copy object %d of file %lu to compacted file\n", d,
+                      compact->file_id);
+                compact->aborted = true;
+            }
+
+            dst_index[d + 1] = dst_index[d] + object_size;
+            d++;
+        }
+
+        /* Write Index Footer After Last Object */
+        if (d == FILE_DATA_COUNT && !compact->aborted)
+        {
+            if (file_driver.write(dst_index, 1, FILE_INDEX_SIZE, compact->dst_fd) != FILE_INDEX_SIZE ||
+                file_driver.flush(compact->dst_fd) < 0)
+            {
+                bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to write index of compacted file %lu\n",
+                      compact->file_id);
+                compact->aborted = true;
+            }
+        }
+    }
+    bplib_os_lock(fs->lock);
+
+    /* Replace File Once Copied */
+    compact->next_offset = d;
+    if (d == FILE_DATA_COUNT || compact->aborted)
+    {
+        compact_finish(fs);
+    }
+
+    return object_size * 2;
+}
+
+/*--------------------------------------------------------------------------------------
+ * compact_files - does the next step of compacting sparsely live data files
+ *
+ *  A data file is only deleted once all of its objects are relinquished.  When this
+ *  is enabled, the I/O thread checks full data files after objects are relinquished,
+ *  at most once per pass interval, and rewrites those with no more than
+ *  compact_live_percent of their bytes still live, one object per step.  File
+ *  access is paced to compact_budget bytes per second.  Called with the store lock
+ *  held, returns true if a step was done.
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE bool compact_files(file_store_t *fs)
+{
+    unsigned long io_bytes = 0;
+    uint64_t      now      = bplib_os_get_dtntime_ms();
+
+    /* Check Anything to Compact */
+    if (fs->compact_live_percent == 0 || (!fs->compact_scanning && !fs->compact_wanted))
+    {
+        return false;
+    }
+
+    /* Refill I/O Budget
+     *  up to one second of it can build up while idle */
+    uint64_t refill = (now - fs->compact_refill_time) * fs->compact_budget / 1000;
+    if (refill > 0)
+    {
+        fs->compact_tokens += (int64_t)refill;
+        if (fs->compact_tokens > (int64_t)fs->compact_budget)
+        {
+            fs->compact_tokens = (int64_t)fs->compact_budget;
+        }
+        fs->compact_refill_time = now;
+    }
+
+    /* Wait Until Budget is Available */
+    if (fs->compact_tokens < 0)
+    {
+        fs->compact_resume = now + (uint64_t)(-fs->compact_tokens) * 1000 / fs->compact_budget + 1;
+        return false;
+    }
+
+    if (fs->compact.active)
+    {
+        /* Copy Next Object */
+        io_bytes = compact_copy_object(fs);
+    }
+    else
+    {
+        /* Start Pass Over Full Files */
+        if (!fs->compact_scanning)
+        {
+            if (now < fs->compact_pass_time + FILE_COMPACT_PASS_INTERVAL)
+            {
+                fs->compact_resume = fs->compact_pass_time + FILE_COMPACT_PASS_INTERVAL;
+                return false;
+            }
+
+            fs->compact_wanted    = false;
+            fs->compact_scanning  = true;
+            fs->compact_scan_id   = fs->compact_first_id;
+            fs->compact_pass_time = now;
+        }
+
+        /* Check Next File */
+        unsigned long file_id = fs->compact_scan_id;
+        if (file_id >= GET_FILEID(GET_DATAID(fs->commit_data_id)))
+        {
+            fs->compact_scanning = false;
+            return false;
+        }
+
+        fs->compact_scan_id++;
+        io_bytes = compact_check_file(fs, file_id);
+    }
+
+    /* Spend I/O Budget */
+    fs->compact_tokens -= (int64_t)io_bytes;
+    fs->compact_resume = now;
+
+    return true;
+}
+
+/*--------------------------------------------------------------------------------------
+ * file_io_thread - writes batches handed off by enqueue, and reads ahead of dequeue
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void file_io_thread(void *arg)
+{
+    file_store_t *fs = (file_store_t *)arg;
+    bp_handle_t   h  = bp_handle_from_serial(fs - file_stores, BPLIB_HANDLE_FILE_STORE_BASE);
+
+    bplib_os_lock(fs->lock);
+    while (true)
+    {
+        file_batch_t *fill_batch = &fs->commit_batches[fs->commit_fill];
+        uint64_t      now        = bplib_os_get_dtntime_ms();
+
+        if (fs->commit_pending > 0 && (!fs->write_error || now >= fs->write_retry))
+        {
+            /* Write Oldest Pending Batch */
+            int           batch_count   = fs->io_depth + 1;
+            int           batch_index   = (fs->commit_fill + batch_count - fs->commit_pending) % batch_count;
+            file_batch_t *batch         = &fs->commit_batches[batch_index];
+            unsigned long first_data_id = fs->commit_data_id;
+
+            bplib_os_unlock(fs->lock);
+            int write_status = write_batch(fs, batch, first_data_id);
+            bplib_os_lock(fs->lock);
+
+            complete_batch(h, fs, batch, write_status);
+        }
+        else if (fs->io_stop)
+        {
+            /* Batches Still Failing to Write are Given Up */
+            break;
+        }
+        else if (fs->io_depth > 0 && fill_batch->size > 0 && fs->commit_pending < fs->io_depth &&
+                 now >= fs->commit_deadline)
+        {
+            /* Commit Batch that has Waited Too Long */
+            commit_objects(h, fs, BP_DTNTIME_INFINITE);
+        }
+        else if (!prefetch_object(fs) && !compact_files(fs))
+        {
+            /* Wait for Work, Latency of Batch Being Filled, or Compaction Budget */
+            uint64_t wait_until = BP_DTNTIME_INFINITE;
+            if (fs->io_depth > 0 && fill_batch->size > 0)
+            {
+                wait_until = fs->commit_deadline;
+            }
+            if ((fs->compact_scanning || fs->compact_wanted) && fs->compact_resume < wait_until)
+            {
+                wait_until = fs->compact_resume;
+            }
+            if (fs->commit_pending > 0 && fs->write_retry < wait_until)
+            {
+                wait_until = fs->write_retry;
+            }
+            bplib_os_wait_until_ms(fs->lock, wait_until);
+        }
+    }
+    bplib_os_unlock(fs->lock);
+}
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * bplib_store_file_init -
+ *-------------------------------------------------------------------------------------*/
+void bplib_store_file_init(bp_file_driver_t *driver)
+{
+    if (driver)
+        file_driver = *driver;
+
+    memset(file_stores, 0, sizeof(file_stores));
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_store_file_create -
+ *-------------------------------------------------------------------------------------*/
+bp_handle_t bplib_store_file_create(int type, bp_ipn_t node, bp_ipn_t service, bool recover, void *parm)
+{
+    (void)type;
+    (void)node;
+    (void)service;
+    (void)recover;
+
+    bp_file_attr_t *attr = (bp_file_attr_t *)parm;
+    bp_handle_t     pending_h;
+
+    int s;
+    for (s = 0; s < FILE_MAX_STORES; s++)
+    {
+        if (file_stores[s].in_use == false)
+        {
+            pending_h = bp_handle_from_serial(s, BPLIB_HANDLE_FILE_STORE_BASE);
+
+            /* Clear File Store (pointers set to NULL) */
+            memset(&file_stores[s], 0, sizeof(file_stores[s]));
+            file_stores[s].write_fd      = NULL;
+            file_stores[s].read_fd       = NULL;
+            file_stores[s].retrieve_fd   = NULL;
+            file_stores[s].relinquish_fd = NULL;
+
+            /* Set In Use (necessary to be able to destroy later) */
+            file_stores[s].in_use = true;
+
+            /* Initialize Parameters */
+            file_stores[s].service_id         = file_service_id++;
+            file_stores[s].lock               = BP_INVALID_HANDLE;
+            file_stores[s].write_data_id      = 1;
+            file_stores[s].read_data_id       = 1;
+            file_stores[s].retrieve_data_id   = 1;
+            file_stores[s].relinquish_data_id = 1;
+            file_stores[s].commit_data_id     = 1;
+            file_stores[s].io_thread          = BP_INVALID_HANDLE;
+
+            /* Setup and Check Lock */
+            file_stores[s].lock = bplib_os_createlock();
+            if (!bp_handle_is_valid(file_stores[s].lock))
+            {
+                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed (%d) to create FSS lock\n",
+                      bp_handle_printable(file_stores[s].lock));
+                bplib_store_file_destroy(pending_h);
+                break;
+            }
+
+            /* Setup Root Path */
+            const char *root_path = FILE_DEFAULT_ROOT;
+            if (attr && attr->root_path)
+            {
+                root_path = attr->root_path;
+            }
+            int root_path_len = bplib_os_strnlen(root_path, FILE_MAX_FILENAME) + 1;
+            if (root_path_len <= FILE_MAX_FILENAME)
+            {
+                file_stores[s].file_root = (char *)bplib_os_calloc(root_path_len);
+                if (file_stores[s].file_root)
+                {
+                    memcpy(file_stores[s].file_root, root_path, root_path_len);
+                }
+            }
+
+            /* Check File Root Setup */
+            if (file_stores[s].file_root == NULL)
+            {
+                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to set FSS root path\n");
+                bplib_store_file_destroy(pending_h);
+                break;
+            }
+
+            /* Setup Data Cache */
+            int cache_size = FILE_DEFAULT_CACHE_SIZE;
+            if (attr && attr->cache_size)
+            {
+                cache_size = attr->cache_size;
+            }
+            file_stores[s].cache_size = cache_size;
+            file_stores[s].data_cache = (data_cache_t *)bplib_os_calloc(cache_size * sizeof(data_cache_t));
+
+            /* Set Flush Attribute */
+            if (attr)
+            {
+                file_stores[s].flush_on_write = attr->flush_on_write;
+            }
+            else
+            {
+                file_stores[s].flush_on_write = FILE_FLUSH_DEFAULT;
+            }
+
+            /* Check Data Cache Setup */
+            if (file_stores[s].data_cache == NULL)
+            {
+                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to allocate FSS data cache\n");
+                bplib_store_file_destroy(pending_h);
+                break;
+            }
+
+            /* Set Commit Attributes */
+            file_stores[s].commit_bytes   = FILE_DEFAULT_COMMIT_BYTES;
+            file_stores[s].commit_latency = FILE_DEFAULT_COMMIT_LATENCY;
+            if (attr)
+            {
+                if (attr->commit_bytes > 0)
+                {
+                    file_stores[s].commit_bytes = attr->commit_bytes;
+                }
+                if (attr->commit_latency > 0)
+                {
+                    file_stores[s].commit_latency = attr->commit_latency;
+                }
+                file_stores[s].commit_callback = attr->commit_callback;
+                file_stores[s].commit_parm     = attr->commit_parm;
+                file_stores[s].map_on_read     = attr->map_on_read;
+                if (attr->io_depth > 0)
+                {
+                    file_stores[s].io_depth = attr->io_depth;
+                }
+                if (attr->compact_live_percent > 0)
+                {
+                    file_stores[s].compact_live_percent = attr->compact_live_percent;
+                }
+            }
+
+            /* Set Compaction Budget */
+            file_stores[s].compact_budget = FILE_DEFAULT_COMPACT_BUDGET;
+            if (attr && attr->compact_budget > 0)
+            {
+                file_stores[s].compact_budget = attr->compact_budget;
+            }
+            file_stores[s].compact_tokens      = (int64_t)file_stores[s].compact_budget;
+            file_stores[s].compact_refill_time = bplib_os_get_dtntime_ms();
+
+            /* Setup File Indices */
+            file_stores[s].write_index = (unsigned long *)bplib_os_calloc(FILE_INDEX_SIZE);
+            file_stores[s].read_index.offsets     = (unsigned long *)bplib_os_calloc(FILE_INDEX_SIZE);
+            file_stores[s].prefetch_index.offsets = (unsigned long *)bplib_os_calloc(FILE_INDEX_SIZE);
+            if (file_stores[s].write_index == NULL || file_stores[s].read_index.offsets == NULL ||
+                file_stores[s].prefetch_index.offsets == NULL)
+            {
+                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to allocate FSS file indices\n");
+                bplib_store_file_destroy(pending_h);
+                break;
+            }
+
+            /* Setup Write-Behind Buffers
+             *  one being filled, and up to io_depth handed to the I/O thread */
+            int batch_count               = file_stores[s].io_depth + 1;
+            file_stores[s].commit_batches = (file_batch_t *)bplib_os_calloc(batch_count * sizeof(file_batch_t));
+            bool batches_allocated        = (file_stores[s].commit_batches != NULL);
+            int  b;
+            for (b = 0; batches_allocated && b < batch_count; b++)
+            {
+                file_stores[s].commit_batches[b].capacity = file_stores[s].commit_bytes;
+                file_stores[s].commit_batches[b].buffer   = (uint8_t *)bplib_os_calloc(file_stores[s].commit_bytes);
+                batches_allocated                         = (file_stores[s].commit_batches[b].buffer != NULL);
+            }
+            if (!batches_allocated)
             {
-                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to set FSS root path\n");
+                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to allocate FSS write-behind buffers\n");
                 bplib_store_file_destroy(pending_h);
                 break;
             }
 
-            /* Setup Data Cache */
-            int cache_size = FILE_DEFAULT_CACHE_SIZE;
-            if (attr && attr->cache_size)
+            /* Setup Read-Ahead
+             *  not needed for full files when they are mapped */
+            if (file_stores[s].io_depth > 0 && !file_stores[s].map_on_read)
             {
-                cache_size = attr->cache_size;
+                file_stores[s].prefetch =
+                    (file_prefetch_t *)bplib_os_calloc(file_stores[s].io_depth * sizeof(file_prefetch_t));
+                if (file_stores[s].prefetch == NULL)
+                {
+                    bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to allocate FSS read-ahead\n");
+                    bplib_store_file_destroy(pending_h);
+                    break;
+                }
             }
-            file_stores[s].cache_size = cache_size;
-            file_stores[s].data_cache = (data_cache_t *)bplib_os_calloc(cache_size * sizeof(data_cache_t));
 
-            /* Set Flush Attribute */
-            if (attr)
-            {
-                file_stores[s].flush_on_write = attr->flush_on_write;
-            }
-            else
+            /* Setup Compaction */
+            if (file_stores[s].compact_live_percent > 0)
             {
-                file_stores[s].flush_on_write = FILE_FLUSH_DEFAULT;
+                file_stores[s].compact.src_index.offsets = (unsigned long *)bplib_os_calloc(FILE_INDEX_SIZE);
+                file_stores[s].compact.dst_index         = (unsigned long *)bplib_os_calloc(FILE_INDEX_SIZE);
+                if (file_stores[s].compact.src_index.offsets == NULL || file_stores[s].compact.dst_index == NULL)
+                {
+                    bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to allocate FSS compaction indices\n");
+                    bplib_store_file_destroy(pending_h);
+                    break;
+                }
             }
 
-            /* Check Data Cache Setup */
-            if (file_stores[s].data_cache == NULL)
+            /* Start I/O Thread
+             *  file access is synchronous, and there is no compaction, where
+             *  threads are not supported */
+            if (file_stores[s].io_depth > 0 || file_stores[s].compact_live_percent > 0)
             {
-                bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to allocate FSS data cache\n");
-                bplib_store_file_destroy(pending_h);
-                break;
+                file_stores[s].io_thread = bplib_os_createthread(file_io_thread, &file_stores[s]);
+                if (!bp_handle_is_valid(file_stores[s].io_thread))
+                {
+                    bplog(NULL, BP_FLAG_DIAGNOSTIC, "Failed to start FSS I/O thread, I/O is synchronous\n");
+                    for (b = 1; b < batch_count; b++)
+                    {
+                        bplib_os_free(file_stores[s].commit_batches[b].buffer);
+                        file_stores[s].commit_batches[b].buffer = NULL;
+                    }
+                    if (file_stores[s].prefetch != NULL)
+                    {
+                        bplib_os_free(file_stores[s].prefetch);
+                        file_stores[s].prefetch = NULL;
+                    }
+                    file_stores[s].io_depth             = 0;
+                    file_stores[s].compact_live_percent = 0;
+                }
             }
 
             /* Return Handle */
@@ -338,10 +1532,101 @@ int bplib_store_file_destroy(bp_handle_t h)
     assert(handle >= 0 && handle < FILE_MAX_STORES);
     assert(file_stores[handle].in_use);
 
+    if (file_stores[handle].commit_batches != NULL)
+    {
+        /* Write Remaining Objects and Stop I/O Thread */
+        bplib_os_lock(file_stores[handle].lock);
+        sync_objects(h, &file_stores[handle], file_stores[handle].write_data_id, BP_DTNTIME_INFINITE);
+        file_stores[handle].io_stop = true;
+        bplib_os_broadcast_signal(file_stores[handle].lock);
+        bplib_os_unlock(file_stores[handle].lock);
+        if (bp_handle_is_valid(file_stores[handle].io_thread))
+        {
+            bplib_os_jointhread(file_stores[handle].io_thread);
+        }
+
+        if (file_stores[handle].commit_data_id < file_stores[handle].write_data_id)
+        {
+            bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to write %lu objects before closing store\n",
+                  file_stores[handle].write_data_id - file_stores[handle].commit_data_id);
+        }
+
+        int b;
+        for (b = 0; b <= file_stores[handle].io_depth; b++)
+        {
+            if (file_stores[handle].commit_batches[b].buffer != NULL)
+            {
+                bplib_os_free(file_stores[handle].commit_batches[b].buffer);
+            }
+        }
+        bplib_os_free(file_stores[handle].commit_batches);
+    }
+    if (file_stores[handle].prefetch != NULL)
+    {
+        int p;
+        for (p = 0; p < file_stores[handle].io_depth; p++)
+        {
+            if (file_stores[handle].prefetch[p].object != NULL)
+            {
+                bplib_os_free(file_stores[handle].prefetch[p].object);
+            }
+        }
+        bplib_os_free(file_stores[handle].prefetch);
+    }
+    if (file_stores[handle].prefetch_fd != NULL)
+    {
+        file_driver.close(file_stores[handle].prefetch_fd);
+    }
+    if (file_stores[handle].compact.active)
+    {
+        file_stores[handle].compact.aborted = true;
+        compact_finish(&file_stores[handle]);
+    }
+    if (file_stores[handle].compact.src_index.offsets != NULL)
+    {
+        bplib_os_free(file_stores[handle].compact.src_index.offsets);
+    }
+    if (file_stores[handle].compact.dst_index != NULL)
+    {
+        bplib_os_free(file_stores[handle].compact.dst_index);
+    }
+    if (file_stores[handle].compact.buffer != NULL)
+    {
+        bplib_os_free(file_stores[handle].compact.buffer);
+    }
+    if (file_stores[handle].data_cache != NULL)
+    {
+        int c;
+        for (c = 0; c < file_stores[handle].cache_size; c++)
+        {
+            free_object(file_stores[handle].data_cache[c].mem_ptr, file_stores[handle].data_cache[c].mem_map);
+        }
+    }
+
+    int m;
+    for (m = 0; m < FILE_MAX_MAPS; m++)
+    {
+        if (file_stores[handle].file_maps[m].addr != NULL)
+        {
+            bplib_os_unmapfile(file_stores[handle].file_maps[m].addr, file_stores[handle].file_maps[m].size);
+        }
+    }
     if (file_stores[handle].write_fd != NULL)
     {
         file_driver.close(file_stores[handle].write_fd);
     }
+    if (file_stores[handle].write_index != NULL)
+    {
+        bplib_os_free(file_stores[handle].write_index);
+    }
+    if (file_stores[handle].read_index.offsets != NULL)
+    {
+        bplib_os_free(file_stores[handle].read_index.offsets);
+    }
+    if (file_stores[handle].prefetch_index.offsets != NULL)
+    {
+        bplib_os_free(file_stores[handle].prefetch_index.offsets);
+    }
     if (file_stores[handle].read_fd != NULL)
     {
         file_driver.close(file_stores[handle].read_fd);
@@ -375,131 +1660,113 @@ int bplib_store_file_enqueue(bp_handle_t h, const void *data1, size_t data1_size
                              int timeout)
 {
     int handle = bp_handle_to_serial(h, BPLIB_HANDLE_FILE_STORE_BASE);
-    (void)timeout;
 
     assert(handle >= 0 && handle < FILE_MAX_STORES);
     assert(file_stores[handle].in_use);
 
     /* Initialize Variables */
-    file_store_t *fs            = (file_store_t *)&file_stores[handle];
-    unsigned long data_size     = data1_size + data2_size;
-    unsigned long object_size   = sizeof(bp_object_hdr_t) + data_size;
-    unsigned long bytes_written = 0;
-    bool          flush_error   = false;
-
-    /* Get IDs */
-    unsigned long data_id     = GET_DATAID(fs->write_data_id);
-    unsigned long file_id     = GET_FILEID(data_id);
-    unsigned long data_offset = GET_DATAOFFSET(data_id);
+    file_store_t *fs          = (file_store_t *)&file_stores[handle];
+    unsigned long data_size   = data1_size + data2_size;
+    unsigned long object_size = ALIGN_OBJECT(sizeof(bp_object_hdr_t) + data_size);
+    unsigned long total_size  = sizeof(object_size) + object_size;
+    uint64_t      deadline    = get_deadline(timeout);
+    int           status      = BP_SUCCESS;
 
-    /* Check Need to Open Write File */
-    if (fs->write_fd == NULL)
+    bplib_os_lock(fs->lock);
     {
-        /* Open Write File */
-        fs->write_fd = open_dat_file(fs->service_id, fs->file_root, file_id, false);
-        if (fs->write_fd == NULL)
+        /* Wait for Previous Data File to be Written
+         *  its index is written to its footer by the I/O thread, or with the
+         *  retry of a failed batch, and is reused for the next file */
+        if (GET_DATAOFFSET(GET_DATAID(fs->write_data_id)) == 0)
         {
-            return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to enqueue data\n");
+            status = sync_objects(h, fs, fs->write_data_id, deadline);
+            if (status != BP_SUCCESS)
+            {
+                bplib_os_unlock(fs->lock);
+                return status;
+            }
         }
 
-        /* Seek to Current Position */
-        if (fs->write_error)
+        /* Make Room in Write-Behind Buffer */
+        file_batch_t *batch = &fs->commit_batches[fs->commit_fill];
+        if (batch->size + total_size > batch->capacity)
         {
-            /* Start at Beginning of File */
-            int seek_status = file_driver.seek(fs->write_fd, 0, SEEK_SET);
-            if (seek_status < 0)
+            status = commit_objects(h, fs, deadline);
+            if (status != BP_SUCCESS)
             {
-                return bplog(NULL, BP_FLAG_STORE_FAILURE,
-                             "Failed (%d) to set write position after error to start of file\n", seek_status);
+                bplib_os_unlock(fs->lock);
+                return status;
             }
 
-            /* Read/Seek Through File */
-            unsigned long pos;
-            for (pos = 0; pos < data_offset; pos++)
+            /* Grow Buffer to Fit Object */
+            batch = &fs->commit_batches[fs->commit_fill];
+            if (total_size > batch->capacity)
             {
-                unsigned long current_size;
-
-                /* Read Current Data Size */
-                unsigned long bytes_read = file_driver.read(&current_size, 1, sizeof(current_size), fs->write_fd);
-                if (bytes_read != sizeof(current_size))
-                {
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE,
-                                 "Failed to read data size for write after error (%d != %d)\n", bytes_read,
-                                 sizeof(current_size));
-                }
-
-                /* Seek to End of Current Data */
-                seek_status = file_driver.seek(fs->write_fd, current_size, SEEK_CUR);
-                if (seek_status < 0)
+                uint8_t *commit_buffer = (uint8_t *)bplib_os_calloc(total_size);
+                if (commit_buffer == NULL)
                 {
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to jump over data for write after error\n",
-                                 seek_status);
+                    bplib_os_unlock(fs->lock);
+                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to allocate write-behind buffer of %lu bytes\n",
+                                 total_size);
                 }
+                bplib_os_free(batch->buffer);
+                batch->buffer   = commit_buffer;
+                batch->capacity = total_size;
             }
         }
-    }
-
-    /* Create Object */
-    bp_object_hdr_t object_header = {.handle = h, .sid = BP_SID_VACANT, .size = data_size};
-
-    /* Write Object Size */
-    bytes_written += file_driver.write(&object_size, 1, sizeof(object_size), fs->write_fd);
-
-    /* Write Object */
-    bytes_written += file_driver.write(&object_header, 1, sizeof(bp_object_hdr_t), fs->write_fd);
 
-    /* Write Data Buffer 1 */
-    bytes_written += file_driver.write(data1, 1, data1_size, fs->write_fd);
-
-    /* Write Data Buffer 2 */
-    bytes_written += file_driver.write(data2, 1, data2_size, fs->write_fd);
-
-    /* Flush File Data */
-    if (fs->flush_on_write)
-    {
-        int flush_status = file_driver.flush(fs->write_fd);
-        if (flush_status < 0)
+        /* Start Latency of Write-Behind Buffer */
+        if (batch->size == 0)
         {
-            bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to flush data write\n", flush_status);
-            flush_error = true;
+            fs->commit_deadline = bplib_os_get_dtntime_ms() + fs->commit_latency;
         }
-    }
 
-    /* Check Errors and Return Status */
-    if ((bytes_written != (object_size + sizeof(object_size))) || flush_error)
-    {
-        fs->write_error = true;
-        if (fs->write_fd)
+        /* Create Object */
+        bp_object_hdr_t object_header = {.handle = h, .sid = BP_SID_VACANT, .size = data_size};
+        uint8_t        *object_ptr    = &batch->buffer[batch->size];
+
+        /* Copy Object Size, Object, and Data Buffers */
+        memcpy(object_ptr, &object_size, sizeof(object_size));
+        object_ptr += sizeof(object_size);
+        memcpy(object_ptr, &object_header, sizeof(bp_object_hdr_t));
+        object_ptr += sizeof(bp_object_hdr_t);
+        if (data1_size > 0)
         {
-            file_driver.close(fs->write_fd);
-            fs->write_fd = NULL;
+            memcpy(object_ptr, data1, data1_size);
+            object_ptr += data1_size;
         }
-
-        /* Return Failure */
-        return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to write data to file (%d ?= %d)\n", bytes_written,
-                     object_size + sizeof(object_size));
-    }
-    else
-    {
-        /* Close Write File
-         *  this needs to be performed here prior to the write_data_id being
-         *  incremented because the x_data_id variables are one based instead
-         *  of zero based */
-        if (fs->write_data_id % FILE_DATA_COUNT == 0)
+        if (data2_size > 0)
         {
-            file_driver.close(fs->write_fd);
-            fs->write_fd = NULL;
+            memcpy(object_ptr, data2, data2_size);
+            object_ptr += data2_size;
         }
+        memset(object_ptr, 0, object_size - sizeof(bp_object_hdr_t) - data_size);
 
         /* Set Write State */
-        fs->write_error = false;
+        unsigned long data_offset        = GET_DATAOFFSET(GET_DATAID(fs->write_data_id));
+        fs->write_index[data_offset + 1] = fs->write_index[data_offset] + total_size;
+        batch->size += total_size;
         fs->write_data_id++;
         fs->data_count++;
-        bplib_os_signal(fs->lock);
 
-        /* Return Success */
-        return BP_SUCCESS;
+        /* Commit Write-Behind Buffer
+         *  an object that is the last one in a data file is always
+         *  committed so that the buffer never spans two files */
+        if (fs->flush_on_write || (batch->size >= fs->commit_bytes) || ((fs->write_data_id - 1) % FILE_DATA_COUNT == 0))
+        {
+            /* Object Stays in Buffer until I/O Thread can Take It, or a Failed Write is Retried */
+            commit_objects(h, fs, deadline);
+        }
+        else
+        {
+            commit_if_late(h, fs);
+        }
+
+        bplib_os_broadcast_signal(fs->lock);
     }
+    bplib_os_unlock(fs->lock);
+
+    return status;
 }
 
 /*--------------------------------------------------------------------------------------
@@ -513,168 +1780,180 @@ int bplib_store_file_dequeue(bp_handle_t h, bp_object_t **object, int timeout)
     assert(file_stores[handle].in_use);
     assert(object);
 
-    file_store_t *fs = (file_store_t *)&file_stores[handle];
+    file_store_t *fs       = (file_store_t *)&file_stores[handle];
+    uint64_t      deadline = get_deadline(timeout);
     bplib_os_lock(fs->lock);
     {
         /* Initialize Variables */
         unsigned long  bytes_read   = 0;
         unsigned long  object_size  = 0;
         unsigned char *object_ptr   = NULL;
+        file_map_t    *object_map   = NULL;
         unsigned long  cache_index  = 0;
         bool           read_success = false;
 
-        /* Get IDs */
-        unsigned long data_id     = GET_DATAID(fs->read_data_id);
-        unsigned long file_id     = GET_FILEID(data_id);
-        unsigned long data_offset = GET_DATAOFFSET(data_id);
-
         /* Check if Data Available */
-        if (fs->read_data_id == fs->write_data_id)
+        while (fs->read_data_id == fs->write_data_id)
         {
-            int wait_status = bplib_os_waiton(fs->lock, timeout);
+            int wait_status = bplib_os_wait_until_ms(fs->lock, deadline);
             if (wait_status == BP_ERROR)
             {
                 bplib_os_unlock(fs->lock);
                 return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to wait for FSS lock\n", wait_status);
             }
-            else if ((wait_status == BP_TIMEOUT) || (fs->read_data_id == fs->write_data_id))
+            else if ((wait_status == BP_TIMEOUT) && (fs->read_data_id == fs->write_data_id))
             {
+                commit_if_late(h, fs);
                 bplib_os_unlock(fs->lock);
                 return BP_TIMEOUT;
             }
         }
 
-        /* Check Need to Open Read File */
-        if (fs->read_fd == NULL)
+        /* Commit Write-Behind Buffer if Next Object is Not Yet Written */
+        if (fs->read_data_id >= fs->commit_data_id)
         {
-            /* Open Read File */
-            fs->read_fd = open_dat_file(fs->service_id, fs->file_root, file_id, true);
-            if (fs->read_fd == NULL)
+            int commit_status = sync_objects(h, fs, fs->read_data_id + 1, deadline);
+            if (commit_status != BP_SUCCESS)
             {
                 bplib_os_unlock(fs->lock);
-                return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to dequeue data\n");
+                return commit_status;
             }
         }
+        else
+        {
+            commit_if_late(h, fs);
+        }
+
+        /* Get IDs */
+        unsigned long data_id     = GET_DATAID(fs->read_data_id);
+        unsigned long file_id     = GET_FILEID(data_id);
+        unsigned long data_offset = GET_DATAOFFSET(data_id);
 
-        /* Seek to Current Position */
-        if (fs->read_error)
+        /* Take Object Read Ahead, or Map it from Full Data File */
+        object_ptr = take_prefetched(fs, data_id);
+        if (object_ptr == NULL)
         {
-            /* Start at Beginning of File */
-            int seek_status = file_driver.seek(fs->read_fd, 0, SEEK_SET);
-            if (seek_status < 0)
+            object_ptr = map_object(fs, data_id, true, &object_map);
+        }
+        if (object_ptr != NULL)
+        {
+            bp_object_hdr_t *dequeued_object_header = (bp_object_hdr_t *)object_ptr;
+            dequeued_object_header->sid             = (bp_sid_t)fs->read_data_id;
+        }
+        else
+        {
+            /* Check Need to Open Read File */
+            if (fs->read_fd == NULL)
             {
-                bplib_os_unlock(fs->lock);
-                return bplog(NULL, BP_FLAG_STORE_FAILURE,
-                             "Failed (%d) to set read position after error to start of file\n", seek_status);
+                /* Open Read File */
+                fs->read_fd = open_dat_file(fs->service_id, fs->file_root, file_id, "rb");
+                if (fs->read_fd == NULL)
+                {
+                    bplib_os_unlock(fs->lock);
+                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to dequeue data\n");
+                }
+                fs->read_fd_data_id = data_id - data_offset;
             }
 
-            /* Read/Seek Through File */
-            unsigned int pos;
-            for (pos = 0; pos < data_offset; pos++)
+            /* Seek to Current Position
+             *  needed after a read error, or when objects were taken from a mapping */
+            if (fs->read_fd_data_id != data_id)
             {
-                unsigned long current_size;
-
-                /* Read Current Object Size */
-                bytes_read = file_driver.read(&current_size, 1, sizeof(current_size), fs->read_fd);
-                if (bytes_read != sizeof(current_size))
+                unsigned long *file_index = get_file_index(fs, fs->read_fd, file_id);
+                if (file_index == NULL)
                 {
                     bplib_os_unlock(fs->lock);
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE,
-                                 "Failed to read data size for read after error (%d != %d)\n", bytes_read,
-                                 sizeof(current_size));
+                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to get read position\n");
                 }
 
-                /* Seek to End of Current Data */
-                seek_status = file_driver.seek(fs->read_fd, current_size, SEEK_CUR);
+                int seek_status = file_driver.seek(fs->read_fd, file_index[data_offset], SEEK_SET);
                 if (seek_status < 0)
                 {
                     bplib_os_unlock(fs->lock);
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to jump over data for read after error\n",
-                                 seek_status);
+                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to set read position\n", seek_status);
                 }
             }
-        }
 
-        /* Read Data */
-        bytes_read = file_driver.read(&object_size, 1, sizeof(object_size), fs->read_fd);
-        if (bytes_read == sizeof(object_size))
-        {
-            object_ptr = (unsigned char *)bplib_os_calloc(object_size);
-            bytes_read = file_driver.read(object_ptr, 1, object_size, fs->read_fd);
-            if (bytes_read == object_size)
+            /* Read Data */
+            bytes_read = file_driver.read(&object_size, 1, sizeof(object_size), fs->read_fd);
+            if (bytes_read == sizeof(object_size))
             {
-                /* Update SID */
-                bp_object_hdr_t *dequeued_object_header = (bp_object_hdr_t *)object_ptr;
-                dequeued_object_header->sid             = (bp_sid_t)fs->read_data_id;
-                read_success                            = true;
+                object_ptr = (unsigned char *)bplib_os_calloc(object_size);
+                bytes_read = file_driver.read(object_ptr, 1, object_size, fs->read_fd);
+                if (bytes_read == object_size)
+                {
+                    /* Update SID */
+                    bp_object_hdr_t *dequeued_object_header = (bp_object_hdr_t *)object_ptr;
+                    dequeued_object_header->sid             = (bp_sid_t)fs->read_data_id;
+                    fs->read_fd_data_id                     = data_id + 1;
+                    read_success                            = true;
+                }
             }
-        }
-
-        /* Check for Read Errors */
-        if (!read_success)
-        {
-            /* Set Error State */
-            fs->read_error = true;
 
-            /* Close Read File */
-            if (fs->read_fd)
+            /* Check for Read Errors */
+            if (!read_success)
             {
-                file_driver.close(fs->read_fd);
-                fs->read_fd = NULL;
-            }
+                /* Close Read File */
+                if (fs->read_fd)
+                {
+                    file_driver.close(fs->read_fd);
+                    fs->read_fd = NULL;
+                }
 
-            /* Free Object Pointer */
-            if (object_ptr)
-                bplib_os_free(object_ptr);
+                /* Free Object Pointer */
+                if (object_ptr)
+                    bplib_os_free(object_ptr);
 
-            /* Return Failure */
-            bplib_os_unlock(fs->lock);
-            return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to read data from file\n", bytes_read);
+                /* Return Failure */
+                bplib_os_unlock(fs->lock);
+                return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%lu) to read data from file\n", bytes_read);
+            }
         }
 
         /* Check State of Data Cache */
         cache_index = data_id % fs->cache_size;
-        if (fs->data_cache[cache_index].mem_locked)
+        while (fs->data_cache[cache_index].mem_locked)
         {
-            int wait_status = bplib_os_waiton(fs->lock, timeout);
+            int wait_status = bplib_os_wait_until_ms(fs->lock, deadline);
             if (wait_status == BP_ERROR)
             {
-                bplib_os_free(object_ptr);
+                free_object(object_ptr, object_map);
                 bplib_os_unlock(fs->lock);
                 return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to get lock to update cache\n", wait_status);
             }
-            else if ((wait_status == BP_TIMEOUT) || (fs->data_cache[cache_index].mem_locked))
+            else if ((wait_status == BP_TIMEOUT) && (fs->data_cache[cache_index].mem_locked))
             {
-                bplib_os_free(object_ptr);
+                free_object(object_ptr, object_map);
                 bplib_os_unlock(fs->lock);
                 return BP_TIMEOUT;
             }
         }
 
         /* Free Previous Entry in Data Cache */
-        if (fs->data_cache[cache_index].mem_ptr)
-        {
-            bplib_os_free(fs->data_cache[cache_index].mem_ptr);
-        }
+        free_object(fs->data_cache[cache_index].mem_ptr, fs->data_cache[cache_index].mem_map);
 
         /* Update Data Cache */
         fs->data_cache[cache_index].mem_locked  = FILE_MEM_LOCKED;
         fs->data_cache[cache_index].mem_ptr     = object_ptr;
         fs->data_cache[cache_index].mem_data_id = data_id;
+        fs->data_cache[cache_index].mem_map     = object_map;
 
         /* Check Need to Open New File
          *  this needs to be performed here prior to the read_data_id being
          *  incremented because the x_data_id variables are one based instead
          *  of zero based */
-        if (fs->read_data_id % FILE_DATA_COUNT == 0)
+        if (fs->read_data_id % FILE_DATA_COUNT == 0 && fs->read_fd != NULL)
         {
             file_driver.close(fs->read_fd);
             fs->read_fd = NULL;
         }
 
         /* Set Read State */
-        fs->read_error = false;
         fs->read_data_id++;
+        if (fs->prefetch != NULL)
+        {
+            bplib_os_broadcast_signal(fs->lock);
+        }
 
         /* Return Object */
         *object = (bp_object_t *)object_ptr;
@@ -692,13 +1971,12 @@ int bplib_store_file_retrieve(bp_handle_t h, bp_sid_t sid, bp_object_t **object,
 {
     int handle = bp_handle_to_serial(h, BPLIB_HANDLE_FILE_STORE_BASE);
 
-    (void)timeout;
-
     assert(handle >= 0 && handle < FILE_MAX_STORES);
     assert(file_stores[handle].in_use);
     assert(object);
 
-    file_store_t *fs = (file_store_t *)&file_stores[handle];
+    file_store_t *fs       = (file_store_t *)&file_stores[handle];
+    uint64_t      deadline = get_deadline(timeout);
     bplib_os_lock(fs->lock);
     {
         /* Initialize Variables */
@@ -706,16 +1984,16 @@ int bplib_store_file_retrieve(bp_handle_t h, bp_sid_t sid, bp_object_t **object,
         unsigned long  object_size      = 0;
         unsigned char *object_ptr       = NULL;
         unsigned long  cache_index      = 0;
-        long           offset_delta     = 0;
+        unsigned long *file_index       = NULL;
+        file_map_t    *object_map       = NULL;
         bool           retrieve_success = false;
 
         /* Get IDs */
-        unsigned long data_id          = GET_DATAID(sid);
-        unsigned long file_id          = GET_FILEID(data_id);
-        unsigned long data_offset      = GET_DATAOFFSET(data_id);
-        unsigned long prev_data_id     = GET_DATAID(fs->retrieve_data_id);
-        unsigned long prev_file_id     = GET_FILEID(prev_data_id);
-        unsigned long prev_data_offset = GET_DATAOFFSET(prev_data_id);
+        unsigned long data_id      = GET_DATAID(sid);
+        unsigned long file_id      = GET_FILEID(data_id);
+        unsigned long data_offset  = GET_DATAOFFSET(data_id);
+        unsigned long prev_data_id = GET_DATAID(fs->retrieve_data_id);
+        unsigned long prev_file_id = GET_FILEID(prev_data_id);
 
         /* Check Data Cache */
         cache_index = data_id % fs->cache_size;
@@ -730,135 +2008,119 @@ int bplib_store_file_retrieve(bp_handle_t h, bp_sid_t sid, bp_object_t **object,
             }
         }
 
-        /* Check Need to Open New Retrieve File */
-        if (file_id != prev_file_id)
-        {
-            if (fs->retrieve_fd)
-            {
-                file_driver.close(fs->retrieve_fd);
-                fs->retrieve_fd = NULL;
-            }
-        }
-
-        /* Check Need to Open Retrieve File */
-        if (fs->retrieve_fd == NULL)
+        /* Map Object from Full Data File */
+        object_ptr = map_object(fs, data_id, false, &object_map);
+        if (object_ptr != NULL)
         {
-            /* Open Retrieve File */
-            fs->retrieve_fd = open_dat_file(fs->service_id, fs->file_root, file_id, true);
-            if (fs->retrieve_fd == NULL)
-            {
-                bplib_os_unlock(fs->lock);
-                return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to retrieve data\n");
-            }
+            bp_object_hdr_t *retrieved_object_header = (bp_object_hdr_t *)object_ptr;
+            retrieved_object_header->sid             = sid;
         }
         else
         {
-            /* Set Delta from Current Position in File */
-            offset_delta = data_offset - prev_data_offset;
-            if (offset_delta < 0)
+            /* Check Need to Open New Retrieve File */
+            if (file_id != prev_file_id)
             {
-                /* Handling Seeking Backwards */
-                offset_delta    = data_offset;
-                int seek_status = file_driver.seek(fs->retrieve_fd, 0, SEEK_SET);
-                if (seek_status < 0)
+                if (fs->retrieve_fd)
                 {
-                    bplib_os_unlock(fs->lock);
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to set retrieve position to start of file\n",
-                                 seek_status);
+                    file_driver.close(fs->retrieve_fd);
+                    fs->retrieve_fd = NULL;
                 }
             }
-        }
 
-        /* Seek Forward */
-        if (offset_delta > 0)
-        {
-            unsigned long current_size;
-            long          pos;
-
-            for (pos = 0; pos < offset_delta; pos++)
+            /* Check Need to Open Retrieve File */
+            if (fs->retrieve_fd == NULL)
             {
-                /* Read Current Data Size */
-                bytes_read = file_driver.read(&current_size, 1, sizeof(current_size), fs->retrieve_fd);
-                if (bytes_read != sizeof(current_size))
-                {
-                    bplib_os_unlock(fs->lock);
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to read data size on retrieval (%d != %d)\n",
-                                 bytes_read, sizeof(current_size));
-                }
-
-                /* Seek to End of Current Data */
-                int seek_status = file_driver.seek(fs->retrieve_fd, current_size, SEEK_CUR);
-                if (seek_status < 0)
+                /* Open Retrieve File */
+                fs->retrieve_fd = open_dat_file(fs->service_id, fs->file_root, file_id, "rb");
+                if (fs->retrieve_fd == NULL)
                 {
                     bplib_os_unlock(fs->lock);
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to jump to end of data on retrieval\n",
-                                 seek_status);
+                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to retrieve data\n");
                 }
             }
-        }
 
-        /* Read Data */
-        bytes_read = file_driver.read(&object_size, 1, sizeof(object_size), fs->retrieve_fd);
-        if (bytes_read == sizeof(object_size))
-        {
-            object_ptr = (unsigned char *)bplib_os_calloc(object_size);
-            bytes_read = file_driver.read(object_ptr, 1, object_size, fs->retrieve_fd);
-            if (bytes_read == object_size)
+            /* Seek to Object */
+            file_index = get_file_index(fs, fs->retrieve_fd, file_id);
+            if (file_index == NULL)
             {
-                bp_object_hdr_t *retrieved_object_header = (bp_object_hdr_t *)object_ptr;
-                retrieved_object_header->sid             = sid;
-                fs->retrieve_data_id                     = (unsigned long)sid;
-                retrieve_success                         = true;
+                bplib_os_unlock(fs->lock);
+                return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to get position of data on retrieval\n");
             }
-        }
 
-        /* Check Success */
-        if (!retrieve_success)
-        {
-            bplib_os_free(object_ptr);
+            long object_pos  = file_index[data_offset] + sizeof(object_size);
+            int  seek_status = file_driver.seek(fs->retrieve_fd, object_pos, SEEK_SET);
+            if (seek_status < 0)
+            {
+                bplib_os_unlock(fs->lock);
+                return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to set retrieve position\n", seek_status);
+            }
 
-            /* Close Read File */
-            if (fs->retrieve_fd)
+            /* Read Data
+             *  an object that compaction left out has no size */
+            object_size = file_index[data_offset + 1] - file_index[data_offset] - sizeof(object_size);
+            object_ptr  = NULL;
+            if (file_index[data_offset + 1] - file_index[data_offset] >= sizeof(object_size) + sizeof(bp_object_hdr_t))
+            {
+                object_ptr = (unsigned char *)bplib_os_calloc(object_size);
+            }
+            if (object_ptr != NULL)
             {
-                file_driver.close(fs->retrieve_fd);
-                fs->retrieve_fd = NULL;
+                bytes_read = file_driver.read(object_ptr, 1, object_size, fs->retrieve_fd);
+                if (bytes_read == object_size)
+                {
+                    bp_object_hdr_t *retrieved_object_header = (bp_object_hdr_t *)object_ptr;
+                    retrieved_object_header->sid             = sid;
+                    fs->retrieve_data_id                     = (unsigned long)sid;
+                    retrieve_success                         = true;
+                }
             }
 
-            /* Return Failure */
-            bplib_os_unlock(fs->lock);
-            return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to retrieve data from file\n", bytes_read);
+            /* Check Success */
+            if (!retrieve_success)
+            {
+                bplib_os_free(object_ptr);
+
+                /* Close Read File */
+                if (fs->retrieve_fd)
+                {
+                    file_driver.close(fs->retrieve_fd);
+                    fs->retrieve_fd = NULL;
+                }
+
+                /* Return Failure */
+                bplib_os_unlock(fs->lock);
+                return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%lu) to retrieve data from file\n", bytes_read);
+            }
         }
 
         /* Check State of Data Cache */
         cache_index = data_id % fs->cache_size;
-        if (fs->data_cache[cache_index].mem_locked)
+        while (fs->data_cache[cache_index].mem_locked)
         {
-            int wait_status = bplib_os_waiton(fs->lock, timeout);
+            int wait_status = bplib_os_wait_until_ms(fs->lock, deadline);
             if (wait_status == BP_ERROR)
             {
-                bplib_os_free(object_ptr);
+                free_object(object_ptr, object_map);
                 bplib_os_unlock(fs->lock);
                 return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to update data cache on retrieval\n",
                              wait_status);
             }
-            else if ((wait_status == BP_TIMEOUT) || (fs->data_cache[cache_index].mem_locked))
+            else if ((wait_status == BP_TIMEOUT) && (fs->data_cache[cache_index].mem_locked))
             {
-                bplib_os_free(object_ptr);
+                free_object(object_ptr, object_map);
                 bplib_os_unlock(fs->lock);
                 return BP_TIMEOUT;
             }
         }
 
         /* Free Previous Entry in Data Cache */
-        if (fs->data_cache[cache_index].mem_ptr)
-        {
-            bplib_os_free(fs->data_cache[cache_index].mem_ptr);
-        }
+        free_object(fs->data_cache[cache_index].mem_ptr, fs->data_cache[cache_index].mem_map);
 
         /* Update Data Cache */
         fs->data_cache[cache_index].mem_locked  = FILE_MEM_LOCKED;
         fs->data_cache[cache_index].mem_ptr     = object_ptr;
         fs->data_cache[cache_index].mem_data_id = data_id;
+        fs->data_cache[cache_index].mem_map     = object_map;
 
         /* Return Object */
         *object = (bp_object_t *)object_ptr;
@@ -897,7 +2159,11 @@ int bplib_store_file_release(bp_handle_t h, bp_sid_t sid)
 
         /* Unlock Cache Entry */
         fs->data_cache[cache_index].mem_locked = FILE_MEM_AVAIABLE;
-        bplib_os_signal(fs->lock);
+        if (fs->data_cache[cache_index].mem_map)
+        {
+            drop_object_pages(fs->data_cache[cache_index].mem_ptr);
+        }
+        bplib_os_broadcast_signal(fs->lock);
     }
     bplib_os_unlock(fs->lock);
 
@@ -931,7 +2197,8 @@ int bplib_store_file_relinquish(bp_handle_t h, bp_sid_t sid)
         {
             if (fs->data_cache[cache_index].mem_data_id == data_id)
             {
-                bplib_os_free(fs->data_cache[cache_index].mem_ptr);
+                free_object(fs->data_cache[cache_index].mem_ptr, fs->data_cache[cache_index].mem_map);
+                fs->data_cache[cache_index].mem_map     = NULL;
                 fs->data_cache[cache_index].mem_ptr     = NULL;
                 fs->data_cache[cache_index].mem_data_id = BP_SID_VACANT;
                 fs->data_cache[cache_index].mem_locked  = FILE_MEM_AVAIABLE;
@@ -944,8 +2211,9 @@ int bplib_store_file_relinquish(bp_handle_t h, bp_sid_t sid)
             /* Set Current Relinquish Table */
             fs->relinquish_data_id = (unsigned long)sid;
 
-            /* Check Need to Save Off Previous Relinquish Table */
-            if (fs->relinquish_table.free_cnt > 0)
+            /* Check Need to Save Off Previous Relinquish Table
+             *  not once all of its objects are freed, as the file is deleted */
+            if (fs->relinquish_table.free_cnt > 0 && fs->relinquish_table.free_cnt < FILE_DATA_COUNT)
             {
                 /* Open Previous Relinquish File */
                 if (fs->relinquish_fd == NULL)
@@ -970,8 +2238,8 @@ int bplib_store_file_relinquish(bp_handle_t h, bp_sid_t sid)
                 if (bytes_written != sizeof(fs->relinquish_table))
                 {
                     bplib_os_unlock(fs->lock);
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to update relinquish table (%d != %d)\n",
-                                 bytes_written, sizeof(fs->relinquish_table));
+                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to update relinquish table (%lu != %lu)\n",
+                                 bytes_written, (unsigned long)sizeof(fs->relinquish_table));
                 }
             }
 
@@ -996,8 +2264,8 @@ int bplib_store_file_relinquish(bp_handle_t h, bp_sid_t sid)
                 if (bytes_read != sizeof(fs->relinquish_table))
                 {
                     bplib_os_unlock(fs->lock);
-                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to read new relinquish table (%d != %d)\n",
-                                 bytes_read, sizeof(fs->relinquish_table));
+                    return bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to read new relinquish table (%lu != %lu)\n",
+                                 bytes_read, (unsigned long)sizeof(fs->relinquish_table));
                 }
             }
         }
@@ -1011,6 +2279,11 @@ int bplib_store_file_relinquish(bp_handle_t h, bp_sid_t sid)
 
             /* Relinquish Resources */
             fs->relinquish_table.free_cnt++;
+            if (fs->compact_live_percent > 0 && !fs->compact_wanted)
+            {
+                fs->compact_wanted = true;
+                bplib_os_broadcast_signal(fs->lock);
+            }
             if (fs->relinquish_table.free_cnt == FILE_DATA_COUNT)
             {
                 /* Delete Associated Files
@@ -1020,6 +2293,32 @@ int bplib_store_file_relinquish(bp_handle_t h, bp_sid_t sid)
                  *  not need to be saved off */
                 delete_tbl_file(fs->service_id, fs->file_root, file_id);
                 int dat_status = delete_dat_file(fs->service_id, fs->file_root, file_id);
+                if (fs->read_index.file_id == file_id)
+                {
+                    fs->read_index.valid = false;
+                }
+
+                /* Stop Compaction of Deleted File */
+                if (fs->compact.active && fs->compact.file_id == file_id)
+                {
+                    fs->compact.aborted = true;
+                }
+                if (fs->compact_first_id == file_id)
+                {
+                    fs->compact_first_id++;
+                }
+
+                /* Unmap Deleted File */
+                int m;
+                for (m = 0; m < FILE_MAX_MAPS; m++)
+                {
+                    if (fs->file_maps[m].addr != NULL && fs->file_maps[m].file_id == file_id &&
+                        fs->file_maps[m].refs == 0)
+                    {
+                        bplib_os_unmapfile(fs->file_maps[m].addr, fs->file_maps[m].size);
+                        fs->file_maps[m].addr = NULL;
+                    }
+                }
                 if (dat_status < 0)
                 {
                     bplib_os_unlock(fs->lock);
@@ -1048,3 +2347,23 @@ int bplib_store_file_getcount(bp_handle_t h)
 
     return fs->data_count;
 }
+
+/*--------------------------------------------------------------------------------------
+ * bplib_store_file_commit -
+ *-------------------------------------------------------------------------------------*/
+int bplib_store_file_commit(bp_handle_t h)
+{
+    int handle = bp_handle_to_serial(h, BPLIB_HANDLE_FILE_STORE_BASE);
+
+    assert(handle >= 0 && handle < FILE_MAX_STORES);
+    assert(file_stores[handle].in_use);
+
+    file_store_t *fs = &file_stores[handle];
+
+    bplib_os_lock(fs->lock);
+    unsigned long end_data_id = fs->write_data_id;
+    int           status      = sync_objects(h, fs, end_data_id, BP_DTNTIME_INFINITE);
+    bplib_os_unlock(fs->lock);
+
+    return status;
+}
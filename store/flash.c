@@ -37,6 +37,12 @@
 #define FLASH_OBJECT_SYNC_HI 0x42502046
 #define FLASH_OBJECT_SYNC_LO 0x4C415348
 
+#define FLASH_WEAR_BUCKETS 64 /* free lists by erase count, starting at the least worn free block */
+
+#if FLASH_MAX_WEAR_GAP >= FLASH_WEAR_BUCKETS
+#error "FLASH_MAX_WEAR_GAP must be less than FLASH_WEAR_BUCKETS"
+#endif
+
 /******************************************************************************
  MACROS
  ******************************************************************************/
@@ -60,8 +66,16 @@ typedef struct
 {
     bp_flash_index_t next_block;
     bp_flash_index_t pages_in_use;
+    uint32_t         erase_count; /* kept across allocations for wear leveling */
+    unsigned long    alloc_time;  /* system time the block was last allocated */
 } flash_block_control_t;
 
+typedef struct
+{
+    const uint8_t *data; /* NULL data is written as zeros */
+    int            size;
+} flash_segment_t;
+
 typedef struct
 {
     bp_flash_index_t out;
@@ -69,6 +83,14 @@ typedef struct
     int              count;
 } flash_block_list_t;
 
+typedef struct
+{
+    flash_block_list_t buckets[FLASH_WEAR_BUCKETS]; /* blocks erased base_count + n times, at that count mod size */
+    flash_block_list_t overflow;                    /* blocks erased more times than the buckets hold */
+    uint32_t           base_count;                  /* no free block has been erased fewer times */
+    int                count;
+} flash_free_table_t;
+
 typedef struct
 {
     bool             in_use;
@@ -80,8 +102,7 @@ typedef struct
     bp_flash_addr_t  write_addr;
     bp_flash_addr_t  read_addr;
     bp_flash_index_t active_block;
-    uint8_t         *write_stage; /* holding buffer to construct data object before write */
-    uint8_t         *read_stage;  /* lockable buffer that holds data object for read */
+    uint8_t         *read_stage; /* lockable buffer that holds data object for read */
     bool             stage_locked;
     int              object_count;
     int              inactive_count;
@@ -96,18 +117,20 @@ typedef struct
 static bp_flash_driver_t FLASH_DRIVER;             /* function pointers and meta data needed to use flash */
 static int               FLASH_PAGE_DATA_SIZE = 0; /* size in bytes of data being written to page */
 static int               FLASH_ECC_CODE_SIZE  = 0; /* size in bytes of encoding */
+static int               FLASH_BATCH_PAGES    = 1; /* max pages passed to the driver at a time */
 
 /* Globals */
 
 static flash_store_t      flash_stores[FLASH_MAX_STORES]; /* available set of storage service control structures */
-static flash_block_list_t flash_free_blocks;              /* linked list of flash blocks available for use */
+static flash_free_table_t flash_free_blocks;              /* lists of flash blocks available for use, by wear */
 static flash_block_list_t flash_fail_blocks; /* linked list of flash blocks that have failed during runtime use */
 
 static bp_handle_t            flash_device_lock = {0};  /* mutex for accessing flash control structures */
 static flash_block_control_t *flash_blocks      = NULL; /* memory array of per block meta data, one per flash block */
 static int      flash_error_count      = 0; /* total number of flash errors encountered across all storage services */
 static int      flash_used_block_count = 0; /* total number of flash blocks currently in use by all storage services */
-static uint8_t *flash_page_buffer      = NULL; /* memory buffer used for ECC and for object deletes */
+static uint8_t *flash_page_buffer      = NULL; /* memory buffer used to decode pages being read */
+static uint8_t *flash_write_buffer     = NULL; /* memory buffer used to encode pages being written */
 
 /******************************************************************************
  LOCAL FUNCTIONS - UTILITY
@@ -139,83 +162,98 @@ BP_LOCAL_SCOPE const char *type2str(int type)
  ******************************************************************************/
 
 /*--------------------------------------------------------------------------------------
- * flash_page_write -
+ * flash_pages_write - count consecutive pages of one block, packed page_size apart
  *-------------------------------------------------------------------------------------*/
-BP_LOCAL_SCOPE int flash_page_write(bp_flash_addr_t addr, uint8_t *data, int size)
+BP_LOCAL_SCOPE int flash_pages_write(bp_flash_addr_t addr, uint8_t *pages, int count)
 {
-    assert(size <= FLASH_PAGE_DATA_SIZE);
+    assert(count <= FLASH_BATCH_PAGES);
+    assert(addr.page + count <= FLASH_DRIVER.pages_per_block);
 
-    if (FLASH_ECC_CODE_SIZE > 0)
+    int status = BP_SUCCESS;
+    int p;
+
+    if (FLASH_DRIVER.write_pages)
     {
-        memcpy(flash_page_buffer, data, size);
-        lrc_encode(flash_page_buffer, FLASH_PAGE_DATA_SIZE);
-        return FLASH_DRIVER.write(addr, flash_page_buffer);
+        return FLASH_DRIVER.write_pages(addr, pages, count);
     }
-    else
+
+    for (p = 0; p < count; p++)
     {
-        return FLASH_DRIVER.write(addr, data);
+        int page_status = FLASH_DRIVER.write(addr, &pages[p * FLASH_DRIVER.page_size]);
+        if (page_status != BP_SUCCESS)
+        {
+            status = page_status;
+        }
+        addr.page++;
     }
+
+    return status;
 }
 
 /*--------------------------------------------------------------------------------------
- * flash_page_read -
+ * flash_pages_read - count consecutive pages of one block, packed page_size apart
  *-------------------------------------------------------------------------------------*/
-BP_LOCAL_SCOPE int flash_page_read(bp_flash_addr_t addr, uint8_t *data, int size)
+BP_LOCAL_SCOPE int flash_pages_read(bp_flash_addr_t addr, uint8_t *pages, int count)
 {
-    assert(size <= FLASH_PAGE_DATA_SIZE);
+    assert(count <= FLASH_BATCH_PAGES);
+    assert(addr.page + count <= FLASH_DRIVER.pages_per_block);
 
-    int status;
+    int status = BP_SUCCESS;
+    int p;
 
-    if (FLASH_ECC_CODE_SIZE > 0)
+    if (FLASH_DRIVER.read_pages)
     {
-        status = FLASH_DRIVER.read(addr, flash_page_buffer);
-        if (status == BP_SUCCESS)
-        {
-            int decode_status = lrc_decode(flash_page_buffer, FLASH_PAGE_DATA_SIZE);
-            if (decode_status == BP_ECC_NO_ERRORS)
-            {
-                status = BP_SUCCESS;
-            }
-            else if (decode_status == BP_ECC_COR_ERRORS)
-            {
-                bplog(NULL, BP_FLAG_STORE_FAILURE, "Single-bit error corrected at %d.%d\n",
-                      FLASH_DRIVER.phyblk(addr.block), addr.page);
-                status = BP_SUCCESS;
-            }
-            else /* decode_status == BP_ECC_UNCOR_ERRORS */
-            {
-                bplog(NULL, BP_FLAG_STORE_FAILURE, "Multiple-bit error detected at %d.%d\n",
-                      FLASH_DRIVER.phyblk(addr.block), addr.page);
-                status = BP_ERROR;
-            }
+        return FLASH_DRIVER.read_pages(addr, pages, count);
+    }
 
-            /*
-             * Inside flash_object_delete, the flash_page_buffer is used to read the first
-             * page of an object - this is a shortcut so that the code doesn't need to allocate
-             * a separate buffer just to read the beginning of the object.  It is the only
-             * time in the code when this is done, and it is hardcoded to only read one page
-             * and have the offset into the flash_page_buffer be zero.
-             *
-             * When this occurs, we not only don't need to copy the contents out of the flash_page_buffer
-             * since the "data" pointer already points to it, but on many architectures, calling
-             * memcpy with overlapping address ranges causes an exception.
-             *
-             * Note that there is no case in the code where the data buffer is pointing to a location
-             * in memory that overlaps with the flash_page_buffer; so the check for equivalence is
-             * sufficient.
-             */
-            if (data != flash_page_buffer)
-            {
-                memcpy(data, flash_page_buffer, size);
-            }
+    for (p = 0; p < count; p++)
+    {
+        int page_status = FLASH_DRIVER.read(addr, &pages[p * FLASH_DRIVER.page_size]);
+        if (page_status != BP_SUCCESS)
+        {
+            status = page_status;
         }
+        addr.page++;
     }
-    else
+
+    return status;
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_page_decode - checks and corrects a page read with software ECC
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int flash_page_decode(bp_flash_addr_t addr, uint8_t *page)
+{
+    int decode_status = lrc_decode(page, FLASH_PAGE_DATA_SIZE);
+    if (decode_status == BP_ECC_NO_ERRORS)
     {
-        status = FLASH_DRIVER.read(addr, data);
+        return BP_SUCCESS;
     }
+    else if (decode_status == BP_ECC_COR_ERRORS)
+    {
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "Single-bit error corrected at %d.%d\n", FLASH_DRIVER.phyblk(addr.block),
+              addr.page);
+        return BP_SUCCESS;
+    }
+    else /* decode_status == BP_ECC_UNCOR_ERRORS */
+    {
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "Multiple-bit error detected at %d.%d\n", FLASH_DRIVER.phyblk(addr.block),
+              addr.page);
+        return BP_ERROR;
+    }
+}
 
-    return status;
+/*--------------------------------------------------------------------------------------
+ * flash_write_wait - waits for pages still programming after an asynchronous write
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void flash_write_wait(bp_flash_addr_t start_addr)
+{
+    if (FLASH_DRIVER.write_wait && (FLASH_DRIVER.write_wait() != BP_SUCCESS))
+    {
+        flash_error_count++;
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "Error encountered writing data to flash starting at address: %d.%d\n",
+              FLASH_DRIVER.phyblk(start_addr.block), start_addr.page);
+    }
 }
 
 /******************************************************************************
@@ -243,6 +281,210 @@ BP_LOCAL_SCOPE void flash_block_list_add(flash_block_list_t *list, bp_flash_inde
     list->count++;
 }
 
+/*--------------------------------------------------------------------------------------
+ * flash_block_list_pop - removes the first block of the list
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE bp_flash_index_t flash_block_list_pop(flash_block_list_t *list)
+{
+    bp_flash_index_t block = list->out;
+
+    if (block != BP_FLASH_INVALID_INDEX)
+    {
+        list->out = flash_blocks[block].next_block;
+        if (list->out == BP_FLASH_INVALID_INDEX)
+        {
+            list->in = BP_FLASH_INVALID_INDEX;
+        }
+
+        list->count--;
+        flash_blocks[block].next_block = BP_FLASH_INVALID_INDEX;
+    }
+
+    return block;
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_block_list_move - appends all the blocks of one list to another
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void flash_block_list_move(flash_block_list_t *list, flash_block_list_t *from_list)
+{
+    if (from_list->out != BP_FLASH_INVALID_INDEX)
+    {
+        if (list->out == BP_FLASH_INVALID_INDEX)
+        {
+            list->out = from_list->out;
+        }
+        else
+        {
+            flash_blocks[list->in].next_block = from_list->out;
+        }
+
+        list->in = from_list->in;
+        list->count += from_list->count;
+
+        from_list->out   = BP_FLASH_INVALID_INDEX;
+        from_list->in    = BP_FLASH_INVALID_INDEX;
+        from_list->count = 0;
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_free_bucket - free list of blocks erased erase_count times, NULL if in overflow
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE flash_block_list_t *flash_free_bucket(uint32_t erase_count)
+{
+    if (erase_count - flash_free_blocks.base_count >= FLASH_WEAR_BUCKETS)
+    {
+        return NULL;
+    }
+
+    return &flash_free_blocks.buckets[erase_count % FLASH_WEAR_BUCKETS];
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_free_add - adds a block to the end of the free list for its erase count
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void flash_free_add(bp_flash_index_t block)
+{
+    uint32_t erase_count = flash_blocks[block].erase_count;
+
+    /* Start Buckets at Less Worn Block
+     *  the buckets for the most worn blocks no longer fit, so they go to overflow */
+    if (flash_free_blocks.count == 0)
+    {
+        flash_free_blocks.base_count = erase_count;
+    }
+    else if (erase_count < flash_free_blocks.base_count)
+    {
+        uint32_t shift = flash_free_blocks.base_count - erase_count;
+        while (shift-- > 0 && flash_free_blocks.overflow.count < flash_free_blocks.count)
+        {
+            flash_free_blocks.base_count--;
+            flash_block_list_move(&flash_free_blocks.overflow,
+                                  &flash_free_blocks.buckets[flash_free_blocks.base_count % FLASH_WEAR_BUCKETS]);
+        }
+        flash_free_blocks.base_count = erase_count;
+    }
+
+    /* Add Block */
+    flash_block_list_t *list = flash_free_bucket(erase_count);
+    flash_blocks[block].next_block = BP_FLASH_INVALID_INDEX;
+    flash_block_list_add(list ? list : &flash_free_blocks.overflow, block);
+    flash_free_blocks.count++;
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_free_settle - moves the buckets up to the least worn free block
+ *
+ *  blocks in overflow that then fit in the buckets are moved into them, in order
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void flash_free_settle(void)
+{
+    flash_block_list_t *overflow   = &flash_free_blocks.overflow;
+    uint32_t            base_count = flash_free_blocks.base_count;
+    bp_flash_index_t    prev_block = BP_FLASH_INVALID_INDEX;
+    bp_flash_index_t    block;
+
+    /* Find Least Worn Free Block */
+    if (flash_free_blocks.count == overflow->count)
+    {
+        base_count = UINT32_MAX;
+        for (block = overflow->out; block != BP_FLASH_INVALID_INDEX; block = flash_blocks[block].next_block)
+        {
+            if (flash_blocks[block].erase_count < base_count)
+            {
+                base_count = flash_blocks[block].erase_count;
+            }
+        }
+    }
+    else
+    {
+        while (flash_free_blocks.buckets[base_count % FLASH_WEAR_BUCKETS].out == BP_FLASH_INVALID_INDEX)
+        {
+            base_count++;
+        }
+    }
+
+    if (base_count == flash_free_blocks.base_count)
+    {
+        return;
+    }
+
+    /* Move Buckets */
+    flash_free_blocks.base_count = base_count;
+
+    /* Move Overflow Blocks that Fit */
+    block = overflow->out;
+    while (block != BP_FLASH_INVALID_INDEX)
+    {
+        bp_flash_index_t    next_block = flash_blocks[block].next_block;
+        flash_block_list_t *list       = flash_free_bucket(flash_blocks[block].erase_count);
+        if (list)
+        {
+            /* Unlink from Overflow */
+            if (prev_block == BP_FLASH_INVALID_INDEX)
+            {
+                overflow->out = next_block;
+            }
+            else
+            {
+                flash_blocks[prev_block].next_block = next_block;
+            }
+
+            if (overflow->in == block)
+            {
+                overflow->in = prev_block;
+            }
+
+            overflow->count--;
+
+            /* Add to Bucket */
+            flash_blocks[block].next_block = BP_FLASH_INVALID_INDEX;
+            flash_block_list_add(list, block);
+        }
+        else
+        {
+            prev_block = block;
+        }
+
+        block = next_block;
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_free_take - removes the next free block to allocate, the first of any ties
+ *
+ *  the least worn block is taken, unless cold is set, in which case it is the most worn
+ *  block that is no more than FLASH_MAX_WEAR_GAP erases past it
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE bp_flash_index_t flash_free_take(bool cold)
+{
+    if (flash_free_blocks.count == 0)
+    {
+        return BP_FLASH_INVALID_INDEX;
+    }
+
+    flash_free_settle();
+
+    /* Find Bucket */
+    uint32_t            base_count = flash_free_blocks.base_count;
+    flash_block_list_t *list       = &flash_free_blocks.buckets[base_count % FLASH_WEAR_BUCKETS];
+    int                 gap;
+    for (gap = cold ? FLASH_MAX_WEAR_GAP : 0; gap > 0; gap--)
+    {
+        flash_block_list_t *worn_list = &flash_free_blocks.buckets[(base_count + gap) % FLASH_WEAR_BUCKETS];
+        if (worn_list->out != BP_FLASH_INVALID_INDEX)
+        {
+            list = worn_list;
+            break;
+        }
+    }
+
+    /* Take Block */
+    flash_free_blocks.count--;
+    return flash_block_list_pop(list);
+}
+
 /*--------------------------------------------------------------------------------------
  * flash_free_reclaim -
  *-------------------------------------------------------------------------------------*/
@@ -258,7 +500,7 @@ BP_LOCAL_SCOPE int flash_free_reclaim(bp_flash_index_t block)
     /* Add to Free or Failed List */
     if (!FLASH_DRIVER.isbad(block))
     {
-        flash_block_list_add(&flash_free_blocks, block);
+        flash_free_add(block);
         return BP_SUCCESS;
     }
     else
@@ -270,21 +512,26 @@ BP_LOCAL_SCOPE int flash_free_reclaim(bp_flash_index_t block)
 
 /*--------------------------------------------------------------------------------------
  * flash_free_allocate -
+ *
+ *  blocks holding objects kept long (cold) are not erased again while they do; so they
+ *  get the more worn free blocks to rest them, and everything else the least worn
  *-------------------------------------------------------------------------------------*/
-BP_LOCAL_SCOPE int flash_free_allocate(bp_flash_index_t *block)
+BP_LOCAL_SCOPE int flash_free_allocate(bp_flash_index_t *block, bool cold)
 {
     int status = BP_ERROR;
 
     /* Erase Block */
-    while (status != BP_SUCCESS && flash_free_blocks.out != BP_FLASH_INVALID_INDEX)
+    while (status != BP_SUCCESS && flash_free_blocks.count > 0)
     {
-        bp_flash_index_t block_out = flash_free_blocks.out;
+        bp_flash_index_t block_out = flash_free_take(cold);
         status                     = FLASH_DRIVER.erase(block_out);
+        flash_blocks[block_out].erase_count++;
         if (status == BP_SUCCESS)
         {
             /* Return Block */
             *block = block_out;
             flash_used_block_count++;
+            bplib_os_systime(&flash_blocks[block_out].alloc_time);
         }
         else
         {
@@ -295,13 +542,6 @@ BP_LOCAL_SCOPE int flash_free_allocate(bp_flash_index_t *block)
                   "Failed to erase block %d when allocating it... adding as failed block\n",
                   FLASH_DRIVER.phyblk(block_out));
         }
-
-        /* Move to Next Free Block */
-        flash_free_blocks.out = flash_blocks[block_out].next_block;
-        flash_free_blocks.count--;
-
-        /* Mark Next Block Invalid */
-        flash_blocks[block_out].next_block = BP_FLASH_INVALID_INDEX;
     }
 
     /* Log Error */
@@ -314,13 +554,82 @@ BP_LOCAL_SCOPE int flash_free_allocate(bp_flash_index_t *block)
     return status;
 }
 
+/*--------------------------------------------------------------------------------------
+ * flash_run_size - pages in the next run of a read or write, which never crosses a block
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int flash_run_size(bp_flash_addr_t addr, int bytes_left, int *run_bytes)
+{
+    int run_pages = (bytes_left + FLASH_PAGE_DATA_SIZE - 1) / FLASH_PAGE_DATA_SIZE;
+    if (run_pages > FLASH_BATCH_PAGES)
+    {
+        run_pages = FLASH_BATCH_PAGES;
+    }
+    if (run_pages > FLASH_DRIVER.pages_per_block - addr.page)
+    {
+        run_pages = FLASH_DRIVER.pages_per_block - addr.page;
+    }
+
+    *run_bytes = run_pages * FLASH_PAGE_DATA_SIZE;
+    if (*run_bytes > bytes_left)
+    {
+        *run_bytes = bytes_left;
+    }
+
+    return run_pages;
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_data_gather - copies the next size bytes of a list of segments
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE void flash_data_gather(const flash_segment_t *segments, int *segment, int *offset, uint8_t *data,
+                                      int size)
+{
+    while (size > 0)
+    {
+        const flash_segment_t *current       = &segments[*segment];
+        int                    bytes_to_copy = current->size - *offset;
+        if (bytes_to_copy > size)
+        {
+            bytes_to_copy = size;
+        }
+
+        if (current->data)
+        {
+            memcpy(data, &current->data[*offset], bytes_to_copy);
+        }
+        else
+        {
+            memset(data, 0, bytes_to_copy);
+        }
+
+        data += bytes_to_copy;
+        size -= bytes_to_copy;
+        *offset += bytes_to_copy;
+
+        /* Go to Next Segment */
+        if (*offset >= current->size)
+        {
+            (*segment)++;
+            *offset = 0;
+        }
+    }
+}
+
 /*--------------------------------------------------------------------------------------
  * flash_data_write -
+ *
+ *  writes the segments one after the other, a run of pages at a time; when the driver
+ *  writes asynchronously, each run is gathered, encoded, and handed to the driver while
+ *  the previous run programs
  *-------------------------------------------------------------------------------------*/
-BP_LOCAL_SCOPE int flash_data_write(bp_flash_addr_t *addr, uint8_t *data, int size)
+BP_LOCAL_SCOPE int flash_data_write(bp_flash_addr_t *addr, const flash_segment_t *segments, int num_segments,
+                                     bool cold)
 {
-    int data_index = 0;
-    int bytes_left = size;
+    bp_flash_addr_t start_addr = *addr;
+    int             segment    = 0;
+    int             offset     = 0;
+    int             bytes_left = 0;
+    int             s;
 
     /* Check for Valid Address */
     if (addr->block >= FLASH_DRIVER.num_blocks || addr->page >= FLASH_DRIVER.pages_per_block)
@@ -329,16 +638,58 @@ BP_LOCAL_SCOPE int flash_data_write(bp_flash_addr_t *addr, uint8_t *data, int si
                      FLASH_DRIVER.phyblk(addr->block), addr->page);
     }
 
-    /* Copy Into and Write Pages */
+    /* Total Size of Segments */
+    for (s = 0; s < num_segments; s++)
+    {
+        bytes_left += segments[s].size;
+    }
+
+    /* Gather Into and Write Pages */
     while (bytes_left > 0)
     {
-        /* Write Data into Page */
-        int bytes_to_copy = bytes_left < FLASH_PAGE_DATA_SIZE ? bytes_left : FLASH_PAGE_DATA_SIZE;
-        int flash_status  = flash_page_write(*addr, &data[data_index], bytes_to_copy);
+        uint8_t *run_data;
+        int      p;
+
+        /* Size Run of Pages */
+        int run_bytes;
+        int run_pages = flash_run_size(*addr, bytes_left, &run_bytes);
 
-        /* Check if Write Failed
+        /* Stage Pages - only full pages without ECC are written straight from the segment */
+        if ((FLASH_ECC_CODE_SIZE == 0) && (run_bytes == run_pages * FLASH_PAGE_DATA_SIZE) &&
+            (segments[segment].data != NULL) && (segments[segment].size - offset >= run_bytes))
+        {
+            run_data = (uint8_t *)&segments[segment].data[offset];
+            offset += run_bytes;
+            if (offset >= segments[segment].size)
+            {
+                segment++;
+                offset = 0;
+            }
+        }
+        else
+        {
+            run_data = flash_write_buffer;
+            for (p = 0; p < run_pages; p++)
+            {
+                uint8_t *page       = &run_data[p * FLASH_DRIVER.page_size];
+                int      page_bytes = run_bytes - (p * FLASH_PAGE_DATA_SIZE);
+                if (page_bytes > FLASH_PAGE_DATA_SIZE)
+                {
+                    page_bytes = FLASH_PAGE_DATA_SIZE;
+                }
+
+                flash_data_gather(segments, &segment, &offset, page, page_bytes);
+                if (FLASH_ECC_CODE_SIZE > 0)
+                {
+                    lrc_encode(page, FLASH_PAGE_DATA_SIZE);
+                }
+            }
+        }
+
+        /* Write Pages
          *  don't set return status of function to failure
          *  but instead count and log the error and keep going */
+        int flash_status = flash_pages_write(*addr, run_data, run_pages);
         if (flash_status != BP_SUCCESS)
         {
             flash_error_count++;
@@ -347,15 +698,14 @@ BP_LOCAL_SCOPE int flash_data_write(bp_flash_addr_t *addr, uint8_t *data, int si
         }
 
         /* Always Continue with Write */
-        data_index += bytes_to_copy;
-        bytes_left -= bytes_to_copy;
-        addr->page++;
+        bytes_left -= run_bytes;
+        addr->page += run_pages;
 
         /* Check Need to go to Next Block */
         if (addr->page >= FLASH_DRIVER.pages_per_block)
         {
             bp_flash_index_t next_write_block;
-            flash_status = flash_free_allocate(&next_write_block);
+            flash_status = flash_free_allocate(&next_write_block, cold);
             if (flash_status == BP_SUCCESS)
             {
                 flash_blocks[addr->block].next_block = next_write_block;
@@ -364,6 +714,7 @@ BP_LOCAL_SCOPE int flash_data_write(bp_flash_addr_t *addr, uint8_t *data, int si
             }
             else
             {
+                flash_write_wait(start_addr);
                 return bplog(NULL, BP_FLAG_STORE_FAILURE,
                              "Failed to retrieve next free block in middle of flash write at block: %ld\n",
                              FLASH_DRIVER.phyblk(addr->block));
@@ -371,6 +722,9 @@ BP_LOCAL_SCOPE int flash_data_write(bp_flash_addr_t *addr, uint8_t *data, int si
         }
     }
 
+    /* Wait for Pages Still Programming */
+    flash_write_wait(start_addr);
+
     return BP_SUCCESS;
 }
 
@@ -389,27 +743,59 @@ BP_LOCAL_SCOPE int flash_data_read(bp_flash_addr_t *addr, uint8_t *data, int siz
                      FLASH_DRIVER.phyblk(addr->block), addr->page);
     }
 
-    /* Copy Into and Write Pages */
+    /* Read Pages and Copy Out */
     while (bytes_left > 0)
     {
-        /* Read Data from Page */
-        int bytes_to_copy = bytes_left < FLASH_PAGE_DATA_SIZE ? bytes_left : FLASH_PAGE_DATA_SIZE;
-        int flash_status  = flash_page_read(*addr, &data[data_index], bytes_to_copy);
+        uint8_t *run_data;
+        int      p;
+
+        /* Size Run of Pages */
+        int run_bytes;
+        int run_pages = flash_run_size(*addr, bytes_left, &run_bytes);
 
-        /* Check if Read Failed
+        /* Only Full Pages without ECC are Read Straight into the Data */
+        bool direct = (FLASH_ECC_CODE_SIZE == 0) && (run_bytes == run_pages * FLASH_PAGE_DATA_SIZE);
+        run_data    = direct ? &data[data_index] : flash_page_buffer;
+
+        /* Read Data from Pages
          *  don't set return status of function to failure
          *  but instead count and log the error and keep going */
+        int flash_status = flash_pages_read(*addr, run_data, run_pages);
         if (flash_status != BP_SUCCESS)
         {
             flash_error_count++;
             bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to read data from flash address: %d.%d\n",
                   FLASH_DRIVER.phyblk(addr->block), addr->page);
         }
+        else if (!direct)
+        {
+            for (p = 0; p < run_pages; p++)
+            {
+                bp_flash_addr_t page_addr  = {addr->block, addr->page + p};
+                uint8_t        *page       = &run_data[p * FLASH_DRIVER.page_size];
+                int             page_bytes = run_bytes - (p * FLASH_PAGE_DATA_SIZE);
+                if (page_bytes > FLASH_PAGE_DATA_SIZE)
+                {
+                    page_bytes = FLASH_PAGE_DATA_SIZE;
+                }
+
+                if ((FLASH_ECC_CODE_SIZE > 0) && (flash_page_decode(page_addr, page) != BP_SUCCESS))
+                {
+                    flash_error_count++;
+                    bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed to read data from flash address: %d.%d\n",
+                          FLASH_DRIVER.phyblk(page_addr.block), page_addr.page);
+                }
+                else
+                {
+                    memcpy(&data[data_index + (p * FLASH_PAGE_DATA_SIZE)], page, page_bytes);
+                }
+            }
+        }
 
-        /* Always Continue with Write */
-        data_index += bytes_to_copy;
-        bytes_left -= bytes_to_copy;
-        addr->page++;
+        /* Always Continue with Read */
+        data_index += run_bytes;
+        bytes_left -= run_bytes;
+        addr->page += run_pages;
 
         /* Check Need to go to Next Block */
         if (addr->page >= FLASH_DRIVER.pages_per_block)
@@ -435,6 +821,24 @@ BP_LOCAL_SCOPE int flash_data_read(bp_flash_addr_t *addr, uint8_t *data, int siz
  LOCAL FUNCTIONS - OBJECT LEVEL
  ******************************************************************************/
 
+/*--------------------------------------------------------------------------------------
+ * flash_object_cold - objects written now are expected to be kept long
+ *
+ *  as the store already holds objects written more than FLASH_RETAINED_AGE seconds ago
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE bool flash_object_cold(flash_store_t *fs)
+{
+    unsigned long sysnow;
+
+    if (fs->active_block == BP_FLASH_INVALID_INDEX || bplib_os_systime(&sysnow) != BP_SUCCESS)
+    {
+        return false;
+    }
+
+    unsigned long alloc_time = flash_blocks[fs->active_block].alloc_time;
+    return (sysnow > alloc_time) && (sysnow - alloc_time >= FLASH_RETAINED_AGE);
+}
+
 /*--------------------------------------------------------------------------------------
  * flash_object_write -
  *-------------------------------------------------------------------------------------*/
@@ -458,19 +862,11 @@ BP_LOCAL_SCOPE int flash_object_write(flash_store_t *fs, bp_handle_t h, const ui
             .synclo     = FLASH_OBJECT_SYNC_LO,
             .object_hdr = {.handle = h, .size = data1_size + data2_size, .sid = (bp_sid_t)sid}};
 
-        /* Copy into Write Stage */
-        memcpy(&fs->write_stage[0], &flash_object_hdr, sizeof(flash_object_hdr_t));
-        if (data1)
-        {
-            memcpy(&fs->write_stage[sizeof(flash_object_hdr_t)], data1, data1_size);
-        }
-        if (data2)
-        {
-            memcpy(&fs->write_stage[sizeof(flash_object_hdr_t) + data1_size], data2, data2_size);
-        }
-
-        /* Write Data into Flash */
-        status = flash_data_write(&fs->write_addr, fs->write_stage, bytes_needed);
+        /* Stream Object into Flash */
+        flash_segment_t segments[3] = {{(const uint8_t *)&flash_object_hdr, sizeof(flash_object_hdr_t)},
+                                       {data1, data1_size},
+                                       {data2, data2_size}};
+        status = flash_data_write(&fs->write_addr, segments, 3, flash_object_cold(fs));
     }
     else
     {
@@ -557,23 +953,23 @@ BP_LOCAL_SCOPE int flash_object_delete(flash_store_t *fs, bp_sid_t sid)
     }
 
     /* Retrieve Object Header */
-    flash_object_hdr_t *flash_object_hdr = (flash_object_hdr_t *)flash_page_buffer;
-    flash_object_hdr->object_hdr.sid     = BP_SID_VACANT;
-    bp_flash_addr_t hdr_addr             = addr;
-    status = flash_data_read(&hdr_addr, (uint8_t *)flash_object_hdr, sizeof(flash_object_hdr_t));
+    flash_object_hdr_t flash_object_hdr;
+    flash_object_hdr.object_hdr.sid = BP_SID_VACANT;
+    bp_flash_addr_t hdr_addr        = addr;
+    status = flash_data_read(&hdr_addr, (uint8_t *)&flash_object_hdr, sizeof(flash_object_hdr_t));
     if (status != BP_SUCCESS)
     {
         return bplog(NULL, BP_FLAG_STORE_FAILURE, "Unable to read object header at %d.%d in delete function\n",
                      FLASH_DRIVER.phyblk(addr.block), addr.page);
     }
-    else if (flash_object_hdr->object_hdr.sid != sid)
+    else if (flash_object_hdr.object_hdr.sid != sid)
     {
         return bplog(NULL, BP_FLAG_STORE_FAILURE, "Attempting to delete object with invalid SID: %lu != %lu\n",
-                     (unsigned long)flash_object_hdr->object_hdr.sid, (unsigned long)sid);
+                     (unsigned long)flash_object_hdr.object_hdr.sid, (unsigned long)sid);
     }
 
     /* Delete Each Page of Data */
-    bytes_left = sizeof(flash_object_hdr_t) + flash_object_hdr->object_hdr.size;
+    bytes_left = sizeof(flash_object_hdr_t) + flash_object_hdr.object_hdr.size;
     while (bytes_left > 0)
     {
         /* Set Current Block */
@@ -657,6 +1053,18 @@ int bplib_store_flash_init(bp_flash_driver_t driver, bool sw_edac)
     /* Default Constants */
     FLASH_PAGE_DATA_SIZE = FLASH_DRIVER.page_size;
     FLASH_ECC_CODE_SIZE  = 0;
+    FLASH_BATCH_PAGES    = 1;
+
+    /* Batched Operations - asynchronous writes need batched writes to start them */
+    if ((FLASH_DRIVER.read_pages || FLASH_DRIVER.write_pages) && (FLASH_DRIVER.batch_pages > 1))
+    {
+        FLASH_BATCH_PAGES = FLASH_DRIVER.batch_pages < FLASH_DRIVER.pages_per_block ? FLASH_DRIVER.batch_pages
+                                                                                    : FLASH_DRIVER.pages_per_block;
+    }
+    if (FLASH_DRIVER.write_pages == NULL)
+    {
+        FLASH_DRIVER.write_wait = NULL;
+    }
 
     /* Default Variables  */
     flash_device_lock      = BP_INVALID_HANDLE;
@@ -664,14 +1072,24 @@ int bplib_store_flash_init(bp_flash_driver_t driver, bool sw_edac)
     flash_error_count      = 0;
     flash_used_block_count = 0;
     flash_page_buffer      = NULL;
+    flash_write_buffer     = NULL;
 
     /* Zero Out Flash Stores */
     memset(flash_stores, 0, sizeof(flash_stores));
 
-    /* Initialize Free Blocks List */
-    flash_free_blocks.out   = BP_FLASH_INVALID_INDEX;
-    flash_free_blocks.in    = BP_FLASH_INVALID_INDEX;
-    flash_free_blocks.count = 0;
+    /* Initialize Free Blocks Lists */
+    int bucket;
+    for (bucket = 0; bucket < FLASH_WEAR_BUCKETS; bucket++)
+    {
+        flash_free_blocks.buckets[bucket].out   = BP_FLASH_INVALID_INDEX;
+        flash_free_blocks.buckets[bucket].in    = BP_FLASH_INVALID_INDEX;
+        flash_free_blocks.buckets[bucket].count = 0;
+    }
+    flash_free_blocks.overflow.out   = BP_FLASH_INVALID_INDEX;
+    flash_free_blocks.overflow.in    = BP_FLASH_INVALID_INDEX;
+    flash_free_blocks.overflow.count = 0;
+    flash_free_blocks.base_count     = 0;
+    flash_free_blocks.count          = 0;
 
     /* Initialize Failed Blocks List */
     flash_fail_blocks.out   = BP_FLASH_INVALID_INDEX;
@@ -710,11 +1128,12 @@ int bplib_store_flash_init(bp_flash_driver_t driver, bool sw_edac)
             }
         }
 
-        /* Allocate Page Buffer */
-        flash_page_buffer = (uint8_t *)bplib_os_calloc(FLASH_DRIVER.page_size);
-        if (!flash_page_buffer)
+        /* Allocate Page Buffers */
+        flash_page_buffer  = (uint8_t *)bplib_os_calloc(FLASH_DRIVER.page_size * FLASH_BATCH_PAGES);
+        flash_write_buffer = (uint8_t *)bplib_os_calloc(FLASH_DRIVER.page_size * FLASH_BATCH_PAGES);
+        if (!flash_page_buffer || !flash_write_buffer)
         {
-            bplog(NULL, BP_FLAG_DIAGNOSTIC, "Unable to allocate memory for flash page buffer\n");
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "Unable to allocate memory for flash page buffers\n");
             break; /* Skip rest of initialization */
         }
 
@@ -723,6 +1142,11 @@ int bplib_store_flash_init(bp_flash_driver_t driver, bool sw_edac)
         for (block = 0; block < FLASH_DRIVER.num_blocks; block++)
         {
             bp_flash_index_t block_to_reclaim = (block + start_block) % FLASH_DRIVER.num_blocks;
+            if (FLASH_DRIVER.erase_count)
+            {
+                flash_blocks[block_to_reclaim].erase_count = FLASH_DRIVER.erase_count(block_to_reclaim);
+            }
+
             if (flash_free_reclaim(block_to_reclaim) == BP_SUCCESS)
             {
                 reclaimed_blocks++;
@@ -796,6 +1220,12 @@ void bplib_store_flash_uninit(void)
         bplib_os_free(flash_page_buffer);
         flash_page_buffer = NULL;
     }
+
+    if (flash_write_buffer)
+    {
+        bplib_os_free(flash_write_buffer);
+        flash_write_buffer = NULL;
+    }
 }
 
 /*--------------------------------------------------------------------------------------
@@ -837,7 +1267,7 @@ void bplib_store_flash_restore_failed_blocks(void)
         /* Add to Free or Failed List */
         if (!FLASH_DRIVER.isbad(block))
         {
-            flash_block_list_add(&flash_free_blocks, block);
+            flash_free_add(block);
         }
         else
         {
@@ -857,6 +1287,24 @@ void bplib_store_flash_restore_failed_blocks(void)
  *-------------------------------------------------------------------------------------*/
 void bplib_store_flash_stats(bp_flash_stats_t *stats, bool log_stats, bool reset_stats)
 {
+    uint32_t     min_erase_count = 0;
+    uint32_t     max_erase_count = 0;
+    unsigned int block;
+
+    /* Find Range of Wear */
+    for (block = 0; flash_blocks && block < FLASH_DRIVER.num_blocks; block++)
+    {
+        uint32_t erase_count = flash_blocks[block].erase_count;
+        if (block == 0 || erase_count < min_erase_count)
+        {
+            min_erase_count = erase_count;
+        }
+        if (erase_count > max_erase_count)
+        {
+            max_erase_count = erase_count;
+        }
+    }
+
     /* Copy Stats */
     if (stats)
     {
@@ -864,6 +1312,8 @@ void bplib_store_flash_stats(bp_flash_stats_t *stats, bool log_stats, bool reset
         stats->num_used_blocks = flash_used_block_count;
         stats->num_fail_blocks = flash_fail_blocks.count;
         stats->error_count     = flash_error_count;
+        stats->min_erase_count = min_erase_count;
+        stats->max_erase_count = max_erase_count;
     }
 
     /* Log Stats */
@@ -873,8 +1323,10 @@ void bplib_store_flash_stats(bp_flash_stats_t *stats, bool log_stats, bool reset
         bplog(NULL, BP_FLAG_STORE_FAILURE, "Number of used blocks: %d\n", flash_used_block_count);
         bplog(NULL, BP_FLAG_STORE_FAILURE, "Number of failed blocks: %d\n", flash_fail_blocks.count);
         bplog(NULL, BP_FLAG_STORE_FAILURE, "Number of flash errors: %d\n", flash_error_count);
+        bplog(NULL, BP_FLAG_STORE_FAILURE, "Block erase counts: %lu to %lu\n", (unsigned long)min_erase_count,
+              (unsigned long)max_erase_count);
 
-        int block = flash_fail_blocks.out;
+        block = flash_fail_blocks.out;
         while (block != BP_FLASH_INVALID_INDEX)
         {
             bplog(NULL, BP_FLAG_STORE_FAILURE, "Block <%d> failed\n", FLASH_DRIVER.phyblk(block));
@@ -983,19 +1435,14 @@ bp_handle_t bplib_store_flash_create(int type, bp_ipn_t node, bp_ipn_t service,
         }
     }
 
-    /* Allocate Stage */
+    /* Allocate Stage - objects are written straight from the caller's data, so only reads need one */
     if (bp_handle_is_valid(handle))
     {
         flash_stores[s].stage_locked = false;
-        flash_stores[s].write_stage  = (uint8_t *)bplib_os_calloc(flash_stores[s].attributes.max_data_size);
         flash_stores[s].read_stage   = (uint8_t *)bplib_os_calloc(flash_stores[s].attributes.max_data_size);
-        if ((flash_stores[s].write_stage == NULL) || (flash_stores[s].read_stage == NULL))
+        if (flash_stores[s].read_stage == NULL)
         {
-            bplog(NULL, BP_FLAG_DIAGNOSTIC, "Unable to allocate data stages\n");
-            if (flash_stores[s].write_stage)
-                bplib_os_free(flash_stores[s].write_stage);
-            if (flash_stores[s].read_stage)
-                bplib_os_free(flash_stores[s].read_stage);
+            bplog(NULL, BP_FLAG_DIAGNOSTIC, "Unable to allocate data stage\n");
             handle = BP_INVALID_HANDLE;
         }
     }
@@ -1049,13 +1496,6 @@ int bplib_store_flash_destroy(bp_handle_t h)
         flash_stores[handle].active_block = next_active_block;
     }
 
-    /* Cleanup Write Stage */
-    if (flash_stores[handle].write_stage)
-    {
-        bplib_os_free(flash_stores[handle].write_stage);
-        flash_stores[handle].write_stage = NULL;
-    }
-
     /* Cleanup Read Stage */
     if (flash_stores[handle].read_stage)
     {
@@ -1106,7 +1546,7 @@ int bplib_store_flash_enqueue(bp_handle_t h, const void *data1, size_t data1_siz
         /* Check if First Write Block Available */
         if (fs->write_addr.block == BP_FLASH_INVALID_INDEX)
         {
-            status = flash_free_allocate(&fs->write_addr.block);
+            status = flash_free_allocate(&fs->write_addr.block, false);
             if (status != BP_SUCCESS)
             {
                 bplog(NULL, BP_FLAG_STORE_FAILURE, "Failed (%d) to allocate write block first time\n");
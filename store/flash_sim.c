@@ -64,6 +64,56 @@ typedef struct
 flash_driver_device_t flash_driver_device;
 bool                  flash_sim_initialized = false;
 
+static int      flash_sim_transfer_us = 0; /* time to move a page between the host and a page register */
+static int      flash_sim_read_us     = 0; /* time to read a page from the array into its page register */
+static int      flash_sim_program_us  = 0; /* time to program a page from its page register into the array */
+static int      flash_sim_erase_us    = 0; /* time to erase a block */
+static uint64_t flash_sim_busy_until  = 0; /* time at which the array finishes the operation in progress */
+static uint64_t flash_sim_cache_free  = 0; /* time at which the cache registers can take the next pages */
+static uint32_t flash_sim_erase_counts[FLASH_SIM_NUM_BLOCKS]; /* kept by the device across service restarts */
+
+/******************************************************************************
+ LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * flash_sim_spin - spins until the given time
+ *-------------------------------------------------------------------------------------*/
+static void flash_sim_spin(uint64_t until_us)
+{
+    while (bplib_os_get_monotonic_us() < until_us)
+    {
+        /* busy device */
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_sim_operate - queues an array operation on count pages behind the one in progress
+ *
+ *  each set of FLASH_SIM_NUM_PLANES pages costs one latency; returns the start time
+ *-------------------------------------------------------------------------------------*/
+static uint64_t flash_sim_operate(int latency_us, int count)
+{
+    uint64_t start = bplib_os_get_monotonic_us();
+    if (start < flash_sim_busy_until)
+    {
+        start = flash_sim_busy_until;
+    }
+
+    int plane_passes     = (count + FLASH_SIM_NUM_PLANES - 1) / FLASH_SIM_NUM_PLANES;
+    flash_sim_busy_until = start + ((uint64_t)latency_us * plane_passes);
+
+    return start;
+}
+
+/*--------------------------------------------------------------------------------------
+ * flash_sim_transfer - moves count pages over the bus
+ *-------------------------------------------------------------------------------------*/
+static void flash_sim_transfer(int count)
+{
+    flash_sim_spin(bplib_os_get_monotonic_us() + ((uint64_t)flash_sim_transfer_us * count));
+}
+
 /******************************************************************************
  EXPORTED FUNCTIONS
  ******************************************************************************/
@@ -148,8 +198,7 @@ int bplib_flash_sim_uninitialize(void)
  *-------------------------------------------------------------------------------------*/
 int bplib_flash_sim_page_read(bp_flash_addr_t addr, void *page_data)
 {
-    memcpy(page_data, flash_driver_device.blocks[addr.block].pages[addr.page].data, FLASH_SIM_PAGE_SIZE);
-    return BP_SUCCESS;
+    return bplib_flash_sim_pages_read(addr, page_data, 1);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -157,13 +206,7 @@ int bplib_flash_sim_page_read(bp_flash_addr_t addr, void *page_data)
  *-------------------------------------------------------------------------------------*/
 int bplib_flash_sim_page_write(bp_flash_addr_t addr, void *page_data)
 {
-    int      i;
-    uint8_t *byte_ptr = (uint8_t *)page_data;
-    for (i = 0; i < FLASH_SIM_PAGE_SIZE; i++)
-    {
-        flash_driver_device.blocks[addr.block].pages[addr.page].data[i] &= byte_ptr[i];
-    }
-    return BP_SUCCESS;
+    return bplib_flash_sim_pages_write(addr, page_data, 1);
 }
 
 /*--------------------------------------------------------------------------------------
@@ -173,6 +216,10 @@ int bplib_flash_sim_block_erase(bp_flash_index_t block)
 {
     int p;
 
+    flash_sim_operate(flash_sim_erase_us, 1);
+    flash_sim_spin(flash_sim_busy_until);
+    flash_sim_erase_counts[block]++;
+
     for (p = 0; p < FLASH_SIM_PAGES_PER_BLOCK; p++)
     {
         memset(flash_driver_device.blocks[block].pages[p].data, 0xFF, FLASH_SIM_PAGE_SIZE);
@@ -182,6 +229,14 @@ int bplib_flash_sim_block_erase(bp_flash_index_t block)
     return BP_SUCCESS;
 }
 
+/*--------------------------------------------------------------------------------------
+ * bplib_flash_sim_block_erase_count -
+ *-------------------------------------------------------------------------------------*/
+uint32_t bplib_flash_sim_block_erase_count(bp_flash_index_t block)
+{
+    return flash_sim_erase_counts[block];
+}
+
 /*--------------------------------------------------------------------------------------
  * bplib_flash_sim_block_is_bad -
  *-------------------------------------------------------------------------------------*/
@@ -206,3 +261,85 @@ int bplib_flash_sim_block_mark_bad(bp_flash_index_t block)
     flash_driver_device.blocks[block].pages[0].spare[0] = FLASH_SIM_BAD_BLOCK_MARK;
     return BP_SUCCESS;
 }
+
+/*--------------------------------------------------------------------------------------
+ * bplib_flash_sim_pages_read -
+ *-------------------------------------------------------------------------------------*/
+int bplib_flash_sim_pages_read(bp_flash_addr_t addr, void *page_data, int count)
+{
+    assert(addr.page + count <= FLASH_SIM_PAGES_PER_BLOCK);
+
+    int      p;
+    uint8_t *byte_ptr = (uint8_t *)page_data;
+
+    flash_sim_operate(flash_sim_read_us, count);
+    flash_sim_spin(flash_sim_busy_until);
+    flash_sim_transfer(count);
+
+    for (p = 0; p < count; p++)
+    {
+        memcpy(&byte_ptr[p * FLASH_SIM_PAGE_SIZE], flash_driver_device.blocks[addr.block].pages[addr.page + p].data,
+               FLASH_SIM_PAGE_SIZE);
+    }
+
+    return BP_SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_flash_sim_pages_write -
+ *-------------------------------------------------------------------------------------*/
+int bplib_flash_sim_pages_write(bp_flash_addr_t addr, void *page_data, int count)
+{
+    bplib_flash_sim_pages_start(addr, page_data, count);
+    return bplib_flash_sim_write_wait();
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_flash_sim_pages_start -
+ *
+ *  models a cache program: the pages are moved into the cache registers as soon as the
+ *  previous pages have moved on to program, and then program behind them; the pages are
+ *  updated right away, but the array stays busy until they would have programmed
+ *-------------------------------------------------------------------------------------*/
+int bplib_flash_sim_pages_start(bp_flash_addr_t addr, void *page_data, int count)
+{
+    assert(addr.page + count <= FLASH_SIM_PAGES_PER_BLOCK);
+
+    int      i, p;
+    uint8_t *byte_ptr = (uint8_t *)page_data;
+
+    flash_sim_spin(flash_sim_cache_free);
+    flash_sim_transfer(count);
+    flash_sim_cache_free = flash_sim_operate(flash_sim_program_us, count);
+
+    for (p = 0; p < count; p++)
+    {
+        for (i = 0; i < FLASH_SIM_PAGE_SIZE; i++)
+        {
+            flash_driver_device.blocks[addr.block].pages[addr.page + p].data[i] &=
+                byte_ptr[(p * FLASH_SIM_PAGE_SIZE) + i];
+        }
+    }
+
+    return BP_SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_flash_sim_write_wait -
+ *-------------------------------------------------------------------------------------*/
+int bplib_flash_sim_write_wait(void)
+{
+    flash_sim_spin(flash_sim_busy_until);
+    return BP_SUCCESS;
+}
+
+/*--------------------------------------------------------------------------------------
+ * bplib_flash_sim_set_latency -
+ *-------------------------------------------------------------------------------------*/
+void bplib_flash_sim_set_latency(int transfer_us, int read_us, int program_us, int erase_us)
+{
+    flash_sim_transfer_us = transfer_us;
+    flash_sim_read_us     = read_us;
+    flash_sim_program_us  = program_us;
+    flash_sim_erase_us    = erase_us;
+}
@@ -33,6 +33,10 @@ extern int ut_crc(void);
 extern int ut_rb_tree(void);
 extern int ut_rh_hash(void);
 extern int ut_flash(void);
+extern int ut_reassembly(void);
+extern int ut_aggregate(void);
+extern int ut_lzc(void);
+extern int ut_file(void);
 
 /******************************************************************************
  EXPORTED FUNCTIONS
@@ -86,3 +90,51 @@ int bplib_unittest_flash(void)
     return 0;
 #endif
 }
+
+/*--------------------------------------------------------------------------------------
+ * Reassembly Unit Test -
+ *--------------------------------------------------------------------------------------*/
+int bplib_unittest_reassembly(void)
+{
+#if defined(UNITTESTS) && defined(BPLIB_INCLUDE_BPV7)
+    return ut_reassembly();
+#else
+    return 0;
+#endif
+}
+
+/*--------------------------------------------------------------------------------------
+ * Aggregate Unit Test -
+ *--------------------------------------------------------------------------------------*/
+int bplib_unittest_aggregate(void)
+{
+#if defined(UNITTESTS) && defined(BPLIB_INCLUDE_BPV7)
+    return ut_aggregate();
+#else
+    return 0;
+#endif
+}
+
+/*--------------------------------------------------------------------------------------
+ * LZ Compression Unit Test -
+ *--------------------------------------------------------------------------------------*/
+int bplib_unittest_lzc(void)
+{
+#ifdef UNITTESTS
+    return ut_lzc();
+#else
+    return 0;
+#endif
+}
+
+/*--------------------------------------------------------------------------------------
+ * File Store Unit Test -
+ *--------------------------------------------------------------------------------------*/
+int bplib_unittest_file(void)
+{
+#ifdef UNITTESTS
+    return ut_file();
+#else
+    return 0;
+#endif
+}
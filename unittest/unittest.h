@@ -29,5 +29,9 @@ int bplib_unittest_crc(void);
 int bplib_unittest_rb_tree(void);
 int bplib_unittest_rh_hash(void);
 int bplib_unittest_flash(void);
+int bplib_unittest_reassembly(void);
+int bplib_unittest_aggregate(void);
+int bplib_unittest_lzc(void);
+int bplib_unittest_file(void);
 
 #endif /* UNITTEST_H */
@@ -0,0 +1,333 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Bundle aggregation is part of the BPv7 implementation, so these tests are only
+ * built along with it.
+ */
+#ifdef BPLIB_INCLUDE_BPV7
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut_assert.h"
+#include "bplib.h"
+#include "v7.h"
+#include "v7_codec.h"
+#include "v7_mpool.h"
+#include "v7_mpool_bblocks.h"
+#include "v7_mpool_flows.h"
+#include "v7_mpool_ref.h"
+
+/******************************************************************************
+ DEFINES
+ ******************************************************************************/
+
+#define TEST_POOL_SIZE        (4 * 1024 * 1024)
+#define TEST_PAYLOAD_SIZE     100
+#define TEST_BUFFER_SIZE      4096
+#define TEST_BLOCKTYPE_BUNDLE 0x41d7c2e9
+#define TEST_BLOCKTYPE_FLOW   0x41d7c2ea
+#define TEST_LOCAL_NODE       100
+#define TEST_PEER_NODE        101
+
+/******************************************************************************
+ EXTERNAL PROTOTYPES
+ ******************************************************************************/
+
+extern void bplib_cla_init(bplib_mpool_t *pool);
+extern int  bplib_generic_bundle_ingress(bplib_mpool_ref_t flow_ref, const void *content, size_t size,
+                                         uint64_t time_limit, bool defer_crc);
+
+/******************************************************************************
+ FILE DATA
+ ******************************************************************************/
+
+static void               *pool_mem;
+static bplib_mpool_t      *pool;
+static bplib_mpool_ref_t   flow_ref;
+static bplib_mpool_flow_t *flow;
+static uint8_t             payload_data[TEST_PAYLOAD_SIZE];
+static uint8_t             encoded_data[TEST_BUFFER_SIZE];
+
+/******************************************************************************
+ TEST AND DEBUGGING HELPER FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * make_bundle - Builds a bundle, as a block referring to it.  If aggregate_list is not
+ *      NULL, it is an aggregate of the bundles in that list, otherwise a plain bundle.
+ *-------------------------------------------------------------------------------------*/
+static bplib_mpool_block_t *make_bundle(bp_sequencenumber_t sequence_num, bplib_mpool_block_t *aggregate_list)
+{
+    bplib_mpool_block_t            *pblk;
+    bplib_mpool_block_t            *cblk;
+    bplib_mpool_block_t            *rblk;
+    bplib_mpool_bblock_primary_t   *cpb;
+    bplib_mpool_bblock_canonical_t *ccb;
+    bp_primary_block_t             *pri;
+    bp_canonical_block_buffer_t    *pay;
+    bplib_mpool_ref_t               refptr;
+    bp_ipn_addr_t                   addr;
+    int                             status;
+
+    pblk = bplib_mpool_bblock_primary_alloc(pool);
+    cpb  = bplib_mpool_bblock_primary_cast(pblk);
+    cblk = bplib_mpool_bblock_canonical_alloc(pool);
+    ccb  = bplib_mpool_bblock_canonical_cast(cblk);
+    if (cpb == NULL || ccb == NULL)
+    {
+        return NULL;
+    }
+
+    pri                               = bplib_mpool_bblock_primary_get_logical(cpb);
+    pri->version                      = 7;
+    pri->crctype                      = bp_crctype_CRC16;
+    pri->controlFlags.isAdminRecord   = (aggregate_list != NULL);
+    pri->controlFlags.mustNotFragment = true;
+
+    addr.node_number    = TEST_LOCAL_NODE;
+    addr.service_number = (aggregate_list != NULL) ? 0 : 1;
+    v7_set_eid(&pri->sourceEID, &addr);
+    v7_set_eid(&pri->reportEID, &addr);
+    addr.node_number = TEST_PEER_NODE;
+    v7_set_eid(&pri->destinationEID, &addr);
+
+    pri->creationTimeStamp.time         = 742176000000;
+    pri->creationTimeStamp.sequence_num = sequence_num;
+    pri->lifetime                       = 3600000;
+
+    pay                           = bplib_mpool_bblock_canonical_get_logical(ccb);
+    pay->canonical_block.blockNum = 1;
+    pay->canonical_block.crctype  = bp_crctype_CRC32C;
+
+    status = v7_block_encode_pri(cpb);
+    if (status == 0 && aggregate_list != NULL)
+    {
+        pay->canonical_block.blockType = bp_blocktype_bundleAggregatePayloadBlock;
+        status                         = v7_block_encode_pay_from_bundles(ccb, aggregate_list);
+    }
+    else if (status == 0)
+    {
+        pay->canonical_block.blockType = bp_blocktype_payloadBlock;
+        status                         = v7_block_encode_pay(ccb, payload_data, sizeof(payload_data));
+    }
+
+    if (status != 0)
+    {
+        return NULL;
+    }
+
+    bplib_mpool_bblock_primary_append(cpb, cblk);
+
+    refptr = bplib_mpool_ref_create(pblk);
+    if (refptr == NULL)
+    {
+        return NULL;
+    }
+
+    rblk = bplib_mpool_ref_make_block(refptr, TEST_BLOCKTYPE_BUNDLE, NULL);
+    bplib_mpool_ref_release(refptr);
+
+    return rblk;
+}
+
+/*--------------------------------------------------------------------------------------
+ * add_bundle - Adds a bundle to the list for an aggregate
+ *-------------------------------------------------------------------------------------*/
+static void add_bundle(bplib_mpool_block_t *list, bplib_mpool_block_t *rblk)
+{
+    if (ut_assert(rblk != NULL, "Failed to make bundle\n"))
+    {
+        bplib_mpool_insert_before(list, rblk);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * receive_bundle - Passes the encoded bundle in as if from a CLA
+ *-------------------------------------------------------------------------------------*/
+static int receive_bundle(bplib_mpool_block_t *rblk)
+{
+    size_t size;
+    int    status;
+
+    status = BP_ERROR;
+    if (ut_assert(rblk != NULL, "Failed to make bundle\n"))
+    {
+        size = v7_copy_full_bundle_out(bplib_mpool_bblock_primary_cast(rblk), encoded_data, sizeof(encoded_data));
+        if (ut_assert(size > 0, "Failed to encode bundle\n"))
+        {
+            status = bplib_generic_bundle_ingress(flow_ref, encoded_data, size, 0, false);
+        }
+        bplib_mpool_recycle_block(rblk);
+    }
+
+    return status;
+}
+
+/*--------------------------------------------------------------------------------------
+ * check_received - Checks the next bundle received, if sequence_num is 0 that there
+ *      are none left
+ *-------------------------------------------------------------------------------------*/
+static void check_received(bp_sequencenumber_t sequence_num)
+{
+    bplib_mpool_block_t          *rblk;
+    bplib_mpool_bblock_primary_t *cpb;
+
+    rblk = bplib_mpool_flow_try_pull(&flow->ingress, 0);
+    cpb  = bplib_mpool_bblock_primary_cast(rblk);
+    if (sequence_num == 0)
+    {
+        ut_assert(rblk == NULL, "Received more bundles than expected\n");
+    }
+    else if (ut_assert(cpb != NULL, "Failed to receive bundle %lu\n", (unsigned long)sequence_num))
+    {
+        ut_assert(bplib_mpool_bblock_primary_get_logical(cpb)->creationTimeStamp.sequence_num == sequence_num,
+                  "Received bundle %lu instead of %lu\n",
+                  (unsigned long)bplib_mpool_bblock_primary_get_logical(cpb)->creationTimeStamp.sequence_num,
+                  (unsigned long)sequence_num);
+        ut_assert(bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_payloadBlock) != NULL,
+                  "Received bundle has no payload\n");
+    }
+
+    if (rblk != NULL)
+    {
+        bplib_mpool_recycle_block(rblk);
+    }
+}
+
+/******************************************************************************
+ TEST FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * Test #1 - Aggregate of plain bundles
+ *--------------------------------------------------------------------------------------*/
+static void test_1(void)
+{
+    bplib_mpool_block_t list;
+    int                 status;
+
+    bplib_mpool_init_list_head(NULL, &list);
+
+    add_bundle(&list, make_bundle(1, NULL));
+    add_bundle(&list, make_bundle(2, NULL));
+    add_bundle(&list, make_bundle(3, NULL));
+
+    status = receive_bundle(make_bundle(100, &list));
+    ut_assert(status == BP_SUCCESS, "Failed to receive aggregate: %d\n", status);
+
+    check_received(1);
+    check_received(2);
+    check_received(3);
+    check_received(0);
+
+    bplib_mpool_recycle_all_blocks_in_list(NULL, &list);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #2 - Aggregate nested in an aggregate
+ *--------------------------------------------------------------------------------------*/
+static void test_2(void)
+{
+    bplib_mpool_block_t inner_list;
+    bplib_mpool_block_t outer_list;
+    int                 status;
+
+    bplib_mpool_init_list_head(NULL, &inner_list);
+    bplib_mpool_init_list_head(NULL, &outer_list);
+
+    add_bundle(&inner_list, make_bundle(11, NULL));
+    add_bundle(&inner_list, make_bundle(12, NULL));
+
+    add_bundle(&outer_list, make_bundle(10, NULL));
+    add_bundle(&outer_list, make_bundle(101, &inner_list));
+    add_bundle(&outer_list, make_bundle(13, NULL));
+
+    /* the bundles up to the nested aggregate get through, the nested one and the rest are dropped */
+    status = receive_bundle(make_bundle(102, &outer_list));
+    ut_assert(status != BP_SUCCESS, "Nested aggregate was accepted\n");
+
+    check_received(10);
+    check_received(0);
+
+    bplib_mpool_recycle_all_blocks_in_list(NULL, &inner_list);
+    bplib_mpool_recycle_all_blocks_in_list(NULL, &outer_list);
+}
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+int ut_aggregate(void)
+{
+    bplib_mpool_block_t *fblk;
+    size_t               i;
+
+    ut_reset();
+
+    /* Global Setup */
+
+    pool_mem = malloc(TEST_POOL_SIZE);
+    pool     = bplib_mpool_create(pool_mem, TEST_POOL_SIZE);
+    if (!ut_assert(pool != NULL, "Failed to create memory pool\n"))
+    {
+        free(pool_mem);
+        return ut_failures();
+    }
+
+    bplib_cla_init(pool);
+    bplib_mpool_register_blocktype(pool, TEST_BLOCKTYPE_BUNDLE, NULL, 0);
+    bplib_mpool_register_blocktype(pool, TEST_BLOCKTYPE_FLOW, NULL, 0);
+
+    fblk     = bplib_mpool_flow_alloc(pool, TEST_BLOCKTYPE_FLOW, NULL);
+    flow     = bplib_mpool_flow_cast(fblk);
+    flow_ref = bplib_mpool_ref_create(fblk);
+    if (!ut_assert(flow != NULL && flow_ref != NULL, "Failed to create flow\n"))
+    {
+        free(pool_mem);
+        return ut_failures();
+    }
+
+    bplib_mpool_flow_enable(&flow->ingress, BP_MPOOL_MAX_SUBQ_DEPTH);
+
+    for (i = 0; i < sizeof(payload_data); i++)
+    {
+        payload_data[i] = (uint8_t)(i * 3);
+    }
+
+    /* Test Cases */
+
+    test_1();
+    test_2();
+
+    /* Clean Up */
+
+    bplib_mpool_ref_release(flow_ref);
+    free(pool_mem);
+
+    return ut_failures();
+}
+
+#endif /* BPLIB_INCLUDE_BPV7 */
@@ -22,14 +22,31 @@
  INCLUDES
  ******************************************************************************/
 
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
 #include "bplib.h"
 #include "crc.h"
 #include "ut_assert.h"
 
+#if defined(UNITTEST_BENCHMARKS) && defined(__GNUC__) && defined(__x86_64__)
+#include <x86intrin.h>
+#define UT_CRC_HAVE_CYCLE_COUNTER
+#endif
+
 /******************************************************************************
- EXPORTED FUNCTIONS
+ DEFINES
  ******************************************************************************/
 
+#define UT_CRC_CHECK_VALUE_CRC16_X25   0x906E
+#define UT_CRC_CHECK_VALUE_CRC32_C     0xE3069283
+#define UT_CRC_COMPARE_BUFFER_SIZE     4096
+#define UT_CRC_COMPARE_TRIALS          2000
+#define UT_CRC_BENCHMARK_BUFFER_SIZE   65536
+#define UT_CRC_BENCHMARK_MIN_BYTES     (64 * 1024 * 1024)
+#define UT_CRC_COPY_CHUNK_SIZE         384 /* same as an mpool CBOR block */
+
 /******************************************************************************
  HELPER FUNCTIONS
  ******************************************************************************/
@@ -64,104 +81,377 @@ static void print_binary(const void *ptr, const size_t size, const int num_space
 }
 
 /*--------------------------------------------------------------------------------------
- * print_xor_table - Prints the xor table stored by the crc params.
+ * validate_crc_parameters_t - Validates that a bplib_crc_parameters properly computes its check
+ *      value when passed 123456789.
+ *
+ * params: A ptr to a bplib_crc_parameters struct defining how to calculate the crc. [INPUT]
+ * check_value: The expected CRC of the check message. [INPUT]
  *
- * params: A ptr to a crc params to print its xor table. [INPUT]
+ * returns: True or false indicating whether or not the crc matched its check value.
+ *-------------------------------------------------------------------------------------*/
+static bool validate_crc_parameters(bplib_crc_parameters_t *params, bp_crcval_t check_value)
+{
+    uint8_t     check_message[9] = {0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39};
+    bp_crcval_t crc;
+
+    printf("Input Message:\n");
+    print_binary(check_message, 9, 0);
+
+    crc = bplib_crc_get(check_message, 9, params);
+    printf("Check Value [%08lX]: ", (unsigned long)check_value);
+    print_binary(&check_value, bplib_crc_get_width(params) / 8, 0);
+    printf("CRC Output [%08lX]: ", (unsigned long)crc);
+    print_binary(&crc, bplib_crc_get_width(params) / 8, 0);
+
+    return crc == check_value;
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_crc16_vectors - generates the CRC for testing
+ *-------------------------------------------------------------------------------------*/
+static uint16_t test_crc16_vectors(bplib_crc_parameters_t *params, const uint8_t *vector, const int size)
+{
+    return (uint16_t)bplib_crc_get(vector, size, params);
+}
+
+/*--------------------------------------------------------------------------------------
+ * crc_in_two_parts - Calculates a CRC with two calls to bplib_crc_update, the way the
+ *      encoder and decoder do when a block is spread over several chunks.
+ *-------------------------------------------------------------------------------------*/
+static bp_crcval_t crc_in_two_parts(bplib_crc_parameters_t *params, const uint8_t *data, size_t size, size_t split)
+{
+    bp_crcval_t crc;
+
+    crc = bplib_crc_initial_value(params);
+    crc = bplib_crc_update(params, crc, data, split);
+    crc = bplib_crc_update(params, crc, data + split, size - split);
+
+    return bplib_crc_finalize(params, crc);
+}
+
+#ifdef UNITTEST_BENCHMARKS
+/*--------------------------------------------------------------------------------------
+ * copy_then_crc - Copies the data in chunks and then calculates the CRC over each chunk,
+ *      the same way the mpool stream did before the fused copy was available.
  *-------------------------------------------------------------------------------------*/
-static void print_xor_table(bplib_crc_parameters_t *params)
+static bp_crcval_t copy_then_crc(bplib_crc_parameters_t *params, bp_crcval_t crc, uint8_t *dest, const uint8_t *src,
+                                 size_t size)
 {
-    int index, i, j;
-    if (params->length == 16)
+    size_t chunk_sz;
+
+    while (size > 0)
     {
-        const uint16_t *table = params->n_bit_params.crc16.xor_table;
-        for (i = 0; i < 16; i++)
+        chunk_sz = (size < UT_CRC_COPY_CHUNK_SIZE) ? size : UT_CRC_COPY_CHUNK_SIZE;
+        memcpy(dest, src, chunk_sz);
+        crc = bplib_crc_update(params, crc, dest, chunk_sz);
+        dest += chunk_sz;
+        src += chunk_sz;
+        size -= chunk_sz;
+    }
+
+    return crc;
+}
+
+/*--------------------------------------------------------------------------------------
+ * copy_fused_crc - Same as copy_then_crc() but with the combined copy and digest.
+ *-------------------------------------------------------------------------------------*/
+static bp_crcval_t copy_fused_crc(bplib_crc_parameters_t *params, bp_crcval_t crc, uint8_t *dest, const uint8_t *src,
+                                  size_t size)
+{
+    size_t chunk_sz;
+
+    while (size > 0)
+    {
+        chunk_sz = (size < UT_CRC_COPY_CHUNK_SIZE) ? size : UT_CRC_COPY_CHUNK_SIZE;
+        crc      = bplib_crc_update_copy(params, crc, dest, src, chunk_sz);
+        dest += chunk_sz;
+        src += chunk_sz;
+        size -= chunk_sz;
+    }
+
+    return crc;
+}
+
+/*--------------------------------------------------------------------------------------
+ * read_cycle_counter - Returns a cycle count for the benchmark, or 0 if not available
+ *-------------------------------------------------------------------------------------*/
+static uint64_t read_cycle_counter(void)
+{
+#ifdef UT_CRC_HAVE_CYCLE_COUNTER
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+#endif
+
+/******************************************************************************
+ TEST FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * test_crc - Validates the check value for the crc.
+ *
+ * params: A ptr bplib_crc_parameters_t for testing the check value. [INPUT]
+ * check_value: The expected CRC of the check message. [INPUT]
+ *--------------------------------------------------------------------------------------*/
+static void test_crc(bplib_crc_parameters_t *params, bp_crcval_t check_value)
+{
+    printf("Testing CRC %s (%s)\n", bplib_crc_get_name(params), bplib_crc_get_impl_name(bplib_crc_get_impl()));
+    ut_assert(validate_crc_parameters(params, check_value), "Failed to validate %s\n", bplib_crc_get_name(params));
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_crc_impl_compare - Checks that an implementation gives the same results as the
+ *      table implementation for random data, lengths, alignments and split points.
+ *
+ * impl: The implementation to check. [INPUT]
+ *--------------------------------------------------------------------------------------*/
+static void test_crc_impl_compare(bplib_crc_impl_t impl)
+{
+    static uint8_t          buffer[UT_CRC_COMPARE_BUFFER_SIZE + 16];
+    bplib_crc_parameters_t *params[2] = {&BPLIB_CRC16_X25, &BPLIB_CRC32_CASTAGNOLI};
+    bp_crcval_t             ref_crc;
+    bp_crcval_t             crc;
+    size_t                  offset, size, split;
+    int                     trial, p;
+
+    srand(1234);
+    for (size = 0; size < sizeof(buffer); ++size)
+    {
+        buffer[size] = rand();
+    }
+
+    for (trial = 0; trial < UT_CRC_COMPARE_TRIALS; ++trial)
+    {
+        offset = rand() % 16;
+        size   = rand() % (UT_CRC_COMPARE_BUFFER_SIZE + 1);
+        split  = rand() % (size + 1);
+
+        for (p = 0; p < 2; ++p)
         {
-            for (j = 0; j < 16; j++)
+            bplib_crc_select_impl(bplib_crc_impl_table);
+            ref_crc = bplib_crc_get(buffer + offset, size, params[p]);
+
+            bplib_crc_select_impl(impl);
+            crc = crc_in_two_parts(params[p], buffer + offset, size, split);
+
+            if (!ut_assert(crc == ref_crc, "%s %s mismatch at size=%lu offset=%lu split=%lu: %08lX != %08lX\n",
+                           bplib_crc_get_impl_name(impl), bplib_crc_get_name(params[p]), (unsigned long)size,
+                           (unsigned long)offset, (unsigned long)split, (unsigned long)crc, (unsigned long)ref_crc))
             {
-                index = (16 * i) + j;
-                printf("%4x|", table[index]);
+                return;
             }
-            printf("\n");
         }
     }
-    else if (params->length == 32)
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_crc_copy - Checks that the combined copy and digest gives the same CRC as the
+ *      table implementation, and copies the data correctly, for an implementation.
+ *
+ * impl: The implementation to check. [INPUT]
+ *--------------------------------------------------------------------------------------*/
+static void test_crc_copy(bplib_crc_impl_t impl)
+{
+    static uint8_t          src[UT_CRC_COMPARE_BUFFER_SIZE + 16];
+    static uint8_t          dest[UT_CRC_COMPARE_BUFFER_SIZE + 16];
+    bplib_crc_parameters_t *params[3] = {&BPLIB_CRC16_X25, &BPLIB_CRC32_CASTAGNOLI, &BPLIB_CRC_NONE};
+    bp_crcval_t             ref_crc;
+    bp_crcval_t             crc;
+    size_t                  src_offset, dest_offset, size;
+    int                     trial, p;
+
+    srand(5678);
+    for (size = 0; size < sizeof(src); ++size)
+    {
+        src[size] = rand();
+    }
+
+    for (trial = 0; trial < UT_CRC_COMPARE_TRIALS; ++trial)
     {
-        const uint32_t *table = params->n_bit_params.crc32.xor_table;
-        for (i = 0; i < 16; i++)
+        src_offset  = rand() % 16;
+        dest_offset = rand() % 16;
+        size        = rand() % (UT_CRC_COMPARE_BUFFER_SIZE + 1);
+
+        for (p = 0; p < 3; ++p)
         {
-            for (j = 0; j < 16; j++)
+            bplib_crc_select_impl(bplib_crc_impl_table);
+            ref_crc = bplib_crc_get(src + src_offset, size, params[p]);
+
+            bplib_crc_select_impl(impl);
+            memset(dest, 0, sizeof(dest));
+            crc = bplib_crc_initial_value(params[p]);
+            crc = bplib_crc_update_copy(params[p], crc, dest + dest_offset, src + src_offset, size);
+            crc = bplib_crc_finalize(params[p], crc);
+
+            if (!ut_assert(crc == ref_crc && memcmp(dest + dest_offset, src + src_offset, size) == 0,
+                           "%s %s copy mismatch at size=%lu: %08lX != %08lX\n", bplib_crc_get_impl_name(impl),
+                           bplib_crc_get_name(params[p]), (unsigned long)size, (unsigned long)crc,
+                           (unsigned long)ref_crc))
             {
-                index = (16 * i) + j;
-                printf("%8x|", table[index]);
+                return;
             }
-            printf("\n");
         }
     }
 }
 
 /*--------------------------------------------------------------------------------------
- * validate_crc_parameters_t - Validates that a bplib_crc_parameters properly computes its check
- *      value when passed 123456789.
- *
- * params: A ptr to a bplib_crc_parameters struct defining how to calculate the crc and check it
- *      value. [INPUT]
- *
- * returns: True or false indicating whether or not the crc matched its check value.
- *-------------------------------------------------------------------------------------*/
-static bool validate_crc_parameters(bplib_crc_parameters_t *params)
+ * test_crc_combine - Checks that combining the CRCs of two parts of the data gives the
+ *      same CRC as calculating it over all the data, for random lengths and split points.
+ *--------------------------------------------------------------------------------------*/
+static void test_crc_combine(void)
 {
-    uint8_t check_message[9] = {0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39};
-    printf("Input Message:\n");
-    print_binary(check_message, 9, 0);
-    if (params->length == 16)
+    static uint8_t          buffer[UT_CRC_COMPARE_BUFFER_SIZE];
+    bplib_crc_parameters_t *params[3] = {&BPLIB_CRC16_X25, &BPLIB_CRC32_CASTAGNOLI, &BPLIB_CRC_NONE};
+    bp_crcval_t             ref_crc;
+    bp_crcval_t             crc;
+    bp_crcval_t             tail_crc;
+    size_t                  size, split;
+    int                     trial, p;
+
+    srand(9012);
+    for (size = 0; size < sizeof(buffer); ++size)
     {
-        uint16_t check_value = params->n_bit_params.crc16.check_value;
-        uint16_t crc         = (uint16_t)bplib_crc_get(check_message, 9, params);
-        printf("Check Value [%04X]: ", check_value);
-        print_binary(&check_value, 2, 0);
-        printf("CRC Output [%04X]: ", crc);
-        print_binary(&crc, 2, 0);
-        return crc == check_value;
+        buffer[size] = rand();
     }
-    else if (params->length == 32)
+
+    for (trial = 0; trial < UT_CRC_COMPARE_TRIALS; ++trial)
     {
-        uint32_t check_value = params->n_bit_params.crc32.check_value;
-        uint32_t crc         = (uint32_t)bplib_crc_get(check_message, 9, params);
-        printf("Check Value [%08X]: ", check_value);
-        print_binary(&check_value, 4, 0);
-        printf("CRC Output [%08X]: ", crc);
-        print_binary(&crc, 4, 0);
-        return crc == check_value;
-    }
+        size  = rand() % (UT_CRC_COMPARE_BUFFER_SIZE + 1);
+        split = rand() % (size + 1);
 
-    return false;
+        for (p = 0; p < 3; ++p)
+        {
+            ref_crc = bplib_crc_get(buffer, size, params[p]);
+
+            crc      = bplib_crc_update(params[p], bplib_crc_initial_value(params[p]), buffer, split);
+            tail_crc = bplib_crc_update(params[p], 0, buffer + split, size - split);
+            crc      = bplib_crc_finalize(params[p], bplib_crc_combine(params[p], crc, tail_crc, size - split));
+
+            if (!ut_assert(crc == ref_crc, "%s combine mismatch at size=%lu split=%lu: %08lX != %08lX\n",
+                           bplib_crc_get_name(params[p]), (unsigned long)size, (unsigned long)split,
+                           (unsigned long)crc, (unsigned long)ref_crc))
+            {
+                return;
+            }
+        }
+    }
 }
 
+#ifdef UNITTEST_BENCHMARKS
 /*--------------------------------------------------------------------------------------
- * test_crc16_vectors - generates the CRC for testing
- *-------------------------------------------------------------------------------------*/
-static uint16_t test_crc16_vectors(bplib_crc_parameters_t *params, const uint8_t *vector, const int size)
+ * benchmark_crc - Prints the throughput of each implementation, for comparison with the
+ *      table implementation.  This does not fail, the numbers depend on the machine.
+ *      Only built with BUILD_BENCHMARKS=1, as it is a timing run and not a check.
+ *--------------------------------------------------------------------------------------*/
+static void benchmark_crc(void)
 {
-    crc_init(params);
-    return (uint16_t)bplib_crc_get(vector, size, params);
-}
+    static uint8_t          buffer[UT_CRC_BENCHMARK_BUFFER_SIZE];
+    bplib_crc_parameters_t *params[2] = {&BPLIB_CRC16_X25, &BPLIB_CRC32_CASTAGNOLI};
+    volatile bp_crcval_t    sink;
+    bplib_crc_impl_t        impl;
+    clock_t                 start;
+    double                  elapsed;
+    double                  table_rate[2];
+    double                  rate;
+    size_t                  total;
+    int                     p;
 
-/******************************************************************************
- TEST FUNCTIONS
- ******************************************************************************/
+    memset(buffer, 0xA5, sizeof(buffer));
+
+    for (impl = 0; impl < bplib_crc_impl_max; ++impl)
+    {
+        bplib_crc_select_impl(impl);
+        for (p = 0; p < 2; ++p)
+        {
+            start = clock();
+            total = 0;
+            sink  = 0;
+            while (total < UT_CRC_BENCHMARK_MIN_BYTES)
+            {
+                sink ^= bplib_crc_get(buffer, sizeof(buffer), params[p]);
+                total += sizeof(buffer);
+            }
+            elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+            rate = (elapsed > 0) ? ((double)total / (1024.0 * 1024.0)) / elapsed : 0;
+            if (impl == bplib_crc_impl_table)
+            {
+                table_rate[p] = rate;
+            }
+
+            printf("CRC benchmark: %-20s %-34s %9.1f MiB/s (%.1fx table)\n", bplib_crc_get_name(params[p]),
+                   bplib_crc_get_impl_name(impl), rate, (table_rate[p] > 0) ? rate / table_rate[p] : 0);
+        }
+    }
+
+    (void)sink;
+}
+#endif
 
+#ifdef UNITTEST_BENCHMARKS
 /*--------------------------------------------------------------------------------------
- * test_crc - Populates a crc table and validates the check value for the crc.
- *
- * params: A ptr bplib_crc_parameters_t for initing the XOR table and testing the check value. [INPUT]
+ * benchmark_crc_copy - Prints the throughput of copying data into blocks while calculating
+ *      the CRC, as separate copy and CRC passes vs. the combined copy and digest.  This is the
+ *      work done by the mpool stream when a received bundle is saved.  Only built with
+ *      BUILD_BENCHMARKS=1.
  *--------------------------------------------------------------------------------------*/
-static void test_crc(bplib_crc_parameters_t *params)
+static void benchmark_crc_copy(void)
 {
-    printf("Testing CRC %s\n", params->name);
-    crc_init(params);
-    print_xor_table(params);
-    ut_assert(validate_crc_parameters(params), "Failed to validate %s\n", params->name);
+    static uint8_t          src[UT_CRC_BENCHMARK_BUFFER_SIZE];
+    static uint8_t          dest[UT_CRC_BENCHMARK_BUFFER_SIZE];
+    bplib_crc_parameters_t *params[2] = {&BPLIB_CRC16_X25, &BPLIB_CRC32_CASTAGNOLI};
+    volatile bp_crcval_t    sink;
+    bplib_crc_impl_t        impl;
+    uint64_t                start;
+    double                  bytes_per_cycle[2];
+    size_t                  total;
+    int                     p;
+    int                     fused;
+
+    if (read_cycle_counter() == 0)
+    {
+        printf("CRC copy benchmark: no cycle counter available, skipped\n");
+        return;
+    }
+
+    memset(src, 0x5A, sizeof(src));
+
+    for (impl = 0; impl < bplib_crc_impl_max; ++impl)
+    {
+        bplib_crc_select_impl(impl);
+        for (p = 0; p < 2; ++p)
+        {
+            for (fused = 0; fused < 2; ++fused)
+            {
+                start = read_cycle_counter();
+                total = 0;
+                sink  = 0;
+                while (total < UT_CRC_BENCHMARK_MIN_BYTES)
+                {
+                    if (fused)
+                    {
+                        sink ^= copy_fused_crc(params[p], 0, dest, src, sizeof(src));
+                    }
+                    else
+                    {
+                        sink ^= copy_then_crc(params[p], 0, dest, src, sizeof(src));
+                    }
+                    total += sizeof(src);
+                }
+                bytes_per_cycle[fused] = (double)total / (double)(read_cycle_counter() - start);
+            }
+
+            printf("CRC copy benchmark: %-20s %-34s copy+crc %5.2f -> fused %5.2f bytes/cycle\n",
+                   bplib_crc_get_name(params[p]), bplib_crc_get_impl_name(impl), bytes_per_cycle[0],
+                   bytes_per_cycle[1]);
+        }
+    }
+
+    (void)sink;
 }
+#endif
 
 /******************************************************************************
  EXPORTED FUNCTIONS
@@ -169,31 +459,64 @@ static void test_crc(bplib_crc_parameters_t *params)
 
 int ut_crc(void)
 {
+    bplib_crc_impl_t prev_impl;
+    bplib_crc_impl_t impl;
+
     ut_reset();
+    bplib_crc_init();
+    prev_impl = bplib_crc_get_impl();
+
+    for (impl = 0; impl < bplib_crc_impl_max; ++impl)
+    {
+        bplib_crc_select_impl(impl);
+
+        /* Test 1 */
+        test_crc(&BPLIB_CRC16_X25, UT_CRC_CHECK_VALUE_CRC16_X25);
+
+        /* Test 2 */
+        test_crc(&BPLIB_CRC32_CASTAGNOLI, UT_CRC_CHECK_VALUE_CRC32_C);
+
+        /* Test 3 */
+        uint8_t  v3[]        = {0x7, 0x46, 0x57, 0x37, 0x43, 0x25, 0xf7, 0x47, 0x26, 0x16, 0x36, 0x50};
+        uint16_t v3_crc      = 0x0A58;
+        uint16_t v3_crc_calc = test_crc16_vectors(&BPLIB_CRC16_X25, v3, sizeof(v3));
+        ut_assert(v3_crc_calc == v3_crc, "Failed to caluclate correct CRC16 for V3, %04X != %04X\n", v3_crc_calc,
+                  v3_crc);
+
+        /* Test 4 */
+        uint8_t  v4[]        = {0x07, 0x46, 0x57, 0x37, 0x45, 0xf7, 0x47, 0x26, 0x16, 0x36, 0x53, 0x60};
+        uint16_t v4_crc      = 0xD9A2;
+        uint16_t v4_crc_calc = test_crc16_vectors(&BPLIB_CRC16_X25, v4, sizeof(v4));
+        ut_assert(v4_crc_calc == v4_crc, "Failed to caluclate correct CRC16 for V4, %04X != %04X\n", v4_crc_calc,
+                  v4_crc);
+
+        /* Test 5 */
+        uint8_t  v5[]        = {0x74, 0x65, 0x73, 0x74, 0x5f, 0x74, 0x72, 0x61, 0x63, 0x65, 0x37};
+        uint16_t v5_crc      = 0x441A;
+        uint16_t v5_crc_calc = test_crc16_vectors(&BPLIB_CRC16_X25, v5, sizeof(v5));
+        ut_assert(v5_crc_calc == v5_crc, "Failed to caluclate correct CRC16 for V5, %04X != %04X\n", v5_crc_calc,
+                  v5_crc);
+
+        /* Test 6 */
+        if (impl != bplib_crc_impl_table)
+        {
+            test_crc_impl_compare(impl);
+        }
+
+        /* Test 7 */
+        test_crc_copy(impl);
+
+        /* Test 8 */
+        test_crc_combine();
+    }
+
+    /* Benchmark */
+#ifdef UNITTEST_BENCHMARKS
+    benchmark_crc();
+    benchmark_crc_copy();
+#endif
 
-    /* Test 1 */
-    test_crc(&BPLIB_CRC16_X25);
-
-    /* Test 2 */
-    test_crc(&BPLIB_CRC32_CASTAGNOLI);
-
-    /* Test 3 */
-    uint8_t  v3[]        = {0x7, 0x46, 0x57, 0x37, 0x43, 0x25, 0xf7, 0x47, 0x26, 0x16, 0x36, 0x50};
-    uint16_t v3_crc      = 0x0A58;
-    uint16_t v3_crc_calc = test_crc16_vectors(&crc16_x25, v3, sizeof(v3));
-    ut_assert(v3_crc_calc == v3_crc, "Failed to caluclate correct CRC16 for V3, %04X != %04X\n", v3_crc_calc, v3_crc);
-
-    /* Test 4 */
-    uint8_t  v4[]        = {0x07, 0x46, 0x57, 0x37, 0x45, 0xf7, 0x47, 0x26, 0x16, 0x36, 0x53, 0x60};
-    uint16_t v4_crc      = 0xD9A2;
-    uint16_t v4_crc_calc = test_crc16_vectors(&crc16_x25, v4, sizeof(v4));
-    ut_assert(v4_crc_calc == v4_crc, "Failed to caluclate correct CRC16 for V4, %04X != %04X\n", v4_crc_calc, v4_crc);
-
-    /* Test 5 */
-    uint8_t  v5[]        = {0x74, 0x65, 0x73, 0x74, 0x5f, 0x74, 0x72, 0x61, 0x63, 0x65, 0x37};
-    uint16_t v5_crc      = 0x441A;
-    uint16_t v5_crc_calc = test_crc16_vectors(&crc16_x25, v5, sizeof(v5));
-    ut_assert(v5_crc_calc == v5_crc, "Failed to caluclate correct CRC16 for V5, %04X != %04X\n", v5_crc_calc, v5_crc);
+    bplib_crc_select_impl(prev_impl);
 
     /* Return Failures */
     return ut_failures();
@@ -0,0 +1,649 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ut_assert.h"
+#include "bplib_store_file.h"
+
+/******************************************************************************
+ DEFINES
+ ******************************************************************************/
+
+#define TEST_ROOT_PATH       "." /* data files are named <service>_<file>.dat */
+#define TEST_FILE_OBJECTS    256 /* objects in a full data file, matches store/file.c */
+#define TEST_NUM_OBJECTS     600 /* two full data files, and part of a third */
+#define TEST_NUM_FILES       3
+#define TEST_DATA_SIZE       100
+#define TEST_MAX_DATA_SIZE   1000
+#define TEST_COMMIT_BYTES    4096
+#define TEST_COMMIT_LATENCY  20
+#define TEST_IO_DEPTH        2
+#define TEST_TIMEOUT         1000 /* milliseconds to wait for an object to be written */
+#define TEST_COMPACT_PERCENT 25
+#define TEST_COMPACT_WAIT    10 /* seconds */
+
+/******************************************************************************
+ FILE DATA
+ ******************************************************************************/
+
+static int               test_service_id; /* of the last data file opened */
+static bool              test_fail_writes;
+static volatile bp_sid_t test_committed_sid;
+static volatile int      test_commit_errors;
+static uint8_t           test_data[TEST_MAX_DATA_SIZE];
+
+/******************************************************************************
+ TEST AND DEBUGGING HELPER FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * test_open - Opens the file, noting the service ID the store names its data files with
+ *-------------------------------------------------------------------------------------*/
+static FILE *test_open(const char *filename, const char *modes)
+{
+    sscanf(filename, TEST_ROOT_PATH "/%d_", &test_service_id);
+
+    return fopen(filename, modes);
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_write - Writes through to the file, unless writes are set to fail
+ *-------------------------------------------------------------------------------------*/
+static size_t test_write(const void *src, size_t size, size_t n, FILE *stream)
+{
+    if (test_fail_writes)
+    {
+        return 0;
+    }
+
+    return fwrite(src, size, n, stream);
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_commit - Commit callback, checks that storage IDs are only ever reported in order
+ *-------------------------------------------------------------------------------------*/
+static void test_commit(void *parm, bp_handle_t h, bp_sid_t committed_sid)
+{
+    (void)parm;
+    (void)h;
+
+    if (committed_sid <= test_committed_sid)
+    {
+        test_commit_errors++;
+    }
+    test_committed_sid = committed_sid;
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_size - Size of the data of object i, varied so objects are not all alike
+ *-------------------------------------------------------------------------------------*/
+static size_t test_size(int i, size_t size)
+{
+    return size - (i % 16);
+}
+
+/*--------------------------------------------------------------------------------------
+ * create_store - Creates a file store for a test, with the commit callback set
+ *-------------------------------------------------------------------------------------*/
+static bp_handle_t create_store(int test, bp_file_attr_t *attr)
+{
+    bp_handle_t h;
+
+    attr->root_path       = TEST_ROOT_PATH;
+    attr->commit_callback = test_commit;
+
+    test_committed_sid = 0;
+    test_commit_errors = 0;
+    test_fail_writes   = false;
+
+    h = bplib_store_file_create(BP_STORE_DATA_TYPE, 0, test, false, attr);
+    ut_assert(bp_handle_is_valid(h), "Failed to create file store\n");
+
+    return h;
+}
+
+/*--------------------------------------------------------------------------------------
+ * enqueue_object - Enqueues object i, the first part of it as a separate buffer
+ *-------------------------------------------------------------------------------------*/
+static int enqueue_object(bp_handle_t h, int i, size_t size)
+{
+    char header[16];
+
+    bplib_os_format(header, sizeof(header), "object %d", i);
+    memset(test_data, i & 0xFF, sizeof(test_data));
+
+    return bplib_store_file_enqueue(h, header, sizeof(header), test_data, test_size(i, size), BP_PEND);
+}
+
+/*--------------------------------------------------------------------------------------
+ * enqueue_objects - Enqueues objects first to last, all expected to be accepted
+ *-------------------------------------------------------------------------------------*/
+static void enqueue_objects(bp_handle_t h, int first, int last, size_t size)
+{
+    int i;
+
+    for (i = first; i <= last; i++)
+    {
+        int status = enqueue_object(h, i, size);
+        ut_assert(status == BP_SUCCESS, "Failed (%d) to enqueue object %d\n", status, i);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * check_object - Checks that object is object i, with storage ID i + 1
+ *-------------------------------------------------------------------------------------*/
+static bool check_object(bp_object_t *object, int i, size_t size)
+{
+    char   header[16];
+    size_t data_size = test_size(i, size);
+    size_t d;
+
+    bplib_os_format(header, sizeof(header), "object %d", i);
+
+    if (!ut_assert(object->header.sid == (bp_sid_t)(i + 1), "Incorrect storage ID of object %d: %lu\n", i,
+                   (unsigned long)object->header.sid) ||
+        !ut_assert(object->header.size == sizeof(header) + data_size, "Incorrect size of object %d: %lu\n", i,
+                   (unsigned long)object->header.size) ||
+        !ut_assert(strcmp(object->data, header) == 0, "Incorrect header of object %d: %s\n", i, object->data))
+    {
+        return false;
+    }
+
+    for (d = 0; d < data_size; d++)
+    {
+        if (!ut_assert((uint8_t)object->data[sizeof(header) + d] == (i & 0xFF), "Incorrect data of object %d\n", i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/*--------------------------------------------------------------------------------------
+ * dequeue_objects - Dequeues and checks objects first to last, releasing each
+ *-------------------------------------------------------------------------------------*/
+static void dequeue_objects(bp_handle_t h, int first, int last, size_t size, bool relinquish)
+{
+    bp_object_t *object;
+    int          status;
+    int          i;
+
+    for (i = first; i <= last; i++)
+    {
+        status = bplib_store_file_dequeue(h, &object, TEST_TIMEOUT);
+        if (!ut_assert(status == BP_SUCCESS, "Failed (%d) to dequeue object %d\n", status, i))
+        {
+            return;
+        }
+
+        check_object(object, i, size);
+        bplib_store_file_release(h, object->header.sid);
+        if (relinquish)
+        {
+            bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * retrieve_object - Retrieves and checks object i, and releases it
+ *-------------------------------------------------------------------------------------*/
+static void retrieve_object(bp_handle_t h, int i, size_t size)
+{
+    bp_object_t *object;
+    int          status;
+
+    status = bplib_store_file_retrieve(h, (bp_sid_t)(i + 1), &object, TEST_TIMEOUT);
+    if (ut_assert(status == BP_SUCCESS, "Failed (%d) to retrieve object %d\n", status, i))
+    {
+        check_object(object, i, size);
+        bplib_store_file_release(h, (bp_sid_t)(i + 1));
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * file_size - Size of a data file of the store being tested, -1 if it does not exist
+ *-------------------------------------------------------------------------------------*/
+static long file_size(int file_id)
+{
+    char  filename[64];
+    FILE *fd;
+    long  size = -1;
+
+    bplib_os_format(filename, sizeof(filename), "%s/%d_%d.dat", TEST_ROOT_PATH, test_service_id, file_id);
+    fd = fopen(filename, "rb");
+    if (fd != NULL)
+    {
+        if (fseek(fd, 0, SEEK_END) == 0)
+        {
+            size = ftell(fd);
+        }
+        fclose(fd);
+    }
+
+    return size;
+}
+
+/*--------------------------------------------------------------------------------------
+ * destroy_store - Destroys the store being tested, and removes the data file it was
+ *      still writing, which is not deleted with the store
+ *-------------------------------------------------------------------------------------*/
+static void destroy_store(bp_handle_t h)
+{
+    char filename[64];
+    int  file_id;
+
+    bplib_store_file_destroy(h);
+
+    for (file_id = 0; file_id < TEST_NUM_FILES; file_id++)
+    {
+        bplib_os_format(filename, sizeof(filename), "%s/%d_%d.dat", TEST_ROOT_PATH, test_service_id, file_id);
+        remove(filename);
+        bplib_os_format(filename, sizeof(filename), "%s/%d_%d.tbl", TEST_ROOT_PATH, test_service_id, file_id);
+        remove(filename);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * run_file_boundary - Enqueues, dequeues, and retrieves objects across data files
+ *-------------------------------------------------------------------------------------*/
+static void run_file_boundary(int test, int io_depth)
+{
+    bp_file_attr_t attr = {.commit_bytes = TEST_COMMIT_BYTES, .io_depth = io_depth};
+    bp_object_t   *object;
+    bp_handle_t    h;
+    int            status;
+    int            i;
+
+    h = create_store(test, &attr);
+
+    printf("\n==== Step %d.1: Enqueue Across Data Files ====\n", test);
+    enqueue_objects(h, 0, TEST_NUM_OBJECTS - 1, TEST_DATA_SIZE);
+    ut_assert(bplib_store_file_getcount(h) == TEST_NUM_OBJECTS, "Incorrect count: %d\n",
+              bplib_store_file_getcount(h));
+
+    printf("\n==== Step %d.2: Commit ====\n", test);
+    status = bplib_store_file_commit(h);
+    ut_assert(status == BP_SUCCESS, "Failed (%d) to commit\n", status);
+    ut_assert(test_committed_sid == TEST_NUM_OBJECTS, "Incorrect last committed object: %lu\n",
+              (unsigned long)test_committed_sid);
+    ut_assert(test_commit_errors == 0, "Committed objects reported out of order\n");
+    ut_assert(file_size(0) > 0 && file_size(1) > 0 && file_size(2) > 0,
+              "Failed to write three data files\n");
+
+    printf("\n==== Step %d.3: Dequeue Across Data Files ====\n", test);
+    dequeue_objects(h, 0, TEST_NUM_OBJECTS - 1, TEST_DATA_SIZE, false);
+    status = bplib_store_file_dequeue(h, &object, BP_CHECK);
+    ut_assert(status == BP_TIMEOUT, "Dequeued (%d) more objects than enqueued\n", status);
+
+    printf("\n==== Step %d.4: Retrieve Either Side of Each Boundary ====\n", test);
+    for (i = TEST_FILE_OBJECTS - 2; i < TEST_NUM_OBJECTS; i += TEST_FILE_OBJECTS)
+    {
+        retrieve_object(h, i + 2, TEST_DATA_SIZE);
+        retrieve_object(h, i, TEST_DATA_SIZE);
+        retrieve_object(h, i + 1, TEST_DATA_SIZE);
+        retrieve_object(h, i - 1, TEST_DATA_SIZE);
+    }
+
+    printf("\n==== Step %d.5: Relinquish All ====\n", test);
+    for (i = 0; i < TEST_NUM_OBJECTS; i++)
+    {
+        bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+    }
+    ut_assert(bplib_store_file_getcount(h) == 0, "Incorrect count: %d\n", bplib_store_file_getcount(h));
+    ut_assert(file_size(0) < 0 && file_size(1) < 0, "Failed to delete full data files\n");
+
+    destroy_store(h);
+}
+
+/*--------------------------------------------------------------------------------------
+ * run_write_error - Fails writes, and checks that accepted objects are written once
+ *      writes work again, with none dropped and no storage IDs reused
+ *-------------------------------------------------------------------------------------*/
+static void run_write_error(int test, int io_depth)
+{
+    bp_file_attr_t attr = {.io_depth = io_depth}; /* default write-behind buffer holds a data file of objects */
+    bp_object_t   *object;
+    bp_handle_t    h;
+    int            status;
+    int            i;
+
+    h = create_store(test, &attr);
+
+    printf("\n==== Step %d.1: Write Some Objects ====\n", test);
+    enqueue_objects(h, 0, 9, TEST_DATA_SIZE);
+    status = bplib_store_file_commit(h);
+    ut_assert(status == BP_SUCCESS, "Failed (%d) to commit\n", status);
+    ut_assert(test_committed_sid == 10, "Incorrect last committed object: %lu\n", (unsigned long)test_committed_sid);
+
+    printf("\n==== Step %d.2: Accept Objects while Writes Fail ====\n", test);
+    test_fail_writes = true;
+    enqueue_objects(h, 10, 19, TEST_DATA_SIZE);
+    status = bplib_store_file_commit(h);
+    ut_assert(status != BP_SUCCESS, "Committed objects while writes fail\n");
+    ut_assert(test_committed_sid == 10, "Objects reported durable while writes fail: %lu\n",
+              (unsigned long)test_committed_sid);
+
+    printf("\n==== Step %d.3: Dequeue Written, but not Failed Objects ====\n", test);
+    dequeue_objects(h, 0, 9, TEST_DATA_SIZE, false);
+    status = bplib_store_file_dequeue(h, &object, BP_CHECK);
+    ut_assert(status != BP_SUCCESS, "Dequeued object that was not written\n");
+
+    printf("\n==== Step %d.4: Accept Objects to End of Data File, but not into Next ====\n", test);
+    enqueue_objects(h, 20, TEST_FILE_OBJECTS - 1, TEST_DATA_SIZE);
+    status = enqueue_object(h, TEST_FILE_OBJECTS, TEST_DATA_SIZE);
+    ut_assert(status != BP_SUCCESS, "Started new data file while writes fail\n");
+    ut_assert(bplib_store_file_getcount(h) == TEST_FILE_OBJECTS, "Incorrect count: %d\n",
+              bplib_store_file_getcount(h));
+
+    printf("\n==== Step %d.5: Write Accepted Objects Once Writes Work ====\n", test);
+    test_fail_writes = false;
+    status           = bplib_store_file_commit(h);
+    ut_assert(status == BP_SUCCESS, "Failed (%d) to commit\n", status);
+    ut_assert(test_committed_sid == TEST_FILE_OBJECTS, "Incorrect last committed object: %lu\n",
+              (unsigned long)test_committed_sid);
+    ut_assert(test_commit_errors == 0, "Committed objects reported out of order\n");
+
+    printf("\n==== Step %d.6: Continue into Next Data File ====\n", test);
+    enqueue_objects(h, TEST_FILE_OBJECTS, TEST_FILE_OBJECTS + 9, TEST_DATA_SIZE);
+    dequeue_objects(h, 10, TEST_FILE_OBJECTS + 9, TEST_DATA_SIZE, false);
+    retrieve_object(h, 15, TEST_DATA_SIZE);
+
+    printf("\n==== Step %d.7: Relinquish All ====\n", test);
+    for (i = 0; i < TEST_FILE_OBJECTS + 10; i++)
+    {
+        bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+    }
+    ut_assert(bplib_store_file_getcount(h) == 0, "Incorrect count: %d\n", bplib_store_file_getcount(h));
+
+    destroy_store(h);
+}
+
+/******************************************************************************
+ TEST FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * Test #1
+ *--------------------------------------------------------------------------------------*/
+static void test_1(void)
+{
+    printf("==== Test 1: Write-Behind Across Data Files ====\n");
+
+    run_file_boundary(1, 0);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #2
+ *--------------------------------------------------------------------------------------*/
+static void test_2(void)
+{
+    printf("\n==== Test 2: Write Errors ====\n");
+
+    run_write_error(2, 0);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #3
+ *--------------------------------------------------------------------------------------*/
+static void test_3(void)
+{
+    bp_file_attr_t attr = {.commit_bytes = TEST_COMMIT_BYTES};
+    bp_object_t   *object;
+    bp_handle_t    h;
+    int            status;
+    int            i;
+
+    printf("\n==== Test 3: Retrieve by Index ====\n");
+
+    h = create_store(3, &attr);
+    enqueue_objects(h, 0, TEST_NUM_OBJECTS - 1, TEST_MAX_DATA_SIZE);
+    dequeue_objects(h, 0, TEST_NUM_OBJECTS - 1, TEST_MAX_DATA_SIZE, false);
+
+    printf("\n==== Step 3.1: Retrieve Alternating between Data Files ====\n");
+    for (i = 0; i < TEST_FILE_OBJECTS; i += 7)
+    {
+        retrieve_object(h, TEST_FILE_OBJECTS - 1 - i, TEST_MAX_DATA_SIZE);
+        retrieve_object(h, TEST_FILE_OBJECTS + i, TEST_MAX_DATA_SIZE);
+        retrieve_object(h, TEST_NUM_OBJECTS - 1 - (i % (TEST_NUM_OBJECTS - (2 * TEST_FILE_OBJECTS))),
+                        TEST_MAX_DATA_SIZE);
+    }
+
+    printf("\n==== Step 3.2: Retrieve First and Last of Each Data File ====\n");
+    for (i = 0; i < TEST_NUM_OBJECTS; i += TEST_FILE_OBJECTS)
+    {
+        retrieve_object(h, i, TEST_MAX_DATA_SIZE);
+    }
+    for (i = TEST_FILE_OBJECTS - 1; i < TEST_NUM_OBJECTS; i += TEST_FILE_OBJECTS)
+    {
+        retrieve_object(h, i, TEST_MAX_DATA_SIZE);
+    }
+
+    printf("\n==== Step 3.3: Retrieve Object Never Enqueued ====\n");
+    status = bplib_store_file_retrieve(h, TEST_NUM_OBJECTS + 1, &object, BP_CHECK);
+    ut_assert(status != BP_SUCCESS, "Retrieved object never enqueued\n");
+    retrieve_object(h, TEST_NUM_OBJECTS - 1, TEST_MAX_DATA_SIZE);
+
+    for (i = 0; i < TEST_NUM_OBJECTS; i++)
+    {
+        bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+    }
+
+    destroy_store(h);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #4
+ *--------------------------------------------------------------------------------------*/
+static void test_4(void)
+{
+    bp_file_attr_t attr = {.commit_bytes = TEST_COMMIT_BYTES, .map_on_read = true};
+    bp_object_t   *object;
+    bp_object_t   *held_object;
+    bp_handle_t    h;
+    int            status;
+    int            i;
+
+    printf("\n==== Test 4: Mapped Reads ====\n");
+
+    h = create_store(4, &attr);
+    enqueue_objects(h, 0, TEST_NUM_OBJECTS - 1, TEST_DATA_SIZE);
+
+    printf("\n==== Step 4.1: Dequeue, Holding One Object of a Full Data File ====\n");
+    held_object = NULL;
+    for (i = 0; i < TEST_NUM_OBJECTS; i++)
+    {
+        status = bplib_store_file_dequeue(h, &object, TEST_TIMEOUT);
+        if (!ut_assert(status == BP_SUCCESS, "Failed (%d) to dequeue object %d\n", status, i))
+        {
+            break;
+        }
+
+        check_object(object, i, TEST_DATA_SIZE);
+        if (i == 10)
+        {
+            held_object = object;
+        }
+        else
+        {
+            bplib_store_file_release(h, object->header.sid);
+        }
+    }
+
+    printf("\n==== Step 4.2: Relinquish Others in Data File of Held Object ====\n");
+    for (i = 0; i < TEST_FILE_OBJECTS; i++)
+    {
+        if (i != 10)
+        {
+            bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+        }
+    }
+    if (ut_assert(held_object != NULL, "Failed to hold object\n"))
+    {
+        check_object(held_object, 10, TEST_DATA_SIZE);
+    }
+    ut_assert(file_size(0) > 0, "Deleted data file of live object\n");
+
+    printf("\n==== Step 4.3: Release and Retrieve Mapped Objects ====\n");
+    status = bplib_store_file_release(h, 11);
+    ut_assert(status == BP_SUCCESS, "Failed (%d) to release held object\n", status);
+    retrieve_object(h, 10, TEST_DATA_SIZE);
+    for (i = TEST_FILE_OBJECTS; i < TEST_NUM_OBJECTS; i += 13)
+    {
+        retrieve_object(h, i, TEST_DATA_SIZE);
+    }
+
+    printf("\n==== Step 4.4: Relinquish All ====\n");
+    bplib_store_file_relinquish(h, 11);
+    ut_assert(file_size(0) < 0, "Failed to delete data file once all relinquished\n");
+    for (i = TEST_FILE_OBJECTS; i < TEST_NUM_OBJECTS; i++)
+    {
+        bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+    }
+    ut_assert(bplib_store_file_getcount(h) == 0, "Incorrect count: %d\n", bplib_store_file_getcount(h));
+    ut_assert(file_size(1) < 0, "Failed to delete data file once all relinquished\n");
+
+    destroy_store(h);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #5
+ *--------------------------------------------------------------------------------------*/
+static void test_5(void)
+{
+    printf("\n==== Test 5: I/O Thread Across Data Files ====\n");
+
+    run_file_boundary(5, TEST_IO_DEPTH);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #6
+ *--------------------------------------------------------------------------------------*/
+static void test_6(void)
+{
+    printf("\n==== Test 6: I/O Thread Write Errors ====\n");
+
+    run_write_error(6, TEST_IO_DEPTH);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #7
+ *--------------------------------------------------------------------------------------*/
+static void test_7(void)
+{
+    bp_file_attr_t attr = {.commit_bytes         = TEST_COMMIT_BYTES,
+                           .commit_latency       = TEST_COMMIT_LATENCY,
+                           .io_depth             = TEST_IO_DEPTH,
+                           .compact_live_percent = TEST_COMPACT_PERCENT};
+    bp_object_t   *object;
+    bp_handle_t    h;
+    long           full_size;
+    int            status;
+    int            i;
+
+    printf("\n==== Test 7: Compaction ====\n");
+
+    h = create_store(7, &attr);
+    enqueue_objects(h, 0, TEST_NUM_OBJECTS - 1, TEST_MAX_DATA_SIZE);
+
+    printf("\n==== Step 7.1: Relinquish All but One in Eight of Full Data Files ====\n");
+    dequeue_objects(h, 0, TEST_NUM_OBJECTS - 1, TEST_MAX_DATA_SIZE, false);
+    full_size = file_size(0);
+    for (i = 0; i < 2 * TEST_FILE_OBJECTS; i++)
+    {
+        if (i % 8 != 3)
+        {
+            bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+        }
+    }
+
+    printf("\n==== Step 7.2: Wait for Compaction ====\n");
+    for (i = 0; i < TEST_COMPACT_WAIT; i++)
+    {
+        if (file_size(0) < (full_size / 4) && file_size(1) < (full_size / 4))
+        {
+            break;
+        }
+        bplib_os_sleep(1);
+    }
+    ut_assert(file_size(0) > 0 && file_size(0) < (full_size / 4), "Failed to compact data file 0: %ld\n",
+              file_size(0));
+    ut_assert(file_size(1) > 0 && file_size(1) < (full_size / 4), "Failed to compact data file 1: %ld\n",
+              file_size(1));
+
+    printf("\n==== Step 7.3: Retrieve Survivors ====\n");
+    for (i = 0; i < TEST_NUM_OBJECTS; i++)
+    {
+        if (i % 8 == 3 || i >= 2 * TEST_FILE_OBJECTS)
+        {
+            retrieve_object(h, i, TEST_MAX_DATA_SIZE);
+        }
+    }
+    status = bplib_store_file_retrieve(h, 1, &object, BP_CHECK);
+    ut_assert(status != BP_SUCCESS, "Retrieved relinquished object from compacted file\n");
+
+    printf("\n==== Step 7.4: Relinquish All ====\n");
+    for (i = 0; i < TEST_NUM_OBJECTS; i++)
+    {
+        if (i % 8 == 3 || i >= 2 * TEST_FILE_OBJECTS)
+        {
+            bplib_store_file_relinquish(h, (bp_sid_t)(i + 1));
+        }
+    }
+    ut_assert(bplib_store_file_getcount(h) == 0, "Incorrect count: %d\n", bplib_store_file_getcount(h));
+    ut_assert(file_size(0) < 0 && file_size(1) < 0, "Failed to delete compacted data files\n");
+
+    destroy_store(h);
+}
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+int ut_file(void)
+{
+    bp_file_driver_t test_driver = {
+        .open = test_open, .close = fclose, .read = fread, .write = test_write, .seek = fseek, .flush = fflush};
+    bp_file_driver_t file_driver = {
+        .open = fopen, .close = fclose, .read = fread, .write = fwrite, .seek = fseek, .flush = fflush};
+
+    ut_reset();
+
+    bplib_store_file_init(&test_driver);
+
+    test_1();
+    test_2();
+    test_3();
+    test_4();
+    test_5();
+    test_6();
+    test_7();
+
+    bplib_store_file_init(&file_driver);
+
+    return ut_failures();
+}
@@ -22,6 +22,8 @@
  INCLUDES
  ******************************************************************************/
 
+#include <string.h>
+
 #include "ut_assert.h"
 #include "bplib_store_flash.h"
 #include "bplib_flash_sim.h"
@@ -39,13 +41,26 @@
 #define TEST_DATA_SIZE (TEST_PAGE_DATA_SIZE * 3 + 200)
 #define NUM_BUNDLES    200
 
+#define TEST_WEAR_BUCKETS 64 /* matches FLASH_WEAR_BUCKETS in store/flash.c */
+
+/******************************************************************************
+ TYPEDEFS
+ ******************************************************************************/
+
+/* Matches store/flash.c */
+typedef struct
+{
+    const uint8_t *data;
+    int            size;
+} flash_segment_t;
+
 /******************************************************************************
  EXTERNAL PROTOTYPES
  ******************************************************************************/
 
 extern int flash_free_reclaim(bp_flash_index_t block);
-extern int flash_free_allocate(bp_flash_index_t *block);
-extern int flash_data_write(bp_flash_addr_t *addr, uint8_t *data, int size);
+extern int flash_free_allocate(bp_flash_index_t *block, bool cold);
+extern int flash_data_write(bp_flash_addr_t *addr, const flash_segment_t *segments, int num_segments, bool cold);
 extern int flash_data_read(bp_flash_addr_t *addr, uint8_t *data, int size);
 
 /******************************************************************************
@@ -61,6 +76,19 @@ static bp_flash_driver_t flash_driver = {.num_blocks      = FLASH_SIM_NUM_BLOCKS
                                          .isbad           = bplib_flash_sim_block_is_bad,
                                          .phyblk          = bplib_flash_sim_physical_block};
 
+static bp_flash_driver_t flash_batch_driver = {.num_blocks      = FLASH_SIM_NUM_BLOCKS,
+                                               .pages_per_block = FLASH_SIM_PAGES_PER_BLOCK,
+                                               .page_size       = TEST_PAGE_DATA_SIZE,
+                                               .read            = bplib_flash_sim_page_read,
+                                               .write           = bplib_flash_sim_page_write,
+                                               .erase           = bplib_flash_sim_block_erase,
+                                               .isbad           = bplib_flash_sim_block_is_bad,
+                                               .phyblk          = bplib_flash_sim_physical_block,
+                                               .read_pages      = bplib_flash_sim_pages_read,
+                                               .write_pages     = bplib_flash_sim_pages_start,
+                                               .write_wait      = bplib_flash_sim_write_wait,
+                                               .batch_pages     = FLASH_SIM_NUM_PLANES};
+
 static uint8_t test_data[TEST_DATA_SIZE], read_data[TEST_DATA_SIZE];
 
 /******************************************************************************
@@ -83,7 +111,8 @@ static void test_1(void)
     printf("\n==== Step 1.1: Allocate All ====\n");
     for (i = 0; i < flash_driver.num_blocks; i++)
     {
-        ut_assert(flash_free_allocate(&block) == BP_SUCCESS, "Failed to allocate block on %dth iteration\n", i);
+        ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block on %dth iteration\n",
+                  i);
     }
 
     printf("\n==== Step 1.2: Reclaim All In Reverse Order ====\n");
@@ -95,13 +124,13 @@ static void test_1(void)
     printf("\n==== Step 1.3: Re-Allocate All ====\n");
     for (i = 0; i < flash_driver.num_blocks; i++)
     {
-        ut_assert(flash_free_allocate(&block) == BP_SUCCESS, "Failed to allocate block\n");
+        ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
         ut_assert(block == flash_driver.num_blocks - i - 1, "Failed to allocate block %d, allocated %d instead\n",
                   flash_driver.num_blocks - i - 1, block);
     }
 
     printf("\n==== Step 1.4: Attempt Allocate On Empty List ====\n");
-    ut_assert(flash_free_allocate(&block) == BP_ERROR,
+    ut_assert(flash_free_allocate(&block, false) == BP_ERROR,
               "Incorrectly succeeded to allocate block when no blocks available\n");
 
     /* Uninitialize Driver */
@@ -113,8 +142,9 @@ static void test_1(void)
  *--------------------------------------------------------------------------------------*/
 static void test_2(void)
 {
-    int i, j;
-    int h[FLASH_MAX_STORES];
+    int         i;
+    bp_handle_t h[FLASH_MAX_STORES];
+    bp_handle_t j;
 
     printf("\n==== Test 2: Service Creation/Deletion ====\n");
 
@@ -125,33 +155,36 @@ static void test_2(void)
     for (i = 0; i < FLASH_MAX_STORES; i++)
     {
         h[i] = bplib_store_flash_create(0, 0, 0, false, NULL);
-        ut_assert(h[i] != BP_INVALID_HANDLE, "Failed to create store on %dth iteration\n", i);
+        ut_assert(bp_handle_is_valid(h[i]), "Failed to create store on %dth iteration\n", i);
     }
 
     printf("\n==== Step 2.2: Check Full ====\n");
     j = bplib_store_flash_create(0, 0, 0, false, NULL);
-    ut_assert(j == BP_INVALID_HANDLE, "Incorrectly created store when no more handles available\n");
+    ut_assert(!bp_handle_is_valid(j), "Incorrectly created store when no more handles available\n");
 
     printf("\n==== Step 2.2: Clean Up Stores ====\n");
     for (i = 0; i < FLASH_MAX_STORES; i++)
     {
-        ut_assert(bplib_store_flash_destroy(h[i]) == BP_SUCCESS, "Failed to destroy handle %d\n", h[i]);
+        ut_assert(bplib_store_flash_destroy(h[i]) == BP_SUCCESS, "Failed to destroy handle %d\n",
+                  bp_handle_printable(h[i]));
     }
 
     printf("\n==== Step 2.3: Check Holes ====\n");
     for (i = 0; i < FLASH_MAX_STORES; i++)
     {
         h[i] = bplib_store_flash_create(0, 0, 0, false, NULL);
-        ut_assert(h[i] != BP_INVALID_HANDLE, "Failed to create store on %dth iteration\n", i);
+        ut_assert(bp_handle_is_valid(h[i]), "Failed to create store on %dth iteration\n", i);
     }
-    ut_assert(bplib_store_flash_destroy(h[3]) == BP_SUCCESS, "Failed to destroy handle %d\n", h[3]);
+    ut_assert(bplib_store_flash_destroy(h[3]) == BP_SUCCESS, "Failed to destroy handle %d\n",
+              bp_handle_printable(h[3]));
     h[3] = bplib_store_flash_create(0, 0, 0, false, NULL);
-    ut_assert(h[3] != BP_INVALID_HANDLE, "Failed to create store\n", i);
+    ut_assert(bp_handle_is_valid(h[3]), "Failed to create store\n");
 
     printf("\n==== Step 2.4: Clean Up Stores ====\n");
     for (i = 0; i < FLASH_MAX_STORES; i++)
     {
-        ut_assert(bplib_store_flash_destroy(h[i]) == BP_SUCCESS, "Failed to destroy handle %d\n", h[i]);
+        ut_assert(bplib_store_flash_destroy(h[i]) == BP_SUCCESS, "Failed to destroy handle %d\n",
+                  bp_handle_printable(h[i]));
     }
 
     /* Uninitialize Driver */
@@ -180,13 +213,14 @@ static void test_3(void)
     }
 
     /* Write Test Data */
-    status = flash_free_allocate(&addr.block);
+    status = flash_free_allocate(&addr.block, false);
     ut_assert(status == BP_SUCCESS, "Failed to allocate free block\n");
     if (status == BP_SUCCESS)
     {
         bp_flash_index_t saved_block = addr.block;
+        flash_segment_t  segment     = {test_data, TEST_DATA_SIZE};
         addr.page                    = 0;
-        status                       = flash_data_write(&addr, test_data, TEST_DATA_SIZE);
+        status                       = flash_data_write(&addr, &segment, 1, false);
         ut_assert(status == BP_SUCCESS, "Failed to write data: %d\n", status);
         ut_assert(addr.page > 0, "Failed to increment page number: %d\n", addr.page);
 
@@ -212,7 +246,8 @@ static void test_3(void)
  *--------------------------------------------------------------------------------------*/
 static void test_4(void)
 {
-    int i, h;
+    int         i;
+    bp_handle_t h;
 
     printf("\n==== Test 4: Enqueue/Dequeue ====\n");
 
@@ -230,7 +265,7 @@ static void test_4(void)
     /* Create Storage Service */
     bp_flash_attr_t attr = {TEST_DATA_SIZE};
     h                    = bplib_store_flash_create(0, 0, 0, false, &attr);
-    ut_assert(h != BP_INVALID_HANDLE, "Failed to create storage service\n", i);
+    ut_assert(bp_handle_is_valid(h), "Failed to create storage service\n");
 
     /* Enqueue/Dequeue Test Data */
     bp_object_t *object = NULL;
@@ -239,10 +274,10 @@ static void test_4(void)
     ut_assert(bplib_store_flash_dequeue(h, &object, BP_CHECK) == BP_SUCCESS, "Failed to enqueue test data\n");
     if (object != NULL)
     {
-        ut_assert(object->header.handle == h, "Incorrect handle in dequeued object: %d != %d\n", object->header.handle,
-                  h);
+        ut_assert(bp_handle_equal(object->header.handle, h), "Incorrect handle in dequeued object: %d != %d\n",
+                  bp_handle_printable(object->header.handle), bp_handle_printable(h));
         ut_assert(object->header.size == TEST_DATA_SIZE, "Incorrect size in dequeued object: %d != %d\n",
-                  object->header.size, TEST_DATA_SIZE);
+                  (int)object->header.size, TEST_DATA_SIZE);
         for (i = 0; i < TEST_DATA_SIZE; i++)
         {
             ut_assert((uint8_t)object->data[i] == test_data[i], "Failed to dequeue correct data at %d, %02X != %02X\n",
@@ -366,8 +401,9 @@ static void test_5(void)
  *--------------------------------------------------------------------------------------*/
 static void test_6(void)
 {
-    int      i, h, b;
-    bp_sid_t sids[NUM_BUNDLES];
+    int         i, b;
+    bp_handle_t h;
+    bp_sid_t    sids[NUM_BUNDLES];
 
     printf("\n==== Test 6: Relinquish ====\n");
 
@@ -385,7 +421,7 @@ static void test_6(void)
     /* Create Storage Service */
     bp_flash_attr_t attr = {TEST_DATA_SIZE};
     h                    = bplib_store_flash_create(0, 0, 0, false, &attr);
-    ut_assert(h != BP_INVALID_HANDLE, "Failed to create storage service\n", i);
+    ut_assert(bp_handle_is_valid(h), "Failed to create storage service\n");
 
     /* Enqueue Test Data */
     for (b = 0; b < NUM_BUNDLES; b++)
@@ -416,6 +452,203 @@ static void test_6(void)
     bplib_store_flash_uninit();
 }
 
+/*--------------------------------------------------------------------------------------
+ * Test #7
+ *--------------------------------------------------------------------------------------*/
+static void test_7(void)
+{
+    int         i, e;
+    bp_handle_t h;
+
+    printf("\n==== Test 7: Batched and Asynchronous Page Operations ====\n");
+
+    /* Initialize Test Data */
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+    {
+        test_data[i] = i % 0xFF;
+    }
+
+    /* Without and With Software ECC */
+    for (e = 0; e < 2; e++)
+    {
+        int reclaimed_blocks = bplib_store_flash_init(flash_batch_driver, e == 1);
+        ut_assert(reclaimed_blocks == 256, "Failed to reclaim all blocks\n");
+
+        /* Create Storage Service */
+        bp_flash_attr_t attr = {TEST_DATA_SIZE};
+        h                    = bplib_store_flash_create(0, 0, 0, false, &attr);
+        ut_assert(bp_handle_is_valid(h), "Failed to create storage service\n");
+
+        /* Enqueue/Dequeue Test Data - split so that pages are gathered across both parts */
+        bp_object_t *object = NULL;
+        ut_assert(bplib_store_flash_enqueue(h, test_data, 100, &test_data[100], TEST_DATA_SIZE - 100, BP_CHECK) ==
+                      BP_SUCCESS,
+                  "Failed to enqueue test data\n");
+        ut_assert(bplib_store_flash_dequeue(h, &object, BP_CHECK) == BP_SUCCESS, "Failed to dequeue test data\n");
+        if (object != NULL)
+        {
+            ut_assert(object->header.size == TEST_DATA_SIZE, "Incorrect size in dequeued object: %d != %d\n",
+                      (int)object->header.size, TEST_DATA_SIZE);
+            ut_assert(memcmp(object->data, test_data, TEST_DATA_SIZE) == 0, "Failed to dequeue correct data\n");
+            ut_assert(bplib_store_flash_release(h, object->header.sid) == BP_SUCCESS, "Failed to release object\n");
+            ut_assert(bplib_store_flash_relinquish(h, object->header.sid) == BP_SUCCESS,
+                      "Failed to relinquish object\n");
+        }
+        else
+        {
+            ut_assert(false, "Failed to dequeue object\n");
+        }
+
+        /* Check for Errors */
+        bp_flash_stats_t stats;
+        bplib_store_flash_stats(&stats, false, false);
+        ut_assert(stats.error_count == 0, "Flash errors encountered: %d\n", stats.error_count);
+
+        /* Destroy Storage Service */
+        bplib_store_flash_destroy(h);
+
+        /* Uninitialize Driver */
+        bplib_store_flash_uninit();
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_erase_count - block 0 worn past the wear gap, block 1 within it, and the rest new
+ *--------------------------------------------------------------------------------------*/
+static uint32_t test_erase_count(bp_flash_index_t block)
+{
+    if (block == 0)
+    {
+        return FLASH_MAX_WEAR_GAP * 4;
+    }
+    else if (block == 1)
+    {
+        return FLASH_MAX_WEAR_GAP;
+    }
+
+    return 0;
+}
+
+/*--------------------------------------------------------------------------------------
+ * test_spread_erase_count - block 0 new, block 1 past every bucket, block 2 in the last
+ *      buckets above the rest, and the rest in the middle
+ *--------------------------------------------------------------------------------------*/
+static uint32_t test_spread_erase_count(bp_flash_index_t block)
+{
+    if (block == 0)
+    {
+        return 0;
+    }
+    else if (block == 1)
+    {
+        return TEST_WEAR_BUCKETS * 4;
+    }
+    else if (block == 2)
+    {
+        return TEST_WEAR_BUCKETS + (TEST_WEAR_BUCKETS / 4);
+    }
+
+    return TEST_WEAR_BUCKETS / 2;
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #8
+ *--------------------------------------------------------------------------------------*/
+static void test_8(void)
+{
+    unsigned int      i;
+    bp_flash_index_t  block, worn_block;
+    bp_flash_stats_t  stats;
+    bp_flash_driver_t wear_driver = flash_driver;
+
+    printf("\n==== Test 8: Wear Leveling ====\n");
+
+    int reclaimed_blocks = bplib_store_flash_init(flash_driver, false);
+    ut_assert(reclaimed_blocks == 256, "Failed to reclaim all blocks\n");
+
+    printf("\n==== Step 8.1: Wear One Block Twice ====\n");
+    for (i = 0; i < flash_driver.num_blocks; i++)
+    {
+        ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    }
+    ut_assert(flash_free_reclaim(0) == BP_SUCCESS, "Failed to reclaim block\n");
+    ut_assert(flash_free_allocate(&worn_block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(worn_block == 0, "Failed to allocate only free block, allocated %d instead\n", worn_block);
+    for (i = 0; i < flash_driver.num_blocks; i++)
+    {
+        ut_assert(flash_free_reclaim(i) == BP_SUCCESS, "Failed to reclaim block\n");
+    }
+
+    bplib_store_flash_stats(&stats, false, false);
+    ut_assert(stats.min_erase_count == 1, "Incorrect min erase count: %lu\n", (unsigned long)stats.min_erase_count);
+    ut_assert(stats.max_erase_count == 2, "Incorrect max erase count: %lu\n", (unsigned long)stats.max_erase_count);
+
+    printf("\n==== Step 8.2: Hot Allocation Skips Worn Block ====\n");
+    ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block == 1, "Failed to allocate least worn block 1, allocated %d instead\n", block);
+
+    /* Uninitialize Driver */
+    bplib_store_flash_uninit();
+
+    printf("\n==== Step 8.3: Cold Allocation Takes Worn Block Within Gap ====\n");
+    wear_driver.erase_count = test_erase_count;
+    reclaimed_blocks        = bplib_store_flash_init(wear_driver, false);
+    ut_assert(reclaimed_blocks == 256, "Failed to reclaim all blocks\n");
+    ut_assert(flash_free_allocate(&block, true) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block == 1, "Failed to allocate block 1 within wear gap, allocated %d instead\n", block);
+    ut_assert(flash_free_allocate(&block, true) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block != 0, "Failed to rest block 0 past wear gap\n");
+
+    printf("\n==== Step 8.4: Block Past Gap Allocated Last ====\n");
+    for (i = 2; i < (unsigned int)flash_driver.num_blocks - 1; i++)
+    {
+        ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+        ut_assert(block != 0, "Failed to allocate least worn block, allocated block 0\n");
+    }
+    ut_assert(flash_free_allocate(&block, true) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block == 0, "Failed to allocate last free block 0, allocated %d instead\n", block);
+
+    bplib_store_flash_stats(&stats, false, false);
+    ut_assert(stats.min_erase_count == 1, "Incorrect min erase count: %lu\n", (unsigned long)stats.min_erase_count);
+    ut_assert(stats.max_erase_count == FLASH_MAX_WEAR_GAP * 4 + 1, "Incorrect max erase count: %lu\n",
+              (unsigned long)stats.max_erase_count);
+
+    /* Uninitialize Driver */
+    bplib_store_flash_uninit();
+
+    printf("\n==== Step 8.5: Free Less Worn Block With Blocks In Overflow ====\n");
+    wear_driver.erase_count = test_spread_erase_count;
+    reclaimed_blocks        = bplib_store_flash_init(wear_driver, false);
+    ut_assert(reclaimed_blocks == 256, "Failed to reclaim all blocks\n");
+    ut_assert(flash_free_allocate(&worn_block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(worn_block == 0, "Failed to allocate least worn block 0, allocated %d instead\n", worn_block);
+    ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block > 2, "Failed to allocate least worn block, allocated %d instead\n", block);
+    ut_assert(flash_free_reclaim(worn_block) == BP_SUCCESS, "Failed to reclaim block\n");
+
+    printf("\n==== Step 8.6: Allocate All In Wear Order ====\n");
+    ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block == 0, "Failed to allocate least worn block 0, allocated %d instead\n", block);
+    for (i = 3; i < (unsigned int)flash_driver.num_blocks - 1; i++)
+    {
+        ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+        ut_assert(block > 2, "Failed to allocate least worn block, allocated %d instead\n", block);
+    }
+    ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block == 2, "Failed to allocate block 2 from overflow, allocated %d instead\n", block);
+    ut_assert(flash_free_allocate(&block, false) == BP_SUCCESS, "Failed to allocate block\n");
+    ut_assert(block == 1, "Failed to allocate most worn block 1, allocated %d instead\n", block);
+    ut_assert(flash_free_allocate(&block, false) == BP_ERROR, "Allocated block from empty free list\n");
+
+    bplib_store_flash_stats(&stats, false, false);
+    ut_assert(stats.min_erase_count == 2, "Incorrect min erase count: %lu\n", (unsigned long)stats.min_erase_count);
+    ut_assert(stats.max_erase_count == TEST_WEAR_BUCKETS * 4 + 1, "Incorrect max erase count: %lu\n",
+              (unsigned long)stats.max_erase_count);
+
+    /* Uninitialize Driver */
+    bplib_store_flash_uninit();
+}
+
 /******************************************************************************
  EXPORTED FUNCTIONS
  ******************************************************************************/
@@ -436,6 +669,8 @@ int ut_flash(void)
     test_4();
     test_5();
     test_6();
+    test_7();
+    test_8();
 
     /* Clean Up */
 
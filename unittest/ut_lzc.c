@@ -0,0 +1,258 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include <string.h>
+
+#include "ut_assert.h"
+#include "bplib.h"
+#include "lzc.h"
+
+/******************************************************************************
+ DEFINES
+ ******************************************************************************/
+
+#define TEST_DATA_SIZE  (70 * 1024) /* more than the match window */
+#define TEST_BOUND_SIZE (TEST_DATA_SIZE + (TEST_DATA_SIZE / 255) + 16)
+#define TEST_SMALL_SIZE 16
+#define TEST_NO_MATCH   12 /* matches are not used this close to the end of the input */
+
+/******************************************************************************
+ FILE DATA
+ ******************************************************************************/
+
+static uint8_t  test_data[TEST_DATA_SIZE];
+static uint8_t  compressed_data[TEST_BOUND_SIZE];
+static uint8_t  read_data[TEST_DATA_SIZE];
+static uint32_t test_random_state;
+
+/******************************************************************************
+ TEST AND DEBUGGING HELPER FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * test_random - Repeatable pseudo-random octets, so the input does not compress
+ *-------------------------------------------------------------------------------------*/
+static uint8_t test_random(void)
+{
+    test_random_state ^= test_random_state << 13;
+    test_random_state ^= test_random_state >> 17;
+    test_random_state ^= test_random_state << 5;
+    return test_random_state >> 24;
+}
+
+/*--------------------------------------------------------------------------------------
+ * round_trip - Compresses and decompresses the first size octets of test_data, and
+ *      checks that the result is the same.  Returns the compressed size.
+ *-------------------------------------------------------------------------------------*/
+static size_t round_trip(size_t size, const char *label)
+{
+    size_t compressed_size;
+    size_t decompressed_size;
+
+    compressed_size = lzc_compress(test_data, size, compressed_data, sizeof(compressed_data));
+    if (!ut_assert(compressed_size > 0, "Failed to compress %s data of size %lu\n", label, (unsigned long)size))
+    {
+        return 0;
+    }
+
+    memset(read_data, 0, size);
+    decompressed_size = lzc_decompress(compressed_data, compressed_size, read_data, size);
+    ut_assert(decompressed_size == size, "Incorrect decompressed size of %s data: %lu != %lu\n", label,
+              (unsigned long)decompressed_size, (unsigned long)size);
+    ut_assert(memcmp(read_data, test_data, size) == 0, "Incorrect decompressed %s data of size %lu\n", label,
+              (unsigned long)size);
+
+    return compressed_size;
+}
+
+/*--------------------------------------------------------------------------------------
+ * check_malformed - Checks that the input is rejected
+ *-------------------------------------------------------------------------------------*/
+static void check_malformed(const uint8_t *input, size_t input_size, size_t capacity, const char *label)
+{
+    size_t decompressed_size;
+
+    decompressed_size = lzc_decompress(input, input_size, read_data, capacity);
+    ut_assert(decompressed_size == 0, "Failed to reject %s: %lu\n", label, (unsigned long)decompressed_size);
+}
+
+/******************************************************************************
+ TEST FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * Test #1 - Round trips
+ *--------------------------------------------------------------------------------------*/
+static void test_1(void)
+{
+    size_t i;
+    size_t size;
+
+    /* Step 1: Repetitive text compresses */
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+    {
+        test_data[i] = "The quick brown fox jumps over the lazy dog. "[i % 45];
+    }
+    size = round_trip(TEST_DATA_SIZE, "text");
+    ut_assert(size > 0 && size < (TEST_DATA_SIZE / 10), "Text did not compress: %lu\n", (unsigned long)size);
+
+    /* Step 2: A single repeated octet - a long match that overlaps its own output */
+    memset(test_data, 0xA5, TEST_DATA_SIZE);
+    size = round_trip(TEST_DATA_SIZE, "uniform");
+    ut_assert(size > 0 && size < (TEST_DATA_SIZE / 100), "Uniform data did not compress: %lu\n",
+              (unsigned long)size);
+
+    /* Step 3: Incompressible data - a long run of literals, a little bigger than the input */
+    test_random_state = 0x12345678;
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+    {
+        test_data[i] = test_random();
+    }
+    size = round_trip(TEST_DATA_SIZE, "random");
+    ut_assert(size >= TEST_DATA_SIZE, "Random data compressed: %lu\n", (unsigned long)size);
+    size = lzc_compress(test_data, TEST_DATA_SIZE, compressed_data, TEST_DATA_SIZE);
+    ut_assert(size == 0, "Random data compressed within its own size: %lu\n", (unsigned long)size);
+
+    /* Step 4: Matches further back than the window can reach */
+    memcpy(&test_data[TEST_DATA_SIZE - 1024], test_data, 1024);
+    round_trip(TEST_DATA_SIZE, "distant repeat");
+
+    /* Step 5: Inputs shorter than the minimum match, or too short for any match to be used */
+    memset(test_data, 'x', TEST_SMALL_SIZE);
+    for (i = 1; i <= TEST_SMALL_SIZE; i++)
+    {
+        size = round_trip(i, "short");
+        if (i <= TEST_NO_MATCH)
+        {
+            ut_assert(size == i + 1, "Incorrect compressed size of %lu octets: %lu\n", (unsigned long)i,
+                      (unsigned long)size);
+        }
+    }
+
+    /* Step 6: Nothing at all */
+    size = lzc_compress(test_data, 0, compressed_data, sizeof(compressed_data));
+    ut_assert(size == 1, "Incorrect compressed size of no data: %lu\n", (unsigned long)size);
+    size = lzc_decompress(compressed_data, size, read_data, sizeof(read_data));
+    ut_assert(size == 0, "Incorrect decompressed size of no data: %lu\n", (unsigned long)size);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #2 - Output bounds
+ *--------------------------------------------------------------------------------------*/
+static void test_2(void)
+{
+    size_t i;
+    size_t compressed_size;
+    size_t size;
+
+    for (i = 0; i < TEST_DATA_SIZE; i++)
+    {
+        test_data[i] = (i / 100) + (i % 7);
+    }
+
+    compressed_size = lzc_compress(test_data, TEST_DATA_SIZE, compressed_data, sizeof(compressed_data));
+    ut_assert(compressed_size > 0, "Failed to compress data\n");
+
+    /* Step 1: Compression fails, rather than overruns, if the output does not fit */
+    for (i = 0; i < compressed_size; i += 1 + (i / 8))
+    {
+        memset(compressed_data, 0xEE, sizeof(compressed_data));
+        size = lzc_compress(test_data, TEST_DATA_SIZE, compressed_data, i);
+        ut_assert(size == 0, "Compressed into %lu octets, needs %lu\n", (unsigned long)i,
+                  (unsigned long)compressed_size);
+        ut_assert(compressed_data[i] == 0xEE, "Compression wrote past %lu octets\n", (unsigned long)i);
+    }
+
+    /* Step 2: Decompression fails if the output does not fit, the input itself is good */
+    compressed_size = lzc_compress(test_data, TEST_DATA_SIZE, compressed_data, sizeof(compressed_data));
+    size            = lzc_decompress(compressed_data, compressed_size, read_data, TEST_DATA_SIZE - 1);
+    ut_assert(size == 0, "Decompressed into too small a buffer: %lu\n", (unsigned long)size);
+    size = lzc_decompress(compressed_data, compressed_size, read_data, TEST_DATA_SIZE);
+    ut_assert(size == TEST_DATA_SIZE, "Failed to decompress into exact size buffer: %lu\n", (unsigned long)size);
+
+    /* Step 3: Truncated input never yields the whole output */
+    for (i = 0; i < compressed_size; i += 1 + (i / 8))
+    {
+        size = lzc_decompress(compressed_data, i, read_data, TEST_DATA_SIZE);
+        ut_assert(size < TEST_DATA_SIZE, "Decompressed %lu octets of truncated input to full size\n",
+                  (unsigned long)i);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #3 - Malformed input
+ *--------------------------------------------------------------------------------------*/
+static void test_3(void)
+{
+    /* one literal, a match at offset 1 of length 4, then one more literal */
+    static const uint8_t good[] = {0x10, 'a', 0x01, 0x00, 0x10, 'b'};
+
+    static const uint8_t offset_before_start[] = {0x10, 'a', 0x02, 0x00};
+    static const uint8_t offset_zero[]         = {0x10, 'a', 0x00, 0x00};
+    static const uint8_t no_literal_offset[]   = {0x00, 0x01, 0x00};
+    static const uint8_t literal_past_input[]  = {0x50, 'a', 'b'};
+    static const uint8_t literal_length_cut[]  = {0xF0, 0xFF, 0xFF};
+    static const uint8_t offset_cut[]          = {0x10, 'a', 0x01};
+    static const uint8_t match_length_cut[]    = {0x1F, 'a', 0x01, 0x00, 0xFF};
+    static const uint8_t match_past_output[]   = {0x1F, 'a', 0x01, 0x00, 0xFF, 0xFF, 0x10};
+    static const uint8_t literal_past_output[] = {0x20, 'a', 'b'};
+
+    size_t size;
+
+    size = lzc_decompress(good, sizeof(good), read_data, sizeof(read_data));
+    ut_assert(size == 6 && memcmp(read_data, "aaaaab", 6) == 0, "Failed to decompress good input: %lu\n",
+              (unsigned long)size);
+
+    /* Step 1: Matches that refer to data before the start of the output */
+    check_malformed(offset_before_start, sizeof(offset_before_start), sizeof(read_data), "offset before start");
+    check_malformed(offset_zero, sizeof(offset_zero), sizeof(read_data), "zero offset");
+    check_malformed(no_literal_offset, sizeof(no_literal_offset), sizeof(read_data), "match with no output");
+
+    /* Step 2: Lengths that run past the end of the input */
+    check_malformed(literal_past_input, sizeof(literal_past_input), sizeof(read_data), "literals past input");
+    check_malformed(literal_length_cut, sizeof(literal_length_cut), sizeof(read_data), "cut literal length");
+    check_malformed(offset_cut, sizeof(offset_cut), sizeof(read_data), "cut offset");
+    check_malformed(match_length_cut, sizeof(match_length_cut), sizeof(read_data), "cut match length");
+
+    /* Step 3: Lengths that run past the end of the output */
+    check_malformed(good, sizeof(good), 5, "match past output");
+    check_malformed(good, sizeof(good), 3, "short output");
+    check_malformed(match_past_output, sizeof(match_past_output), 100, "long match past output");
+    check_malformed(literal_past_output, sizeof(literal_past_output), 1, "literals past output");
+}
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+int ut_lzc(void)
+{
+    ut_reset();
+
+    test_1();
+    test_2();
+    test_3();
+
+    return ut_failures();
+}
@@ -0,0 +1,514 @@
+/*
+ * NASA Docket No. GSC-18,587-1 and identified as “The Bundle Protocol Core Flight
+ * System Application (BP) v6.5”
+ *
+ * Copyright © 2020 United States Government as represented by the Administrator of
+ * the National Aeronautics and Space Administration. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * The reassembly table is part of the BPv7 implementation, so these tests are only
+ * built along with it.
+ */
+#ifdef BPLIB_INCLUDE_BPV7
+
+/******************************************************************************
+ INCLUDES
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ut_assert.h"
+#include "bplib.h"
+#include "v7.h"
+#include "v7_codec.h"
+#include "v7_mpool.h"
+#include "v7_mpool_bblocks.h"
+#include "v7_mpool_ref.h"
+#include "crc.h"
+#include "bplib_reassembly.h"
+
+/******************************************************************************
+ DEFINES
+ ******************************************************************************/
+
+#define TEST_POOL_SIZE          (8 * 1024 * 1024)
+#define TEST_ADU_SIZE           1000
+#define TEST_BIG_FRAGMENT_SIZE  ((BPLIB_REASSEMBLY_BYTE_BUDGET * 2) / 5)
+#define TEST_BIG_ADU_SIZE       (TEST_BIG_FRAGMENT_SIZE * 2)
+#define TEST_BLOCKTYPE_FRAGMENT 0x7e3a51c6
+#define TEST_SOURCE_NODE        100
+#define TEST_SOURCE_SERVICE     42
+#define TEST_COLLISION_SEARCH   (1 << 18)
+
+/******************************************************************************
+ TYPEDEFS
+ ******************************************************************************/
+
+typedef struct
+{
+    bp_val_t            key;
+    bp_sequencenumber_t sequence_num;
+} test_key_t;
+
+/******************************************************************************
+ FILE DATA
+ ******************************************************************************/
+
+static void          *pool_mem;
+static bplib_mpool_t *pool;
+static uint8_t        adu_data[BPLIB_REASSEMBLY_BYTE_BUDGET];
+static uint8_t        read_data[BPLIB_REASSEMBLY_BYTE_BUDGET];
+
+/******************************************************************************
+ TEST AND DEBUGGING HELPER FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * make_fragment - Builds a received fragment of the ADU in adu_data, as a block
+ *      referring to the bundle, the way the fragments are passed in by the data service
+ *-------------------------------------------------------------------------------------*/
+static bplib_mpool_block_t *make_fragment(bp_sequencenumber_t sequence_num, size_t offset, size_t size,
+                                          size_t total_size)
+{
+    bplib_mpool_block_t            *pblk;
+    bplib_mpool_block_t            *cblk;
+    bplib_mpool_block_t            *rblk;
+    bplib_mpool_bblock_primary_t   *cpb;
+    bplib_mpool_bblock_canonical_t *ccb;
+    bp_primary_block_t             *pri;
+    bp_canonical_block_buffer_t    *pay;
+    bplib_mpool_ref_t               refptr;
+    bp_ipn_addr_t                   addr;
+
+    pblk = bplib_mpool_bblock_primary_alloc(pool);
+    cpb  = bplib_mpool_bblock_primary_cast(pblk);
+    cblk = bplib_mpool_bblock_canonical_alloc(pool);
+    ccb  = bplib_mpool_bblock_canonical_cast(cblk);
+    if (cpb == NULL || ccb == NULL)
+    {
+        return NULL;
+    }
+
+    pri          = bplib_mpool_bblock_primary_get_logical(cpb);
+    pri->version = 7;
+    pri->crctype = bp_crctype_CRC16;
+
+    addr.node_number    = TEST_SOURCE_NODE;
+    addr.service_number = TEST_SOURCE_SERVICE;
+    v7_set_eid(&pri->sourceEID, &addr);
+    v7_set_eid(&pri->reportEID, &addr);
+    addr.node_number = TEST_SOURCE_NODE + 1;
+    v7_set_eid(&pri->destinationEID, &addr);
+
+    pri->creationTimeStamp.time         = 742176000000;
+    pri->creationTimeStamp.sequence_num = sequence_num;
+    pri->lifetime                       = 3600000;
+    pri->controlFlags.isFragment        = true;
+    pri->fragmentOffset                 = offset;
+    pri->totalADUlength                 = total_size;
+
+    pay                            = bplib_mpool_bblock_canonical_get_logical(ccb);
+    pay->canonical_block.blockNum  = 1;
+    pay->canonical_block.blockType = bp_blocktype_payloadBlock;
+    pay->canonical_block.crctype   = bp_crctype_CRC32C;
+
+    if (v7_block_encode_pri(cpb) < 0 || v7_block_encode_pay(ccb, &adu_data[offset], size) < 0)
+    {
+        return NULL;
+    }
+
+    bplib_mpool_bblock_primary_append(cpb, cblk);
+
+    refptr = bplib_mpool_ref_create(pblk);
+    if (refptr == NULL)
+    {
+        return NULL;
+    }
+
+    rblk = bplib_mpool_ref_make_block(refptr, TEST_BLOCKTYPE_FRAGMENT, NULL);
+    bplib_mpool_ref_release(refptr);
+
+    return rblk;
+}
+
+/*--------------------------------------------------------------------------------------
+ * check_bundle - Checks that the reassembled bundle has the whole ADU as its payload,
+ *      and releases it
+ *-------------------------------------------------------------------------------------*/
+static void check_bundle(bplib_mpool_ref_t refptr, size_t total_size)
+{
+    bplib_mpool_bblock_primary_t   *cpb;
+    bplib_mpool_bblock_canonical_t *ccb;
+    size_t                          size;
+
+    cpb = bplib_mpool_bblock_primary_cast(bplib_mpool_dereference(refptr));
+    ccb = NULL;
+    if (cpb != NULL)
+    {
+        ut_assert(!bplib_mpool_bblock_primary_get_logical(cpb)->controlFlags.isFragment,
+                  "Reassembled bundle is still a fragment\n");
+        ccb = bplib_mpool_bblock_canonical_cast(
+            bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_payloadBlock));
+    }
+
+    if (ccb == NULL)
+    {
+        ut_assert(false, "Reassembled bundle has no payload\n");
+    }
+    else if (ut_assert(bplib_mpool_bblock_canonical_get_content_length(ccb) == total_size,
+                       "Incorrect reassembled payload size: %lu != %lu\n",
+                       (unsigned long)bplib_mpool_bblock_canonical_get_content_length(ccb),
+                       (unsigned long)total_size))
+    {
+        memset(read_data, 0, total_size);
+        size = bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb), read_data,
+                                              total_size, bplib_mpool_bblock_canonical_get_content_offset(ccb),
+                                              total_size);
+        ut_assert(size == total_size, "Failed to export reassembled payload: %lu\n", (unsigned long)size);
+        ut_assert(memcmp(read_data, adu_data, total_size) == 0, "Incorrect reassembled payload\n");
+    }
+
+    bplib_mpool_ref_release(refptr);
+}
+
+/*--------------------------------------------------------------------------------------
+ * get_key - Same key as v7_reassembly.c computes for a bundle ID from the test source
+ *-------------------------------------------------------------------------------------*/
+static bp_val_t get_key(bp_sequencenumber_t sequence_num)
+{
+    bp_ipn_addr_t           source;
+    bp_creation_timestamp_t timestamp;
+    bp_crcval_t             hash;
+
+    memset(&source, 0, sizeof(source));
+    memset(&timestamp, 0, sizeof(timestamp));
+    source.node_number     = TEST_SOURCE_NODE;
+    source.service_number  = TEST_SOURCE_SERVICE;
+    timestamp.time         = 742176000000;
+    timestamp.sequence_num = sequence_num;
+
+    hash = bplib_crc_initial_value(&BPLIB_CRC32_CASTAGNOLI);
+    hash = bplib_crc_update(&BPLIB_CRC32_CASTAGNOLI, hash, &source, sizeof(source));
+    hash = bplib_crc_update(&BPLIB_CRC32_CASTAGNOLI, hash, &timestamp, sizeof(timestamp));
+
+    return bplib_crc_finalize(&BPLIB_CRC32_CASTAGNOLI, hash);
+}
+
+/*--------------------------------------------------------------------------------------
+ * compare_keys -
+ *-------------------------------------------------------------------------------------*/
+static int compare_keys(const void *a, const void *b)
+{
+    const test_key_t *ka = a;
+    const test_key_t *kb = b;
+
+    if (ka->key != kb->key)
+    {
+        return (ka->key < kb->key) ? -1 : 1;
+    }
+    return (ka->sequence_num < kb->sequence_num) ? -1 : (ka->sequence_num > kb->sequence_num);
+}
+
+/*--------------------------------------------------------------------------------------
+ * find_collision - Finds two sequence numbers that give the same key
+ *-------------------------------------------------------------------------------------*/
+static bool find_collision(bp_sequencenumber_t *seq_1, bp_sequencenumber_t *seq_2)
+{
+    test_key_t *keys;
+    bool        found;
+    int         i;
+
+    keys = malloc(sizeof(test_key_t) * TEST_COLLISION_SEARCH);
+    if (keys == NULL)
+    {
+        return false;
+    }
+
+    for (i = 0; i < TEST_COLLISION_SEARCH; i++)
+    {
+        keys[i].key          = get_key(i);
+        keys[i].sequence_num = i;
+    }
+    qsort(keys, TEST_COLLISION_SEARCH, sizeof(test_key_t), compare_keys);
+
+    found = false;
+    for (i = 1; i < TEST_COLLISION_SEARCH && !found; i++)
+    {
+        if (keys[i].key == keys[i - 1].key)
+        {
+            *seq_1 = keys[i - 1].sequence_num;
+            *seq_2 = keys[i].sequence_num;
+            found  = true;
+        }
+    }
+
+    free(keys);
+    return found;
+}
+
+/******************************************************************************
+ TEST FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * Test #1 - Fragments in order, out of order, and overlapping
+ *--------------------------------------------------------------------------------------*/
+static void test_1(void)
+{
+    bplib_reassembly_table_t table;
+    bplib_mpool_ref_t        refptr;
+
+    bplib_reassembly_table_init(NULL, &table);
+
+    /* Step 1: In order */
+    refptr = bplib_reassembly_collect(&table, make_fragment(1, 0, 400, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    ut_assert(table.held_bytes > 0, "First fragment is not held\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(1, 400, 600, TEST_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble fragments received in order\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+    ut_assert(table.held_bytes == 0, "Fragments still held after reassembly: %lu\n", (unsigned long)table.held_bytes);
+
+    /* Step 2: Out of order */
+    refptr = bplib_reassembly_collect(&table, make_fragment(2, 700, 300, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the last fragment\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(2, 0, 300, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with a gap in the middle\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(2, 300, 400, TEST_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble fragments received out of order\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+
+    /* Step 3: Overlapping, including one that is entirely within another */
+    refptr = bplib_reassembly_collect(&table, make_fragment(3, 0, 600, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(3, 100, 200, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with an overlapping fragment\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(3, 400, 600, TEST_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble overlapping fragments\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+
+    /* Step 4: Fragments that disagree on the length are dropped */
+    refptr = bplib_reassembly_collect(&table, make_fragment(4, 0, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(4, 500, 500, TEST_ADU_SIZE + 1), 0);
+    ut_assert(refptr == NULL, "Bundle completed with a fragment of a different length\n");
+    bplib_reassembly_expire(&table, BPLIB_REASSEMBLY_TIMEOUT_MS);
+    ut_assert(table.held_bytes == 0, "Fragments still held after expiry: %lu\n", (unsigned long)table.held_bytes);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #2 - Timeout expiry
+ *--------------------------------------------------------------------------------------*/
+static void test_2(void)
+{
+    bplib_reassembly_table_t table;
+    bplib_mpool_ref_t        refptr;
+    size_t                   held_bytes;
+
+    bplib_reassembly_table_init(NULL, &table);
+
+    /* Step 1: Not expired yet */
+    refptr = bplib_reassembly_collect(&table, make_fragment(10, 0, 500, TEST_ADU_SIZE), 1000);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    held_bytes = table.held_bytes;
+    bplib_reassembly_expire(&table, 1000 + BPLIB_REASSEMBLY_TIMEOUT_MS - 1);
+    ut_assert(table.held_bytes == held_bytes, "Fragment dropped before the timeout\n");
+
+    /* Step 2: Expired - the rest of the bundle is then not enough to complete it */
+    bplib_reassembly_expire(&table, 1000 + BPLIB_REASSEMBLY_TIMEOUT_MS);
+    ut_assert(table.held_bytes == 0, "Fragment still held after the timeout: %lu\n", (unsigned long)table.held_bytes);
+    refptr = bplib_reassembly_collect(&table, make_fragment(10, 500, 500, TEST_ADU_SIZE),
+                                      1000 + BPLIB_REASSEMBLY_TIMEOUT_MS);
+    ut_assert(refptr == NULL, "Bundle completed after its first fragment expired\n");
+
+    /* Step 3: Only the expired bundles are dropped */
+    refptr = bplib_reassembly_collect(&table, make_fragment(11, 0, 500, TEST_ADU_SIZE),
+                                      1000 + BPLIB_REASSEMBLY_TIMEOUT_MS + 10);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    bplib_reassembly_expire(&table, 1000 + (2 * BPLIB_REASSEMBLY_TIMEOUT_MS));
+    refptr = bplib_reassembly_collect(&table, make_fragment(11, 500, 500, TEST_ADU_SIZE),
+                                      1000 + (2 * BPLIB_REASSEMBLY_TIMEOUT_MS));
+    ut_assert(refptr != NULL, "Failed to reassemble bundle that had not expired\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+
+    bplib_reassembly_expire(&table, 1000 + (3 * BPLIB_REASSEMBLY_TIMEOUT_MS));
+    ut_assert(table.held_bytes == 0, "Fragments still held after expiry: %lu\n", (unsigned long)table.held_bytes);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #3 - Budget exhaustion
+ *--------------------------------------------------------------------------------------*/
+static void test_3(void)
+{
+    bplib_reassembly_table_t table;
+    bplib_mpool_ref_t        refptr;
+
+    bplib_reassembly_table_init(NULL, &table);
+
+    /* Step 1: The first fragments of two bundles fit in the budget */
+    refptr = bplib_reassembly_collect(&table, make_fragment(20, 0, TEST_BIG_FRAGMENT_SIZE, TEST_BIG_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(21, 0, TEST_BIG_FRAGMENT_SIZE, TEST_BIG_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    ut_assert(table.held_bytes <= BPLIB_REASSEMBLY_BYTE_BUDGET, "Reassembly budget exceeded: %lu\n",
+              (unsigned long)table.held_bytes);
+
+    /* Step 2: A third one does not fit, so the oldest bundle is dropped to make room */
+    refptr = bplib_reassembly_collect(&table, make_fragment(22, 0, TEST_BIG_FRAGMENT_SIZE, TEST_BIG_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    ut_assert(table.held_bytes <= BPLIB_REASSEMBLY_BYTE_BUDGET, "Reassembly budget exceeded: %lu\n",
+              (unsigned long)table.held_bytes);
+
+    /* Step 3: The rest of the newest bundle completes it, the oldest one cannot be completed anymore */
+    refptr = bplib_reassembly_collect(
+        &table, make_fragment(22, TEST_BIG_FRAGMENT_SIZE, TEST_BIG_FRAGMENT_SIZE, TEST_BIG_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble the newest bundle\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_BIG_ADU_SIZE);
+    }
+
+    refptr = bplib_reassembly_collect(
+        &table, make_fragment(20, TEST_BIG_FRAGMENT_SIZE, TEST_BIG_FRAGMENT_SIZE, TEST_BIG_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed after it was dropped for room\n");
+
+    /* Step 4: A fragment larger than the whole budget is not held at all */
+    refptr =
+        bplib_reassembly_collect(&table, make_fragment(23, 0, BPLIB_REASSEMBLY_BYTE_BUDGET, sizeof(adu_data)), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    ut_assert(table.held_bytes <= BPLIB_REASSEMBLY_BYTE_BUDGET, "Reassembly budget exceeded: %lu\n",
+              (unsigned long)table.held_bytes);
+
+    bplib_reassembly_expire(&table, BPLIB_REASSEMBLY_TIMEOUT_MS);
+    ut_assert(table.held_bytes == 0, "Fragments still held after expiry: %lu\n", (unsigned long)table.held_bytes);
+}
+
+/*--------------------------------------------------------------------------------------
+ * Test #4 - Different bundles with the same key
+ *--------------------------------------------------------------------------------------*/
+static void test_4(void)
+{
+    bplib_reassembly_table_t table;
+    bplib_mpool_ref_t        refptr;
+    bp_sequencenumber_t      seq_1;
+    bp_sequencenumber_t      seq_2;
+
+    if (!ut_assert(find_collision(&seq_1, &seq_2), "Failed to find bundle IDs with the same key\n"))
+    {
+        return;
+    }
+
+    bplib_reassembly_table_init(NULL, &table);
+
+    /* Step 1: Both bundles are held at once */
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_1, 0, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_2, 0, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with the fragment of another bundle\n");
+
+    /* Step 2: Completing the one that is first in the index leaves the other one there */
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_1, 500, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble the first of two bundles with the same key\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_2, 500, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble the second of two bundles with the same key\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+
+    /* Step 3: Same again, completing the one that is chained behind the other */
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_1, 0, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with only the first fragment\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_2, 0, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr == NULL, "Bundle completed with the fragment of another bundle\n");
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_2, 500, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble the chained bundle with the same key\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+
+    refptr = bplib_reassembly_collect(&table, make_fragment(seq_1, 500, 500, TEST_ADU_SIZE), 0);
+    ut_assert(refptr != NULL, "Failed to reassemble the bundle left in the index\n");
+    if (refptr != NULL)
+    {
+        check_bundle(refptr, TEST_ADU_SIZE);
+    }
+
+    ut_assert(table.held_bytes == 0, "Fragments still held after reassembly: %lu\n", (unsigned long)table.held_bytes);
+}
+
+/******************************************************************************
+ EXPORTED FUNCTIONS
+ ******************************************************************************/
+
+int ut_reassembly(void)
+{
+    size_t i;
+
+    ut_reset();
+
+    /* Global Setup */
+
+    pool_mem = malloc(TEST_POOL_SIZE);
+    pool     = bplib_mpool_create(pool_mem, TEST_POOL_SIZE);
+    if (!ut_assert(pool != NULL, "Failed to create memory pool\n"))
+    {
+        free(pool_mem);
+        return ut_failures();
+    }
+
+    bplib_reassembly_init(pool);
+    bplib_mpool_register_blocktype(pool, TEST_BLOCKTYPE_FRAGMENT, NULL, 0);
+
+    for (i = 0; i < sizeof(adu_data); i++)
+    {
+        adu_data[i] = (uint8_t)((i * 7) ^ (i >> 8));
+    }
+
+    /* Test Cases */
+
+    test_1();
+    test_2();
+    test_3();
+    test_4();
+
+    /* Clean Up */
+
+    free(pool_mem);
+
+    return ut_failures();
+}
+
+#endif /* BPLIB_INCLUDE_BPV7 */
@@ -22,9 +22,20 @@
  INCLUDES
  ******************************************************************************/
 
+#include <stdlib.h>
+#include <time.h>
+
 #include "ut_assert.h"
+#include "bplib_os.h"
 #include "rh_hash.h"
 
+/******************************************************************************
+ DEFINES
+ ******************************************************************************/
+
+#define UT_RH_HASH_BENCHMARK_SIZE   4096
+#define UT_RH_HASH_BENCHMARK_CYCLES 200000
+
 /******************************************************************************
  LOCAL FUNCTIONS
  ******************************************************************************/
@@ -34,7 +45,7 @@
  *-------------------------------------------------------------------------------------*/
 static void print_hash(rh_hash_t *rh_hash, const char *message)
 {
-    int i, j;
+    int i;
 
     printf("\n------------------------\n");
     printf("HASH TABLE: %s\n", message);
@@ -73,16 +84,6 @@ static void print_hash(rh_hash_t *rh_hash, const char *message)
         {
             printf("%-4lu -- ", (unsigned long)rh_hash->table[i].bundle.cid);
 
-            j = rh_hash->table[i].next;
-            if (j == BP_MAX_INDEX)
-                printf("   ");
-
-            while (j != BP_MAX_INDEX)
-            {
-                printf("%-2d ", j);
-                j = rh_hash->table[j].next;
-            }
-
             printf("| ");
             if (rh_hash->table[i].before != BP_MAX_INDEX)
                 printf("%d", rh_hash->table[i].before);
@@ -93,16 +94,21 @@ static void print_hash(rh_hash_t *rh_hash, const char *message)
                 printf("%d", rh_hash->table[i].after);
             else
                 printf("N");
-            printf(" | ");
-            if (rh_hash->table[i].prev != BP_MAX_INDEX)
-                printf("%d", rh_hash->table[i].prev);
-            else
-                printf("N");
-            printf(" <<-h->> ");
-            if (rh_hash->table[i].next != BP_MAX_INDEX)
-                printf("%d", rh_hash->table[i].next);
-            else
-                printf("N");
+        }
+        printf("\n");
+    }
+
+    for (i = 0; (bp_val_t)i <= rh_hash->slot_mask; i++)
+    {
+        printf("<%d> ", i);
+        if (rh_hash->slots[i].node == BP_MAX_INDEX)
+        {
+            printf("EMPTY");
+        }
+        else
+        {
+            printf("%-4lu -> [%d] +%d", (unsigned long)rh_hash->slots[i].cid, rh_hash->slots[i].node,
+                   rh_hash->slots[i].probe);
         }
         printf("\n");
     }
@@ -121,7 +127,7 @@ static void test_1(void)
     bp_val_t   cid;
 
     int                hash_size = 8;
-    bp_active_bundle_t bundle    = {1, 0, 0};
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
 
     printf("\n==== Test 1: Create/Destroy ====\n");
 
@@ -212,7 +218,7 @@ static void test_2(void)
     bp_val_t   cid;
 
     int                hash_size = 8;
-    bp_active_bundle_t bundle    = {1, 0, 0};
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
 
     printf("\n==== Test 2: Chaining ====\n");
 
@@ -295,7 +301,7 @@ static void test_3(void)
     bp_val_t   cid;
 
     int                hash_size = 16;
-    bp_active_bundle_t bundle    = {1, 0, 0};
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
 
     printf("\n==== Test 3: Remove First, Middle, Last in Chain ====\n");
 
@@ -438,7 +444,7 @@ static void test_4(void)
     rh_hash_t *rh_hash;
 
     int                hash_size = 16;
-    bp_active_bundle_t bundle    = {1, 0, 0};
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
 
     printf("\n==== Test 4: Duplicates ====\n");
 
@@ -578,7 +584,7 @@ static void test_5(void)
     bp_val_t   cid;
 
     int                hash_size = 8;
-    bp_active_bundle_t bundle    = {1, 0, 0};
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
 
     printf("\n==== Test 5: Retransverse ====\n");
 
@@ -667,7 +673,7 @@ static void test_6(void)
     int        i, j;
 
     int                hash_size = 8;
-    bp_active_bundle_t bundle    = {1, 0, 0};
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
 
     printf("\n==== Test 6: Full Hash ====\n");
 
@@ -794,7 +800,7 @@ static void test_7(void)
     bp_val_t   cid;
 
     int                hash_size = 16;
-    bp_active_bundle_t bundle    = {1, 0, 0};
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
 
     printf("\n==== Test 7: Collisions - First, Middle, Last in Chain ====\n");
 
@@ -931,7 +937,7 @@ static void test_8(void)
     int          hash_size   = 64;
     unsigned int cid_range   = 0xFFFFFFFF;
 
-    bp_active_bundle_t bundle        = {1, 0, 0};
+    bp_active_bundle_t bundle        = {1, 0, 0, 0};
     bp_val_t          *order_of_cids = (bp_val_t *)malloc(hash_size * sizeof(bp_val_t));
 
     printf("\n==== Test 8: Stress - In Order ====\n");
@@ -1014,7 +1020,7 @@ static void test_9(void)
     int          hash_size   = 64;
     unsigned int cid_range   = 0xFFFFFFFF;
 
-    bp_active_bundle_t bundle        = {1, 0, 0};
+    bp_active_bundle_t bundle        = {1, 0, 0, 0};
     bp_val_t          *order_of_cids = (bp_val_t *)malloc(hash_size * sizeof(bp_val_t));
 
     printf("\n==== Test 9: Stress - Out of Order ====\n");
@@ -1104,6 +1110,135 @@ static void test_9(void)
     free(order_of_cids);
 }
 
+#ifdef UNITTEST_BENCHMARKS
+/*--------------------------------------------------------------------------------------
+ * Test #10 - only built with BUILD_BENCHMARKS=1, as it is a timing run and not a check
+ *--------------------------------------------------------------------------------------*/
+static void test_10(void)
+{
+    rh_hash_t         *rh_hash;
+    bp_active_bundle_t bundle = {1, 0, 0, 0};
+    volatile int       sink;
+    clock_t            start;
+    double             elapsed;
+    unsigned long      total_probe;
+    int                max_probe;
+    int                load, num_entries;
+    int                i;
+
+    int hash_size = UT_RH_HASH_BENCHMARK_SIZE;
+
+    printf("\n==== Test 10: Benchmark - Load Factor ====\n");
+
+    for (load = 50; load <= 95; load += 5)
+    {
+        ut_assert(rh_hash_create(&rh_hash, hash_size) == BP_SUCCESS, "Failed to create hash\n");
+
+        /* Load Hash to Load Factor */
+        num_entries = (hash_size * load) / 100;
+        while (rh_hash_count(rh_hash) < num_entries)
+        {
+            bundle.cid = bplib_os_random();
+            rh_hash_add(rh_hash, bundle, false);
+        }
+
+        /* Retire Oldest and Add Newest, as the Active Table Does */
+        start = clock();
+        sink  = 0;
+        for (i = 0; i < UT_RH_HASH_BENCHMARK_CYCLES; i++)
+        {
+            rh_hash_next(rh_hash, &bundle);
+            sink += rh_hash_available(rh_hash, bundle.cid);
+            rh_hash_remove(rh_hash, bundle.cid, NULL);
+            do
+            {
+                bundle.cid = bplib_os_random();
+            } while (rh_hash_add(rh_hash, bundle, false) != BP_SUCCESS);
+        }
+        elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+        ut_assert(rh_hash_count(rh_hash) == num_entries, "Failed to keep hash size of %d\n", num_entries);
+
+        /* Probe Distances */
+        total_probe = 0;
+        max_probe   = 0;
+        for (i = 0; (bp_val_t)i <= rh_hash->slot_mask; i++)
+        {
+            if (rh_hash->slots[i].node != BP_MAX_INDEX)
+            {
+                total_probe += rh_hash->slots[i].probe;
+                if (rh_hash->slots[i].probe > max_probe)
+                {
+                    max_probe = rh_hash->slots[i].probe;
+                }
+            }
+        }
+
+        printf("Hash benchmark: size %d, load %d%%: %6.1f ns per retire/add, probe distance %.2f average, %d max\n",
+               hash_size, load, (elapsed * 1e9) / UT_RH_HASH_BENCHMARK_CYCLES, (double)total_probe / num_entries,
+               max_probe);
+
+        ut_assert(rh_hash_destroy(rh_hash) == BP_SUCCESS, "Failed to destroy hash\n");
+    }
+
+    (void)sink;
+}
+#endif
+
+/*--------------------------------------------------------------------------------------
+ * Test #11
+ *--------------------------------------------------------------------------------------*/
+static void test_11(void)
+{
+    rh_hash_t         *rh_hash;
+    bp_active_bundle_t bundles[16];
+    bp_val_t           cid;
+    int                num_removed;
+    int                i;
+
+    int                hash_size = 16;
+    bp_active_bundle_t bundle    = {1, 0, 0, 0};
+
+    printf("\n==== Test 11: Remove Range ====\n");
+
+    ut_assert(rh_hash_create(&rh_hash, hash_size) == BP_SUCCESS, "Failed to create hash\n");
+
+    for (cid = 100; cid < 116; cid++)
+    {
+        bundle.cid = cid;
+        ut_assert(rh_hash_add(rh_hash, bundle, false) == BP_SUCCESS, "Failed to add CID %d\n", bundle.cid);
+    }
+
+    /* Range Smaller than Hash - CIDs Looked Up */
+    num_removed = rh_hash_remove_range(rh_hash, 96, 8, bundles);
+    ut_assert(num_removed == 4, "Failed to remove 4 CIDs: %d\n", num_removed);
+    for (i = 0; i < num_removed; i++)
+    {
+        ut_assert(bundles[i].cid == (bp_val_t)(100 + i), "Failed to output CID %d\n", 100 + i);
+    }
+    ut_assert(rh_hash_count(rh_hash) == 12, "Failed to get hash size of 12\n");
+
+    /* Range Larger than Hash - Entries Checked */
+    num_removed = rh_hash_remove_range(rh_hash, 110, 1000, bundles);
+    ut_assert(num_removed == 6, "Failed to remove 6 CIDs: %d\n", num_removed);
+    ut_assert(rh_hash_count(rh_hash) == 6, "Failed to get hash size of 6\n");
+
+    print_hash(rh_hash, "Step 11.1 - Ranges Removed");
+
+    /* Remaining Entries Still in Time Order */
+    for (cid = 104; cid < 110; cid++)
+    {
+        ut_assert(rh_hash_next(rh_hash, &bundle) == BP_SUCCESS && bundle.cid == cid, "Failed to get next CID %d\n",
+                  cid);
+        ut_assert(rh_hash_remove(rh_hash, cid, NULL) == BP_SUCCESS, "Failed to remove CID %d\n", cid);
+    }
+
+    ut_assert(rh_hash_remove_range(rh_hash, 0, 1000, NULL) == 0, "Failed to remove nothing from empty hash\n");
+    ut_assert(rh_hash_count(rh_hash) == 0, "Failed to get hash size of 0\n");
+
+    ut_assert(rh_hash_destroy(rh_hash) == BP_SUCCESS, "Failed to destroy hash\n");
+}
+
 /******************************************************************************
  EXPORTED FUNCTIONS
  ******************************************************************************/
@@ -1121,6 +1256,10 @@ int ut_rh_hash(void)
     test_7();
     test_8();
     test_9();
+#ifdef UNITTEST_BENCHMARKS
+    test_10();
+#endif
+    test_11();
 
     return ut_failures();
 }
@@ -30,6 +30,79 @@
 #include "sdnv.h"
 #include "dacs.h"
 
+/******************************************************************************
+ LOCAL FUNCTIONS
+ ******************************************************************************/
+
+/*--------------------------------------------------------------------------------------
+ * dacs_read_fills -
+ *
+ *  Walks the fills of an ACS record, calling ack (if not NULL) for each fill of
+ *  acknowledged custody IDs.  The number of bundles deleted is added to ack_count.
+ *
+ *  Returns:    Number of bytes processed of bundle
+ *-------------------------------------------------------------------------------------*/
+BP_LOCAL_SCOPE int dacs_read_fills(const uint8_t *rec, int rec_size, bp_delete_func_t ack, void *ack_parm,
+                                   int *ack_count, uint32_t *flags)
+{
+    bp_field_t cid       = {0, 2, 0};
+    bp_field_t fill      = {0, 0, 0};
+    int        cidin     = true;
+    uint32_t   sdnvflags = 0;
+
+    /* Read First Custody ID */
+    fill.index = sdnv_read(rec, rec_size, &cid, &sdnvflags);
+    if (sdnvflags != 0)
+    {
+        *flags |= sdnvflags;
+        return bplog(flags, BP_FLAG_FAILED_TO_PARSE, "Failed to read first custody ID (%08X)\n", sdnvflags);
+    }
+
+    /* Process Fills */
+    while ((int)fill.index < rec_size)
+    {
+        /* Read Fill */
+        fill.index = sdnv_read(rec, rec_size, &fill, &sdnvflags);
+        if (sdnvflags != 0)
+        {
+            *flags |= sdnvflags;
+            return bplog(flags, BP_FLAG_FAILED_TO_PARSE, "Failed to read fill (%08X)\n", sdnvflags);
+        }
+
+        /* Process Custody IDs */
+        if (cidin == true)
+        {
+            cidin = false;
+
+            if (fill.value > 0)
+            {
+                /* Acknowledge Range of Bundle CIDs */
+                if (ack)
+                {
+                    int status = ack(ack_parm, cid.value, fill.value, flags);
+                    if (status > 0)
+                    {
+                        *ack_count += status;
+                    }
+                }
+
+                /* Gap that Follows is Counted from Last CID Acknowledged */
+                cid.value += fill.value - 1;
+            }
+        }
+        else
+        {
+            cidin = true;
+
+            /* Skip Bundles */
+            cid.value += fill.value;
+        }
+    }
+
+    /* Return Bytes Read */
+    return fill.index;
+}
+
 /******************************************************************************
  EXPORTED FUNCTIONS
  ******************************************************************************/
@@ -102,84 +175,37 @@ int dacs_write(uint8_t *rec, int size, int max_fills_per_dacs, rb_tree_t *tree,
 
 /*--------------------------------------------------------------------------------------
  * dacs_read -
+ *
+ *  rec - buffer containing the ACS record [INPUT]
+ *  rec_size - size of record [INPUT]
+ *  num_acks - number of bundles acknowledged [OUTPUT]
+ *  ack - called once for each fill of acknowledged custody IDs, with the first custody ID
+ *      and the number of them; returns the number of bundles it deleted
+ *  ack_parm - passed through to ack
+ *
+ *  The whole record is decoded before any fill is acknowledged, so a malformed record
+ *  acknowledges nothing.
+ *
+ *  Returns:    Number of bytes processed of bundle
  *-------------------------------------------------------------------------------------*/
 int dacs_read(const uint8_t *rec, int rec_size, int *num_acks, bp_delete_func_t ack, void *ack_parm, uint32_t *flags)
 {
-    bp_field_t cid         = {0, 2, 0};
-    bp_field_t fill        = {0, 0, 0};
-    int        cidin       = true;
-    uint8_t    acs_status  = rec[BP_ACS_REC_STATUS_INDEX];
-    bool       ack_success = (acs_status & BP_ACS_ACK_MASK) == BP_ACS_ACK_MASK;
-    int        ack_count   = 0;
-    uint32_t   sdnvflags   = 0;
-    int        ret_status  = BP_SUCCESS;
+    uint8_t acs_status  = rec[BP_ACS_REC_STATUS_INDEX];
+    bool    ack_success = (acs_status & BP_ACS_ACK_MASK) == BP_ACS_ACK_MASK;
+    int     ack_count   = 0;
 
-    /* Read First Custody ID */
-    fill.index = sdnv_read(rec, rec_size, &cid, &sdnvflags);
-    if (sdnvflags != 0)
-    {
-        *flags |= sdnvflags;
-        return bplog(flags, BP_FLAG_FAILED_TO_PARSE, "Failed to read first custody ID (%08X)\n", sdnvflags);
-    }
+    /* Decode Fills */
+    int bytes_read = dacs_read_fills(rec, rec_size, NULL, NULL, NULL, flags);
 
-    /* Process Fills */
-    while ((int)fill.index < rec_size)
+    /* Acknowledge Fills */
+    if (bytes_read > 0 && ack_success)
     {
-        /* Read Fill */
-        fill.index = sdnv_read(rec, rec_size, &fill, &sdnvflags);
-        if (sdnvflags != 0)
-        {
-            *flags |= sdnvflags;
-            return bplog(flags, BP_FLAG_FAILED_TO_PARSE, "Failed to read fill (%08X)\n", sdnvflags);
-        }
-
-        /* Process Custody IDs */
-        if (cidin == true)
-        {
-            bp_val_t i;
-            bp_val_t fill_start = cid.value;
-            cidin = false;
-
-            /* Free Bundles */
-            for (i = 0; i < fill.value; i++)
-            {
-                /* Calculate CID being Acknowledged */
-                cid.value = fill_start + i;
-
-                /* Acknowledge Bundle CID */
-                if (ack_success)
-                {
-                    int status = ack(ack_parm, cid.value, flags);
-                    if (status == BP_SUCCESS) ack_count++;
-
-                    /* Set Return Status */
-                    if (status != BP_SUCCESS && ret_status != BP_SUCCESS)
-                    {
-                        /* Save Off First Failure */
-                        ret_status = status;
-                    }
-                }
-            }
-        }
-        else
-        {
-            cidin = true;
-
-            /* Skip Bundles */
-            cid.value += fill.value;
-        }
+        dacs_read_fills(rec, rec_size, ack, ack_parm, &ack_count, flags);
     }
 
     /* Set Number of Acknowledgments */
     *num_acks = ack_count;
 
     /* Return Bytes Read or Error Code */
-    if (ret_status == BP_SUCCESS)
-    {
-        return fill.index;
-    }
-    else
-    {
-        return ret_status;
-    }
+    return bytes_read;
 }
@@ -29,15 +29,42 @@
 #include "v7_mpool.h"
 #include "v7_types.h"
 
+/******************************************************************************
+ TYPEDEFS
+ ******************************************************************************/
+
+/*
+ * Maximum size of a pre-encoded primary block template.  This covers an IPN-scheme primary
+ * block with all integers at their largest encoded size, excluding the creation timestamp values.
+ */
+#define V7_PRIMARY_BLOCK_TEMPLATE_MAX_SIZE 104
+
+typedef struct v7_primary_block_template
+{
+    bp_crctype_t crctype;
+    uint8_t      prefix_size; /* octets before the creation timestamp values */
+    uint8_t      suffix_size; /* octets after the creation timestamp values, not including the CRC */
+    uint8_t      octets[V7_PRIMARY_BLOCK_TEMPLATE_MAX_SIZE];
+} v7_primary_block_template_t;
+
 /*
  * On the decode side of things, the bundle buffer is passed in from the network/CLA and all that is known will
  * be a pointer and size.  The first block is always supposed to be primary (per BP) and every block thereafter
  * can be assumed canonical.  Payload of the bundle will be recorded as an offset and size into that block, there
  * is no separate output.
  */
-int v7_block_decode_pri(bplib_mpool_bblock_primary_t *cpb, const void *data_ptr, size_t data_size);
+int v7_block_decode_pri(bplib_mpool_bblock_primary_t *cpb, const void *data_ptr, size_t data_size, bool defer_crc);
 int v7_block_decode_canonical(bplib_mpool_bblock_canonical_t *ccb, const void *data_ptr, size_t data_size,
-                              bp_blocktype_t payload_block_hint);
+                              bp_blocktype_t payload_block_hint, bool defer_crc);
+
+/*
+ * If the CRC check was deferred when the bundle was decoded (defer_crc set), this must be called before
+ * the bundle is stored, consumed locally, or modified in any way.  A bundle that is only relayed to another
+ * CLA can be sent on without ever calling this; the original encoded blocks (and CRC values) are sent as-is.
+ *
+ * Returns 0 if the CRCs are good (or were already checked), -1 if any block fails to validate.
+ */
+int v7_verify_deferred_crc(bplib_mpool_bblock_primary_t *cpb);
 
 /*
  * On the encode side of things, the block types are known ahead of time.  Encoding of a payload block is separate
@@ -47,12 +74,109 @@ int v7_block_decode_canonical(bplib_mpool_bblock_canonical_t *ccb, const void *d
  * more consistent.
  */
 int v7_block_encode_pri(bplib_mpool_bblock_primary_t *cpb);
+
+/*
+ * A series of bundles from the same source (e.g. a connected socket) have primary blocks that differ only
+ * in the creation timestamp.  A template holds the pre-encoded octets before and after the timestamp, so
+ * encoding a primary block from it is just a copy, encoding of the two timestamp values, and the CRC.
+ *
+ * The template is initialized from a logical primary block, and can be used for any primary block whose
+ * fields (other than the creation timestamp) match it.  Only IPN-scheme primary blocks can be templated;
+ * v7_block_template_init_pri() returns -1 for anything else, and the caller should fall back to
+ * v7_block_encode_pri().
+ */
+int v7_block_template_init_pri(v7_primary_block_template_t *tmpl, const bp_primary_block_t *pri);
+int v7_block_encode_pri_from_template(bplib_mpool_bblock_primary_t *cpb, const v7_primary_block_template_t *tmpl);
 int v7_block_encode_pay(bplib_mpool_bblock_canonical_t *ccb, const void *data_ptr, size_t data_size);
 
 int v7_block_encode_canonical(bplib_mpool_bblock_canonical_t *ccb);
 
+/*
+ * A forwarding node updates the previous node, bundle age and hop count blocks.  These are encoded with
+ * fixed-width integers, so after changing the logical data this overwrites the content of the existing
+ * encoded block and recomputes only its CRC; the size of the block (and thus the bundle) is unchanged.
+ * Any other block type, or a block that was not encoded in the fixed-width layout, is re-encoded via
+ * v7_block_encode_canonical() instead.
+ *
+ * Returns 0 on success, -1 if the block could not be encoded, or if the bundle CRCs were deferred and
+ * do not validate.
+ */
+int v7_block_update_canonical(bplib_mpool_bblock_canonical_t *ccb);
+
 size_t v7_compute_full_bundle_size(bplib_mpool_bblock_primary_t *cpb);
 size_t v7_copy_full_bundle_out(bplib_mpool_bblock_primary_t *cpb, void *buffer, size_t buf_sz);
-size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buffer, size_t buf_sz);
+size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buffer, size_t buf_sz, bool defer_crc);
+
+/*
+ * Fragmentation (RFC 9171 section 5.8).  When a bundle is too big for the CLA, it is sent as a series
+ * of fragments, each of which is written directly into the CLA buffer from the blocks of the original
+ * bundle - the payload slice is copied straight from the original payload chunks, so no separate
+ * bundle is ever created for a fragment.
+ *
+ * This writes the fragment holding the payload from payload_offset onward, with as much of the payload
+ * as fits in buf_sz.  The first fragment (offset 0) carries all the extension blocks, the rest only carry
+ * the ones flagged for replication.  The offset for the next fragment is output via next_offset, or 0
+ * after the last fragment.
+ *
+ * Returns the size of the fragment, or 0 if the bundle cannot be fragmented (it is flagged as must not
+ * fragment, is an administrative record, or is not IPN scheme) or the buffer is too small for even one
+ * octet of the payload.
+ */
+size_t v7_copy_fragment_out(bplib_mpool_bblock_primary_t *cpb, size_t payload_offset, void *buffer, size_t buf_sz,
+                            size_t *next_offset);
+
+/*
+ * On the receiving end, this encodes the payload block of a reassembled bundle from the payload blocks
+ * of its fragments.  The fragment_list holds the fragments (blocks that convert to a primary block, such
+ * as references) in order of fragment offset, which together must cover the whole total_length; where
+ * they overlap, the data from the earlier one is used.  The logical data of the payload block must be
+ * set beforehand, as for v7_block_encode_pay().
+ *
+ * Returns 0 on success, -1 if the fragments do not cover the payload or it could not be encoded.
+ */
+int v7_block_encode_pay_from_fragments(bplib_mpool_bblock_canonical_t *ccb, bplib_mpool_block_t *fragment_list,
+                                       size_t total_length);
+
+/*
+ * Aggregation of small bundles.  An aggregate is an administrative record carrying a series of complete
+ * encoded bundles, each one as a byte string.  It only goes one hop; the receiving CLA takes the bundles
+ * back out, and the aggregate itself is discarded.
+ *
+ * Every bundle adds v7_compute_aggregate_entry_size() octets to the payload of the aggregate, and the
+ * rest of the aggregate (primary block, payload block header, CRCs and record framing) never exceeds
+ * V7_AGGREGATE_MAX_OVERHEAD.
+ */
+#define V7_AGGREGATE_MAX_OVERHEAD 160
+
+size_t v7_compute_aggregate_entry_size(size_t bundle_size);
+
+/*
+ * Encodes the payload block of an aggregate from the bundles in bundle_list (blocks that convert to a
+ * primary block, such as references).  The encoded blocks of each bundle are copied as they are, so any
+ * changes to them must be made beforehand.  The logical data of the payload block must be set beforehand,
+ * with the block type set to bp_blocktype_bundleAggregatePayloadBlock.
+ *
+ * Returns 0 on success, -1 if it could not be encoded.
+ */
+int v7_block_encode_pay_from_bundles(bplib_mpool_bblock_canonical_t *ccb, bplib_mpool_block_t *bundle_list);
+
+/*
+ * Gets the next bundle out of a received aggregate.  The cpb must have been decoded from this buffer by
+ * v7_copy_full_bundle_in(), the bundles are located within the buffer itself and not copied.  The position
+ * should be 0 on the first call, and is updated each time.
+ *
+ * Returns the size of the bundle, and outputs a pointer to it via bundle_ptr, or returns 0 after the last
+ * one (or if this is not an aggregate, or it is malformed).
+ */
+size_t v7_next_aggregated_bundle(bplib_mpool_bblock_primary_t *cpb, const void *buffer, size_t buf_sz,
+                                 size_t *position, const void **bundle_ptr);
+
+/*
+ * The common block shapes (IPN-scheme primary block, payload, previous node, bundle age, hop count and
+ * custody tracking blocks) are encoded and decoded by specialized straight-line code, and everything else
+ * goes through the generic CBOR path.  Both produce the same encoded octets.  The specialized code is
+ * enabled by default; this switch exists mainly so the two can be compared.
+ */
+void v7_codec_enable_fast_path(bool enable);
 
 #endif /* V7_CODEC_H */
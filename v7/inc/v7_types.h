@@ -27,7 +27,11 @@
 
 #include "bplib_api_types.h"
 
-#define BP_DACS_MAX_SEQ_PER_PAYLOAD 16
+/*
+ * The maximum number of sequence number ranges in a single DACS payload.
+ * Each range covers any number of consecutive sequence numbers.
+ */
+#define BP_DACS_MAX_SEQ_RANGES_PER_PAYLOAD 16
 
 /******************************************************************************
  TYPEDEFS
@@ -67,11 +71,18 @@ typedef enum bp_blocktype
      * is deduced from the other bundle block contents, but CBOR-encoded content will have a
      * value of 1.
      */
-    bp_blocktype_SPECIAL_PAYLOADS_START    = 100,
-    bp_blocktype_adminRecordPayloadBlock   = bp_blocktype_SPECIAL_PAYLOADS_START,
-    bp_blocktype_ciphertextPayloadBlock    = 101,
-    bp_blocktype_custodyAcceptPayloadBlock = 102,
-    bp_blocktype_SPECIAL_PAYLOADS_MAX
+    bp_blocktype_SPECIAL_PAYLOADS_START      = 100,
+    bp_blocktype_adminRecordPayloadBlock     = bp_blocktype_SPECIAL_PAYLOADS_START,
+    bp_blocktype_ciphertextPayloadBlock      = 101,
+    bp_blocktype_custodyAcceptPayloadBlock   = 102,
+    bp_blocktype_bundleAggregatePayloadBlock = 103,
+    bp_blocktype_SPECIAL_PAYLOADS_MAX,
+
+    /*
+     * RFC9171 reserves block types 192-255 for private and experimental use.  These are
+     * only understood by bplib.
+     */
+    bp_blocktype_payloadCompressionBlock = 192
 } bp_blocktype_t;
 
 typedef enum bp_adminrectype
@@ -79,8 +90,9 @@ typedef enum bp_adminrectype
     bp_adminrectype_undefined              = 0,
     bp_adminrectype_statusReport           = 1,
     bp_adminrectype_custodyAcknowledgement = 4,
+    bp_adminrectype_bundleAggregate        = 5, /* not IANA assigned, only understood by bplib */
 
-    bp_adminrectype_MAX = 5
+    bp_adminrectype_MAX = 6
 
 } bp_adminrectype_t;
 
@@ -250,12 +262,26 @@ typedef struct bp_custody_tracking_block
     bp_endpointid_buffer_t current_custodian;
 } bp_custody_tracking_block_t;
 
+/* The payload of a bundle with this block is compressed, this identifies how to decompress it */
+typedef struct bp_payload_compression_block
+{
+    bp_integer_t algorithm;
+    bp_integer_t uncompressed_length;
+} bp_payload_compression_block_t;
+
+/* A run of consecutive sequence numbers, starting at "start" and covering "length" values */
+typedef struct bp_custody_seq_range
+{
+    bp_sequencenumber_t start;
+    bp_integer_t        length;
+} bp_custody_seq_range_t;
+
 /* This reflects the payload block (1) of a bundle containing a custody block w/bp_custody_op_accept */
 typedef struct bp_custody_accept_payload_block
 {
     bp_endpointid_buffer_t flow_source_eid;
-    bp_integer_t           num_entries;
-    bp_integer_t           sequence_nums[BP_DACS_MAX_SEQ_PER_PAYLOAD];
+    bp_integer_t           num_ranges; /* ranges are kept sorted and non-adjacent */
+    bp_custody_seq_range_t seq_ranges[BP_DACS_MAX_SEQ_RANGES_PER_PAYLOAD];
 } bp_custody_accept_payload_block_t;
 
 typedef union bp_canonical_block_data
@@ -264,6 +290,7 @@ typedef union bp_canonical_block_data
     bp_bundle_age_block_t             age_block;
     bp_hop_count_block_t              hop_count_block;
     bp_custody_tracking_block_t       custody_tracking_block;
+    bp_payload_compression_block_t    payload_compression_block;
     bp_custody_accept_payload_block_t custody_accept_payload_block;
 } bp_canonical_block_data_t;
 
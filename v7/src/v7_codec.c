@@ -184,11 +184,15 @@ static void v7_decode_bp_hop_count_block(v7_decode_state_t *dec, bp_hop_count_bl
 static void v7_encode_bp_custody_tracking_block(v7_encode_state_t *enc, const bp_custody_tracking_block_t *v);
 static void v7_decode_bp_custody_tracking_block(v7_decode_state_t *dec, bp_custody_tracking_block_t *v);
 
+static void v7_encode_bp_payload_compression_block(v7_encode_state_t *enc, const bp_payload_compression_block_t *v);
+static void v7_decode_bp_payload_compression_block(v7_decode_state_t *dec, bp_payload_compression_block_t *v);
+
 static void v7_encode_bp_custody_acceptance_block(v7_encode_state_t *enc, const bp_custody_accept_payload_block_t *v);
 static void v7_decode_bp_custody_acceptance_block(v7_decode_state_t *dec, bp_custody_accept_payload_block_t *v);
 
 static void v7_decode_bp_canonical_block_buffer(v7_decode_state_t *dec, bp_canonical_block_buffer_t *v,
                                                 size_t *content_encoded_offset, size_t *content_length);
+static void v7_encode_bp_canonical_block_content(v7_encode_state_t *enc, const bp_canonical_block_buffer_t *v);
 static void v7_encode_bp_canonical_block_buffer(v7_encode_state_t *enc, const bp_canonical_block_buffer_t *v,
                                                 const void *content_ptr, size_t content_length,
                                                 size_t *content_encoded_offset);
@@ -213,9 +217,50 @@ static void v7_encode_bp_canonical_block_buffer(v7_encode_state_t *enc, const bp
  *
  * Returns the actual size saved to the storage service.  If the CRC fails to validate, this returns 0,
  * and nothing is saved to the storage service.
+ *
+ * If defer_crc is set, the block is saved without computing the CRC at all.  The original encoded bytes
+ * (including the original CRC value) are kept, so the block can still be checked later on by
+ * v7_verify_deferred_crc(), and it can be sent back out unchanged without ever being checked.
  */
 static size_t v7_save_and_verify_block(bplib_mpool_block_t *head, const uint8_t *block_base, size_t block_size,
-                                       bp_crctype_t crc_type, bp_crcval_t crc_check);
+                                       bp_crctype_t crc_type, bp_crcval_t crc_check, bool defer_crc);
+
+/*
+ * Copies a range of the encoded data saved in a chunk list (e.g. the content of an existing block)
+ * into the stream, without an intermediate buffer.  If digest is false, the data is not added to the
+ * stream CRC (see bplib_mpool_stream_write_undigested()).  Returns the number of octets copied, which
+ * is less than data_size only if the saved data does not extend over the whole range.
+ */
+static size_t v7_stream_copy_saved_data(bplib_mpool_stream_t *mps, bplib_mpool_block_t *head, size_t data_offset,
+                                        size_t data_size, bool digest);
+
+/*
+ * Gets the CRC parameters for the CRC type of a block, or NULL if the block has no CRC.
+ */
+static bplib_crc_parameters_t *v7_get_crc_params(bp_crctype_t crc_type);
+
+/*
+ * Checks the CRC of a block that was previously saved by v7_save_and_verify_block() with the
+ * check deferred.  The CRC value field is still present in the saved data, so it is treated as
+ * zeros here, the same way as the check during decode.
+ */
+static bool v7_verify_saved_block(bplib_mpool_block_t *head, size_t block_size, bp_crctype_t crc_type,
+                                  bp_crcval_t crc_check);
+
+/*
+ * Computes the CRC of a saved block from its chunks, the same way as the check above, treating the
+ * CRC value field at the end of the block as zeros.  The CRC length is output as 0 (and the result
+ * is true) if the block has no CRC.
+ */
+static bool v7_compute_saved_block_crc(bplib_mpool_block_t *head, size_t block_size, bp_crctype_t crc_type,
+                                       size_t *crc_len_out, bp_crcval_t *crc_out);
+
+/*
+ * Overwrites part of a saved block at the given offset, which may span chunks.  The saved
+ * data must already extend over the whole range; this never changes the size of the block.
+ */
+static bool v7_overwrite_saved_block(bplib_mpool_block_t *head, size_t offset, const void *data_ptr,
+                                     size_t data_size);
 
 /*
  * -----------------------------------------------------------------------------------
@@ -624,7 +669,7 @@ void v7_decode_bp_crctype(v7_decode_state_t *dec, bp_crctype_t *v)
     *v = (bp_crctype_t)v7_decode_small_int(dec);
 }
 
-void v7_encode_bitmap(v7_encode_state_t *enc, const uint8_t *v, const v7_bitmap_table_t *ptbl)
+static bp_integer_t v7_bitmap_to_integer(const uint8_t *v, const v7_bitmap_table_t *ptbl)
 {
     bp_integer_t value;
 
@@ -638,14 +683,11 @@ void v7_encode_bitmap(v7_encode_state_t *enc, const uint8_t *v, const v7_bitmap_
         ++ptbl;
     }
 
-    v7_encode_bp_integer(enc, &value);
+    return value;
 }
 
-void v7_decode_bitmap(v7_decode_state_t *dec, uint8_t *v, const v7_bitmap_table_t *ptbl)
+static void v7_integer_to_bitmap(bp_integer_t value, uint8_t *v, const v7_bitmap_table_t *ptbl)
 {
-    bp_integer_t value;
-
-    v7_decode_bp_integer(dec, &value);
     while (ptbl->mask != 0)
     {
         v[ptbl->offset] = (value & ptbl->mask) != 0;
@@ -653,6 +695,22 @@ void v7_decode_bitmap(v7_decode_state_t *dec, uint8_t *v, const v7_bitmap_table_
     }
 }
 
+void v7_encode_bitmap(v7_encode_state_t *enc, const uint8_t *v, const v7_bitmap_table_t *ptbl)
+{
+    bp_integer_t value;
+
+    value = v7_bitmap_to_integer(v, ptbl);
+    v7_encode_bp_integer(enc, &value);
+}
+
+void v7_decode_bitmap(v7_decode_state_t *dec, uint8_t *v, const v7_bitmap_table_t *ptbl)
+{
+    bp_integer_t value;
+
+    v7_decode_bp_integer(dec, &value);
+    v7_integer_to_bitmap(value, v, ptbl);
+}
+
 void v7_encode_bp_bundle_processing_control_flags(v7_encode_state_t *enc, const bp_bundle_processing_control_flags_t *v)
 {
     v7_encode_bitmap(enc, (const uint8_t *)v, V7_BUNDLE_CONTROL_FLAGS_BITMAP_TABLE);
@@ -898,14 +956,49 @@ void v7_decode_bp_custody_tracking_block(v7_decode_state_t *dec, bp_custody_trac
     v7_decode_bp_endpointid_buffer(dec, &v->current_custodian);
 }
 
+static void v7_encode_bp_payload_compression_block_impl(v7_encode_state_t *enc, const void *arg)
+{
+    const bp_payload_compression_block_t *v = arg;
+
+    v7_encode_bp_integer(enc, &v->algorithm);
+    v7_encode_bp_integer(enc, &v->uncompressed_length);
+}
+
+void v7_encode_bp_payload_compression_block(v7_encode_state_t *enc, const bp_payload_compression_block_t *v)
+{
+    v7_encode_container(enc, 2, v7_encode_bp_payload_compression_block_impl, v);
+}
+
+static void v7_decode_bp_payload_compression_block_impl(v7_decode_state_t *dec, void *arg)
+{
+    bp_payload_compression_block_t *v = arg;
+
+    v7_decode_bp_integer(dec, &v->algorithm);
+    v7_decode_bp_integer(dec, &v->uncompressed_length);
+}
+
+void v7_decode_bp_payload_compression_block(v7_decode_state_t *dec, bp_payload_compression_block_t *v)
+{
+    v7_decode_container(dec, 2, v7_decode_bp_payload_compression_block_impl, v);
+}
+
+static void v7_encode_bp_custody_seq_range_impl(v7_encode_state_t *enc, const void *arg)
+{
+    const bp_custody_seq_range_t *v = arg;
+
+    v7_encode_bp_sequencenumber(enc, &v->start);
+    v7_encode_bp_integer(enc, &v->length);
+}
+
 static void v7_encode_bp_custody_acceptance_seqlist_impl(v7_encode_state_t *enc, const void *arg)
 {
     const bp_custody_accept_payload_block_t *v = arg;
     bp_integer_t                             n;
 
-    for (n = 0; n < v->num_entries && !enc->error; ++n)
+    /* each entry is a [start, length] pair, describing a run of consecutive sequence numbers */
+    for (n = 0; n < v->num_ranges && !enc->error; ++n)
     {
-        v7_encode_bp_integer(enc, &v->sequence_nums[n]);
+        v7_encode_container(enc, 2, v7_encode_bp_custody_seq_range_impl, &v->seq_ranges[n]);
     }
 }
 
@@ -914,7 +1007,7 @@ static void v7_encode_bp_custody_acceptance_block_impl(v7_encode_state_t *enc, c
     const bp_custody_accept_payload_block_t *v = arg;
 
     v7_encode_bp_endpointid_buffer(enc, &v->flow_source_eid);
-    v7_encode_container(enc, v->num_entries, v7_encode_bp_custody_acceptance_seqlist_impl, v);
+    v7_encode_container(enc, v->num_ranges, v7_encode_bp_custody_acceptance_seqlist_impl, v);
 }
 
 void v7_encode_bp_custody_acceptance_block(v7_encode_state_t *enc, const bp_custody_accept_payload_block_t *v)
@@ -922,19 +1015,33 @@ void v7_encode_bp_custody_acceptance_block(v7_encode_state_t *enc, const bp_cust
     v7_encode_container(enc, 2, v7_encode_bp_custody_acceptance_block_impl, v);
 }
 
+static void v7_decode_bp_custody_seq_range_impl(v7_decode_state_t *dec, void *arg)
+{
+    bp_custody_seq_range_t *v = arg;
+
+    v7_decode_bp_sequencenumber(dec, &v->start);
+    v7_decode_bp_integer(dec, &v->length);
+
+    /* a range must cover at least one sequence number, and must not wrap around */
+    if (!dec->error && (v->length == 0 || (v->start + v->length) < v->start))
+    {
+        dec->error = true;
+    }
+}
+
 static void v7_decode_bp_custody_acceptance_seqlist_impl(v7_decode_state_t *dec, void *arg)
 {
     bp_custody_accept_payload_block_t *v = arg;
 
-    while (!cbor_value_at_end(dec->cbor) && v->num_entries < BP_DACS_MAX_SEQ_PER_PAYLOAD)
+    while (!cbor_value_at_end(dec->cbor) && v->num_ranges < BP_DACS_MAX_SEQ_RANGES_PER_PAYLOAD)
     {
-        v7_decode_bp_integer(dec, &v->sequence_nums[v->num_entries]);
+        v7_decode_container(dec, 2, v7_decode_bp_custody_seq_range_impl, &v->seq_ranges[v->num_ranges]);
         if (dec->error)
         {
             break;
         }
 
-        ++v->num_entries;
+        ++v->num_ranges;
     }
 }
 
@@ -989,6 +1096,13 @@ static void v7_decode_bp_adminrec_payload_impl(v7_decode_state_t *dec, void *arg
                 v7_decode_bp_custody_acceptance_block(dec,
                                                       &admin_rec_payload->payload_data->custody_accept_payload_block);
                 break;
+            case bp_adminrectype_bundleAggregate:
+                /* the bundles in the record are not decoded here, see v7_next_aggregated_bundle() */
+                if (cbor_value_advance(dec->cbor) != CborNoError)
+                {
+                    dec->error = true;
+                }
+                break;
             default:
                 /* missing implementation */
                 dec->error = true;
@@ -1037,6 +1151,9 @@ void v7_decode_bp_admin_record_payload(v7_decode_state_t *dec, bp_canonical_bloc
             case bp_adminrectype_custodyAcknowledgement:
                 v->canonical_block.blockType = bp_blocktype_custodyAcceptPayloadBlock;
                 break;
+            case bp_adminrectype_bundleAggregate:
+                v->canonical_block.blockType = bp_blocktype_bundleAggregatePayloadBlock;
+                break;
             default:
                 /* missing implementation */
                 dec->error = true;
@@ -1045,6 +1162,49 @@ void v7_decode_bp_admin_record_payload(v7_decode_state_t *dec, bp_canonical_bloc
     }
 }
 
+void v7_encode_bp_canonical_block_content(v7_encode_state_t *enc, const bp_canonical_block_buffer_t *logical)
+{
+    switch (logical->canonical_block.blockType)
+    {
+        case bp_blocktype_payloadBlock:
+            break;
+        case bp_blocktype_bundleAuthenicationBlock:
+            break;
+        case bp_blocktype_payloadIntegrityBlock:
+            break;
+        case bp_blocktype_payloadConfidentialityBlock:
+            break;
+        case bp_blocktype_previousHopInsertionBlock:
+            break;
+        case bp_blocktype_previousNode:
+            v7_encode_bp_previous_node_block(enc, &logical->data.previous_node_block);
+            break;
+        case bp_blocktype_bundleAge:
+            v7_encode_bp_bundle_age_block(enc, &logical->data.age_block);
+            break;
+        case bp_blocktype_metadataExtensionBlock:
+            break;
+        case bp_blocktype_extensionSecurityBlock:
+            break;
+        case bp_blocktype_hopCount:
+            v7_encode_bp_hop_count_block(enc, &logical->data.hop_count_block);
+            break;
+        case bp_blocktype_custodyTrackingBlock:
+            v7_encode_bp_custody_tracking_block(enc, &logical->data.custody_tracking_block);
+            break;
+        case bp_blocktype_payloadCompressionBlock:
+            v7_encode_bp_payload_compression_block(enc, &logical->data.payload_compression_block);
+            break;
+        case bp_blocktype_adminRecordPayloadBlock:
+        case bp_blocktype_custodyAcceptPayloadBlock:
+            v7_encode_bp_admin_record_payload(enc, logical);
+            break;
+        default:
+            /* do nothing */
+            break;
+    }
+}
+
 void v7_encode_bp_canonical_bundle_block(v7_encode_state_t *enc, const bp_canonical_bundle_block_t *v,
                                          const v7_canonical_block_info_t *info)
 {
@@ -1225,292 +1385,2029 @@ void v7_decode_bp_canonical_block_buffer(v7_decode_state_t *dec, bp_canonical_bl
     *content_length = info.content_size;
 }
 
-static CborError v7_encoder_write(void *arg, const void *ptr, size_t sz, CborEncoderAppendType at)
+/*
+ * -----------------------------------------------------------------------------------
+ * IMPLEMENTATION
+ * Specialized encode/decode for the common block shapes
+ *
+ * The generic encode/decode above goes through TinyCBOR and the container callbacks for
+ * every field.  The routines below handle the shapes that make up nearly all traffic
+ * (IPN-scheme primary block, and the payload, previous node, bundle age and hop count
+ * canonical blocks) with straight-line code that works directly on the bytes.
+ *
+ * The encoders produce the same octets as the generic path (preferred/shortest CBOR
+ * integer encoding, definite-length arrays), except for the previous node, bundle age and
+ * hop count content, which is always encoded at a fixed width by both paths so it can be
+ * updated in place when forwarding.  The decoders accept only definite-length
+ * arrays with the expected number of items; anything else returns "not handled" and the
+ * caller falls back to the generic path, which deals with (or rejects) the unusual shapes.
+ * -----------------------------------------------------------------------------------
+ */
+
+/*
+ * Upper bound of the primary block, without the CRC: array header, version, 3 EIDs of 5 octets
+ * plus 2 integers each, and up to 7 more integers of 9 octets each.
+ */
+#define V7_FAST_PRI_MAX_ENCODE_SIZE (2 + (3 * (3 + (2 * 9))) + (7 * 9))
+
+/*
+ * Upper bound of the canonical block header up to and including the byte string head, and of the
+ * content of the extension blocks encoded here (the largest being an EID, hop count or compression block).
+ */
+#define V7_FAST_CANONICAL_MAX_HEADER_SIZE  (1 + (5 * 9))
+#define V7_FAST_CANONICAL_MAX_CONTENT_SIZE (3 + (2 * 9))
+
+#define V7_FAST_CBOR_MAJOR_UINT       0x00
+#define V7_FAST_CBOR_MAJOR_BYTESTRING 0x40
+#define V7_FAST_CBOR_MAJOR_ARRAY      0x80
+
+static bool V7_CODEC_FAST_PATH_ENABLED = true;
+
+static inline uint8_t *v7_fast_put_head(uint8_t *out, uint8_t major, uint64_t val)
 {
-    v7_encode_state_t *v7_state = arg;
-    if (bplib_mpool_stream_write(&v7_state->mps, ptr, sz) < sz)
+    if (val < 24)
     {
-        return CborErrorOutOfMemory;
+        *out++ = major | (uint8_t)val;
+    }
+    else if (val <= 0xFF)
+    {
+        *out++ = major | 24;
+        *out++ = (uint8_t)val;
+    }
+    else if (val <= 0xFFFF)
+    {
+        *out++ = major | 25;
+        *out++ = (uint8_t)(val >> 8);
+        *out++ = (uint8_t)val;
+    }
+    else if (val <= 0xFFFFFFFF)
+    {
+        *out++ = major | 26;
+        *out++ = (uint8_t)(val >> 24);
+        *out++ = (uint8_t)(val >> 16);
+        *out++ = (uint8_t)(val >> 8);
+        *out++ = (uint8_t)val;
+    }
+    else
+    {
+        *out++ = major | 27;
+        *out++ = (uint8_t)(val >> 56);
+        *out++ = (uint8_t)(val >> 48);
+        *out++ = (uint8_t)(val >> 40);
+        *out++ = (uint8_t)(val >> 32);
+        *out++ = (uint8_t)(val >> 24);
+        *out++ = (uint8_t)(val >> 16);
+        *out++ = (uint8_t)(val >> 8);
+        *out++ = (uint8_t)val;
     }
 
-    return CborNoError;
+    return out;
 }
 
-size_t v7_save_and_verify_block(bplib_mpool_block_t *head, const uint8_t *block_base, size_t block_size,
-                                bp_crctype_t crc_type, bp_crcval_t crc_check)
+/*
+ * Writes a CBOR head that always uses the 8-octet argument form, whatever the value.  This is still
+ * well-formed CBOR (just not the preferred serialization) and gives the field a fixed encoded size,
+ * so it can later be overwritten in place with any other value.
+ */
+static inline uint8_t *v7_fast_put_head_fixed(uint8_t *out, uint8_t major, uint64_t val)
 {
-    static const uint8_t    ZERO_BYTES[4] = {0};
-    size_t                  data_len;
-    size_t                  crc_len;
-    bplib_crc_parameters_t *crc_params;
-    bp_crcval_t             crc_val;
-    bplib_mpool_stream_t    mps;
-    size_t                  result;
+    int shift;
 
-    result = 0;
-    bplib_mpool_start_stream_init(&mps, bplib_mpool_get_parent_pool_from_link(head), bplib_mpool_stream_dir_write,
-                                  crc_type);
-    crc_params = bplib_mpool_stream_get_crc_params(&mps);
-    crc_len    = bplib_crc_get_width(crc_params) / 8;
-    if (crc_len < block_size && crc_len <= sizeof(ZERO_BYTES))
+    *out++ = major | 27;
+    for (shift = 56; shift >= 0; shift -= 8)
     {
-        data_len = block_size - crc_len;
-        /* first copy only the data part */
-        if (bplib_mpool_stream_write(&mps, block_base, data_len) == data_len)
-        {
-            /* snapshot the CRC intermediate value now */
-            crc_val = bplib_mpool_stream_get_intermediate_crc(&mps);
-
-            /* now copy the original (still unverified) CRC to the buffer */
-            if (bplib_mpool_stream_write(&mps, block_base + data_len, crc_len) == crc_len)
-            {
-                /* now verify the CRC - need to pump in zero bytes for CRC width */
-                crc_val = bplib_crc_update(crc_params, crc_val, ZERO_BYTES, crc_len);
-                crc_val = bplib_crc_finalize(crc_params, crc_val);
-
-                if (crc_val == crc_check)
-                {
-                    result = bplib_mpool_stream_tell(&mps);
-                    bplib_mpool_stream_attach(&mps, head);
-                }
-            }
-        }
+        *out++ = (uint8_t)(val >> shift);
     }
 
-    bplib_mpool_stream_close(&mps);
-
-    return result;
+    return out;
 }
 
-int v7_block_decode_pri(bplib_mpool_bblock_primary_t *cpb, const void *data_ptr, size_t data_size)
+/*
+ * Reads a CBOR head of the given major type.  Returns the position after it, or NULL if the
+ * data is short, the major type does not match, or the length is indefinite/reserved.
+ */
+static inline const uint8_t *v7_fast_get_head(const uint8_t *in, const uint8_t *end, uint8_t major, uint64_t *val)
 {
-    v7_decode_state_t   v7_state;
-    CborValue           origin;
-    bp_primary_block_t *pri;
-    size_t              block_size;
-    CborParser          parser;
+    uint8_t  info;
+    uint8_t  extra;
+    uint64_t result;
 
-    /* If there is any existing encoded data, return it to the pool */
-    bplib_mpool_bblock_primary_drop_encode(cpb);
-
-    pri = bplib_mpool_bblock_primary_get_logical(cpb);
-    memset(&v7_state, 0, sizeof(v7_state));
+    if (in >= end || (*in & 0xE0) != major)
+    {
+        return NULL;
+    }
 
-    if (cbor_parser_init(data_ptr, data_size, 0, &parser, &origin) != CborNoError)
+    info = *in & 0x1F;
+    ++in;
+    if (info < 24)
     {
-        v7_state.error = true;
+        *val = info;
+        return in;
     }
-    else
+    if (info > 27)
     {
-        v7_state.base = data_ptr;
-        v7_state.cbor = &origin;
-
-        v7_decode_bp_primary_block(&v7_state, pri);
+        return NULL;
     }
 
-    if (!v7_state.error)
+    extra = 1 << (info - 24);
+    if ((size_t)(end - in) < extra)
     {
-        block_size                   = cbor_value_get_next_byte(&origin) - v7_state.base;
-        cpb->block_encode_size_cache = v7_save_and_verify_block(bplib_mpool_bblock_primary_get_encoded_chunks(cpb),
-                                                                v7_state.base, block_size, pri->crctype, pri->crcval);
-
-        if (cpb->block_encode_size_cache != block_size)
-        {
-            /* something went wrong in validation */
-            v7_state.error = true;
-        }
+        return NULL;
     }
 
-    if (v7_state.error)
+    result = 0;
+    while (extra > 0)
     {
-        return -1;
+        result = (result << 8) | *in;
+        ++in;
+        --extra;
     }
-    return 0;
+
+    *val = result;
+    return in;
 }
 
-int v7_block_decode_canonical(bplib_mpool_bblock_canonical_t *ccb, const void *data_ptr, size_t data_size,
-                              bp_blocktype_t payload_block_hint)
+static inline const uint8_t *v7_fast_get_small_int(const uint8_t *in, const uint8_t *end, int *val)
 {
-    v7_decode_state_t            v7_state;
-    CborValue                    origin;
-    bp_canonical_block_buffer_t *logical;
-    size_t                       block_size;
-    CborParser                   parser;
-    size_t                       content_offset;
-    size_t                       content_size;
-
-    block_size     = 0;
-    content_offset = 0;
-    content_size   = 0;
+    uint64_t temp;
 
-    /* If there is any existing encoded data, return it to the pool */
-    bplib_mpool_bblock_canonical_drop_encode(ccb);
+    in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &temp);
+    if (in != NULL && temp <= INT_MAX)
+    {
+        *val = (int)temp;
+        return in;
+    }
 
-    logical = bplib_mpool_bblock_canonical_get_logical(ccb);
-    memset(&v7_state, 0, sizeof(v7_state));
+    return NULL;
+}
 
-    if (cbor_parser_init(data_ptr, data_size, 0, &parser, &origin) != CborNoError)
+static uint8_t *v7_fast_put_ipn_eid(uint8_t *out, const bp_endpointid_buffer_t *v)
+{
+    if (v->scheme != bp_endpointid_scheme_ipn)
     {
-        v7_state.error = true;
+        return NULL;
     }
-    else
-    {
-        v7_state.base = data_ptr;
-        v7_state.cbor = &origin;
 
-        v7_decode_bp_canonical_block_buffer(&v7_state, logical, &content_offset, &content_size);
+    *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+    *out++ = bp_endpointid_scheme_ipn;
+    *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+    out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->ssp.ipn.node_number);
+    out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->ssp.ipn.service_number);
+
+    return out;
+}
+
+static const uint8_t *v7_fast_get_ipn_eid(const uint8_t *in, const uint8_t *end, bp_endpointid_buffer_t *v)
+{
+    if ((end - in) < 5 || in[0] != (V7_FAST_CBOR_MAJOR_ARRAY | 2) || in[1] != bp_endpointid_scheme_ipn ||
+        in[2] != (V7_FAST_CBOR_MAJOR_ARRAY | 2))
+    {
+        return NULL;
     }
 
-    if (!v7_state.error)
+    v->scheme = bp_endpointid_scheme_ipn;
+    in        = v7_fast_get_head(in + 3, end, V7_FAST_CBOR_MAJOR_UINT, &v->ssp.ipn.node_number);
+    if (in != NULL)
     {
-        /* This reflects the size of the entire CBOR blob that the caller passed in */
-        block_size = cbor_value_get_next_byte(&origin) - v7_state.base;
+        in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &v->ssp.ipn.service_number);
+    }
 
-        /* Copy it to the pool buffers, and check the CRC in the process */
-        ccb->block_encode_size_cache =
-            v7_save_and_verify_block(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb), v7_state.base, block_size,
-                                     logical->canonical_block.crctype, logical->canonical_block.crcval);
+    return in;
+}
 
-        if (ccb->block_encode_size_cache != block_size)
-        {
-            v7_state.error = true;
-        }
-        else
-        {
-            bplib_mpool_bblock_canonical_set_content_position(ccb, content_offset, content_size);
-        }
+/*
+ * Gets the octet size of the CRC for the given type, which is also the size of the CRC byte string.
+ * Returns 0 for no CRC, or -1 for an unknown type.
+ */
+static int v7_fast_crc_size(bp_crctype_t crctype)
+{
+    switch (crctype)
+    {
+        case bp_crctype_none:
+            return 0;
+        case bp_crctype_CRC16:
+            return 2;
+        case bp_crctype_CRC32C:
+            return 4;
+        default:
+            break;
     }
 
-    if (!v7_state.error)
-    {
-        /*
-         * Second stage decode - for recognized non-payload extension blocks
+    return -1;
+}
+
+/*
+ * Writes the CRC byte string to the buffer, given the intermediate CRC of everything in the block
+ * before it.  Like v7_encode_crc(), the byte string head and zeros are digested in place of the value.
+ * The crc_len must match the width of the CRC parameters.  Returns the position after the CRC.
+ */
+static uint8_t *v7_fast_put_crc(uint8_t *out, bplib_crc_parameters_t *crc_params, bp_crcval_t crc_val, size_t crc_len)
+{
+    size_t i;
+
+    out[0] = V7_FAST_CBOR_MAJOR_BYTESTRING | (uint8_t)crc_len;
+    memset(&out[1], 0, crc_len);
+
+    crc_val = bplib_crc_update(crc_params, crc_val, out, 1 + crc_len);
+    crc_val = bplib_crc_finalize(crc_params, crc_val);
+
+    for (i = crc_len; i > 0; --i)
+    {
+        out[i] = crc_val & 0xFF;
+        crc_val >>= 8;
+    }
+
+    return out + 1 + crc_len;
+}
+
+/*
+ * Writes the CRC to the stream as a byte string.  The stream must have been started with the crctype
+ * of the block, so its intermediate CRC covers everything before this point.
+ */
+static void v7_fast_write_crc(v7_encode_state_t *enc, size_t crc_len)
+{
+    bplib_crc_parameters_t *crc_params;
+    uint8_t                 crc_encode[1 + sizeof(bp_crcval_t)];
+
+    crc_params = bplib_mpool_stream_get_crc_params(&enc->mps);
+    if (crc_len > sizeof(bp_crcval_t) || crc_len != (bplib_crc_get_width(crc_params) / 8))
+    {
+        enc->error = true;
+        return;
+    }
+
+    v7_fast_put_crc(crc_encode, crc_params, bplib_mpool_stream_get_intermediate_crc(&enc->mps), crc_len);
+
+    if (bplib_mpool_stream_write(&enc->mps, crc_encode, 1 + crc_len) < (1 + crc_len))
+    {
+        enc->error = true;
+    }
+}
+
+static const uint8_t *v7_fast_get_crc(const uint8_t *in, const uint8_t *end, size_t crc_len, bp_crcval_t *v)
+{
+    bp_crcval_t crc_val;
+    size_t      i;
+
+    if ((size_t)(end - in) < (1 + crc_len) || *in != (V7_FAST_CBOR_MAJOR_BYTESTRING | crc_len))
+    {
+        return NULL;
+    }
+
+    ++in;
+    crc_val = 0;
+    for (i = 0; i < crc_len; ++i)
+    {
+        crc_val = (crc_val << 8) | *in;
+        ++in;
+    }
+
+    *v = crc_val;
+    return in;
+}
+
+/*
+ * Encodes the part of an IPN-scheme primary block that comes before the creation timestamp
+ * values, ending with the timestamp array head.  Returns NULL if the block cannot be handled here.
+ */
+static uint8_t *v7_fast_put_primary_prefix(uint8_t *out, const bp_primary_block_t *v)
+{
+    int          crc_len;
+    size_t       num_fields;
+    bp_integer_t flags;
+
+    crc_len = v7_fast_crc_size(v->crctype);
+    if (v->version != 7 || crc_len < 0)
+    {
+        return NULL;
+    }
+
+    num_fields = 8;
+    if (v->controlFlags.isFragment)
+    {
+        num_fields += 2;
+    }
+    if (crc_len != 0)
+    {
+        ++num_fields;
+    }
+
+    flags = v7_bitmap_to_integer((const uint8_t *)&v->controlFlags, V7_BUNDLE_CONTROL_FLAGS_BITMAP_TABLE);
+
+    *out++ = V7_FAST_CBOR_MAJOR_ARRAY | (uint8_t)num_fields;
+    *out++ = 7;
+    out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, flags);
+    out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->crctype);
+    out    = v7_fast_put_ipn_eid(out, &v->destinationEID);
+    if (out != NULL)
+    {
+        out = v7_fast_put_ipn_eid(out, &v->sourceEID);
+    }
+    if (out != NULL)
+    {
+        out = v7_fast_put_ipn_eid(out, &v->reportEID);
+    }
+    if (out != NULL)
+    {
+        *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+    }
+
+    return out;
+}
+
+/*
+ * Encodes the part of a primary block that comes after the creation timestamp, not including the CRC
+ */
+static uint8_t *v7_fast_put_primary_suffix(uint8_t *out, const bp_primary_block_t *v)
+{
+    out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->lifetime);
+
+    if (v->controlFlags.isFragment)
+    {
+        out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->fragmentOffset);
+        out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->totalADUlength);
+    }
+
+    return out;
+}
+
+/*
+ * Encodes an IPN-scheme primary block into the stream.  The stream must have been started with the
+ * crctype of the block.  Returns false if the block cannot be handled here, in which case nothing
+ * has been written.  Otherwise any failure is indicated via the error flag in the state.
+ */
+static bool v7_fast_encode_primary_block(v7_encode_state_t *enc, const bp_primary_block_t *v)
+{
+    uint8_t  buffer[V7_FAST_PRI_MAX_ENCODE_SIZE];
+    uint8_t *out;
+
+    out = v7_fast_put_primary_prefix(buffer, v);
+    if (out == NULL)
+    {
+        return false;
+    }
+
+    out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->creationTimeStamp.time);
+    out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->creationTimeStamp.sequence_num);
+    out = v7_fast_put_primary_suffix(out, v);
+
+    if (bplib_mpool_stream_write(&enc->mps, buffer, out - buffer) < (size_t)(out - buffer))
+    {
+        enc->error = true;
+    }
+    else if (v->crctype != bp_crctype_none)
+    {
+        v7_fast_write_crc(enc, v7_fast_crc_size(v->crctype));
+    }
+
+    return true;
+}
+
+/*
+ * Decodes an IPN-scheme primary block.  Returns the encoded size of the block, or 0 if the
+ * block cannot be handled here.
+ */
+static size_t v7_fast_decode_primary_block(const uint8_t *base, size_t size, bp_primary_block_t *v)
+{
+    const uint8_t *in;
+    const uint8_t *end;
+    uint64_t       flags;
+    int            crctype;
+    int            crc_len;
+    size_t         num_fields;
+
+    in  = base;
+    end = base + size;
+
+    /* definite length array, starting with version 7 */
+    if (size < 2 || (in[0] & 0xE0) != V7_FAST_CBOR_MAJOR_ARRAY || (in[0] & 0x1F) < 8 || (in[0] & 0x1F) > 11 ||
+        in[1] != 7)
+    {
+        return 0;
+    }
+
+    num_fields = in[0] & 0x1F;
+    in += 2;
+
+    in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &flags);
+    if (in != NULL)
+    {
+        in = v7_fast_get_small_int(in, end, &crctype);
+    }
+    if (in == NULL)
+    {
+        return 0;
+    }
+
+    crc_len = v7_fast_crc_size(crctype);
+    if (crc_len < 0)
+    {
+        return 0;
+    }
+
+    v->version = 7;
+    v->crctype = crctype;
+    v7_integer_to_bitmap(flags, (uint8_t *)&v->controlFlags, V7_BUNDLE_CONTROL_FLAGS_BITMAP_TABLE);
+
+    if (num_fields != (8 + (v->controlFlags.isFragment ? 2 : 0) + (crc_len != 0 ? 1 : 0)))
+    {
+        return 0;
+    }
+
+    in = v7_fast_get_ipn_eid(in, end, &v->destinationEID);
+    if (in != NULL)
+    {
+        in = v7_fast_get_ipn_eid(in, end, &v->sourceEID);
+    }
+    if (in != NULL)
+    {
+        in = v7_fast_get_ipn_eid(in, end, &v->reportEID);
+    }
+    if (in == NULL || in >= end || *in != (V7_FAST_CBOR_MAJOR_ARRAY | 2))
+    {
+        return 0;
+    }
+
+    in = v7_fast_get_head(in + 1, end, V7_FAST_CBOR_MAJOR_UINT, &v->creationTimeStamp.time);
+    if (in != NULL)
+    {
+        in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &v->creationTimeStamp.sequence_num);
+    }
+    if (in != NULL)
+    {
+        in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &v->lifetime);
+    }
+
+    v->fragmentOffset = 0;
+    v->totalADUlength = 0;
+    if (in != NULL && v->controlFlags.isFragment)
+    {
+        in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &v->fragmentOffset);
+        if (in != NULL)
+        {
+            in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &v->totalADUlength);
+        }
+    }
+
+    if (in != NULL && crc_len != 0)
+    {
+        in = v7_fast_get_crc(in, end, crc_len, &v->crcval);
+    }
+
+    if (in == NULL)
+    {
+        return 0;
+    }
+
+    return (in - base);
+}
+
+/*
+ * Encodes the content of the extension block types handled by the fast path.  Returns the
+ * size of the content, or 0 if the block type is not handled here.
+ */
+static size_t v7_fast_encode_canonical_content(uint8_t *buffer, const bp_canonical_block_buffer_t *v)
+{
+    uint8_t *out;
+
+    out = buffer;
+    switch (v->canonical_block.blockType)
+    {
+        case bp_blocktype_custodyTrackingBlock:
+            out = v7_fast_put_ipn_eid(out, &v->data.custody_tracking_block.current_custodian);
+            break;
+        case bp_blocktype_payloadCompressionBlock:
+            *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+            out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->data.payload_compression_block.algorithm);
+            out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT,
+                                      v->data.payload_compression_block.uncompressed_length);
+            break;
+        default:
+            out = NULL;
+            break;
+    }
+
+    if (out == NULL)
+    {
+        return 0;
+    }
+
+    return (out - buffer);
+}
+
+/*
+ * Encodes the content of the extension blocks that a forwarding node updates: previous node, bundle
+ * age and hop count.  The integers are always written at their full 8-octet width, so the content
+ * size never changes and v7_block_update_canonical() can overwrite it in place.  This is used
+ * regardless of whether the fast path is enabled.  Returns the size of the content, or 0 if the
+ * block type is not one of these (or the EID is not IPN scheme).
+ */
+static size_t v7_encode_mutable_canonical_content(uint8_t *buffer, const bp_canonical_block_buffer_t *v)
+{
+    const bp_endpointid_buffer_t *eid;
+    uint8_t                      *out;
+
+    out = buffer;
+    switch (v->canonical_block.blockType)
+    {
+        case bp_blocktype_previousNode:
+            eid = &v->data.previous_node_block.nodeId;
+            if (eid->scheme != bp_endpointid_scheme_ipn)
+            {
+                return 0;
+            }
+            *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+            *out++ = bp_endpointid_scheme_ipn;
+            *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+            out    = v7_fast_put_head_fixed(out, V7_FAST_CBOR_MAJOR_UINT, eid->ssp.ipn.node_number);
+            out    = v7_fast_put_head_fixed(out, V7_FAST_CBOR_MAJOR_UINT, eid->ssp.ipn.service_number);
+            break;
+        case bp_blocktype_bundleAge:
+            out = v7_fast_put_head_fixed(out, V7_FAST_CBOR_MAJOR_UINT, v->data.age_block.age);
+            break;
+        case bp_blocktype_hopCount:
+            *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+            out    = v7_fast_put_head_fixed(out, V7_FAST_CBOR_MAJOR_UINT, v->data.hop_count_block.hopLimit);
+            out    = v7_fast_put_head_fixed(out, V7_FAST_CBOR_MAJOR_UINT, v->data.hop_count_block.hopCount);
+            break;
+        default:
+            break;
+    }
+
+    return (out - buffer);
+}
+
+/*
+ * Decodes the content of the extension block types handled by the fast path, or skips it for the
+ * block types where the content is not interpreted here at all (e.g. the payload).  Returns false if
+ * the block type is not handled here, or the content is not in the expected shape.
+ */
+static bool v7_fast_decode_canonical_content(const uint8_t *in, size_t size, bp_canonical_block_buffer_t *v)
+{
+    const uint8_t *end;
+
+    end = in + size;
+    switch (v->canonical_block.blockType)
+    {
+        case bp_blocktype_previousNode:
+            in = v7_fast_get_ipn_eid(in, end, &v->data.previous_node_block.nodeId);
+            break;
+        case bp_blocktype_bundleAge:
+            in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &v->data.age_block.age);
+            break;
+        case bp_blocktype_hopCount:
+            if (in < end && *in == (V7_FAST_CBOR_MAJOR_ARRAY | 2))
+            {
+                in = v7_fast_get_head(in + 1, end, V7_FAST_CBOR_MAJOR_UINT, &v->data.hop_count_block.hopLimit);
+                if (in != NULL)
+                {
+                    in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &v->data.hop_count_block.hopCount);
+                }
+            }
+            else
+            {
+                in = NULL;
+            }
+            break;
+        case bp_blocktype_custodyTrackingBlock:
+            in = v7_fast_get_ipn_eid(in, end, &v->data.custody_tracking_block.current_custodian);
+            break;
+        case bp_blocktype_payloadCompressionBlock:
+            if (in < end && *in == (V7_FAST_CBOR_MAJOR_ARRAY | 2))
+            {
+                in = v7_fast_get_head(in + 1, end, V7_FAST_CBOR_MAJOR_UINT,
+                                      &v->data.payload_compression_block.algorithm);
+                if (in != NULL)
+                {
+                    in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT,
+                                          &v->data.payload_compression_block.uncompressed_length);
+                }
+            }
+            else
+            {
+                in = NULL;
+            }
+            break;
+        case bp_blocktype_adminRecordPayloadBlock:
+            /* of the admin records, only an aggregate is handled here, and the bundles in it are not decoded */
+            if ((end - in) >= 2 && in[0] == (V7_FAST_CBOR_MAJOR_ARRAY | 2) && in[1] == bp_adminrectype_bundleAggregate)
+            {
+                v->canonical_block.blockType = bp_blocktype_bundleAggregatePayloadBlock;
+                in                           = end;
+            }
+            else
+            {
+                in = NULL;
+            }
+            break;
+        case bp_blocktype_payloadBlock:
+        case bp_blocktype_bundleAuthenicationBlock:
+        case bp_blocktype_payloadIntegrityBlock:
+        case bp_blocktype_payloadConfidentialityBlock:
+        case bp_blocktype_previousHopInsertionBlock:
+        case bp_blocktype_metadataExtensionBlock:
+        case bp_blocktype_extensionSecurityBlock:
+            /* content is not interpreted by the codec */
+            in = end;
+            break;
+        default:
+            in = NULL;
+            break;
+    }
+
+    /* the content must be consumed exactly */
+    return (in == end);
+}
+
+/*
+ * Writes the header of a canonical block, up to and including the head of the content byte string, to
+ * the buffer, which must have room for V7_FAST_CANONICAL_MAX_HEADER_SIZE octets.  Returns the position
+ * after it, or NULL if the block cannot be handled here.  The size of the CRC that needs to follow the
+ * content is output.
+ */
+static uint8_t *v7_fast_put_canonical_header(uint8_t *out, const bp_canonical_bundle_block_t *v,
+                                             size_t content_length, int *crc_len_out)
+{
+    int            crc_len;
+    bp_blocktype_t encode_blocktype;
+
+    crc_len = v7_fast_crc_size(v->crctype);
+    if (crc_len < 0)
+    {
+        return NULL;
+    }
+
+    /* same mapping of the special payload types as v7_encode_bp_canonical_bundle_block() */
+    encode_blocktype = v->blockType;
+    if (encode_blocktype >= bp_blocktype_SPECIAL_PAYLOADS_START && encode_blocktype < bp_blocktype_SPECIAL_PAYLOADS_MAX)
+    {
+        encode_blocktype = bp_blocktype_payloadBlock;
+    }
+
+    *out++ = V7_FAST_CBOR_MAJOR_ARRAY | (crc_len != 0 ? 6 : 5);
+    out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, encode_blocktype);
+    out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->blockNum);
+    out    = v7_fast_put_head(
+        out, V7_FAST_CBOR_MAJOR_UINT,
+        v7_bitmap_to_integer((const uint8_t *)&v->processingControlFlags, V7_BLOCK_PROCESSING_FLAGS_BITMAP_TABLE));
+    out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, v->crctype);
+    out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_BYTESTRING, content_length);
+
+    *crc_len_out = crc_len;
+    return out;
+}
+
+/*
+ * Encodes the header of a canonical block, up to and including the head of the content byte string,
+ * into the stream.  Returns false if the block cannot be handled here, in which case nothing has been
+ * written.  Otherwise any failure is indicated via the error flag in the state, and the size of the
+ * CRC that needs to follow the content is output.
+ */
+static bool v7_fast_encode_canonical_header(v7_encode_state_t *enc, const bp_canonical_bundle_block_t *v,
+                                            size_t content_length, int *crc_len_out)
+{
+    uint8_t  header[V7_FAST_CANONICAL_MAX_HEADER_SIZE];
+    uint8_t *out;
+
+    out = v7_fast_put_canonical_header(header, v, content_length, crc_len_out);
+    if (out == NULL)
+    {
+        return false;
+    }
+
+    if (bplib_mpool_stream_write(&enc->mps, header, out - header) < (size_t)(out - header))
+    {
+        enc->error = true;
+    }
+
+    return true;
+}
+
+/*
+ * Encodes a canonical block with the given content into the stream.  The stream must have been
+ * started with the crctype of the block.  The content is copied straight into the stream, so the
+ * CRC is computed in the same pass.  Returns false if the block cannot be handled here, in which
+ * case nothing has been written.  Otherwise any failure is indicated via the error flag in the state.
+ */
+static bool v7_fast_encode_canonical_block(v7_encode_state_t *enc, const bp_canonical_bundle_block_t *v,
+                                           const void *content_ptr, size_t content_length,
+                                           size_t *content_encoded_offset)
+{
+    int crc_len;
+
+    if (!v7_fast_encode_canonical_header(enc, v, content_length, &crc_len))
+    {
+        return false;
+    }
+
+    if (enc->error)
+    {
+        return true;
+    }
+
+    *content_encoded_offset = bplib_mpool_stream_tell(&enc->mps);
+    if (bplib_mpool_stream_write(&enc->mps, content_ptr, content_length) < content_length)
+    {
+        enc->error = true;
+    }
+    else if (crc_len != 0)
+    {
+        v7_fast_write_crc(enc, crc_len);
+    }
+
+    return true;
+}
+
+/*
+ * Decodes the frame of a canonical block (everything except the content).  Returns the encoded
+ * size of the block, or 0 if the block cannot be handled here.
+ */
+static size_t v7_fast_decode_canonical_block(const uint8_t *base, size_t size, bp_canonical_bundle_block_t *v,
+                                             size_t *content_offset, size_t *content_length)
+{
+    const uint8_t *in;
+    const uint8_t *end;
+    uint64_t       flags;
+    uint64_t       length;
+    int            blocktype;
+    int            blocknum;
+    int            crctype;
+    int            crc_len;
+
+    in  = base;
+    end = base + size;
+
+    if (size < 1 || (in[0] != (V7_FAST_CBOR_MAJOR_ARRAY | 5) && in[0] != (V7_FAST_CBOR_MAJOR_ARRAY | 6)))
+    {
+        return 0;
+    }
+
+    in = v7_fast_get_small_int(in + 1, end, &blocktype);
+    if (in != NULL)
+    {
+        in = v7_fast_get_small_int(in, end, &blocknum);
+    }
+    if (in != NULL)
+    {
+        in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_UINT, &flags);
+    }
+    if (in != NULL)
+    {
+        in = v7_fast_get_small_int(in, end, &crctype);
+    }
+    if (in == NULL)
+    {
+        return 0;
+    }
+
+    crc_len = v7_fast_crc_size(crctype);
+    if (crc_len < 0 || blocknum > UINT8_MAX || base[0] != (V7_FAST_CBOR_MAJOR_ARRAY | (crc_len != 0 ? 6 : 5)))
+    {
+        return 0;
+    }
+
+    in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_BYTESTRING, &length);
+    if (in == NULL || length > (uint64_t)(end - in))
+    {
+        return 0;
+    }
+
+    v->blockType = blocktype;
+    v->blockNum  = blocknum;
+    v->crctype   = crctype;
+    v7_integer_to_bitmap(flags, (uint8_t *)&v->processingControlFlags, V7_BLOCK_PROCESSING_FLAGS_BITMAP_TABLE);
+
+    *content_offset = in - base;
+    *content_length = length;
+    in += length;
+
+    if (crc_len != 0)
+    {
+        in = v7_fast_get_crc(in, end, crc_len, &v->crcval);
+        if (in == NULL)
+        {
+            return 0;
+        }
+    }
+
+    return (in - base);
+}
+
+static CborError v7_encoder_write(void *arg, const void *ptr, size_t sz, CborEncoderAppendType at)
+{
+    v7_encode_state_t *v7_state = arg;
+    if (bplib_mpool_stream_write(&v7_state->mps, ptr, sz) < sz)
+    {
+        return CborErrorOutOfMemory;
+    }
+
+    return CborNoError;
+}
+
+size_t v7_save_and_verify_block(bplib_mpool_block_t *head, const uint8_t *block_base, size_t block_size,
+                                bp_crctype_t crc_type, bp_crcval_t crc_check, bool defer_crc)
+{
+    static const uint8_t    ZERO_BYTES[4] = {0};
+    size_t                  data_len;
+    size_t                  crc_len;
+    bplib_crc_parameters_t *crc_params;
+    bp_crcval_t             crc_val;
+    bplib_mpool_stream_t    mps;
+    size_t                  result;
+
+    result = 0;
+
+    if (defer_crc)
+    {
+        /* just a straight copy - the stream will not compute any CRC */
+        bplib_mpool_start_stream_init(&mps, bplib_mpool_get_parent_pool_from_link(head), bplib_mpool_stream_dir_write,
+                                      bp_crctype_none);
+        if (bplib_mpool_stream_write(&mps, block_base, block_size) == block_size)
+        {
+            result = bplib_mpool_stream_tell(&mps);
+            bplib_mpool_stream_attach(&mps, head);
+        }
+
+        bplib_mpool_stream_close(&mps);
+
+        return result;
+    }
+
+    bplib_mpool_start_stream_init(&mps, bplib_mpool_get_parent_pool_from_link(head), bplib_mpool_stream_dir_write,
+                                  crc_type);
+    crc_params = bplib_mpool_stream_get_crc_params(&mps);
+    crc_len    = bplib_crc_get_width(crc_params) / 8;
+    if (crc_len < block_size && crc_len <= sizeof(ZERO_BYTES))
+    {
+        data_len = block_size - crc_len;
+        /* first copy only the data part */
+        if (bplib_mpool_stream_write(&mps, block_base, data_len) == data_len)
+        {
+            /* snapshot the CRC intermediate value now */
+            crc_val = bplib_mpool_stream_get_intermediate_crc(&mps);
+
+            /* now copy the original (still unverified) CRC to the buffer */
+            if (bplib_mpool_stream_write(&mps, block_base + data_len, crc_len) == crc_len)
+            {
+                /* now verify the CRC - need to pump in zero bytes for CRC width */
+                crc_val = bplib_crc_update(crc_params, crc_val, ZERO_BYTES, crc_len);
+                crc_val = bplib_crc_finalize(crc_params, crc_val);
+
+                if (crc_val == crc_check)
+                {
+                    result = bplib_mpool_stream_tell(&mps);
+                    bplib_mpool_stream_attach(&mps, head);
+                }
+            }
+        }
+    }
+
+    bplib_mpool_stream_close(&mps);
+
+    return result;
+}
+
+size_t v7_stream_copy_saved_data(bplib_mpool_stream_t *mps, bplib_mpool_block_t *head, size_t data_offset,
+                                 size_t data_size, bool digest)
+{
+    bplib_mpool_block_t *blk;
+    const uint8_t       *in_p;
+    size_t               remain_sz;
+    size_t               chunk_sz;
+    size_t               written;
+
+    remain_sz = data_size;
+    blk       = head;
+    while (remain_sz > 0)
+    {
+        blk  = bplib_mpool_get_next_block(blk);
+        in_p = bplib_mpool_bblock_cbor_cast(blk);
+        if (in_p == NULL)
+        {
+            /* ran out of data */
+            break;
+        }
+
+        chunk_sz = bplib_mpool_get_user_content_size(blk);
+        if (data_offset >= chunk_sz)
+        {
+            data_offset -= chunk_sz;
+            continue;
+        }
+
+        in_p += data_offset;
+        chunk_sz -= data_offset;
+        data_offset = 0;
+        if (chunk_sz > remain_sz)
+        {
+            chunk_sz = remain_sz;
+        }
+
+        if (digest)
+        {
+            written = bplib_mpool_stream_write(mps, in_p, chunk_sz);
+        }
+        else
+        {
+            written = bplib_mpool_stream_write_undigested(mps, in_p, chunk_sz);
+        }
+
+        remain_sz -= written;
+        if (written < chunk_sz)
+        {
+            break;
+        }
+    }
+
+    return data_size - remain_sz;
+}
+
+bplib_crc_parameters_t *v7_get_crc_params(bp_crctype_t crc_type)
+{
+    switch (crc_type)
+    {
+        case bp_crctype_CRC16:
+            return &BPLIB_CRC16_X25;
+        case bp_crctype_CRC32C:
+            return &BPLIB_CRC32_CASTAGNOLI;
+        default:
+            break;
+    }
+
+    return NULL;
+}
+
+bool v7_compute_saved_block_crc(bplib_mpool_block_t *head, size_t block_size, bp_crctype_t crc_type,
+                                size_t *crc_len_out, bp_crcval_t *crc_out)
+{
+    static const uint8_t    ZERO_BYTES[4] = {0};
+    size_t                  remain_sz;
+    size_t                  chunk_sz;
+    size_t                  crc_len;
+    bplib_crc_parameters_t *crc_params;
+    bp_crcval_t             crc_val;
+    bplib_mpool_block_t    *blk;
+    const uint8_t          *in_p;
+
+    crc_params = v7_get_crc_params(crc_type);
+    if (crc_params == NULL)
+    {
+        /* no CRC on this block */
+        *crc_len_out = 0;
+        *crc_out     = 0;
+        return true;
+    }
+
+    crc_len = bplib_crc_get_width(crc_params) / 8;
+    if (crc_len >= block_size || crc_len > sizeof(ZERO_BYTES))
+    {
+        return false;
+    }
+
+    /* only the data part goes into the CRC, the CRC value itself is replaced by zeros */
+    remain_sz = block_size - crc_len;
+    crc_val   = bplib_crc_initial_value(crc_params);
+    blk       = head;
+    while (remain_sz > 0)
+    {
+        blk  = bplib_mpool_get_next_block(blk);
+        in_p = bplib_mpool_bblock_cbor_cast(blk);
+        if (in_p == NULL)
+        {
+            /* ran out of data */
+            break;
+        }
+
+        chunk_sz = bplib_mpool_get_user_content_size(blk);
+        if (chunk_sz > remain_sz)
+        {
+            chunk_sz = remain_sz;
+        }
+
+        crc_val = bplib_crc_update(crc_params, crc_val, in_p, chunk_sz);
+        remain_sz -= chunk_sz;
+    }
+
+    if (remain_sz != 0)
+    {
+        return false;
+    }
+
+    crc_val = bplib_crc_update(crc_params, crc_val, ZERO_BYTES, crc_len);
+
+    *crc_len_out = crc_len;
+    *crc_out     = bplib_crc_finalize(crc_params, crc_val);
+    return true;
+}
+
+bool v7_verify_saved_block(bplib_mpool_block_t *head, size_t block_size, bp_crctype_t crc_type,
+                           bp_crcval_t crc_check)
+{
+    size_t      crc_len;
+    bp_crcval_t crc_val;
+
+    if (!v7_compute_saved_block_crc(head, block_size, crc_type, &crc_len, &crc_val))
+    {
+        return false;
+    }
+
+    /* nothing to check if the block has no CRC */
+    return (crc_len == 0 || crc_val == crc_check);
+}
+
+bool v7_overwrite_saved_block(bplib_mpool_block_t *head, size_t offset, const void *data_ptr, size_t data_size)
+{
+    size_t               chunk_sz;
+    bplib_mpool_block_t *blk;
+    uint8_t             *out_p;
+    const uint8_t       *in_p;
+
+    in_p = data_ptr;
+    blk  = head;
+    while (data_size > 0)
+    {
+        blk   = bplib_mpool_get_next_block(blk);
+        out_p = bplib_mpool_bblock_cbor_cast(blk);
+        if (out_p == NULL)
+        {
+            /* ran out of data */
+            break;
+        }
+
+        chunk_sz = bplib_mpool_get_user_content_size(blk);
+        if (offset >= chunk_sz)
+        {
+            /* not there yet */
+            offset -= chunk_sz;
+            continue;
+        }
+
+        chunk_sz -= offset;
+        if (chunk_sz > data_size)
+        {
+            chunk_sz = data_size;
+        }
+
+        memcpy(&out_p[offset], in_p, chunk_sz);
+        in_p += chunk_sz;
+        data_size -= chunk_sz;
+        offset = 0;
+    }
+
+    return (data_size == 0);
+}
+
+int v7_block_decode_pri(bplib_mpool_bblock_primary_t *cpb, const void *data_ptr, size_t data_size, bool defer_crc)
+{
+    v7_decode_state_t   v7_state;
+    CborValue           origin;
+    bp_primary_block_t *pri;
+    size_t              block_size;
+    CborParser          parser;
+
+    /* If there is any existing encoded data, return it to the pool */
+    bplib_mpool_bblock_primary_drop_encode(cpb);
+
+    pri = bplib_mpool_bblock_primary_get_logical(cpb);
+    memset(&v7_state, 0, sizeof(v7_state));
+
+    v7_state.base = data_ptr;
+    block_size    = 0;
+    if (V7_CODEC_FAST_PATH_ENABLED)
+    {
+        block_size = v7_fast_decode_primary_block(v7_state.base, data_size, pri);
+    }
+
+    if (block_size == 0)
+    {
+        /* not a common shape, use the generic decoder */
+        if (cbor_parser_init(data_ptr, data_size, 0, &parser, &origin) != CborNoError)
+        {
+            v7_state.error = true;
+        }
+        else
+        {
+            v7_state.cbor = &origin;
+
+            v7_decode_bp_primary_block(&v7_state, pri);
+        }
+
+        if (!v7_state.error)
+        {
+            block_size = cbor_value_get_next_byte(&origin) - v7_state.base;
+        }
+    }
+
+    if (!v7_state.error)
+    {
+        cpb->block_encode_size_cache =
+            v7_save_and_verify_block(bplib_mpool_bblock_primary_get_encoded_chunks(cpb), v7_state.base, block_size,
+                                     pri->crctype, pri->crcval, defer_crc);
+
+        if (cpb->block_encode_size_cache != block_size)
+        {
+            /* something went wrong in validation */
+            v7_state.error = true;
+        }
+    }
+
+    if (v7_state.error)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int v7_block_decode_canonical(bplib_mpool_bblock_canonical_t *ccb, const void *data_ptr, size_t data_size,
+                              bp_blocktype_t payload_block_hint, bool defer_crc)
+{
+    v7_decode_state_t            v7_state;
+    CborValue                    origin;
+    bp_canonical_block_buffer_t *logical;
+    size_t                       block_size;
+    CborParser                   parser;
+    size_t                       content_offset;
+    size_t                       content_size;
+
+    block_size     = 0;
+    content_offset = 0;
+    content_size   = 0;
+
+    /* If there is any existing encoded data, return it to the pool */
+    bplib_mpool_bblock_canonical_drop_encode(ccb);
+
+    logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+    memset(&v7_state, 0, sizeof(v7_state));
+
+    v7_state.base = data_ptr;
+    if (V7_CODEC_FAST_PATH_ENABLED)
+    {
+        block_size = v7_fast_decode_canonical_block(v7_state.base, data_size, &logical->canonical_block,
+                                                    &content_offset, &content_size);
+    }
+
+    if (block_size == 0)
+    {
+        /* not a common shape, use the generic decoder */
+        if (cbor_parser_init(data_ptr, data_size, 0, &parser, &origin) != CborNoError)
+        {
+            v7_state.error = true;
+        }
+        else
+        {
+            v7_state.cbor = &origin;
+
+            v7_decode_bp_canonical_block_buffer(&v7_state, logical, &content_offset, &content_size);
+        }
+
+        if (!v7_state.error)
+        {
+            /* This reflects the size of the entire CBOR blob that the caller passed in */
+            block_size = cbor_value_get_next_byte(&origin) - v7_state.base;
+        }
+    }
+
+    if (!v7_state.error)
+    {
+        /* Copy it to the pool buffers, and check the CRC in the process */
+        ccb->block_encode_size_cache =
+            v7_save_and_verify_block(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb), v7_state.base, block_size,
+                                     logical->canonical_block.crctype, logical->canonical_block.crcval, defer_crc);
+
+        if (ccb->block_encode_size_cache != block_size)
+        {
+            v7_state.error = true;
+        }
+        else
+        {
+            bplib_mpool_bblock_canonical_set_content_position(ccb, content_offset, content_size);
+        }
+    }
+
+    if (!v7_state.error)
+    {
+        /*
+         * multiple different block types may get labeled as the "payload block"
+         * because RFC9171 insists that something must be labeled as such.
+         * the purpose of the "payload_block_hint" is to identify how the payload
+         * should really be interpreted based on other blocks/fields in the bundle
+         */
+        if (payload_block_hint != bp_blocktype_undefined &&
+            logical->canonical_block.blockType == bp_blocktype_payloadBlock)
+        {
+            logical->canonical_block.blockType = payload_block_hint;
+        }
+
+        /*
+         * Second stage decode - for recognized non-payload extension blocks
+         */
+        if (V7_CODEC_FAST_PATH_ENABLED &&
+            v7_fast_decode_canonical_content(v7_state.base + content_offset, content_size, logical))
+        {
+            /* nothing more to do */
+        }
+        else if (cbor_parser_init(v7_state.base + content_offset, content_size, 0, &parser, &origin) != CborNoError)
+        {
+            v7_state.error = true;
+        }
+        else
+        {
+            v7_state.base += content_offset;
+            v7_state.cbor = &origin;
+
+            switch (logical->canonical_block.blockType)
+            {
+                case bp_blocktype_payloadBlock:
+                    break;
+                case bp_blocktype_bundleAuthenicationBlock:
+                    break;
+                case bp_blocktype_payloadIntegrityBlock:
+                    break;
+                case bp_blocktype_payloadConfidentialityBlock:
+                    break;
+                case bp_blocktype_previousHopInsertionBlock:
+                    break;
+                case bp_blocktype_previousNode:
+                    v7_decode_bp_previous_node_block(&v7_state, &logical->data.previous_node_block);
+                    break;
+                case bp_blocktype_bundleAge:
+                    v7_decode_bp_bundle_age_block(&v7_state, &logical->data.age_block);
+                    break;
+                case bp_blocktype_metadataExtensionBlock:
+                    break;
+                case bp_blocktype_extensionSecurityBlock:
+                    break;
+                case bp_blocktype_hopCount:
+                    v7_decode_bp_hop_count_block(&v7_state, &logical->data.hop_count_block);
+                    break;
+                case bp_blocktype_custodyTrackingBlock:
+                    v7_decode_bp_custody_tracking_block(&v7_state, &logical->data.custody_tracking_block);
+                    break;
+                case bp_blocktype_payloadCompressionBlock:
+                    v7_decode_bp_payload_compression_block(&v7_state, &logical->data.payload_compression_block);
+                    break;
+                case bp_blocktype_adminRecordPayloadBlock:
+                case bp_blocktype_custodyAcceptPayloadBlock:
+                    v7_decode_bp_admin_record_payload(&v7_state, logical);
+                    break;
+                default:
+                    /* do nothing */
+                    break;
+            }
+        }
+    }
+
+    if (v7_state.error)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int v7_block_encode_pri(bplib_mpool_bblock_primary_t *cpb)
+{
+    v7_encode_state_t         v7_state;
+    CborEncoder               origin;
+    const bp_primary_block_t *pri;
+
+    /* If there is any existing encoded data, return it to the pool */
+    bplib_mpool_bblock_primary_drop_encode(cpb);
+
+    pri = bplib_mpool_bblock_primary_get_logical(cpb);
+    memset(&v7_state, 0, sizeof(v7_state));
+
+    bplib_mpool_start_stream_init(&v7_state.mps, bplib_mpool_get_parent_pool_from_link(&cpb->chunk_list),
+                                  bplib_mpool_stream_dir_write, pri->crctype);
+
+    if (!V7_CODEC_FAST_PATH_ENABLED || !v7_fast_encode_primary_block(&v7_state, pri))
+    {
+        cbor_encoder_init_writer(&origin, v7_encoder_write, &v7_state);
+        v7_state.cbor = &origin;
+
+        v7_encode_bp_primary_block(&v7_state, pri);
+    }
+
+    if (!v7_state.error)
+    {
+        cpb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
+        bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_primary_get_encoded_chunks(cpb));
+    }
+
+    bplib_mpool_stream_close(&v7_state.mps);
+
+    if (v7_state.error)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int v7_block_template_init_pri(v7_primary_block_template_t *tmpl, const bp_primary_block_t *pri)
+{
+    uint8_t  buffer[V7_FAST_PRI_MAX_ENCODE_SIZE];
+    uint8_t *out;
+    size_t   prefix_size;
+    size_t   suffix_size;
+
+    memset(tmpl, 0, sizeof(*tmpl));
+
+    /* Only the common shapes can be templated, i.e. those that the specialized encoder handles */
+    out = v7_fast_put_primary_prefix(buffer, pri);
+    if (out == NULL)
+    {
+        return -1;
+    }
+
+    prefix_size = out - buffer;
+    out         = v7_fast_put_primary_suffix(out, pri);
+    suffix_size = (out - buffer) - prefix_size;
+
+    if ((prefix_size + suffix_size) > sizeof(tmpl->octets))
+    {
+        return -1;
+    }
+
+    memcpy(tmpl->octets, buffer, prefix_size + suffix_size);
+    tmpl->crctype     = pri->crctype;
+    tmpl->prefix_size = prefix_size;
+    tmpl->suffix_size = suffix_size;
+
+    return 0;
+}
+
+int v7_block_encode_pri_from_template(bplib_mpool_bblock_primary_t *cpb, const v7_primary_block_template_t *tmpl)
+{
+    v7_encode_state_t         v7_state;
+    const bp_primary_block_t *pri;
+    uint8_t                   buffer[V7_FAST_PRI_MAX_ENCODE_SIZE];
+    uint8_t                  *out;
+
+    /* If there is any existing encoded data, return it to the pool */
+    bplib_mpool_bblock_primary_drop_encode(cpb);
+
+    pri = bplib_mpool_bblock_primary_get_logical(cpb);
+    if (tmpl->prefix_size == 0 || pri->crctype != tmpl->crctype)
+    {
+        /* template was not initialized, or does not belong to this block */
+        return -1;
+    }
+
+    memset(&v7_state, 0, sizeof(v7_state));
+
+    /*
+     * Everything except the creation timestamp is copied from the template.  The timestamp
+     * values are encoded in between, so the result is identical to a full encode of the block.
+     */
+    memcpy(buffer, tmpl->octets, tmpl->prefix_size);
+    out = buffer + tmpl->prefix_size;
+    out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, pri->creationTimeStamp.time);
+    out = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, pri->creationTimeStamp.sequence_num);
+    memcpy(out, &tmpl->octets[tmpl->prefix_size], tmpl->suffix_size);
+    out += tmpl->suffix_size;
+
+    bplib_mpool_start_stream_init(&v7_state.mps, bplib_mpool_get_parent_pool_from_link(&cpb->chunk_list),
+                                  bplib_mpool_stream_dir_write, pri->crctype);
+
+    if (bplib_mpool_stream_write(&v7_state.mps, buffer, out - buffer) < (size_t)(out - buffer))
+    {
+        v7_state.error = true;
+    }
+    else if (pri->crctype != bp_crctype_none)
+    {
+        v7_fast_write_crc(&v7_state, v7_fast_crc_size(pri->crctype));
+    }
+
+    if (!v7_state.error)
+    {
+        cpb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
+        bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_primary_get_encoded_chunks(cpb));
+    }
+
+    bplib_mpool_stream_close(&v7_state.mps);
+
+    if (v7_state.error)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int v7_block_encode_pay(bplib_mpool_bblock_canonical_t *ccb, const void *data_ptr, size_t data_size)
+{
+    v7_encode_state_t                  v7_state;
+    CborEncoder                        origin;
+    const bp_canonical_block_buffer_t *pay;
+    size_t                             data_encoded_offset;
+    bplib_mpool_t                     *ppool;
+
+    /* If there is any existing encoded data, return it to the pool */
+    bplib_mpool_bblock_canonical_drop_encode(ccb);
+
+    ppool = bplib_mpool_get_parent_pool_from_link(&ccb->chunk_list);
+
+    pay = bplib_mpool_bblock_canonical_get_logical(ccb);
+    memset(&v7_state, 0, sizeof(v7_state));
+    bplib_mpool_start_stream_init(&v7_state.mps, ppool, bplib_mpool_stream_dir_write, pay->canonical_block.crctype);
+
+    if (!V7_CODEC_FAST_PATH_ENABLED ||
+        !v7_fast_encode_canonical_block(&v7_state, &pay->canonical_block, data_ptr, data_size, &data_encoded_offset))
+    {
+        cbor_encoder_init_writer(&origin, v7_encoder_write, &v7_state);
+        v7_state.cbor = &origin;
+
+        v7_encode_bp_canonical_block_buffer(&v7_state, pay, data_ptr, data_size, &data_encoded_offset);
+    }
+
+    if (!v7_state.error)
+    {
+        bplib_mpool_bblock_canonical_set_content_position(ccb, data_encoded_offset, data_size);
+        ccb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
+        bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_canonical_get_encoded_chunks(ccb));
+    }
+
+    bplib_mpool_stream_close(&v7_state.mps);
+
+    if (v7_state.error)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int v7_block_encode_canonical(bplib_mpool_bblock_canonical_t *ccb)
+{
+    v7_encode_state_t                  v7_state;
+    CborEncoder                        origin;
+    const bp_canonical_block_buffer_t *logical;
+    uint8_t                            scratch_area[256];
+    size_t                             scratch_size;
+    size_t                             content_encoded_offset;
+    bplib_mpool_t                     *ppool;
+
+    /* If there is any existing encoded data, return it to the pool */
+    bplib_mpool_bblock_canonical_drop_encode(ccb);
+
+    ppool = bplib_mpool_get_parent_pool_from_link(&ccb->chunk_list);
+
+    /*
+     * Encoding of a V7 extension block is a two-part affair, it must
+     * first encode the block-specific information into CBOR, then wrap
+     * those encoded octets as a CBOR byte string within the extension block.
+     * This effectively makes it CBOR-in-CBOR.
+     */
+    logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+
+    memset(&v7_state, 0, sizeof(v7_state));
+    bplib_mpool_start_stream_init(&v7_state.mps, ppool, bplib_mpool_stream_dir_write, logical->canonical_block.crctype);
+
+    scratch_size = v7_encode_mutable_canonical_content(scratch_area, logical);
+    if (scratch_size == 0 && V7_CODEC_FAST_PATH_ENABLED)
+    {
+        scratch_size = v7_fast_encode_canonical_content(scratch_area, logical);
+    }
+
+    if (scratch_size == 0)
+    {
+        /* not a common block type, use the generic encoder */
+        cbor_encoder_init(&origin, scratch_area, sizeof(scratch_area), 0);
+        v7_state.cbor = &origin;
+
+        v7_encode_bp_canonical_block_content(&v7_state, logical);
+
+        if (!v7_state.error)
+        {
+            scratch_size = cbor_encoder_get_buffer_size(&origin, scratch_area);
+        }
+    }
+
+    if (!v7_state.error && scratch_size > 0)
+    {
+        /*
+         * Do second-stage encode - take the scratch buffer and use it as the content of the extension block
+         */
+        bplib_mpool_start_stream_init(&v7_state.mps, ppool, bplib_mpool_stream_dir_write,
+                                      logical->canonical_block.crctype);
+
+        if (!V7_CODEC_FAST_PATH_ENABLED || !v7_fast_encode_canonical_block(&v7_state, &logical->canonical_block,
+                                                                           scratch_area, scratch_size,
+                                                                           &content_encoded_offset))
+        {
+            cbor_encoder_init_writer(&origin, v7_encoder_write, &v7_state);
+            v7_state.cbor = &origin;
+
+            v7_encode_bp_canonical_block_buffer(&v7_state, logical, scratch_area, scratch_size,
+                                                &content_encoded_offset);
+        }
+
+        if (!v7_state.error)
+        {
+            bplib_mpool_bblock_canonical_set_content_position(ccb, content_encoded_offset, scratch_size);
+            ccb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
+            bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_canonical_get_encoded_chunks(ccb));
+        }
+
+        bplib_mpool_stream_close(&v7_state.mps);
+    }
+
+    if (v7_state.error)
+    {
+        return -1;
+    }
+    return 0;
+}
+
+int v7_block_update_canonical(bplib_mpool_bblock_canonical_t *ccb)
+{
+    bp_canonical_block_buffer_t *logical;
+    uint8_t                      content[V7_FAST_CANONICAL_MAX_CONTENT_SIZE];
+    uint8_t                      crc_encode[sizeof(bp_crcval_t)];
+    size_t                       content_size;
+    size_t                       crc_len;
+    size_t                       i;
+    bp_crcval_t                  crc_val;
+    bplib_mpool_block_t         *head;
+
+    /*
+     * If the CRCs of a received bundle were not yet checked, that has to happen now - once
+     * the CRC is recomputed below, a corrupted block would otherwise appear to be good.
+     */
+    if (ccb->bundle_ref != NULL && v7_verify_deferred_crc(ccb->bundle_ref) != 0)
+    {
+        return -1;
+    }
+
+    logical      = bplib_mpool_bblock_canonical_get_logical(ccb);
+    content_size = v7_encode_mutable_canonical_content(content, logical);
+    head         = bplib_mpool_bblock_canonical_get_encoded_chunks(ccb);
+
+    /*
+     * The block can only be patched if it is currently encoded, and the existing content is the same
+     * size as the new content.  This is always true for blocks encoded here, but a block received from
+     * another implementation likely used the shortest integer encoding instead.  In that case (or for
+     * any other block type) it is re-encoded in full, which also gives it the fixed-width layout so the
+     * next update can be done in place.
+     */
+    if (content_size == 0 || ccb->block_encode_size_cache == 0 ||
+        content_size != bplib_mpool_bblock_canonical_get_content_length(ccb) ||
+        !v7_overwrite_saved_block(head, bplib_mpool_bblock_canonical_get_content_offset(ccb), content,
+                                  content_size))
+    {
+        return v7_block_encode_canonical(ccb);
+    }
+
+    /* The content changed, so only the CRC of this block needs to be recomputed */
+    if (!v7_compute_saved_block_crc(head, ccb->block_encode_size_cache, logical->canonical_block.crctype, &crc_len,
+                                    &crc_val))
+    {
+        return v7_block_encode_canonical(ccb);
+    }
+
+    if (crc_len > 0)
+    {
+        logical->canonical_block.crcval = crc_val;
+        for (i = crc_len; i > 0; --i)
+        {
+            crc_encode[i - 1] = crc_val & 0xFF;
+            crc_val >>= 8;
+        }
+
+        if (!v7_overwrite_saved_block(head, ccb->block_encode_size_cache - crc_len, crc_encode, crc_len))
+        {
+            return v7_block_encode_canonical(ccb);
+        }
+    }
+
+    return 0;
+}
+
+size_t v7_sum_preencoded_size(bplib_mpool_block_t *list)
+{
+    bplib_mpool_block_t *blk;
+    size_t               size_sum;
+
+    size_sum = 0;
+    blk      = list;
+    while (true)
+    {
+        blk = bplib_mpool_get_next_block(blk);
+        if (bplib_mpool_is_list_head(blk))
+        {
+            break;
+        }
+        size_sum += bplib_mpool_get_user_content_size(blk);
+    }
+
+    return size_sum;
+}
+
+size_t v7_compute_full_bundle_size(bplib_mpool_bblock_primary_t *cpb)
+{
+    bplib_mpool_block_t            *blk;
+    bplib_mpool_bblock_canonical_t *ccb;
+    int                             last_encode;
+    size_t                          sum_result;
+
+    if (cpb->bundle_encode_size_cache == 0)
+    {
+        /*
+         * For any block which is not already encoded, this needs to encode it now.
+         * For most blocks all the information is in the logical data, so it is possible
+         * to do this on the fly.
+         *
+         * However the payload block MUST be pre-encoded because the information is
+         * not available in the logical data.  The payload content only exists in encoded
+         * form.
          */
-        if (cbor_parser_init(v7_state.base + content_offset, content_size, 0, &parser, &origin) != CborNoError)
+        if (cpb->block_encode_size_cache == 0)
         {
-            v7_state.error = true;
+            last_encode = v7_block_encode_pri(cpb);
         }
         else
         {
-            v7_state.base += content_offset;
-            v7_state.cbor = &origin;
-
-            /*
-             * multiple different block types may get labeled as the "payload block"
-             * because RFC9171 insists that something must be labeled as such.
-             * the purpose of the "payload_block_hint" is to identify how the payload
-             * should really be interpreted based on other blocks/fields in the bundle
-             */
-            if (payload_block_hint != bp_blocktype_undefined &&
-                logical->canonical_block.blockType == bp_blocktype_payloadBlock)
+            last_encode = 0;
+        }
+        sum_result = cpb->block_encode_size_cache;
+        blk        = bplib_mpool_bblock_primary_get_canonical_list(cpb);
+        while (last_encode == 0)
+        {
+            blk = bplib_mpool_get_next_block(blk);
+            ccb = bplib_mpool_bblock_canonical_cast(blk);
+            if (ccb == NULL)
             {
-                logical->canonical_block.blockType = payload_block_hint;
+                /*
+                 * no more blocks... this is the normal stop condition.
+                 *
+                 * This adds 2 extra bytes here because the complete bundle is supposed to be wrapped
+                 * inside a CBOR indefinite-length array, which adds one octet at the beginning
+                 * and one octet at the end.
+                 */
+                cpb->bundle_encode_size_cache = 2 + sum_result;
+                break;
             }
 
-            switch (logical->canonical_block.blockType)
+            if (ccb->block_encode_size_cache == 0)
             {
-                case bp_blocktype_payloadBlock:
-                    break;
-                case bp_blocktype_bundleAuthenicationBlock:
-                    break;
-                case bp_blocktype_payloadIntegrityBlock:
-                    break;
-                case bp_blocktype_payloadConfidentialityBlock:
-                    break;
-                case bp_blocktype_previousHopInsertionBlock:
-                    break;
-                case bp_blocktype_previousNode:
-                    v7_decode_bp_previous_node_block(&v7_state, &logical->data.previous_node_block);
-                    break;
-                case bp_blocktype_bundleAge:
-                    v7_decode_bp_bundle_age_block(&v7_state, &logical->data.age_block);
-                    break;
-                case bp_blocktype_metadataExtensionBlock:
-                    break;
-                case bp_blocktype_extensionSecurityBlock:
-                    break;
-                case bp_blocktype_hopCount:
-                    v7_decode_bp_hop_count_block(&v7_state, &logical->data.hop_count_block);
-                    break;
-                case bp_blocktype_custodyTrackingBlock:
-                    v7_decode_bp_custody_tracking_block(&v7_state, &logical->data.custody_tracking_block);
-                    break;
-                case bp_blocktype_adminRecordPayloadBlock:
-                case bp_blocktype_custodyAcceptPayloadBlock:
-                    v7_decode_bp_admin_record_payload(&v7_state, logical);
-                    break;
-                default:
-                    /* do nothing */
-                    break;
+                last_encode = v7_block_encode_canonical(ccb);
             }
+
+            sum_result += ccb->block_encode_size_cache;
         }
     }
 
-    if (v7_state.error)
+    return cpb->bundle_encode_size_cache;
+}
+
+size_t v7_copy_full_bundle_out(bplib_mpool_bblock_primary_t *cpb, void *buffer, size_t buf_sz)
+{
+    size_t                          remain_sz;
+    size_t                          chunk_sz;
+    uint8_t                        *out_p;
+    bplib_mpool_block_t            *cblk;
+    bplib_mpool_bblock_canonical_t *ccb;
+
+    /*
+     * two bytes is just the overhead added by this routine.  It is definitely not enough
+     * for a real bundle, this just avoids buffer bounds violation in here.
+     */
+    if (buf_sz < 2)
     {
-        return -1;
+        return 0;
     }
-    return 0;
+
+    out_p  = buffer;
+    *out_p = 0x9F; /* Start CBOR indefinite-length array */
+    ++out_p;
+
+    remain_sz = buf_sz - 2;
+
+    chunk_sz =
+        bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_primary_get_encoded_chunks(cpb), out_p, remain_sz, 0, -1);
+    out_p += chunk_sz;
+    remain_sz -= chunk_sz;
+    cblk = bplib_mpool_bblock_primary_get_canonical_list(cpb);
+    while (remain_sz > 0)
+    {
+        cblk = bplib_mpool_get_next_block(cblk);
+        ccb  = bplib_mpool_bblock_canonical_cast(cblk);
+        if (ccb == NULL)
+        {
+            break;
+        }
+        chunk_sz = bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb), out_p,
+                                                  remain_sz, 0, -1);
+        out_p += chunk_sz;
+        remain_sz -= chunk_sz;
+    }
+
+    /* there should always be enough space for this, because it was accounted for at the beginning */
+    *out_p = 0xFF; /* End CBOR indefinite-length array (break code) */
+    ++out_p;
+
+    return (out_p - (uint8_t *)buffer);
 }
 
-int v7_block_encode_pri(bplib_mpool_bblock_primary_t *cpb)
-{
-    v7_encode_state_t         v7_state;
-    CborEncoder               origin;
-    const bp_primary_block_t *pri;
+size_t v7_copy_fragment_out(bplib_mpool_bblock_primary_t *cpb, size_t payload_offset, void *buffer, size_t buf_sz,
+                            size_t *next_offset)
+{
+    bp_primary_block_t                 frag_pri;
+    bplib_crc_parameters_t            *crc_params;
+    bplib_mpool_block_t               *cblk;
+    bplib_mpool_block_t               *blk;
+    bplib_mpool_bblock_canonical_t    *ccb;
+    bplib_mpool_bblock_canonical_t    *pay;
+    const bp_canonical_bundle_block_t *pay_block;
+    const uint8_t                     *in_p;
+    uint8_t                           *out_p;
+    uint8_t                           *end_p;
+    uint8_t                           *block_p;
+    bp_crcval_t                        crc_val;
+    size_t                             content_offset;
+    size_t                             content_length;
+    size_t                             slice_length;
+    size_t                             remain_sz;
+    size_t                             chunk_sz;
+    size_t                             header_sz;
+    int                                crc_len;
+
+    frag_pri = cpb->pri_logical_data;
+    pay      = bplib_mpool_bblock_canonical_cast(
+        bplib_mpool_bblock_primary_locate_canonical(cpb, bp_blocktype_payloadBlock));
+    if (pay == NULL || pay->block_encode_size_cache == 0 || frag_pri.controlFlags.mustNotFragment ||
+        frag_pri.controlFlags.isAdminRecord)
+    {
+        return 0;
+    }
 
-    /* If there is any existing encoded data, return it to the pool */
-    bplib_mpool_bblock_primary_drop_encode(cpb);
+    content_offset = bplib_mpool_bblock_canonical_get_content_offset(pay);
+    content_length = bplib_mpool_bblock_canonical_get_content_length(pay);
+    if (payload_offset >= content_length)
+    {
+        return 0;
+    }
 
-    pri = bplib_mpool_bblock_primary_get_logical(cpb);
-    memset(&v7_state, 0, sizeof(v7_state));
+    /* a fragment of a fragment keeps the original ADU length, the offset is relative to that */
+    if (!frag_pri.controlFlags.isFragment)
+    {
+        frag_pri.controlFlags.isFragment = true;
+        frag_pri.fragmentOffset          = 0;
+        frag_pri.totalADUlength          = content_length;
+    }
+    frag_pri.fragmentOffset += payload_offset;
 
-    bplib_mpool_start_stream_init(&v7_state.mps, bplib_mpool_get_parent_pool_from_link(&cpb->chunk_list),
-                                  bplib_mpool_stream_dir_write, pri->crctype);
-    cbor_encoder_init_writer(&origin, v7_encoder_write, &v7_state);
-    v7_state.cbor = &origin;
+    /* room for the primary block (and its CRC) plus the array start and break code is checked first */
+    if (buf_sz < (2 + V7_FAST_PRI_MAX_ENCODE_SIZE + 1 + sizeof(bp_crcval_t)))
+    {
+        return 0;
+    }
 
-    v7_encode_bp_primary_block(&v7_state, pri);
+    out_p  = buffer;
+    end_p  = out_p + buf_sz - 1; /* the break code goes at the end */
+    *out_p = 0x9F;               /* Start CBOR indefinite-length array */
+    ++out_p;
 
-    if (!v7_state.error)
+    block_p = out_p;
+    out_p   = v7_fast_put_primary_prefix(out_p, &frag_pri);
+    if (out_p == NULL)
     {
-        cpb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
-        bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_primary_get_encoded_chunks(cpb));
+        /* only IPN-scheme primary blocks are done here */
+        return 0;
     }
+    out_p = v7_fast_put_head(out_p, V7_FAST_CBOR_MAJOR_UINT, frag_pri.creationTimeStamp.time);
+    out_p = v7_fast_put_head(out_p, V7_FAST_CBOR_MAJOR_UINT, frag_pri.creationTimeStamp.sequence_num);
+    out_p = v7_fast_put_primary_suffix(out_p, &frag_pri);
 
-    bplib_mpool_stream_close(&v7_state.mps);
+    crc_params = v7_get_crc_params(frag_pri.crctype);
+    if (crc_params != NULL)
+    {
+        crc_val = bplib_crc_update(crc_params, bplib_crc_initial_value(crc_params), block_p, out_p - block_p);
+        out_p   = v7_fast_put_crc(out_p, crc_params, crc_val, bplib_crc_get_width(crc_params) / 8);
+    }
 
-    if (v7_state.error)
+    /*
+     * The extension blocks are sent as they are.  All of them go in the first fragment, and only the
+     * ones flagged for replication go in the others.
+     */
+    cblk = bplib_mpool_bblock_primary_get_canonical_list(cpb);
+    while (true)
     {
-        return -1;
+        cblk = bplib_mpool_get_next_block(cblk);
+        ccb  = bplib_mpool_bblock_canonical_cast(cblk);
+        if (ccb == NULL)
+        {
+            break;
+        }
+
+        if (ccb == pay || (frag_pri.fragmentOffset != 0 &&
+                           !ccb->canonical_logical_data.canonical_block.processingControlFlags.must_replicate))
+        {
+            continue;
+        }
+
+        if (ccb->block_encode_size_cache == 0 && v7_block_encode_canonical(ccb) != 0)
+        {
+            return 0;
+        }
+
+        if (ccb->block_encode_size_cache > (size_t)(end_p - out_p))
+        {
+            return 0;
+        }
+
+        out_p += bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb), out_p,
+                                                end_p - out_p, 0, -1);
     }
-    return 0;
+
+    /*
+     * The payload block carries as much of the remaining payload as fits.  The header size depends on
+     * the length, but it can only get smaller than it is for the full remainder.
+     */
+    pay_block    = &pay->canonical_logical_data.canonical_block;
+    slice_length = content_length - payload_offset;
+    if ((size_t)(end_p - out_p) < V7_FAST_CANONICAL_MAX_HEADER_SIZE)
+    {
+        return 0;
+    }
+
+    block_p = v7_fast_put_canonical_header(out_p, pay_block, slice_length, &crc_len);
+    if (block_p == NULL)
+    {
+        return 0;
+    }
+
+    /* the overhead is the header plus the CRC byte string, if there is one */
+    header_sz = block_p - out_p;
+    if (crc_len != 0)
+    {
+        header_sz += 1 + crc_len;
+    }
+    block_p = out_p;
+    if ((size_t)(end_p - out_p) <= header_sz)
+    {
+        return 0;
+    }
+    if (slice_length > ((end_p - out_p) - header_sz))
+    {
+        slice_length = (end_p - out_p) - header_sz;
+    }
+
+    out_p      = v7_fast_put_canonical_header(out_p, pay_block, slice_length, &crc_len);
+    crc_params = v7_get_crc_params(pay_block->crctype);
+    if (crc_params != NULL)
+    {
+        crc_val = bplib_crc_update(crc_params, bplib_crc_initial_value(crc_params), block_p, out_p - block_p);
+    }
+    else
+    {
+        crc_val = 0;
+    }
+
+    /* Copy (and digest) the slice of the payload straight from the chunks of the original block */
+    content_offset += payload_offset;
+    remain_sz = slice_length;
+    blk       = bplib_mpool_bblock_canonical_get_encoded_chunks(pay);
+    while (remain_sz > 0)
+    {
+        blk  = bplib_mpool_get_next_block(blk);
+        in_p = bplib_mpool_bblock_cbor_cast(blk);
+        if (in_p == NULL)
+        {
+            /* ran out of data */
+            return 0;
+        }
+
+        chunk_sz = bplib_mpool_get_user_content_size(blk);
+        if (content_offset >= chunk_sz)
+        {
+            content_offset -= chunk_sz;
+            continue;
+        }
+
+        in_p += content_offset;
+        chunk_sz -= content_offset;
+        content_offset = 0;
+        if (chunk_sz > remain_sz)
+        {
+            chunk_sz = remain_sz;
+        }
+
+        if (crc_params != NULL)
+        {
+            crc_val = bplib_crc_update_copy(crc_params, crc_val, out_p, in_p, chunk_sz);
+        }
+        else
+        {
+            memcpy(out_p, in_p, chunk_sz);
+        }
+        out_p += chunk_sz;
+        remain_sz -= chunk_sz;
+    }
+
+    if (crc_params != NULL)
+    {
+        out_p = v7_fast_put_crc(out_p, crc_params, crc_val, crc_len);
+    }
+
+    /* there is always space for this, because it was accounted for at the beginning */
+    *out_p = 0xFF; /* End CBOR indefinite-length array (break code) */
+    ++out_p;
+
+    payload_offset += slice_length;
+    if (payload_offset >= content_length)
+    {
+        /* this was the last fragment */
+        payload_offset = 0;
+    }
+    *next_offset = payload_offset;
+
+    return (out_p - (uint8_t *)buffer);
 }
 
-int v7_block_encode_pay(bplib_mpool_bblock_canonical_t *ccb, const void *data_ptr, size_t data_size)
-{
-    v7_encode_state_t                  v7_state;
-    CborEncoder                        origin;
-    const bp_canonical_block_buffer_t *pay;
-    size_t                             data_encoded_offset;
-    bplib_mpool_t                     *ppool;
+int v7_block_encode_pay_from_fragments(bplib_mpool_bblock_canonical_t *ccb, bplib_mpool_block_t *fragment_list,
+                                       size_t total_length)
+{
+    v7_encode_state_t                  v7_state;
+    const bp_canonical_block_buffer_t *logical;
+    bplib_mpool_bblock_primary_t      *frag;
+    bplib_mpool_bblock_canonical_t    *frag_pay;
+    bplib_mpool_block_t               *blk;
+    size_t                             content_encoded_offset;
+    size_t                             position;
+    size_t                             frag_offset;
+    size_t                             frag_length;
+    size_t                             skip_length;
+    int                                crc_len;
+
+    /* In case the block was already encoded, drop it now */
+    bplib_mpool_bblock_canonical_drop_encode(ccb);
+
+    logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+
+    memset(&v7_state, 0, sizeof(v7_state));
+    bplib_mpool_start_stream_init(&v7_state.mps, bplib_mpool_get_parent_pool_from_link(&ccb->chunk_list),
+                                  bplib_mpool_stream_dir_write, logical->canonical_block.crctype);
+
+    if (!v7_fast_encode_canonical_header(&v7_state, &logical->canonical_block, total_length, &crc_len))
+    {
+        v7_state.error = true;
+    }
+
+    content_encoded_offset = bplib_mpool_stream_tell(&v7_state.mps);
+
+    /* the fragments are in order of offset, each one must pick up at or before the end of the last */
+    position = 0;
+    blk      = fragment_list;
+    while (!v7_state.error && position < total_length)
+    {
+        blk  = bplib_mpool_get_next_block(blk);
+        frag = bplib_mpool_bblock_primary_cast(blk);
+        if (frag == NULL)
+        {
+            /* end of list, the payload is not all there */
+            v7_state.error = true;
+            break;
+        }
+
+        frag_pay = bplib_mpool_bblock_canonical_cast(
+            bplib_mpool_bblock_primary_locate_canonical(frag, bp_blocktype_payloadBlock));
+        frag_offset = frag->pri_logical_data.fragmentOffset;
+        if (frag_pay == NULL || frag_offset > position)
+        {
+            v7_state.error = true;
+            break;
+        }
+
+        frag_length = bplib_mpool_bblock_canonical_get_content_length(frag_pay);
+        if ((frag_offset + frag_length) <= position)
+        {
+            /* nothing new in this one (duplicate or overlap) */
+            continue;
+        }
 
-    /* If there is any existing encoded data, return it to the pool */
-    bplib_mpool_bblock_canonical_drop_encode(ccb);
+        skip_length = position - frag_offset;
+        frag_length -= skip_length;
+        if (frag_length > (total_length - position))
+        {
+            frag_length = total_length - position;
+        }
 
-    ppool = bplib_mpool_get_parent_pool_from_link(&ccb->chunk_list);
+        if (v7_stream_copy_saved_data(&v7_state.mps, bplib_mpool_bblock_canonical_get_encoded_chunks(frag_pay),
+                                      bplib_mpool_bblock_canonical_get_content_offset(frag_pay) + skip_length,
+                                      frag_length, true) < frag_length)
+        {
+            v7_state.error = true;
+        }
 
-    pay = bplib_mpool_bblock_canonical_get_logical(ccb);
-    memset(&v7_state, 0, sizeof(v7_state));
-    bplib_mpool_start_stream_init(&v7_state.mps, ppool, bplib_mpool_stream_dir_write, pay->canonical_block.crctype);
-    cbor_encoder_init_writer(&origin, v7_encoder_write, &v7_state);
-    v7_state.cbor = &origin;
+        position += frag_length;
+    }
 
-    v7_encode_bp_canonical_block_buffer(&v7_state, pay, data_ptr, data_size, &data_encoded_offset);
+    if (!v7_state.error && crc_len != 0)
+    {
+        v7_fast_write_crc(&v7_state, crc_len);
+    }
 
     if (!v7_state.error)
     {
-        bplib_mpool_bblock_canonical_set_content_position(ccb, data_encoded_offset, data_size);
+        bplib_mpool_bblock_canonical_set_content_position(ccb, content_encoded_offset, total_length);
         ccb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
         bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_canonical_get_encoded_chunks(ccb));
     }
@@ -1524,99 +3421,150 @@ int v7_block_encode_pay(bplib_mpool_bblock_canonical_t *ccb, const void *data_pt
     return 0;
 }
 
-int v7_block_encode_canonical(bplib_mpool_bblock_canonical_t *ccb)
+size_t v7_compute_aggregate_entry_size(size_t bundle_size)
+{
+    uint8_t head[9];
+
+    return (v7_fast_put_head(head, V7_FAST_CBOR_MAJOR_BYTESTRING, bundle_size) - head) + bundle_size;
+}
+
+int v7_block_encode_pay_from_bundles(bplib_mpool_bblock_canonical_t *ccb, bplib_mpool_block_t *bundle_list)
 {
     v7_encode_state_t                  v7_state;
-    CborEncoder                        origin;
     const bp_canonical_block_buffer_t *logical;
-    uint8_t                            scratch_area[256];
-    size_t                             scratch_size;
+    bplib_mpool_bblock_primary_t      *cpb;
+    bplib_mpool_bblock_canonical_t    *inner_ccb;
+    bplib_mpool_block_t               *blk;
+    bplib_mpool_block_t               *cblk;
+    uint8_t                            framing[1 + 9 + 1];
+    uint8_t                           *out;
     size_t                             content_encoded_offset;
-    bplib_mpool_t                     *ppool;
+    size_t                             content_length;
+    size_t                             bundle_size;
+    int                                crc_len;
 
-    /* If there is any existing encoded data, return it to the pool */
+    /* In case the block was already encoded, drop it now */
     bplib_mpool_bblock_canonical_drop_encode(ccb);
 
-    ppool = bplib_mpool_get_parent_pool_from_link(&ccb->chunk_list);
+    logical = bplib_mpool_bblock_canonical_get_logical(ccb);
 
     /*
-     * Encoding of a V7 extension block is a two-part affair, it must
-     * first encode the block-specific information into CBOR, then wrap
-     * those encoded octets as a CBOR byte string within the extension block.
-     * This effectively makes it CBOR-in-CBOR.
+     * The record is [record type, [_ bundle, bundle, ...]] where each bundle is a byte string.  The
+     * first pass gets the size of it all, which also makes sure every block of every bundle is encoded.
      */
-    logical = bplib_mpool_bblock_canonical_get_logical(ccb);
+    content_length = 4;
+    blk            = bundle_list;
+    while (true)
+    {
+        blk = bplib_mpool_get_next_block(blk);
+        cpb = bplib_mpool_bblock_primary_cast(blk);
+        if (cpb == NULL)
+        {
+            break;
+        }
+
+        bundle_size = v7_compute_full_bundle_size(cpb);
+        if (bundle_size == 0)
+        {
+            return -1;
+        }
+
+        content_length += v7_compute_aggregate_entry_size(bundle_size);
+    }
 
     memset(&v7_state, 0, sizeof(v7_state));
-    bplib_mpool_start_stream_init(&v7_state.mps, ppool, bplib_mpool_stream_dir_write, logical->canonical_block.crctype);
-    cbor_encoder_init(&origin, scratch_area, sizeof(scratch_area), 0);
+    bplib_mpool_start_stream_init(&v7_state.mps, bplib_mpool_get_parent_pool_from_link(&ccb->chunk_list),
+                                  bplib_mpool_stream_dir_write, logical->canonical_block.crctype);
+
+    if (!v7_fast_encode_canonical_header(&v7_state, &logical->canonical_block, content_length, &crc_len))
+    {
+        v7_state.error = true;
+    }
 
-    v7_state.cbor = &origin;
+    content_encoded_offset = bplib_mpool_stream_tell(&v7_state.mps);
 
-    switch (logical->canonical_block.blockType)
+    out    = framing;
+    *out++ = V7_FAST_CBOR_MAJOR_ARRAY | 2;
+    out    = v7_fast_put_head(out, V7_FAST_CBOR_MAJOR_UINT, bp_adminrectype_bundleAggregate);
+    *out++ = 0x9F; /* Start CBOR indefinite-length array */
+    if (!v7_state.error && bplib_mpool_stream_write(&v7_state.mps, framing, out - framing) < (size_t)(out - framing))
     {
-        case bp_blocktype_payloadBlock:
-            break;
-        case bp_blocktype_bundleAuthenicationBlock:
-            break;
-        case bp_blocktype_payloadIntegrityBlock:
-            break;
-        case bp_blocktype_payloadConfidentialityBlock:
-            break;
-        case bp_blocktype_previousHopInsertionBlock:
-            break;
-        case bp_blocktype_previousNode:
-            v7_encode_bp_previous_node_block(&v7_state, &logical->data.previous_node_block);
-            break;
-        case bp_blocktype_bundleAge:
-            v7_encode_bp_bundle_age_block(&v7_state, &logical->data.age_block);
-            break;
-        case bp_blocktype_metadataExtensionBlock:
-            break;
-        case bp_blocktype_extensionSecurityBlock:
-            break;
-        case bp_blocktype_hopCount:
-            v7_encode_bp_hop_count_block(&v7_state, &logical->data.hop_count_block);
-            break;
-        case bp_blocktype_custodyTrackingBlock:
-            v7_encode_bp_custody_tracking_block(&v7_state, &logical->data.custody_tracking_block);
-            break;
-        case bp_blocktype_adminRecordPayloadBlock:
-        case bp_blocktype_custodyAcceptPayloadBlock:
-            v7_encode_bp_admin_record_payload(&v7_state, logical);
-            break;
-        default:
-            /* do nothing */
-            break;
+        v7_state.error = true;
     }
 
-    if (!v7_state.error)
+    /* the second pass copies the encoded blocks of each bundle straight from their chunks */
+    blk = bundle_list;
+    while (!v7_state.error)
     {
-        scratch_size = cbor_encoder_get_buffer_size(&origin, scratch_area);
-        if (scratch_size > 0)
+        blk = bplib_mpool_get_next_block(blk);
+        cpb = bplib_mpool_bblock_primary_cast(blk);
+        if (cpb == NULL)
         {
-            /*
-             * Do second-stage encode - take the scratch buffer and use it as the content of the extension block
-             */
-            bplib_mpool_start_stream_init(&v7_state.mps, ppool, bplib_mpool_stream_dir_write,
-                                          logical->canonical_block.crctype);
-            cbor_encoder_init_writer(&origin, v7_encoder_write, &v7_state);
-            v7_state.cbor = &origin;
+            break;
+        }
 
-            v7_encode_bp_canonical_block_buffer(&v7_state, logical, scratch_area, scratch_size,
-                                                &content_encoded_offset);
+        out    = v7_fast_put_head(framing, V7_FAST_CBOR_MAJOR_BYTESTRING, cpb->bundle_encode_size_cache);
+        *out++ = 0x9F; /* Start CBOR indefinite-length array */
+        if (bplib_mpool_stream_write(&v7_state.mps, framing, out - framing) < (size_t)(out - framing) ||
+            v7_stream_copy_saved_data(&v7_state.mps, bplib_mpool_bblock_primary_get_encoded_chunks(cpb), 0,
+                                      cpb->block_encode_size_cache, true) < cpb->block_encode_size_cache)
+        {
+            v7_state.error = true;
+            break;
+        }
+
+        cblk = bplib_mpool_bblock_primary_get_canonical_list(cpb);
+        while (true)
+        {
+            cblk      = bplib_mpool_get_next_block(cblk);
+            inner_ccb = bplib_mpool_bblock_canonical_cast(cblk);
+            if (inner_ccb == NULL)
+            {
+                break;
+            }
 
-            if (!v7_state.error)
+            if (v7_stream_copy_saved_data(&v7_state.mps, bplib_mpool_bblock_canonical_get_encoded_chunks(inner_ccb),
+                                          0, inner_ccb->block_encode_size_cache,
+                                          true) < inner_ccb->block_encode_size_cache)
             {
-                bplib_mpool_bblock_canonical_set_content_position(ccb, content_encoded_offset, scratch_size);
-                ccb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
-                bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_canonical_get_encoded_chunks(ccb));
+                v7_state.error = true;
+                break;
             }
+        }
 
-            bplib_mpool_stream_close(&v7_state.mps);
+        framing[0] = 0xFF; /* End CBOR indefinite-length array (break code) */
+        if (!v7_state.error && bplib_mpool_stream_write(&v7_state.mps, framing, 1) < 1)
+        {
+            v7_state.error = true;
         }
     }
 
+    framing[0] = 0xFF; /* End CBOR indefinite-length array (break code) */
+    if (!v7_state.error && bplib_mpool_stream_write(&v7_state.mps, framing, 1) < 1)
+    {
+        v7_state.error = true;
+    }
+
+    if (!v7_state.error && (bplib_mpool_stream_tell(&v7_state.mps) - content_encoded_offset) != content_length)
+    {
+        /* a bundle changed size between the passes, not expected */
+        v7_state.error = true;
+    }
+
+    if (!v7_state.error && crc_len != 0)
+    {
+        v7_fast_write_crc(&v7_state, crc_len);
+    }
+
+    if (!v7_state.error)
+    {
+        bplib_mpool_bblock_canonical_set_content_position(ccb, content_encoded_offset, content_length);
+        ccb->block_encode_size_cache = bplib_mpool_stream_tell(&v7_state.mps);
+        bplib_mpool_stream_attach(&v7_state.mps, bplib_mpool_bblock_canonical_get_encoded_chunks(ccb));
+    }
+
+    bplib_mpool_stream_close(&v7_state.mps);
+
     if (v7_state.error)
     {
         return -1;
@@ -1624,112 +3572,105 @@ int v7_block_encode_canonical(bplib_mpool_bblock_canonical_t *ccb)
     return 0;
 }
 
-size_t v7_sum_preencoded_size(bplib_mpool_block_t *list)
+size_t v7_next_aggregated_bundle(bplib_mpool_bblock_primary_t *cpb, const void *buffer, size_t buf_sz,
+                                 size_t *position, const void **bundle_ptr)
 {
-    bplib_mpool_block_t *blk;
-    size_t               size_sum;
-
-    size_sum = 0;
-    blk      = list;
+    bplib_mpool_block_t            *cblk;
+    bplib_mpool_bblock_canonical_t *ccb;
+    const uint8_t                  *base;
+    const uint8_t                  *in;
+    const uint8_t                  *end;
+    size_t                          block_offset;
+    size_t                          content_offset;
+    uint64_t                        bundle_size;
+
+    /* find where the payload content is in the buffer, from the sizes of the blocks decoded from it */
+    block_offset = 1 + cpb->block_encode_size_cache;
+    cblk         = bplib_mpool_bblock_primary_get_canonical_list(cpb);
     while (true)
     {
-        blk = bplib_mpool_get_next_block(blk);
-        if (bplib_mpool_is_list_head(blk))
+        cblk = bplib_mpool_get_next_block(cblk);
+        ccb  = bplib_mpool_bblock_canonical_cast(cblk);
+        if (ccb == NULL)
+        {
+            /* not an aggregate */
+            return 0;
+        }
+
+        if (bplib_mpool_bblock_canonical_get_logical(ccb)->canonical_block.blockType ==
+            bp_blocktype_bundleAggregatePayloadBlock)
         {
             break;
         }
-        size_sum += bplib_mpool_get_user_content_size(blk);
-    }
 
-    return size_sum;
-}
+        block_offset += ccb->block_encode_size_cache;
+    }
 
-size_t v7_compute_full_bundle_size(bplib_mpool_bblock_primary_t *cpb)
-{
-    bplib_mpool_block_t            *blk;
-    bplib_mpool_bblock_canonical_t *ccb;
-    int                             last_encode;
-    size_t                          sum_result;
+    content_offset = block_offset + bplib_mpool_bblock_canonical_get_content_offset(ccb);
+    if ((content_offset + bplib_mpool_bblock_canonical_get_content_length(ccb)) > buf_sz)
+    {
+        return 0;
+    }
 
-    if (cpb->bundle_encode_size_cache == 0)
+    base = buffer;
+    end  = base + content_offset + bplib_mpool_bblock_canonical_get_content_length(ccb);
+    if (*position == 0)
     {
-        /*
-         * For any block which is not already encoded, this needs to encode it now.
-         * For most blocks all the information is in the logical data, so it is possible
-         * to do this on the fly.
-         *
-         * However the payload block MUST be pre-encoded because the information is
-         * not available in the logical data.  The payload content only exists in encoded
-         * form.
-         */
-        if (cpb->block_encode_size_cache == 0)
-        {
-            last_encode = v7_block_encode_pri(cpb);
-        }
-        else
+        /* skip the record type, to the first bundle in the array (this was checked during decode) */
+        in = base + content_offset + 2;
+        if (in >= end || *in != 0x9F)
         {
-            last_encode = 0;
+            return 0;
         }
-        sum_result = cpb->block_encode_size_cache;
-        blk        = bplib_mpool_bblock_primary_get_canonical_list(cpb);
-        while (last_encode == 0)
-        {
-            blk = bplib_mpool_get_next_block(blk);
-            ccb = bplib_mpool_bblock_canonical_cast(blk);
-            if (ccb == NULL)
-            {
-                /*
-                 * no more blocks... this is the normal stop condition.
-                 *
-                 * This adds 2 extra bytes here because the complete bundle is supposed to be wrapped
-                 * inside a CBOR indefinite-length array, which adds one octet at the beginning
-                 * and one octet at the end.
-                 */
-                cpb->bundle_encode_size_cache = 2 + sum_result;
-                break;
-            }
-
-            if (ccb->block_encode_size_cache == 0)
-            {
-                last_encode = v7_block_encode_canonical(ccb);
-            }
+        ++in;
+    }
+    else if (*position > content_offset && *position < (size_t)(end - base))
+    {
+        in = base + *position;
+    }
+    else
+    {
+        return 0;
+    }
 
-            sum_result += ccb->block_encode_size_cache;
-        }
+    /* the break code ends the array, otherwise this should be the next bundle */
+    in = v7_fast_get_head(in, end, V7_FAST_CBOR_MAJOR_BYTESTRING, &bundle_size);
+    if (in == NULL || bundle_size > (uint64_t)(end - in))
+    {
+        return 0;
     }
 
-    return cpb->bundle_encode_size_cache;
+    *bundle_ptr = in;
+    *position   = (in - base) + bundle_size;
+
+    return bundle_size;
 }
 
-size_t v7_copy_full_bundle_out(bplib_mpool_bblock_primary_t *cpb, void *buffer, size_t buf_sz)
+int v7_verify_deferred_crc(bplib_mpool_bblock_primary_t *cpb)
 {
-    size_t                          remain_sz;
-    size_t                          chunk_sz;
-    uint8_t                        *out_p;
     bplib_mpool_block_t            *cblk;
     bplib_mpool_bblock_canonical_t *ccb;
+    bp_canonical_bundle_block_t    *canonical;
 
-    /*
-     * two bytes is just the overhead added by this routine.  It is definitely not enough
-     * for a real bundle, this just avoids buffer bounds violation in here.
-     */
-    if (buf_sz < 2)
+    if (!cpb->crc_verify_deferred)
     {
+        /* already checked, or was never deferred */
         return 0;
     }
 
-    out_p  = buffer;
-    *out_p = 0x9F; /* Start CBOR indefinite-length array */
-    ++out_p;
-
-    remain_sz = buf_sz - 2;
+    /*
+     * Any block that is not currently encoded (size cache is 0) will get a fresh CRC when it is
+     * encoded, so only the blocks still holding the original encoded data need to be checked.
+     */
+    if (cpb->block_encode_size_cache != 0 &&
+        !v7_verify_saved_block(bplib_mpool_bblock_primary_get_encoded_chunks(cpb), cpb->block_encode_size_cache,
+                               cpb->pri_logical_data.crctype, cpb->pri_logical_data.crcval))
+    {
+        return -1;
+    }
 
-    chunk_sz =
-        bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_primary_get_encoded_chunks(cpb), out_p, remain_sz, 0, -1);
-    out_p += chunk_sz;
-    remain_sz -= chunk_sz;
     cblk = bplib_mpool_bblock_primary_get_canonical_list(cpb);
-    while (remain_sz > 0)
+    while (true)
     {
         cblk = bplib_mpool_get_next_block(cblk);
         ccb  = bplib_mpool_bblock_canonical_cast(cblk);
@@ -1737,20 +3678,21 @@ size_t v7_copy_full_bundle_out(bplib_mpool_bblock_primary_t *cpb, void *buffer,
         {
             break;
         }
-        chunk_sz = bplib_mpool_bblock_cbor_export(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb), out_p,
-                                                  remain_sz, 0, -1);
-        out_p += chunk_sz;
-        remain_sz -= chunk_sz;
-    }
 
-    /* there should always be enough space for this, because it was accounted for at the beginning */
-    *out_p = 0xFF; /* End CBOR indefinite-length array (break code) */
-    ++out_p;
+        canonical = &ccb->canonical_logical_data.canonical_block;
+        if (ccb->block_encode_size_cache != 0 &&
+            !v7_verify_saved_block(bplib_mpool_bblock_canonical_get_encoded_chunks(ccb), ccb->block_encode_size_cache,
+                                   canonical->crctype, canonical->crcval))
+        {
+            return -1;
+        }
+    }
 
-    return (out_p - (uint8_t *)buffer);
+    cpb->crc_verify_deferred = false;
+    return 0;
 }
 
-size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buffer, size_t buf_sz)
+size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buffer, size_t buf_sz, bool defer_crc)
 {
     size_t         remain_sz;
     size_t         chunk_sz;
@@ -1767,6 +3709,7 @@ size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buf
     /* In case the bundle had any data with it, drop it now */
     /* note this sets cpb->block_encode_size_cache to 0 */
     bplib_mpool_bblock_primary_drop_encode(cpb);
+    cpb->crc_verify_deferred = defer_crc;
 
     /* also drop any existing canonical blocks */
     if (bplib_mpool_is_nonempty_list_head(&cpb->cblock_list))
@@ -1814,7 +3757,7 @@ size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buf
         {
             /* First block is always a primary block */
             /* Decode Primary Block */
-            if (v7_block_decode_pri(cpb, in_p, remain_sz) < 0)
+            if (v7_block_decode_pri(cpb, in_p, remain_sz, defer_crc) < 0)
             {
                 /* fail to decode */
                 break;
@@ -1845,7 +3788,7 @@ size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buf
             bplib_mpool_bblock_primary_append(cpb, cblk);
 
             /* Decode Canonical/Payload Block */
-            if (v7_block_decode_canonical(ccb, in_p, remain_sz, payload_block_hint) < 0)
+            if (v7_block_decode_canonical(ccb, in_p, remain_sz, payload_block_hint, defer_crc) < 0)
             {
                 /* fail to decode */
                 break;
@@ -1904,3 +3847,8 @@ size_t v7_copy_full_bundle_in(bplib_mpool_bblock_primary_t *cpb, const void *buf
 
     return cpb->bundle_encode_size_cache;
 }
+
+void v7_codec_enable_fast_path(bool enable)
+{
+    V7_CODEC_FAST_PATH_ENABLED = enable;
+}